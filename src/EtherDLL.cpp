@@ -20,12 +20,20 @@
 // Include to DLL specific headers
 #include "etherDLLInit.hpp"
 #include "etherDLLRequest.hpp"
+#include "etherDLLStream.hpp"
+#include "etherDLLChannelMap.hpp"
+#include "etherDLLRecorder.hpp"
+#include "etherDLLSweepStore.hpp"
 
 // Include core EtherDLL headers
 #include "EtherDLLLog.hpp"
 #include "EtherDLLUtils.hpp"
 #include "EtherDLLConfig.hpp"
 #include "EtherDLLClient.hpp"
+#include "EtherDLLTrace.hpp"
+#include "EtherDLLMetrics.hpp"
+#include "EtherDLLAdmission.hpp"
+#include "EtherDLLDeadline.hpp"
 
 // Include additional libraries
 #include <nlohmann/json.hpp>
@@ -58,10 +66,55 @@ using json = nlohmann::json;
 // Code to represent the cause for not running
 edll::INT_CODE interruptionCode = edll::Code::RUNNING;
 
+// Key of the client ID in client messages, as configured
+std::string clientIdKey = edll::DefaultConfig::Service::TaskKeys::ClientId::VALUE;
+
 // Message queues
 MessageQueue request;
 MessageQueue response;
 
+// Correlation between DLL request IDs and client sessions
+RequestRegistry requestRegistry;
+
+// Latency histograms for each processing stage
+LatencyTracer latencyTracer;
+
+// Service counters exported in the metrics endpoint
+ServiceMetrics serviceMetrics;
+
+// Per-session rate limits and in-flight caps for client requests
+AdmissionControl admissionControl;
+
+// Default deadlines for client requests by command code
+DeadlinePolicy deadlinePolicy;
+
+// Pan stream requested continuously on behalf of a client
+PanStreamer panStreamer;
+
+// Full band maps assembled from the chunks of the occupancy tasks
+ChannelMap channelMap;
+
+// IQ streams recorded in SigMF files
+IqRecorder iqRecorder;
+
+// History of the spectrum sweeps received from the station
+SweepStore sweepStore;
+
+// Reductions of the stored sweeps requested by the clients
+SweepQueries sweepQueries;
+
+// Raw DLL callbacks captured to a file
+CallbackCapture callbackCapture;
+
+// Captured DLL callbacks replayed instead of the station connection
+CallbackReplay callbackReplay;
+
+// Max-hold, min-hold and average traces of the pan sweeps
+PanTraces panTraces;
+
+// Last sweeps of each spectrum task, sent on request
+Waterfalls waterfalls;
+
 // Logger pointer
 spdlog::logger* loggerPtr = nullptr;
 
@@ -273,6 +326,61 @@ int main(int argc, char* argv[]) {
 	std::atomic<bool> anyThreadCompleted = false;
 
 
+	clientIdKey = config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::TaskKeys::KEY].value(edll::DefaultConfig::Service::TaskKeys::ClientId::KEY, clientIdKey);
+	requestRegistry.setTTL(config[edll::DefaultConfig::Service::KEY].value(edll::DefaultConfig::Service::RequestTTL::KEY, edll::DefaultConfig::Service::RequestTTL::VALUE));
+	admissionControl.configure(config[edll::DefaultConfig::Service::KEY].value(edll::DefaultConfig::Service::RateLimit::KEY, json::object()));
+	admissionControl.setSlotTTL(config[edll::DefaultConfig::Service::KEY].value(edll::DefaultConfig::Service::RequestTTL::KEY, edll::DefaultConfig::Service::RequestTTL::VALUE));
+	deadlinePolicy.configure(config[edll::DefaultConfig::Service::KEY].value(edll::DefaultConfig::Service::RequestDeadline::KEY, json::object()));
+	latencyTracer.setReportPeriod(config[edll::DefaultConfig::Service::KEY].value(edll::DefaultConfig::Service::LatencyReport::KEY, edll::DefaultConfig::Service::LatencyReport::VALUE));
+
+	json bandConfig = config[DefaultDLLParam::KEY].value(DefaultDLLParam::BandSnapshot::KEY, json::object());
+	channelMap.configure(bandConfig.value(DefaultDLLParam::BandSnapshot::Enabled::KEY, DefaultDLLParam::BandSnapshot::Enabled::VALUE),
+		bandConfig.value(DefaultDLLParam::BandSnapshot::PeriodMs::KEY, DefaultDLLParam::BandSnapshot::PeriodMs::VALUE));
+
+	json recorderConfig = config[DefaultDLLParam::KEY].value(DefaultDLLParam::IqRecorder::KEY, json::object());
+	iqRecorder.configure(recorderConfig.value(DefaultDLLParam::IqRecorder::Enabled::KEY, DefaultDLLParam::IqRecorder::Enabled::VALUE),
+		recorderConfig.value(DefaultDLLParam::IqRecorder::Directory::KEY, std::string(DefaultDLLParam::IqRecorder::Directory::VALUE)),
+		recorderConfig.value(DefaultDLLParam::IqRecorder::FileSizeMB::KEY, DefaultDLLParam::IqRecorder::FileSizeMB::VALUE),
+		recorderConfig.value(DefaultDLLParam::IqRecorder::QueueBlocks::KEY, DefaultDLLParam::IqRecorder::QueueBlocks::VALUE));
+
+	json storeConfig = config[DefaultDLLParam::KEY].value(DefaultDLLParam::SweepStore::KEY, json::object());
+	sweepStore.configure(storeConfig.value(DefaultDLLParam::SweepStore::Enabled::KEY, DefaultDLLParam::SweepStore::Enabled::VALUE),
+		storeConfig.value(DefaultDLLParam::SweepStore::Directory::KEY, std::string(DefaultDLLParam::SweepStore::Directory::VALUE)),
+		storeConfig.value(DefaultDLLParam::SweepStore::SegmentMB::KEY, DefaultDLLParam::SweepStore::SegmentMB::VALUE),
+		storeConfig.value(DefaultDLLParam::SweepStore::MaxAgeS::KEY, DefaultDLLParam::SweepStore::MaxAgeS::VALUE),
+		storeConfig.value(DefaultDLLParam::SweepStore::MaxTotalMB::KEY, DefaultDLLParam::SweepStore::MaxTotalMB::VALUE),
+		storeConfig.value(DefaultDLLParam::SweepStore::QueueSweeps::KEY, DefaultDLLParam::SweepStore::QueueSweeps::VALUE),
+		storeConfig.value(DefaultDLLParam::SweepStore::MaxBins::KEY, DefaultDLLParam::SweepStore::MaxBins::VALUE));
+
+	json queryConfig = config[DefaultDLLParam::KEY].value(DefaultDLLParam::SweepQuery::KEY, json::object());
+	sweepQueries.configure(sweepStore.isEnabled(),
+		queryConfig.value(DefaultDLLParam::SweepQuery::Threads::KEY, DefaultDLLParam::SweepQuery::Threads::VALUE),
+		queryConfig.value(DefaultDLLParam::SweepQuery::MaxPending::KEY, DefaultDLLParam::SweepQuery::MaxPending::VALUE),
+		queryConfig.value(DefaultDLLParam::SweepQuery::MaxMemoryMB::KEY, DefaultDLLParam::SweepQuery::MaxMemoryMB::VALUE));
+
+	json replayConfig = config[DefaultDLLParam::KEY].value(DefaultDLLParam::CallbackReplay::KEY, json::object());
+	callbackReplay.configure(replayConfig.value(DefaultDLLParam::CallbackReplay::Enabled::KEY, DefaultDLLParam::CallbackReplay::Enabled::VALUE),
+		replayConfig.value(DefaultDLLParam::CallbackReplay::File::KEY, std::string(DefaultDLLParam::CallbackReplay::File::VALUE)),
+		replayConfig.value(DefaultDLLParam::CallbackReplay::Speed::KEY, DefaultDLLParam::CallbackReplay::Speed::VALUE),
+		replayConfig.value(DefaultDLLParam::CallbackReplay::Loop::KEY, DefaultDLLParam::CallbackReplay::Loop::VALUE));
+
+	// Replayed callbacks are not captured again
+	json captureConfig = config[DefaultDLLParam::KEY].value(DefaultDLLParam::CallbackCapture::KEY, json::object());
+	callbackCapture.configure(captureConfig.value(DefaultDLLParam::CallbackCapture::Enabled::KEY, DefaultDLLParam::CallbackCapture::Enabled::VALUE) && !callbackReplay.isEnabled(),
+		captureConfig.value(DefaultDLLParam::CallbackCapture::Directory::KEY, std::string(DefaultDLLParam::CallbackCapture::Directory::VALUE)),
+		captureConfig.value(DefaultDLLParam::CallbackCapture::QueueCallbacks::KEY, DefaultDLLParam::CallbackCapture::QueueCallbacks::VALUE));
+
+	json tracesConfig = config[DefaultDLLParam::KEY].value(DefaultDLLParam::PanTraces::KEY, json::object());
+	panTraces.configure(tracesConfig.value(DefaultDLLParam::PanTraces::Enabled::KEY, DefaultDLLParam::PanTraces::Enabled::VALUE),
+		tracesConfig.value(DefaultDLLParam::PanTraces::AverageSweeps::KEY, DefaultDLLParam::PanTraces::AverageSweeps::VALUE),
+		tracesConfig.value(DefaultDLLParam::PanTraces::MaxConfigurations::KEY, DefaultDLLParam::PanTraces::MaxConfigurations::VALUE));
+
+	json waterfallConfig = config[DefaultDLLParam::KEY].value(DefaultDLLParam::Waterfall::KEY, json::object());
+	waterfalls.configure(waterfallConfig.value(DefaultDLLParam::Waterfall::Enabled::KEY, DefaultDLLParam::Waterfall::Enabled::VALUE),
+		waterfallConfig.value(DefaultDLLParam::Waterfall::Depth::KEY, DefaultDLLParam::Waterfall::Depth::VALUE),
+		waterfallConfig.value(DefaultDLLParam::Waterfall::MaxWaterfalls::KEY, DefaultDLLParam::Waterfall::MaxWaterfalls::VALUE),
+		waterfallConfig.value(DefaultDLLParam::Waterfall::MaxPending::KEY, DefaultDLLParam::Waterfall::MaxPending::VALUE));
+
 	DLLConnectionData DLLConnID = DEFAULT_DLL_CONNECTION_DATA;
 
 	if (!connectAPI(DLLConnID, config)) {
@@ -280,6 +388,67 @@ int main(int argc, char* argv[]) {
 		interruptionCode = edll::Code::STATION_ERROR;
 	}
 
+	// Registry entries and admission slots without responses expire independently of new requests
+	auto requestRegistryFuture = std::async(std::launch::async, [&]() {
+		requestRegistry.run(interruptionCode);
+		return true;
+		});
+
+	// Metrics listener runs independently of client connections
+	auto metricsFuture = std::async(std::launch::async, [&]() {
+		MetricsServer metricsServer(config, interruptionCode);
+		metricsServer.run(request, response);
+		return true;
+		});
+
+	// Pan stream requests are issued independently of the client threads
+	auto panStreamFuture = std::async(std::launch::async, [&]() {
+		panStreamer.run(DLLConnID, config, interruptionCode);
+		return true;
+		});
+
+	// IQ blocks are written to disk away from the DLL callback thread
+	auto iqRecorderFuture = std::async(std::launch::async, [&]() {
+		iqRecorder.run(interruptionCode);
+		return true;
+		});
+
+	// Sweeps are stored away from the DLL callback threads
+	auto sweepStoreFuture = std::async(std::launch::async, [&]() {
+		sweepStore.run(interruptionCode);
+		return true;
+		});
+
+	// Sweep queries are reduced away from the client threads
+	auto sweepQueriesFuture = std::async(std::launch::async, [&]() {
+		sweepQueries.run(interruptionCode);
+		return true;
+		});
+
+	// Captured callbacks are written away from the DLL callback threads
+	auto callbackCaptureFuture = std::async(std::launch::async, [&]() {
+		callbackCapture.run(interruptionCode);
+		return true;
+		});
+
+	// Captured callbacks are replayed as if received from the station
+	auto callbackReplayFuture = std::async(std::launch::async, [&]() {
+		callbackReplay.run(interruptionCode, replayCallback);
+		return true;
+		});
+
+	// Trace subscribers are served at their own rate, independently of the sweeps
+	auto panTracesFuture = std::async(std::launch::async, [&]() {
+		panTraces.run(interruptionCode);
+		return true;
+		});
+
+	// Waterfalls are copied and encoded away from the client threads
+	auto waterfallsFuture = std::async(std::launch::async, [&]() {
+		waterfalls.run(interruptionCode);
+		return true;
+		});
+
 	while (interruptionCode == edll::Code::RUNNING)
 	{
 		// Initialize ClientConn object to wait for a client connection
@@ -296,6 +465,8 @@ int main(int argc, char* argv[]) {
 			}
 		}
 
+		serviceMetrics.sessionChange(1);
+
 		// Reset completion flag
 		anyThreadCompleted = false;
 
@@ -379,6 +550,14 @@ int main(int argc, char* argv[]) {
 		{
 			clientConn.closeConnection();
 		}
+
+		// Responses to requests from this session can no longer be delivered
+		requestRegistry.eraseSession(clientConn.getSessionId());
+		admissionControl.eraseSession(clientConn.getSessionId());
+		panStreamer.stop(clientConn.getSessionId(), "Pan stream stopped by client disconnection");
+		channelMap.eraseSession(clientConn.getSessionId());
+		panTraces.eraseSession(clientConn.getSessionId());
+		serviceMetrics.sessionChange(-1);
 	}
 
 	if (!disconnectAPI(DLLConnID)) {
@@ -0,0 +1,429 @@
+/**
+* @file EtherDLLAdmission.hpp
+*
+* @brief Header file for per-session admission control of client requests
+*
+* Each client session has token buckets limiting the request rate and the received byte rate,
+* and a cap on the number of requests submitted and not yet answered by the DLL.
+* The same limits may also be defined for each command code, in addition to the session wide limits.
+* Requests are checked in the receive path, before being added to the request queue.
+*
+* * @author fslobao
+* * @date 2025-10-22
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+// ----------------------------------------------------------------------
+#pragma once
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+// Include general C++ libraries
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+
+// For convenience
+using json = nlohmann::json;
+
+// Global variables
+extern spdlog::logger* loggerPtr;
+
+// ----------------------------------------------------------------------
+/** @brief Limits applied to a session or to a command code within a session
+ *
+ * A rate equal to zero disables the corresponding bucket and a zero in-flight cap disables the cap.
+ * A burst equal to zero is replaced by one second worth of the rate.
+**/
+struct AdmissionLimits {
+	double requestsPerS = edll::DefaultConfig::Service::RateLimit::RequestsPerS::VALUE;
+	double requestBurst = edll::DefaultConfig::Service::RateLimit::RequestBurst::VALUE;
+	double bytesPerS = edll::DefaultConfig::Service::RateLimit::BytesPerS::VALUE;
+	double byteBurst = edll::DefaultConfig::Service::RateLimit::ByteBurst::VALUE;
+	int maxInFlight = edll::DefaultConfig::Service::RateLimit::MaxInFlight::VALUE;
+
+	// ----------------------------------------------------------------------
+	/** @brief Read limits from a configuration object. Missing keys keep the default value.
+	 *
+	 * @param limitsConfig: JSON object with the limit keys
+	 * @return AdmissionLimits: Limits defined in the configuration
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static AdmissionLimits fromJson(const json& limitsConfig) {
+		using rateLimit = edll::DefaultConfig::Service::RateLimit;
+		AdmissionLimits limits;
+
+		if (!limitsConfig.is_object()) {
+			return limits;
+		}
+		limits.requestsPerS = limitsConfig.value(rateLimit::RequestsPerS::KEY, limits.requestsPerS);
+		limits.requestBurst = limitsConfig.value(rateLimit::RequestBurst::KEY, limits.requestBurst);
+		limits.bytesPerS = limitsConfig.value(rateLimit::BytesPerS::KEY, limits.bytesPerS);
+		limits.byteBurst = limitsConfig.value(rateLimit::ByteBurst::KEY, limits.byteBurst);
+		limits.maxInFlight = limitsConfig.value(rateLimit::MaxInFlight::KEY, limits.maxInFlight);
+		return limits;
+	}
+
+	bool enabled() const {
+		return requestsPerS > 0 || bytesPerS > 0 || maxInFlight > 0;
+	}
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Token bucket refilled continuously at a fixed rate up to its capacity
+ *
+ * Not thread-safe. Access is serialized by AdmissionControl.
+**/
+class TokenBucket {
+private:
+	double rate = 0;
+	double capacity = 0;
+	double tokens = 0;
+	std::chrono::steady_clock::time_point lastRefill = std::chrono::steady_clock::now();
+
+public:
+	TokenBucket() = default;
+
+	TokenBucket(double rate, double burst) :
+		rate(rate), capacity(burst > 0 ? burst : rate), tokens(burst > 0 ? burst : rate) {
+	}
+
+	bool enabled() const {
+		return rate > 0;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Add the tokens accumulated since the last refill
+	 *
+	 * @param now: Current time
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void refill(std::chrono::steady_clock::time_point now) {
+		if (now <= lastRefill) {
+			return;
+		}
+		std::chrono::duration<double> elapsed = now - lastRefill;
+		tokens = std::min(capacity, tokens + elapsed.count() * rate);
+		lastRefill = now;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Time to wait until the bucket holds the requested tokens
+	 * Costs above the bucket capacity only require a full bucket, otherwise they would never be admitted.
+	 *
+	 * @param cost: Number of tokens requested
+	 * @return long long: Wait time in milliseconds, zero if the tokens are available
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	long long waitMs(double cost) const {
+		double missing = std::min(cost, capacity) - tokens;
+		if (!enabled() || missing <= 0) {
+			return 0;
+		}
+		return static_cast<long long>(std::ceil(missing * 1000.0 / rate));
+	}
+
+	void take(double cost) {
+		if (enabled()) {
+			tokens -= std::min(cost, capacity);
+		}
+	}
+
+	void give(double cost) {
+		if (enabled()) {
+			tokens = std::min(capacity, tokens + std::min(cost, capacity));
+		}
+	}
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Admission control for client requests, shared by the receive thread and the DLL callbacks
+ *
+ * A request is admitted only if all buckets and in-flight caps that apply to it allow it, and only then tokens are taken.
+ * In-flight slots are released when the command completes, as signaled by the DLL specific request processing,
+ * or when the request fails before reaching the DLL. Slots never released expire after the slot TTL,
+ * by the periodic call to expire, so lost responses do not block the session.
+**/
+class AdmissionControl {
+private:
+	// Retry hint when the in-flight cap is reached, since the release time can not be estimated
+	static constexpr long long IN_FLIGHT_RETRY_MS = 1000;
+
+	struct Scope {
+		TokenBucket requests;
+		TokenBucket bytes;
+		// Admission time of each in-flight request, oldest first
+		std::deque<std::chrono::steady_clock::time_point> inFlight;
+
+		explicit Scope(const AdmissionLimits& limits) :
+			requests(limits.requestsPerS, limits.requestBurst),
+			bytes(limits.bytesPerS, limits.byteBurst) {
+		}
+	};
+
+	struct SessionState {
+		Scope total;
+		std::unordered_map<long long, Scope> codes;
+
+		explicit SessionState(const AdmissionLimits& limits) : total(limits) {}
+	};
+
+	std::mutex mtx;
+	bool active = false;
+	AdmissionLimits sessionLimits;
+	std::unordered_map<long long, AdmissionLimits> codeLimits;
+	std::unordered_map<unsigned long, SessionState> sessions;
+
+	// Maximum time an in-flight slot is held without being released
+	std::chrono::milliseconds slotTTL = std::chrono::seconds(edll::DefaultConfig::Service::RequestTTL::VALUE);
+
+	// ----------------------------------------------------------------------
+	/** @brief Release the oldest in-flight slot of a scope
+	 *
+	 * @param scope: Scope holding the slot
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static void releaseSlot(Scope& scope) {
+		if (!scope.inFlight.empty()) {
+			scope.inFlight.pop_front();
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Release the in-flight slots of a scope admitted before a given time
+	 *
+	 * @param scope: Scope holding the slots
+	 * @param oldest: Admission time of the oldest slot to be kept
+	 * @return size_t: Number of slots released
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static size_t expireSlots(Scope& scope, std::chrono::steady_clock::time_point oldest) {
+		size_t expired = 0;
+		while (!scope.inFlight.empty() && scope.inFlight.front() < oldest) {
+			scope.inFlight.pop_front();
+			expired++;
+		}
+		return expired;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Test a single scope and return the required wait, if any
+	 *
+	 * @param scope: Buckets and in-flight count to be tested
+	 * @param limits: Limits that apply to the scope
+	 * @param bytes: Size of the request in bytes
+	 * @param now: Current time
+	 * @param reason: Description of the exceeded limit, set only if the request must wait
+	 * @return long long: Wait time in milliseconds, zero if the scope admits the request
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static long long test(Scope& scope, const AdmissionLimits& limits, size_t bytes,
+			std::chrono::steady_clock::time_point now, std::string& reason) {
+		if (limits.maxInFlight > 0 && scope.inFlight.size() >= static_cast<size_t>(limits.maxInFlight)) {
+			reason = "in-flight limit of " + std::to_string(limits.maxInFlight) + " requests";
+			return IN_FLIGHT_RETRY_MS;
+		}
+
+		scope.requests.refill(now);
+		scope.bytes.refill(now);
+
+		long long waitMs = scope.requests.waitMs(1);
+		if (waitMs > 0) {
+			reason = fmt::format("rate limit of {} requests/s", limits.requestsPerS);
+			return waitMs;
+		}
+		waitMs = scope.bytes.waitMs(static_cast<double>(bytes));
+		if (waitMs > 0) {
+			reason = fmt::format("rate limit of {} bytes/s", limits.bytesPerS);
+		}
+		return waitMs;
+	}
+
+public:
+	// ----------------------------------------------------------------------
+	/** @brief Set the limits from the rate limit configuration section
+	 *
+	 * @param rateLimitConfig: JSON object with session limits and per command code limits
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void configure(const json& rateLimitConfig) {
+		using rateLimit = edll::DefaultConfig::Service::RateLimit;
+
+		std::lock_guard<std::mutex> lock(mtx);
+		sessionLimits = AdmissionLimits::fromJson(rateLimitConfig);
+		codeLimits.clear();
+		active = sessionLimits.enabled();
+
+		json commands = rateLimitConfig.is_object() ? rateLimitConfig.value(rateLimit::Commands::KEY, json::object()) : json::object();
+		for (const auto& [codeStr, limitsConfig] : commands.items()) {
+			AdmissionLimits limits = AdmissionLimits::fromJson(limitsConfig);
+			if (limits.enabled()) {
+				codeLimits[std::stoll(codeStr)] = limits;
+				active = true;
+			}
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Test if a request may be enqueued and, if so, take its tokens and in-flight slot
+	 *
+	 * @param sessionId: Client session that sent the request
+	 * @param code: Command code of the request
+	 * @param bytes: Size of the request in bytes
+	 * @param retryAfterMs: Suggested wait before retrying, set only if the request is rejected
+	 * @param reason: Description of the exceeded limit, set only if the request is rejected
+	 * @return bool: True if the request is admitted, false otherwise
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool admit(unsigned long sessionId, long long code, size_t bytes, long long& retryAfterMs, std::string& reason) {
+		std::lock_guard<std::mutex> lock(mtx);
+		if (!active) {
+			return true;
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		SessionState& session = sessions.try_emplace(sessionId, sessionLimits).first->second;
+
+		retryAfterMs = test(session.total, sessionLimits, bytes, now, reason);
+		if (retryAfterMs > 0) {
+			return false;
+		}
+
+		Scope* codeScope = nullptr;
+		auto limitsIt = codeLimits.find(code);
+		if (limitsIt != codeLimits.end()) {
+			codeScope = &session.codes.try_emplace(code, limitsIt->second).first->second;
+			retryAfterMs = test(*codeScope, limitsIt->second, bytes, now, reason);
+			if (retryAfterMs > 0) {
+				reason = "command " + std::to_string(code) + " " + reason;
+				return false;
+			}
+		}
+
+		for (Scope* scope : { &session.total, codeScope }) {
+			if (scope != nullptr) {
+				scope->requests.take(1);
+				scope->bytes.take(static_cast<double>(bytes));
+				scope->inFlight.push_back(now);
+			}
+		}
+		return true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Release the in-flight slot taken by an admitted request
+	 *
+	 * @param sessionId: Client session that sent the request
+	 * @param code: Command code of the request
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void release(unsigned long sessionId, long long code) {
+		std::lock_guard<std::mutex> lock(mtx);
+		auto sessionIt = sessions.find(sessionId);
+		if (sessionIt == sessions.end()) {
+			return;
+		}
+
+		SessionState& session = sessionIt->second;
+		releaseSlot(session.total);
+		auto codeIt = session.codes.find(code);
+		if (codeIt != session.codes.end()) {
+			releaseSlot(codeIt->second);
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Undo the admission of a request that will not be enqueued, returning its tokens and in-flight slot
+	 *
+	 * @param sessionId: Client session that sent the request
+	 * @param code: Command code of the request
+	 * @param bytes: Size of the request in bytes, as charged on admission
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void refund(unsigned long sessionId, long long code, size_t bytes) {
+		std::lock_guard<std::mutex> lock(mtx);
+		auto sessionIt = sessions.find(sessionId);
+		if (sessionIt == sessions.end()) {
+			return;
+		}
+
+		SessionState& session = sessionIt->second;
+		auto codeIt = session.codes.find(code);
+		for (Scope* scope : { &session.total, codeIt != session.codes.end() ? &codeIt->second : nullptr }) {
+			if (scope != nullptr) {
+				scope->requests.give(1);
+				scope->bytes.give(static_cast<double>(bytes));
+				if (!scope->inFlight.empty()) {
+					scope->inFlight.pop_back();
+				}
+			}
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Set the maximum time an in-flight slot is held without being released
+	 *
+	 * @param ttlS: Slot time to live in seconds
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void setSlotTTL(int ttlS) {
+		std::lock_guard<std::mutex> lock(mtx);
+		slotTTL = std::chrono::seconds(ttlS);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Release the in-flight slots held for longer than the slot TTL. Called periodically.
+	 *
+	 * @param None
+	 * @return size_t: Number of session wide slots released
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	size_t expire() {
+		std::lock_guard<std::mutex> lock(mtx);
+		if (!active) {
+			return 0;
+		}
+
+		auto oldest = std::chrono::steady_clock::now() - slotTTL;
+		size_t expired = 0;
+		for (auto& [sessionId, session] : sessions) {
+			expired += expireSlots(session.total, oldest);
+			for (auto& [code, scope] : session.codes) {
+				expireSlots(scope, oldest);
+			}
+		}
+		return expired;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Remove the state of a disconnected client session
+	 *
+	 * @param sessionId: Session ID of the disconnected client
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void eraseSession(unsigned long sessionId) {
+		std::lock_guard<std::mutex> lock(mtx);
+		sessions.erase(sessionId);
+	}
+};
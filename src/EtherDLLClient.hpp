@@ -24,6 +24,12 @@
 #include "EtherDLLConfig.hpp"
 #include "EtherDLLLog.hpp"
 #include "EtherDLLUtils.hpp"
+#include "EtherDLLTrace.hpp"
+#include "EtherDLLMetrics.hpp"
+#include "EtherDLLAdmission.hpp"
+#include "EtherDLLDeadline.hpp"
+#include "EtherDLLParser.hpp"
+#include "EtherDLLWriter.hpp"
 
 // Include project libraries
 #include <nlohmann/json.hpp>
@@ -31,11 +37,17 @@
 
 // Include general C++ libraries
 #include <string>
+#include <string_view>
 #include <mutex>
 #include <thread>
 #include <atomic>
 #include <queue>
+#include <condition_variable>
+#include <array>
+#include <unordered_map>
 #include <chrono>
+#include <limits>
+#include <cmath>
 #include <winsock2.h>
 #include <ws2tcpip.h>
 
@@ -51,6 +63,11 @@ using taskKeys = edll::DefaultConfig::Service::TaskKeys;
 
 // Global variables
 extern spdlog::logger* loggerPtr;
+extern std::string clientIdKey;
+extern LatencyTracer latencyTracer;
+extern ServiceMetrics serviceMetrics;
+extern AdmissionControl admissionControl;
+extern DeadlinePolicy deadlinePolicy;
 
 
 // ----------------------------------------------------------------------
@@ -66,6 +83,8 @@ private:
 	mutable std::mutex mtx;
 	// Total number of messages ever added to the queue. May return to zero if it overflows.
 	unsigned long messageCount = 0;
+	// Maximum number of messages held in the queue
+	size_t highWaterMark = 0;
 	// Condition variable to signal addition of messages
 	std::condition_variable push_condition;
 	// Flag to indicate that a message was pushed
@@ -92,10 +111,13 @@ public:
 		std::lock_guard<std::mutex> lock(mtx);
 		item[taskKeys::QueueId::VALUE] = messageCount;
 		if (setClientKey) {
-			item[taskKeys::ClientId::VALUE] = messageCount;
+			item[clientIdKey] = messageCount;
 		}
-		msgQueue.push(item);
+		msgQueue.push(std::move(item));
 		messagePushed = true;
+		if (msgQueue.size() > highWaterMark) {
+			highWaterMark = msgQueue.size();
+		}
 
 		push_condition.notify_all();
 		loggerPtr->debug(logSource + " pushed item to queue. New size: {}", msgQueue.size());
@@ -103,6 +125,48 @@ public:
 		return messageCount++;
 	}
 
+	/** @brief Push a batch of items to the queue as a single item in a thread-safe manner
+	 * The batch and each of its items receive a queue ID, in sequence.
+	 * The client ID key is set to the queue ID for the batch and for the items that do not have one.
+	 * IDs are also set in the batch object received, so the caller can acknowledge them.
+	 *
+	 * @param batch: Object with the items in an array under the batch key
+	 * @param logSource: Message to log upon pushing the batch
+	 * @return json: Array with the client IDs of the items, in order
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	json pushBatch(json& batch, std::string logSource) {
+
+		json itemIds = json::array();
+
+		std::lock_guard<std::mutex> lock(mtx);
+		batch[taskKeys::QueueId::VALUE] = messageCount;
+		if (!batch.contains(clientIdKey)) {
+			batch[clientIdKey] = messageCount;
+		}
+		messageCount++;
+
+		for (json& item : batch[taskKeys::Batch::VALUE]) {
+			item[taskKeys::QueueId::VALUE] = messageCount;
+			if (!item.contains(clientIdKey)) {
+				item[clientIdKey] = messageCount;
+			}
+			itemIds.push_back(item[clientIdKey]);
+			messageCount++;
+		}
+
+		msgQueue.push(batch);
+		messagePushed = true;
+		if (msgQueue.size() > highWaterMark) {
+			highWaterMark = msgQueue.size();
+		}
+
+		push_condition.notify_all();
+		loggerPtr->debug(logSource + " pushed batch of {} items to queue. New size: {}", itemIds.size(), msgQueue.size());
+
+		return itemIds;
+	}
+
 	/** @brief Push an item to the queue in a thread-safe manner
 	 * Signal any waiting threads that a new item is available.
 	 * Upon and pushing, add to the item the queue ID
@@ -240,9 +304,422 @@ public:
 		std::lock_guard<std::mutex> lock(mtx);
 		return messageCount;
 	}
+
+	/** @brief Get the current and maximum number of messages in the queue
+	 *
+	 * @param name: Name used to identify the queue in the metrics
+	 * @return QueueGauge: Queue depth and high-water mark
+	 * @throws NO EXCEPTION HANDLING
+	 **/
+	QueueGauge getGauge(const std::string& name) const {
+		std::lock_guard<std::mutex> lock(mtx);
+		QueueGauge gauge;
+		gauge.name = name;
+		gauge.depth = msgQueue.size();
+		gauge.highWaterMark = highWaterMark;
+		return gauge;
+	}
 };
 
 
+// ----------------------------------------------------------------------
+/** @brief Spectrum output options requested by the client with a spectrum command
+**/
+struct SpectrumOutput {
+	// Number of spectrum bins requested for the client display, zero to send every bin
+	unsigned long bins = 0;
+	// DLL specific reduction used to decimate the spectrum to bins
+	int decimation = 0;
+	// Peaks are detected above this level, or above the noise floor plus this margin in dB. NaN when not requested
+	float peakThreshold = std::numeric_limits<float>::quiet_NaN();
+	float peakMargin = std::numeric_limits<float>::quiet_NaN();
+	// Minimum distance between detected peaks, in Hz
+	double peakSpacing = 0;
+	// Percentile of the spectrum levels taken as the noise floor
+	double noisePercentile = 50;
+	// Flag to send the spectrum levels, false to send only the detected peaks
+	bool sweepData = true;
+
+	bool detectPeaks() const { return !std::isnan(peakThreshold) || !std::isnan(peakMargin); }
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Data associated with a request submitted to the DLL
+ *
+ * Used to route the DLL callbacks back to the client session that originated the request.
+**/
+struct RequestEntry {
+	// Client session that submitted the request
+	unsigned long sessionId = taskKeys::SessionId::INIT_VALUE;
+	// Client provided or generated message ID
+	json clientId = taskKeys::ClientId::INIT_VALUE;
+	// Command code and name as received from the client
+	unsigned long commandCode = 0;
+	std::string commandName = taskKeys::CommandName::INIT_VALUE;
+	// Time the request was submitted to the DLL
+	std::chrono::steady_clock::time_point submitTime = std::chrono::steady_clock::now();
+	// Time of the last response received for the request, used for expiration
+	std::chrono::steady_clock::time_point lastSeen = submitTime;
+	// Trace timestamp of the reception of the request from the client
+	long long recvTraceNs = 0;
+	// Flag to indicate that at least one response was received
+	bool answered = false;
+	// Spectrum output options requested by the client
+	SpectrumOutput output;
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Thread-safe correlation table between DLL request IDs and client sessions
+ *
+ * Entries are distributed over independent shards, each protected by its own mutex,
+ * so that the request thread and the DLL callback threads rarely contend for the same lock.
+ * The DLL returns the request ID only when the call returns, so each submission is reserved before the call and then
+ * committed with the returned ID or rolled back. Callbacks for unknown IDs wait, for a bounded time, for the submissions in progress.
+ * Entries not seen for longer than the configured TTL are removed by a periodic sweep,
+ * which also expires the admission control in-flight slots never released.
+ * A single realtime owner is kept apart, since realtime callbacks carry no request ID.
+**/
+class RequestRegistry {
+private:
+	static constexpr size_t SHARD_COUNT = 16;
+
+	struct Shard {
+		std::mutex mtx;
+		std::unordered_map<unsigned long, RequestEntry> entries;
+	};
+
+	std::array<Shard, SHARD_COUNT> shards;
+
+	// Owner of the realtime data stream
+	mutable std::mutex realTimeMtx;
+	RequestEntry realTimeOwner;
+	bool hasRealTimeOwner = false;
+
+	// Maximum time without responses before an entry is discarded
+	std::atomic<long long> ttlMs = static_cast<long long>(service::RequestTTL::VALUE) * 1000;
+
+	// Longest wait of a callback for the submissions in progress and period of the expiration sweep
+	static constexpr long long PENDING_WAIT_MS = 250;
+	static constexpr long long PRUNE_PERIOD_MS = 1000;
+
+	// Submissions to the DLL whose request ID is not known yet
+	std::mutex pendingMtx;
+	std::condition_variable pendingCondition;
+	int pendingCount = 0;
+
+	// Set on the thread calling the DLL, whose callbacks must not wait for its own submission
+	static inline thread_local bool submitting = false;
+
+	Shard& shardFor(unsigned long requestId) {
+		return shards[requestId % SHARD_COUNT];
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Retrieve the entry associated with a DLL request ID and mark it as answered
+	 *
+	 * @param requestId: Request ID received from the DLL callback
+	 * @param entry: Copy of the entry as it was before this call
+	 * @return bool: True if the request ID was found, false otherwise
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool find(unsigned long requestId, RequestEntry& entry) {
+		Shard& shard = shardFor(requestId);
+
+		std::lock_guard<std::mutex> lock(shard.mtx);
+		auto it = shard.entries.find(requestId);
+		if (it == shard.entries.end()) {
+			return false;
+		}
+		entry = it->second;
+		it->second.answered = true;
+		it->second.lastSeen = std::chrono::steady_clock::now();
+		return true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief End a reservation, committed or rolled back, and wake the callbacks waiting for it
+	 *
+	 * @param None
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void settle() {
+		submitting = false;
+		{
+			std::lock_guard<std::mutex> lock(pendingMtx);
+			if (pendingCount > 0) {
+				pendingCount--;
+			}
+		}
+		pendingCondition.notify_all();
+	}
+
+public:
+	// ----------------------------------------------------------------------
+	/** @brief Set the time to live for entries without activity
+	 *
+	 * @param ttlS: Time to live in seconds
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void setTTL(int ttlS) {
+		ttlMs = static_cast<long long>(ttlS) * 1000;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Reserve a submission before calling the DLL, whose request ID is only known when the call returns
+	 * Must be followed by commit or rollback on the same thread.
+	 *
+	 * @param None
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void reserve() {
+		{
+			std::lock_guard<std::mutex> lock(pendingMtx);
+			pendingCount++;
+		}
+		submitting = true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Add or replace the entry associated with the request ID returned by the DLL and end the reservation
+	 *
+	 * @param requestId: Request ID returned by the DLL
+	 * @param entry: Session and command data associated with the request
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void commit(unsigned long requestId, const RequestEntry& entry) {
+		{
+			Shard& shard = shardFor(requestId);
+			std::lock_guard<std::mutex> lock(shard.mtx);
+			shard.entries[requestId] = entry;
+		}
+		settle();
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief End a reservation whose DLL call failed or was answered by the service
+	 *
+	 * @param None
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void rollback() {
+		settle();
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Retrieve the entry associated with a DLL request ID and mark it as answered
+	 * If the ID is unknown while submissions are in progress, wait until they are settled, up to PENDING_WAIT_MS.
+	 *
+	 * @param requestId: Request ID received from the DLL callback
+	 * @param entry: Copy of the entry as it was before this call
+	 * @return bool: True if the request ID was found, false otherwise
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool resolve(unsigned long requestId, RequestEntry& entry) {
+		if (find(requestId, entry)) {
+			return true;
+		}
+		if (submitting) {
+			return false;
+		}
+
+		auto waitLimit = std::chrono::steady_clock::now() + std::chrono::milliseconds(PENDING_WAIT_MS);
+		std::unique_lock<std::mutex> lock(pendingMtx);
+		while (pendingCount > 0) {
+			if (pendingCondition.wait_until(lock, waitLimit) == std::cv_status::timeout) {
+				break;
+			}
+			lock.unlock();
+			if (find(requestId, entry)) {
+				return true;
+			}
+			lock.lock();
+		}
+		lock.unlock();
+		return find(requestId, entry);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Remove the entries not seen for longer than the TTL
+	 * Their admission control slots, if never released, are expired by the admission control itself after the same TTL.
+	 *
+	 * @param None
+	 * @return size_t: Number of entries removed
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	size_t prune() {
+		auto now = std::chrono::steady_clock::now();
+		std::chrono::milliseconds ttl(ttlMs.load());
+
+		size_t removed = 0;
+		for (Shard& shard : shards) {
+			std::lock_guard<std::mutex> lock(shard.mtx);
+			for (auto it = shard.entries.begin(); it != shard.entries.end(); ) {
+				if (now - it->second.lastSeen > ttl) {
+					it = shard.entries.erase(it);
+					removed++;
+				}
+				else {
+					++it;
+				}
+			}
+		}
+		return removed;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Remove expired entries and expire admission control slots periodically until the service is interrupted
+	 *
+	 * This function will lock the thread. Must be run in a separate thread.
+	 *
+	 * @param interruptionCode: Signal interruption for service interruption
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void run(const edll::INT_CODE& interruptionCode) {
+		while (interruptionCode == edll::Code::RUNNING) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(PRUNE_PERIOD_MS));
+
+			size_t removed = prune();
+			if (removed > 0) {
+				loggerPtr->debug("Request registry expired " + std::to_string(removed) + " entries without responses");
+			}
+			size_t released = admissionControl.expire();
+			if (released > 0) {
+				loggerPtr->warn("Admission control released " + std::to_string(released) + " in-flight slots not completed within the TTL");
+			}
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Remove the entry associated with a DLL request ID
+	 *
+	 * @param requestId: Request ID to be removed
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void erase(unsigned long requestId) {
+		Shard& shard = shardFor(requestId);
+
+		std::lock_guard<std::mutex> lock(shard.mtx);
+		shard.entries.erase(requestId);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Remove all entries associated with a client session
+	 *
+	 * @param sessionId: Session ID of the disconnected client
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void eraseSession(unsigned long sessionId) {
+		for (Shard& shard : shards) {
+			std::lock_guard<std::mutex> lock(shard.mtx);
+			for (auto it = shard.entries.begin(); it != shard.entries.end(); ) {
+				if (it->second.sessionId == sessionId) {
+					it = shard.entries.erase(it);
+				}
+				else {
+					++it;
+				}
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(realTimeMtx);
+		if (hasRealTimeOwner && realTimeOwner.sessionId == sessionId) {
+			hasRealTimeOwner = false;
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Define the request that owns the realtime data stream
+	 *
+	 * @param entry: Session and command data associated with the realtime request
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void setRealTimeOwner(const RequestEntry& entry) {
+		std::lock_guard<std::mutex> lock(realTimeMtx);
+		realTimeOwner = entry;
+		hasRealTimeOwner = true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Retrieve the request that owns the realtime data stream and mark it as answered
+	 *
+	 * @param entry: Copy of the entry as it was before this call
+	 * @return bool: True if there is a realtime owner, false otherwise
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool resolveRealTime(RequestEntry& entry) {
+		std::lock_guard<std::mutex> lock(realTimeMtx);
+		if (!hasRealTimeOwner) {
+			return false;
+		}
+		entry = realTimeOwner;
+		realTimeOwner.answered = true;
+		realTimeOwner.lastSeen = std::chrono::steady_clock::now();
+		return true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Get the number of entries in the table
+	 *
+	 * @param None
+	 * @return size_t: Number of request entries, excluding the realtime owner
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	size_t size() {
+		size_t total = 0;
+		for (Shard& shard : shards) {
+			std::lock_guard<std::mutex> lock(shard.mtx);
+			total += shard.entries.size();
+		}
+		return total;
+	}
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Build the response to a command handled by the service itself, without calling the DLL
+ *
+ * Used by the receive thread for single commands and by the request processing for the commands of a batch.
+ *
+ * @param code: Command code of the request
+ * @param sessionId: Client session that sent the request
+ * @param reply: Response to be sent to the client, without the client ID
+ * @return bool: True if the code is a service command and the reply was built, false otherwise
+ * @throws NO EXCEPTION HANDLING
+**/
+bool buildServiceReply(long long code, unsigned long sessionId, json& reply)
+{
+	const char* commandName = edll::ServiceCode::toString(code);
+	if (commandName == nullptr) {
+		return false;
+	}
+
+	reply[taskKeys::CommandCode::VALUE] = code;
+	reply[taskKeys::CommandName::VALUE] = commandName;
+	reply[taskKeys::Arguments::VALUE] = json::object();
+	reply[taskKeys::SessionId::VALUE] = sessionId;
+
+	switch (code) {
+		case edll::ServiceCode::LATENCY_REPORT:
+			reply[taskKeys::Message::VALUE] = latencyTracer.report();
+			break;
+		default:
+			break;
+	}
+	return true;
+}
+
+
 // ----------------------------------------------------------------------
 /** @brief Socket client connection object
  *
@@ -269,6 +746,10 @@ private:
 	SOCKET clientSocket = INVALID_SOCKET;
 	std::string clientIP;
 
+	// Session counter shared by all connections and the session ID for this connection
+	static inline std::atomic<unsigned long> sessionCounter = taskKeys::SessionId::INIT_VALUE;
+	unsigned long sessionId = ++sessionCounter;
+
 	std::string msgJsonStartStr = std::string(edll::JSON_START);
 	std::string msgJsonMidStr = std::string(edll::JSON_MID);
 
@@ -283,7 +764,7 @@ private:
 
 	bool pingEnable = config[service::KEY][service::PingEnable::KEY].get<bool>();
 
-	std::string idStr = config[service::KEY][taskKeys::KEY][taskKeys::ClientId::KEY].get<std::string>();
+	std::string idStr = clientIdKey;
 
 	std::chrono::steady_clock::time_point lastClientMsgTime = std::chrono::steady_clock::now();
 
@@ -306,6 +787,183 @@ private:
 		return msg;
 	}
 
+	// ----------------------------------------------------------------------
+	/** @brief Answer commands handled by the service itself, without calling the DLL
+	 *
+	 * The client ID is returned in the ACK and in the response if provided by the client.
+	 * Otherwise the ACK carries the initial client ID value and the response a generated ID.
+	 *
+	 * @param jsonObj: Request received from the client
+	 * @param response: Thread-safe message queue containing messages to be sent to the client
+	 * @return bool: True if the request was a service command and was answered, false otherwise
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool handleServiceCommand(const json& jsonObj, MessageQueue& response) {
+		const std::string logSource = "ServiceCommand";
+
+		long long code = edll::commandCodeOf(jsonObj);
+		json reply;
+		if (!buildServiceReply(code, sessionId, reply)) {
+			return false;
+		}
+		std::string commandName = reply[taskKeys::CommandName::VALUE].get<std::string>();
+
+		json ackObj;
+		ackObj[service::Msg::Ack::VALUE] = jsonObj.value(idStr, json(taskKeys::ClientId::INIT_VALUE));
+		response.push(ackObj, logSource, true);
+
+		bool generateId = !jsonObj.contains(idStr);
+		if (!generateId) {
+			reply[idStr] = jsonObj[idStr];
+		}
+		response.push(reply, logSource, generateId);
+
+		loggerPtr->debug(logSource + " answered " + commandName + " from " + clientIP);
+		return true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Answer a frame with a missing or unknown command code, without parsing it
+	 *
+	 * The NACK contains the client ID, if found in the frame, and the reason for the rejection.
+	 *
+	 * @param scan: Keys located in the frame received from the client
+	 * @param response: Thread-safe message queue containing messages to be sent to the client
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void rejectCommand(const edll::FrameScan& scan, MessageQueue& response) {
+		const std::string logSource = "ClientRequestToDLL";
+
+		std::string reason = scan.hasCode ?
+			"Unknown command code " + std::to_string(scan.code) :
+			"Command code required";
+
+		json clientId = json::parse(scan.id.begin(), scan.id.end(), nullptr, false);
+
+		json nackObj;
+		nackObj[service::Msg::Nack::VALUE] = clientId.is_discarded() ? json() : clientId;
+		nackObj[taskKeys::Message::VALUE] = reason;
+		response.push(nackObj, logSource, true);
+		serviceMetrics.countNack();
+
+		loggerPtr->warn(logSource + " rejected message from " + clientIP + ". " + reason);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Apply the session admission control to a request before it is enqueued
+	 *
+	 * Rejected requests are answered immediately with a NACK containing the client ID,
+	 * the suggested wait before retrying and the limit that was exceeded.
+	 *
+	 * @param jsonObj: Request received from the client
+	 * @param code: Command code of the request
+	 * @param messageBytes: Size of the request as received from the client
+	 * @param response: Thread-safe message queue containing messages to be sent to the client
+	 * @return bool: True if the request may be enqueued, false if it was rejected
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool admitRequest(const json& jsonObj, long long code, size_t messageBytes, MessageQueue& response) {
+		const std::string logSource = "AdmissionControl";
+
+		long long retryAfterMs = 0;
+		std::string reason;
+		if (admissionControl.admit(sessionId, code, messageBytes, retryAfterMs, reason)) {
+			return true;
+		}
+
+		json nackObj;
+		nackObj[service::Msg::Nack::VALUE] = jsonObj.value(idStr, json());
+		nackObj[taskKeys::RetryAfter::VALUE] = retryAfterMs;
+		nackObj[taskKeys::Message::VALUE] = "Request rejected by " + reason;
+		response.push(nackObj, logSource, true);
+		serviceMetrics.countNack();
+
+		loggerPtr->debug(logSource + " rejected command " + std::to_string(code) + " from " + clientIP + " due to " + reason);
+		return false;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Enqueue a batch of commands received in a single frame
+	 *
+	 * The batch may be a JSON array of commands or an object with the commands under the batch key.
+	 * The object form may also carry a client ID and the results flag, requesting an aggregated response.
+	 * The batch is enqueued as a single item, so its commands are executed in order without interleaving.
+	 * A single ACK lists the IDs of all commands. If any command is rejected by the admission control, the whole batch is rejected
+	 * and the tokens and slots taken by the commands already admitted are refunded.
+	 *
+	 * @param jsonObj: Batch received from the client. Moved into the queue.
+	 * @param messageBytes: Size of the batch as received from the client
+	 * @param recvNs: Trace timestamp of the reception of the batch
+	 * @param request: Thread-safe message queue where requests are stored
+	 * @param response: Thread-safe message queue containing messages to be sent to the client
+	 * @return bool: True if the batch was enqueued, false if it was rejected
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool enqueueBatch(json& jsonObj, size_t messageBytes, long long recvNs, MessageQueue& request, MessageQueue& response) {
+		const std::string logSource = "ClientRequestToDLL";
+
+		json batch;
+		if (jsonObj.is_array()) {
+			batch[taskKeys::Batch::VALUE] = std::move(jsonObj);
+		}
+		else {
+			batch = std::move(jsonObj);
+		}
+
+		// Items are checked as single frames are, so that the request thread never reads a code or flag of the wrong type
+		json& items = batch[taskKeys::Batch::VALUE];
+		bool validBatch = items.is_array() && !items.empty();
+		for (const json& item : items) {
+			validBatch = validBatch && item.is_object() && edll::knownCommandCode(edll::commandCodeOf(item));
+		}
+		auto resultsIt = batch.find(taskKeys::Results::VALUE);
+		validBatch = validBatch && (resultsIt == batch.end() || resultsIt->is_boolean());
+		if (!validBatch) {
+			json nackObj;
+			nackObj[service::Msg::Nack::VALUE] = batch.value(idStr, json());
+			nackObj[taskKeys::Message::VALUE] = "Batch must be a non-empty array of command objects with known integer command codes, and results a boolean";
+			response.push(nackObj, logSource, true);
+			serviceMetrics.countNack();
+			return false;
+		}
+
+		// Charge the batch size evenly to its commands
+		size_t itemBytes = messageBytes / items.size();
+		for (size_t i = 0; i < items.size(); i++) {
+			long long deadlineNs = deadlinePolicy.resolve(items[i], edll::commandCodeOf(items[i]), recvNs);
+			if (deadlineNs != 0) {
+				items[i][edll::DEADLINE_KEY] = deadlineNs;
+			}
+
+			if (!admitRequest(batch, edll::commandCodeOf(items[i]), itemBytes, response)) {
+				for (size_t j = 0; j < i; j++) {
+					admissionControl.refund(sessionId, edll::commandCodeOf(items[j]), itemBytes);
+				}
+				return false;
+			}
+			serviceMetrics.count(ServiceMetrics::CodeCounter::MSG_IN, edll::commandCodeOf(items[i]));
+		}
+
+		batch[taskKeys::ClientIp::VALUE] = clientIP;
+		batch[taskKeys::SessionId::VALUE] = sessionId;
+		batch[taskKeys::CommandCode::VALUE] = edll::BatchCode::VALUE;
+		batch[taskKeys::CommandName::VALUE] = edll::BatchCode::NAME;
+
+		long long enqueueNs = edll::traceNow();
+		batch[edll::TRACE_KEY] = json::array({ recvNs, enqueueNs });
+		latencyTracer.record(edll::BatchCode::VALUE, edll::Stage::RECV_TO_ENQUEUE, recvNs, enqueueNs);
+
+		json itemIds = request.pushBatch(batch, logSource);
+
+		loggerPtr->debug(logSource + " received batch " + batch.value(idStr, json()).dump() + " from client with IDs: " + itemIds.dump());
+
+		json ackObj;
+		ackObj[service::Msg::Ack::VALUE] = std::move(itemIds);
+		response.push(ackObj, logSource, true);
+		return true;
+	}
+
 	// ----------------------------------------------------------------------
 	/** @brief Wait and establish connection to a single client.
 	 *
@@ -444,6 +1102,8 @@ public:
 	 * ACK will contain the message ID if available, NACK will contain the length of the invalid message.
 	 * If no message ID is provided by the client, a sequential number will be generated and returned in the ACK message.
 	 * The client provided or generated message ID will be used to track responses from the DLL back to the client.
+	 * An array of commands, or an object with commands under the batch key, is enqueued as a single batch.
+	 * Frames are scanned before parsing, and commands with a missing or unknown code are rejected with a NACK without being parsed.
 	 *
 	 * @param request: Thread-safe message queue containing messages to be sent to the DLL
 	 * @param response: Thread-safe message queue containing messages to be sent to the client
@@ -465,6 +1125,9 @@ public:
 
 		int iResult = 0;
 
+		// Trace timestamp of the first data received for the message being processed
+		long long recvNs = 0;
+
 		loggerPtr->debug(logSource + " is waiting for messages from " + clientIP);
 
 		while (interruptionCode == edll::Code::RUNNING) {
@@ -474,51 +1137,100 @@ public:
 
 			if (bytesRead > 0) {
 
-				bool dataToProcess = true;
-
-				json jsonObj = json::parse(buffer, nullptr, false);
+				if (accumulatedData.empty()) {
+					recvNs = edll::traceNow();
+				}
 
-				
-				if (jsonObj == json::value_t::discarded) {
-					accumulatedData.append(buffer.data(), bytesRead);
+				// Scan only the bytes received. A complete frame discards previously accumulated data.
+				std::string_view frame(buffer.data(), static_cast<size_t>(bytesRead));
+				std::string accumulatedFrame;
+				edll::FrameScan scan;
 
-					jsonObj = json::parse(accumulatedData, nullptr, false);
+				if (!edll::scanFrame(frame, idStr, scan)) {
+					accumulatedData.append(frame.data(), frame.size());
 
-					if (jsonObj == json::value_t::discarded) {
+					if (!edll::scanFrame(accumulatedData, idStr, scan)) {
 						loggerPtr->debug(logSource + " accumulated data. So far: " + accumulatedData);
 						bufferTTL--;
-						dataToProcess = false;
 
 						json nackObj;
 						nackObj[service::Msg::Nack::VALUE] = std::to_string(accumulatedData.length());
 						response.push(nackObj, logSource, true);
+						serviceMetrics.countNack();
+						continue;
 					}
+					accumulatedFrame = std::move(accumulatedData);
+					frame = accumulatedFrame;
 				}
+				accumulatedData.clear();
+				bufferTTL = bufferTTLInit;
 
-				if (dataToProcess) {
-					bufferTTL = bufferTTLInit;
-					accumulatedData.clear();
+				size_t messageBytes = frame.size();
+				bool isBatch = scan.isArray || scan.hasBatch;
+				long long code = isBatch ? edll::BatchCode::VALUE : scan.code;
+				serviceMetrics.count(ServiceMetrics::CodeCounter::MSG_IN, code);
+				serviceMetrics.count(ServiceMetrics::CodeCounter::BYTES_IN, code, messageBytes);
+
+				if (!isBatch && !(scan.hasCode && edll::knownCommandCode(code))) {
+					rejectCommand(scan, response);
+					continue;
+				}
 
-					// add client id and queue id to object
-					jsonObj[taskKeys::ClientIp::VALUE] = clientIP;
+				json jsonObj = json::parse(frame.begin(), frame.end(), nullptr, false);
+				if (jsonObj.is_discarded()) {
+					loggerPtr->debug(logSource + " discarded invalid JSON: " + std::string(frame));
 
-					if (jsonObj.contains(idStr)) {
-						jsonObj[taskKeys::QueueId::VALUE] = request.push(jsonObj, logSource, false);
-					}
-					else
-					{
-						jsonObj[idStr] = request.push(jsonObj, logSource, true);
+					json nackObj;
+					nackObj[service::Msg::Nack::VALUE] = std::to_string(messageBytes);
+					response.push(nackObj, logSource, true);
+					serviceMetrics.countNack();
+					continue;
+				}
 
-						// add the queue id to the message for debug/tracking purposes
-						jsonObj[taskKeys::QueueId::VALUE] = jsonObj[idStr];
-					}
-						
-					loggerPtr->debug(logSource + " received message from client: " + jsonObj.dump());
+				if (handleServiceCommand(jsonObj, response)) {
+					continue;
+				}
 
-					json ackObj;
-					ackObj[service::Msg::Ack::VALUE] = jsonObj[idStr];
-					response.push(ackObj, logSource, true);
+				if (isBatch) {
+					enqueueBatch(jsonObj, messageBytes, recvNs, request, response);
+					continue;
+				}
+
+				if (!admitRequest(jsonObj, code, messageBytes, response)) {
+					continue;
 				}
+
+				// add client id, session id, deadline and queue id to object
+				jsonObj[taskKeys::ClientIp::VALUE] = clientIP;
+				jsonObj[taskKeys::SessionId::VALUE] = sessionId;
+
+				long long deadlineNs = deadlinePolicy.resolve(jsonObj, code, recvNs);
+				if (deadlineNs != 0) {
+					jsonObj[edll::DEADLINE_KEY] = deadlineNs;
+				}
+
+				long long enqueueNs = edll::traceNow();
+				jsonObj[edll::TRACE_KEY] = json::array({ recvNs, enqueueNs });
+				latencyTracer.record(code, edll::Stage::RECV_TO_ENQUEUE, recvNs, enqueueNs);
+
+				// The request is moved into the queue, which sets the queue id and, if missing, the client id
+				json clientId;
+				if (jsonObj.contains(idStr)) {
+					clientId = jsonObj[idStr];
+					request.push(std::move(jsonObj), logSource, false);
+				}
+				else
+				{
+					clientId = request.push(std::move(jsonObj), logSource, true);
+				}
+
+				if (loggerPtr->should_log(spdlog::level::debug)) {
+					loggerPtr->debug(logSource + " received message " + clientId.dump() + " from client: " + std::string(frame));
+				}
+
+				json ackObj;
+				ackObj[service::Msg::Ack::VALUE] = std::move(clientId);
+				response.push(ackObj, logSource, true);
 			}
 			else {
 				int error = WSAGetLastError();
@@ -553,6 +1265,9 @@ public:
 	 *
 	 * This function will lock the thread. Must be run in a separate thread.
 	 * Messages are expected to be in JSON format and end with the defined message end sequence.
+	 * Messages tagged with a session ID from another client session are discarded.
+	 * Trace timestamps are removed from the message and used to record the response latency.
+	 * JSON text written by the response converters under the body key is merged with the remaining keys of the message.
 	 * If no data is available to send, a PING message will be sent periodically to check if the connection is still alive.
 	 * PING message will contain the current timestamp in milliseconds since epoch.
 	 *
@@ -573,18 +1288,64 @@ public:
 		{
 			json oneResponse = response.waitAndPop(interruptionCode, logSource);
 
-			std::string message = oneResponse.dump() + msgEndStr;
+			if (oneResponse.contains(taskKeys::SessionId::VALUE) &&
+				oneResponse[taskKeys::SessionId::VALUE] != sessionId) {
+				loggerPtr->debug(logSource + " discarded message from session " + oneResponse[taskKeys::SessionId::VALUE].dump());
+				continue;
+			}
+
+			long long poppedNs = edll::traceNow();
+			json trace;
+			auto traceIt = oneResponse.find(edll::TRACE_KEY);
+			if (traceIt != oneResponse.end()) {
+				trace = std::move(*traceIt);
+				oneResponse.erase(traceIt);
+			}
+			oneResponse.erase(edll::DEADLINE_KEY);
+
+			std::string message;
+			auto bodyIt = oneResponse.find(edll::BODY_KEY);
+			if (bodyIt != oneResponse.end()) {
+				std::string body = std::move(bodyIt->get_ref<std::string&>());
+				oneResponse.erase(bodyIt);
+				std::string_view collision = edll::mergeBody(body, oneResponse, message);
+				if (!collision.empty()) {
+					// The body would duplicate a key of the message. The client still receives the message keys, without the body.
+					loggerPtr->error(logSource + " discarded response body with duplicated key " + std::string(collision));
+					message = oneResponse.dump();
+				}
+			}
+			else {
+				message = oneResponse.dump();
+			}
+			message += msgEndStr;
 
 			iResult = send(clientSocket, message.c_str(), static_cast<int>(message.length()), 0);
 			if (iResult == SOCKET_ERROR) {
 				loggerPtr->warn(logSource + "data send failed. EC:" + std::to_string(WSAGetLastError()));
 			}
 			else {
-				loggerPtr->debug(logSource + " sent message to client: " + message);
+				if (loggerPtr->should_log(spdlog::level::debug)) {
+					loggerPtr->debug(logSource + " sent message to client: " + message);
+				}
 
 				// reset message timer to avoid unnecessary pings if communication is active
 				lastClientMsgTime = std::chrono::steady_clock::now();
+
+				long long code = edll::commandCodeOf(oneResponse);
+				serviceMetrics.count(ServiceMetrics::CodeCounter::MSG_OUT, code);
+				serviceMetrics.count(ServiceMetrics::CodeCounter::BYTES_OUT, code, static_cast<unsigned long long>(iResult));
+
+				if (!trace.is_null()) {
+					long long sentNs = edll::traceNow();
+					latencyTracer.record(code, edll::Stage::RESPONSE_QUEUE, edll::traceAt(trace, edll::ResponseTrace::CONVERTED), poppedNs);
+					latencyTracer.record(code, edll::Stage::SEND, poppedNs, sentNs);
+					latencyTracer.record(code, edll::Stage::RESPONSE_TOTAL, edll::traceAt(trace, edll::ResponseTrace::CALLBACK), sentNs);
+					latencyTracer.record(code, edll::Stage::END_TO_END, edll::traceAt(trace, edll::ResponseTrace::REQUEST_RECV), sentNs);
+				}
 			}
+
+			latencyTracer.logReportIfDue();
 		}
 	}
 
@@ -661,6 +1422,16 @@ public:
 		return clientIP;
 	}
 
+	// ----------------------------------------------------------------------
+	/** @brief Getter for client session ID
+	 * @param None
+	 * @return unsigned long: Session ID assigned to this connection
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	unsigned long getSessionId() const {
+		return sessionId;
+	}
+
 	// ----------------------------------------------------------------------
 	/** @brief Close the client connection
 	 * @param None
@@ -687,4 +1458,156 @@ public:
 			closesocket(clientSocket);
 		}
 	}
-};
\ No newline at end of file
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief HTTP listener serving the service metrics in Prometheus text format
+ *
+ * Answers GET /metrics requests, one connection at a time, closing the connection after each response.
+ * The listener is disabled if the configured port is zero.
+ *
+ * @param config: JSON object containing configuration parameters
+ * @param interruptionCode: Signal interruption for service interruption
+ * @throws NO EXCEPTION HANDLING
+ **/
+class MetricsServer {
+private:
+	int port = service::MetricsPort::VALUE;
+	edll::INT_CODE& interruptionCode;
+
+	// ----------------------------------------------------------------------
+	/** @brief Create the listening socket
+	 *
+	 * @param None
+	 * @return SOCKET: Listening socket, or INVALID_SOCKET in case of error
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	SOCKET createListenSocket() {
+		struct addrinfo* result = nullptr;
+		struct addrinfo hints;
+
+		ZeroMemory(&hints, sizeof(hints));
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_protocol = IPPROTO_TCP;
+		hints.ai_flags = AI_PASSIVE;
+
+		std::string portStr = std::to_string(port);
+		int iResult = getaddrinfo(NULL, portStr.c_str(), &hints, &result);
+		if (iResult != 0) {
+			loggerPtr->error("Metrics socket getaddrinfo failed. EC:" + std::to_string(iResult));
+			return INVALID_SOCKET;
+		}
+
+		SOCKET listenSocket = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+		if (listenSocket == INVALID_SOCKET) {
+			loggerPtr->error("Metrics socket creation failed. EC:" + std::to_string(WSAGetLastError()));
+			freeaddrinfo(result);
+			return INVALID_SOCKET;
+		}
+
+		iResult = ::bind(listenSocket, result->ai_addr, static_cast<int>(result->ai_addrlen));
+		freeaddrinfo(result);
+		if (iResult == SOCKET_ERROR) {
+			loggerPtr->error("Metrics socket bind failed. EC:" + std::to_string(WSAGetLastError()));
+			closesocket(listenSocket);
+			return INVALID_SOCKET;
+		}
+
+		if (listen(listenSocket, SOMAXCONN) == SOCKET_ERROR) {
+			loggerPtr->error("Metrics socket listen failed. EC:" + std::to_string(WSAGetLastError()));
+			closesocket(listenSocket);
+			return INVALID_SOCKET;
+		}
+
+		loggerPtr->info("Serving metrics on port " + portStr);
+		return listenSocket;
+	}
+
+public:
+	MetricsServer(json config, edll::INT_CODE& interruptionCode)
+		: interruptionCode(interruptionCode)
+	{
+		port = config[service::KEY].value(service::MetricsPort::KEY, service::MetricsPort::VALUE);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Serve metrics requests until service interruption
+	 *
+	 * This function will lock the thread. Must be run in a separate thread.
+	 *
+	 * @param request: Thread-safe message queue containing messages to be sent to the DLL
+	 * @param response: Thread-safe message queue containing messages to be sent to the client
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void run(MessageQueue& request, MessageQueue& response) {
+		const std::string logSource = "MetricsServer";
+
+		if (port == 0) {
+			return;
+		}
+
+		SOCKET listenSocket = createListenSocket();
+		if (listenSocket == INVALID_SOCKET) {
+			return;
+		}
+
+		while (interruptionCode == edll::Code::RUNNING) {
+
+			// wait for connections with timeout, to check for service interruption
+			fd_set readSet;
+			FD_ZERO(&readSet);
+			FD_SET(listenSocket, &readSet);
+			timeval timeout = { 1, 0 };
+
+			int ready = select(0, &readSet, nullptr, nullptr, &timeout);
+			if (ready == SOCKET_ERROR) {
+				loggerPtr->error(logSource + " select failed. EC:" + std::to_string(WSAGetLastError()));
+				break;
+			}
+			if (ready == 0) {
+				continue;
+			}
+
+			SOCKET metricsSocket = accept(listenSocket, nullptr, nullptr);
+			if (metricsSocket == INVALID_SOCKET) {
+				continue;
+			}
+
+			int recvTimeout = 1000;
+			setsockopt(metricsSocket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&recvTimeout, sizeof(recvTimeout));
+
+			char buffer[1024];
+			int bytesRead = recv(metricsSocket, buffer, sizeof(buffer), 0);
+			std::string httpRequest(buffer, bytesRead > 0 ? bytesRead : 0);
+
+			std::string status = "404 Not Found";
+			std::string body = "Not Found\n";
+			if (httpRequest.rfind("GET /metrics", 0) == 0) {
+				status = "200 OK";
+				body = serviceMetrics.render({ request.getGauge("request"), response.getGauge("response") }, latencyTracer);
+			}
+
+			std::string message = "HTTP/1.1 " + status + "\r\n"
+				"Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+				"Content-Length: " + std::to_string(body.length()) + "\r\n"
+				"Connection: close\r\n\r\n" + body;
+
+			size_t sent = 0;
+			while (sent < message.length()) {
+				int iResult = send(metricsSocket, message.c_str() + sent, static_cast<int>(message.length() - sent), 0);
+				if (iResult == SOCKET_ERROR) {
+					loggerPtr->warn(logSource + " data send failed. EC:" + std::to_string(WSAGetLastError()));
+					break;
+				}
+				sent += iResult;
+			}
+
+			closesocket(metricsSocket);
+		}
+
+		closesocket(listenSocket);
+	}
+};
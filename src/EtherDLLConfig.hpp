@@ -70,6 +70,24 @@ namespace edll {
 	constexpr double GHZ_MIN_VALUE = 1000.0;
 	constexpr double GHZ_FROM_MHZ = 0.001;
 
+	// Command codes handled by the service itself, without calling the DLL
+	struct ServiceCode {
+		static constexpr int LATENCY_REPORT = 9001;
+
+		static constexpr const char* toString(long long code) {
+			switch (code) {
+				case LATENCY_REPORT: return "LatencyReport";
+				default: return nullptr;
+			}
+		}
+	};
+
+	// Command code and name used in the aggregated response to a batch of commands
+	struct BatchCode {
+		static constexpr int VALUE = 9002;
+		static constexpr const char* NAME = "Batch";
+	};
+
 	// JSON elements
 	constexpr const char* JSON_START = "{\"";
 	constexpr const char* JSON_MID = "\":";
@@ -147,6 +165,48 @@ namespace edll {
 				static constexpr const char* KEY = "demoMode";
 				static constexpr bool VALUE = false;
 			};
+			struct RequestTTL {
+				static constexpr const char* KEY = "requestTTLS";
+				static constexpr int VALUE = 600;
+			};
+			struct LatencyReport {
+				static constexpr const char* KEY = "latencyReportPeriodS";
+				static constexpr int VALUE = 300;
+			};
+			struct MetricsPort {
+				static constexpr const char* KEY = "metricsPort";
+				static constexpr int VALUE = 0;
+			};
+			struct RequestDeadline {
+				static constexpr const char* KEY = "requestDeadlineMs";
+			};
+			struct RateLimit {
+				static constexpr const char* KEY = "rateLimit";
+
+				struct RequestsPerS {
+					static constexpr const char* KEY = "requestsPerS";
+					static constexpr double VALUE = 0.0;
+				};
+				struct RequestBurst {
+					static constexpr const char* KEY = "requestBurst";
+					static constexpr double VALUE = 0.0;
+				};
+				struct BytesPerS {
+					static constexpr const char* KEY = "bytesPerS";
+					static constexpr double VALUE = 0.0;
+				};
+				struct ByteBurst {
+					static constexpr const char* KEY = "byteBurst";
+					static constexpr double VALUE = 0.0;
+				};
+				struct MaxInFlight {
+					static constexpr const char* KEY = "maxInFlight";
+					static constexpr int VALUE = 0;
+				};
+				struct Commands {
+					static constexpr const char* KEY = "commands";
+				};
+			};
 			struct Msg {
 				static constexpr const char* KEY = "msgKeys";
 
@@ -185,6 +245,11 @@ namespace edll {
 					static constexpr const char* VALUE = "SID";
 					static constexpr int INIT_VALUE = 0;
 				};
+				struct SessionId {
+					static constexpr const char* KEY = "sessionId";
+					static constexpr const char* VALUE = "SSN";
+					static constexpr int INIT_VALUE = 0;
+				};
 				struct ClientIp {
 					static constexpr const char* KEY = "clientIP";
 					static constexpr const char* VALUE = "REQUEST_SOURCE";
@@ -210,6 +275,31 @@ namespace edll {
 					static constexpr const char* VALUE = "MSG";
 					static constexpr const char* INIT_VALUE = "No message";
 				};
+				struct RetryAfter {
+					static constexpr const char* KEY = "retryAfter";
+					static constexpr const char* VALUE = "RETRY_AFTER_MS";
+					static constexpr int INIT_VALUE = 0;
+				};
+				struct Deadline {
+					static constexpr const char* KEY = "deadline";
+					static constexpr const char* VALUE = "DEADLINE";
+					static constexpr int INIT_VALUE = 0;
+				};
+				struct DeadlineMs {
+					static constexpr const char* KEY = "deadlineMs";
+					static constexpr const char* VALUE = "DEADLINE_MS";
+					static constexpr int INIT_VALUE = 0;
+				};
+				struct Batch {
+					static constexpr const char* KEY = "batch";
+					static constexpr const char* VALUE = "BATCH";
+					static inline const json INIT_VALUE = json::array();
+				};
+				struct Results {
+					static constexpr const char* KEY = "results";
+					static constexpr const char* VALUE = "RESULTS";
+					static constexpr bool INIT_VALUE = false;
+				};
 			};
 		};
 	};
@@ -236,6 +326,16 @@ json buildCoreDefaultConfigJson(json default_config = json::object()) {
 	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::PingPeriod::KEY] = edll::DefaultConfig::Service::PingPeriod::VALUE;
 	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::PingEnable::KEY] = edll::DefaultConfig::Service::PingEnable::VALUE;
 	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::DemoMode::KEY] = edll::DefaultConfig::Service::DemoMode::VALUE;
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::RequestTTL::KEY] = edll::DefaultConfig::Service::RequestTTL::VALUE;
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::LatencyReport::KEY] = edll::DefaultConfig::Service::LatencyReport::VALUE;
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::MetricsPort::KEY] = edll::DefaultConfig::Service::MetricsPort::VALUE;
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::RequestDeadline::KEY] = json::object();
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::RateLimit::KEY][edll::DefaultConfig::Service::RateLimit::RequestsPerS::KEY] = edll::DefaultConfig::Service::RateLimit::RequestsPerS::VALUE;
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::RateLimit::KEY][edll::DefaultConfig::Service::RateLimit::RequestBurst::KEY] = edll::DefaultConfig::Service::RateLimit::RequestBurst::VALUE;
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::RateLimit::KEY][edll::DefaultConfig::Service::RateLimit::BytesPerS::KEY] = edll::DefaultConfig::Service::RateLimit::BytesPerS::VALUE;
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::RateLimit::KEY][edll::DefaultConfig::Service::RateLimit::ByteBurst::KEY] = edll::DefaultConfig::Service::RateLimit::ByteBurst::VALUE;
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::RateLimit::KEY][edll::DefaultConfig::Service::RateLimit::MaxInFlight::KEY] = edll::DefaultConfig::Service::RateLimit::MaxInFlight::VALUE;
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::RateLimit::KEY][edll::DefaultConfig::Service::RateLimit::Commands::KEY] = json::object();
 	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::Msg::KEY][edll::DefaultConfig::Service::Msg::End::KEY] = edll::DefaultConfig::Service::Msg::End::VALUE;
 	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::Msg::KEY][edll::DefaultConfig::Service::Msg::Ping::KEY] = edll::DefaultConfig::Service::Msg::Ping::VALUE;
 	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::Msg::KEY][edll::DefaultConfig::Service::Msg::Ack::KEY] = edll::DefaultConfig::Service::Msg::Ack::VALUE;
@@ -243,11 +343,17 @@ json buildCoreDefaultConfigJson(json default_config = json::object()) {
 	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::TaskKeys::KEY][edll::DefaultConfig::Service::TaskKeys::ClientId::KEY] = edll::DefaultConfig::Service::TaskKeys::ClientId::VALUE;
 	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::TaskKeys::KEY][edll::DefaultConfig::Service::TaskKeys::QueueId::KEY] = edll::DefaultConfig::Service::TaskKeys::QueueId::VALUE;
 	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::TaskKeys::KEY][edll::DefaultConfig::Service::TaskKeys::DLLId::KEY] = edll::DefaultConfig::Service::TaskKeys::DLLId::VALUE;
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::TaskKeys::KEY][edll::DefaultConfig::Service::TaskKeys::SessionId::KEY] = edll::DefaultConfig::Service::TaskKeys::SessionId::VALUE;
 	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::TaskKeys::KEY][edll::DefaultConfig::Service::TaskKeys::ClientIp::KEY] = edll::DefaultConfig::Service::TaskKeys::ClientIp::VALUE;
 	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::TaskKeys::KEY][edll::DefaultConfig::Service::TaskKeys::CommandCode::KEY] = edll::DefaultConfig::Service::TaskKeys::CommandCode::VALUE;
 	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::TaskKeys::KEY][edll::DefaultConfig::Service::TaskKeys::CommandName::KEY] = edll::DefaultConfig::Service::TaskKeys::CommandName::VALUE;
 	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::TaskKeys::KEY][edll::DefaultConfig::Service::TaskKeys::Arguments::KEY] = edll::DefaultConfig::Service::TaskKeys::Arguments::VALUE;
 	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::TaskKeys::KEY][edll::DefaultConfig::Service::TaskKeys::Message::KEY] = edll::DefaultConfig::Service::TaskKeys::Message::VALUE;
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::TaskKeys::KEY][edll::DefaultConfig::Service::TaskKeys::RetryAfter::KEY] = edll::DefaultConfig::Service::TaskKeys::RetryAfter::VALUE;
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::TaskKeys::KEY][edll::DefaultConfig::Service::TaskKeys::Deadline::KEY] = edll::DefaultConfig::Service::TaskKeys::Deadline::VALUE;
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::TaskKeys::KEY][edll::DefaultConfig::Service::TaskKeys::DeadlineMs::KEY] = edll::DefaultConfig::Service::TaskKeys::DeadlineMs::VALUE;
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::TaskKeys::KEY][edll::DefaultConfig::Service::TaskKeys::Batch::KEY] = edll::DefaultConfig::Service::TaskKeys::Batch::VALUE;
+	default_config[edll::DefaultConfig::Service::KEY][edll::DefaultConfig::Service::TaskKeys::KEY][edll::DefaultConfig::Service::TaskKeys::Results::KEY] = edll::DefaultConfig::Service::TaskKeys::Results::VALUE;
 
 	return default_config;
 }
@@ -305,6 +411,37 @@ bool testLogConfig(json config) {
 	}
 }
 
+// ----------------------------------------------------------------------
+/** @brief Test rate limit parameters for the session or for a command code
+ * @param limits: JSON object with the rate limit keys
+ * @param scope: Description of the limits scope, used in the log messages
+ * @return bool, True if all parameters are valid, false otherwise
+ * @throws NO EXCEPTION HANDLING
+**/
+bool validRateLimitParams(const json& limits, const std::string& scope) {
+
+	using rateLimit = edll::DefaultConfig::Service::RateLimit;
+
+	if (!limits.is_object()) {
+		loggerPtr->error("Invalid rate_limit for " + scope + " in configuration. Expected object. Received: " + limits.dump());
+		return false;
+	}
+
+	bool test_result = true;
+	std::vector<std::string> numericKeys = { rateLimit::RequestsPerS::KEY,
+												rateLimit::RequestBurst::KEY,
+												rateLimit::BytesPerS::KEY,
+												rateLimit::ByteBurst::KEY,
+												rateLimit::MaxInFlight::KEY };
+	for (const auto& key : numericKeys) {
+		if (limits.contains(key) && (!limits[key].is_number() || limits[key].get<double>() < 0)) {
+			loggerPtr->error("Invalid rate_limit '" + key + "' for " + scope + " in configuration. Expected 0 or greater. Received: " + limits[key].dump());
+			test_result = false;
+		}
+	}
+	return test_result;
+}
+
 // ----------------------------------------------------------------------
 /** @brief Test all service configuration parameters are correctly defined
  * @param None
@@ -330,6 +467,11 @@ bool validServiceParams(json config) {
 		loggerPtr->error("Invalid port number in configuration. Expected between 1 and 65535. Received: " + std::to_string(port));
 		test_result = false;
 	}
+	int metricsPort = service_config.value(service::MetricsPort::KEY, service::MetricsPort::VALUE);
+	if (metricsPort < 0 || metricsPort > 65535 || (metricsPort != 0 && metricsPort == port)) {
+		loggerPtr->error("Invalid metrics port number in configuration. Expected 0 (disabled) or between 1 and 65535, different from the service port. Received: " + std::to_string(metricsPort));
+		test_result = false;
+	}
 	int BufferSize = service_config.value(service::BufferSize::KEY, -1);
 	if (BufferSize < 1 || BufferSize > service::BufferSize::MAX_VALUE) {
 		loggerPtr->error("Invalid buffer size in configuration. Expected between 1 and " + std::to_string(service::BufferSize::MAX_VALUE) + ". Received: " + std::to_string(BufferSize));
@@ -355,6 +497,52 @@ bool validServiceParams(json config) {
 		loggerPtr->error("Invalid ping_period value in configuration. Expected 0 or greater. Received: " + std::to_string(pingPeriod));
 		test_result = false;
 	}
+	int requestTTL = service_config.value(service::RequestTTL::KEY, service::RequestTTL::VALUE);
+	if (requestTTL < 1) {
+		loggerPtr->error("Invalid request_ttl value in configuration. Expected greater than 0. Received: " + std::to_string(requestTTL));
+		test_result = false;
+	}
+	int latencyReport = service_config.value(service::LatencyReport::KEY, service::LatencyReport::VALUE);
+	if (latencyReport < 0) {
+		loggerPtr->error("Invalid latency_report_period value in configuration. Expected 0 or greater. Received: " + std::to_string(latencyReport));
+		test_result = false;
+	}
+	json requestDeadline = service_config.value(service::RequestDeadline::KEY, json::object());
+	if (!requestDeadline.is_object()) {
+		loggerPtr->error("Invalid request_deadline in configuration. Expected object with command codes as keys. Received: " + requestDeadline.dump());
+		test_result = false;
+		requestDeadline = json::object();
+	}
+	for (const auto& [codeStr, deadline] : requestDeadline.items()) {
+		if (codeStr.empty() || codeStr.find_first_not_of("0123456789") != std::string::npos) {
+			loggerPtr->error("Invalid command code in request_deadline configuration. Expected integer. Received: " + codeStr);
+			test_result = false;
+		}
+		else if (!deadline.is_number_integer() || deadline.get<long long>() < 0) {
+			loggerPtr->error("Invalid request_deadline for command " + codeStr + " in configuration. Expected 0 or greater. Received: " + deadline.dump());
+			test_result = false;
+		}
+	}
+	if (service_config.contains(service::RateLimit::KEY)) {
+		if (!validRateLimitParams(service_config[service::RateLimit::KEY], "service")) {
+			test_result = false;
+		}
+		json commands = service_config[service::RateLimit::KEY].value(service::RateLimit::Commands::KEY, json::object());
+		if (!commands.is_object()) {
+			loggerPtr->error("Invalid rate_limit commands in configuration. Expected object with command codes as keys. Received: " + commands.dump());
+			test_result = false;
+			commands = json::object();
+		}
+		for (const auto& [codeStr, limits] : commands.items()) {
+			if (codeStr.empty() || codeStr.find_first_not_of("0123456789") != std::string::npos) {
+				loggerPtr->error("Invalid command code in rate_limit configuration. Expected integer. Received: " + codeStr);
+				test_result = false;
+			}
+			else if (!validRateLimitParams(limits, "command " + codeStr)) {
+				test_result = false;
+			}
+		}
+	}
 	if (service_config.contains(service::PingEnable::KEY)) {
 		if (!service_config[service::PingEnable::KEY].is_boolean()) {
 			loggerPtr->error("Invalid ping_enable value in configuration. Expected boolean type. Received: " +
@@ -0,0 +1,146 @@
+/**
+* @file EtherDLLDeadline.hpp
+*
+* @brief Header file for request deadlines
+*
+* Clients may define a deadline for each request, relative to its reception or as an absolute time.
+* Requests without a deadline may receive a default deadline defined for its command code.
+* Deadlines are converted to the trace clock when the request is received, so later checks do not depend on the system clock.
+*
+* * @author fslobao
+* * @date 2025-10-23
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+// ----------------------------------------------------------------------
+#pragma once
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+#include "EtherDLLTrace.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+// Include general C++ libraries
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+
+// For convenience
+using json = nlohmann::json;
+
+// Global variables
+extern spdlog::logger* loggerPtr;
+
+// ----------------------------------------------------------------------
+namespace edll {
+
+	// Key used to carry the request deadline, in trace clock nanoseconds, from the receive thread to the request thread
+	constexpr const char* DEADLINE_KEY = "DEADLINE_NS";
+}
+
+
+// ----------------------------------------------------------------------
+/** @brief Resolve the deadline of each request from the client keys or the command code default
+ *
+ * A relative deadline in milliseconds takes precedence over an absolute deadline in milliseconds since epoch.
+ * Deadlines are limited to MAX_DEADLINE_MS before or after the reception, so the conversion to nanoseconds never overflows.
+ * Default deadlines are set once at startup, before the client threads start, and are read only afterwards.
+**/
+class DeadlinePolicy {
+private:
+	// Longest deadline, about one week, far beyond any request TTL
+	static constexpr long long MAX_DEADLINE_MS = 604800000LL;
+
+	std::unordered_map<long long, long long> defaultMs;
+
+	// ----------------------------------------------------------------------
+	/** @brief Limit a deadline in milliseconds, relative to the reception, to the accepted range
+	 *
+	 * @param ms: Deadline in milliseconds, as a JSON number of any type
+	 * @return long long: Deadline between -MAX_DEADLINE_MS and MAX_DEADLINE_MS
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static long long boundedMs(double ms) {
+		return static_cast<long long>(std::clamp(ms, -static_cast<double>(MAX_DEADLINE_MS), static_cast<double>(MAX_DEADLINE_MS)));
+	}
+
+public:
+	// ----------------------------------------------------------------------
+	/** @brief Set the default deadlines for each command code
+	 *
+	 * @param deadlineConfig: JSON object with command codes as keys and deadlines in milliseconds as values. Zero disables the default.
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void configure(const json& deadlineConfig) {
+		defaultMs.clear();
+		if (!deadlineConfig.is_object()) {
+			return;
+		}
+		for (const auto& [codeStr, deadline] : deadlineConfig.items()) {
+			if (deadline.is_number() && deadline.get<double>() > 0) {
+				defaultMs[std::stoll(codeStr)] = boundedMs(deadline.get<double>());
+			}
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Compute the deadline of a request received from the client
+	 *
+	 * @param request: Request received from the client
+	 * @param code: Command code of the request
+	 * @param recvNs: Trace timestamp of the reception of the request
+	 * @return long long: Deadline as a trace timestamp, or zero if the request has no deadline
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	long long resolve(const json& request, long long code, long long recvNs) const {
+		using taskKeys = edll::DefaultConfig::Service::TaskKeys;
+
+		auto relativeIt = request.find(taskKeys::DeadlineMs::VALUE);
+		if (relativeIt != request.end() && relativeIt->is_number()) {
+			return recvNs + boundedMs(relativeIt->get<double>()) * 1000000;
+		}
+
+		auto absoluteIt = request.find(taskKeys::Deadline::VALUE);
+		if (absoluteIt != request.end() && absoluteIt->is_number()) {
+			long long nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count();
+			return recvNs + boundedMs(absoluteIt->get<double>() - static_cast<double>(nowMs)) * 1000000;
+		}
+
+		auto defaultIt = defaultMs.find(code);
+		if (defaultIt != defaultMs.end()) {
+			return recvNs + defaultIt->second * 1000000;
+		}
+		return 0;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Test if the deadline carried by a request has passed
+	 *
+	 * @param request: Request with the deadline set by the receive thread
+	 * @param nowNs: Current trace timestamp
+	 * @param lateMs: Time elapsed since the deadline, set only if expired
+	 * @return bool: True if the request has a deadline and it has passed, false otherwise
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static bool expired(const json& request, long long nowNs, long long& lateMs) {
+		auto it = request.find(edll::DEADLINE_KEY);
+		if (it == request.end() || !it->is_number_integer()) {
+			return false;
+		}
+		long long deadlineNs = it->get<long long>();
+		if (nowNs <= deadlineNs) {
+			return false;
+		}
+		lateMs = (nowNs - deadlineNs) / 1000000;
+		return true;
+	}
+};
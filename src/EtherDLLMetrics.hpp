@@ -0,0 +1,335 @@
+/**
+* @file EtherDLLMetrics.hpp
+*
+* @brief Header file for service metrics collection and Prometheus text rendering
+*
+* Counters are kept in blocks owned by each thread, so the hot paths only write to memory not shared with other writers.
+* Blocks are registered once per thread and summed only when the metrics are rendered.
+* Counts from finished threads are folded into a retired block, so session threads do not accumulate blocks.
+*
+* * @author fslobao
+* * @date 2025-10-21
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+*
+**/
+// ----------------------------------------------------------------------
+#pragma once
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+#include "EtherDLLTrace.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+// Include general C++ libraries
+#include <string>
+#include <array>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+
+// For convenience
+using json = nlohmann::json;
+
+// Global variables
+extern spdlog::logger* loggerPtr;
+
+// ----------------------------------------------------------------------
+/** @brief Snapshot of a message queue state, used to render queue gauges
+**/
+struct QueueGauge {
+	std::string name;
+	size_t depth = 0;
+	size_t highWaterMark = 0;
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Service metrics with per-thread counters
+ *
+ * Command codes and DLL error codes are mapped to slots by edll::CodeSlots.
+ * Unregistered codes above its direct range share a single overflow slot, rendered with the label "other".
+ * Descriptions for command codes and DLL error codes may be provided by the DLL specific modules.
+**/
+class ServiceMetrics {
+public:
+	// Counters indexed by command code
+	struct CodeCounter {
+		static constexpr size_t MSG_IN = 0;
+		static constexpr size_t BYTES_IN = 1;
+		static constexpr size_t MSG_OUT = 2;
+		static constexpr size_t BYTES_OUT = 3;
+		static constexpr size_t VALIDATION_FAIL = 4;
+		static constexpr size_t CALLBACK = 5;
+		static constexpr size_t DEADLINE_EXPIRED = 6;
+		static constexpr size_t COUNT = 7;
+	};
+
+private:
+	static constexpr size_t SLOT_COUNT = edll::CodeSlots::COUNT;
+
+	using Counter = std::atomic<unsigned long long>;
+
+	struct CounterBlock {
+		std::array<std::array<Counter, SLOT_COUNT>, CodeCounter::COUNT> codes{};
+		std::array<Counter, SLOT_COUNT> dllErrors{};
+		Counter nacks{ 0 };
+	};
+
+	// Registers the block of the current thread and moves its counts to the retired block when the thread finishes
+	struct ThreadBlock {
+		ServiceMetrics* owner = nullptr;
+		CounterBlock* block = nullptr;
+
+		~ThreadBlock() {
+			if (owner != nullptr) {
+				owner->retire(block);
+			}
+		}
+	};
+
+	std::mutex blocksMtx;
+	std::vector<CounterBlock*> blocks;
+	CounterBlock retired;
+
+	std::atomic<long long> sessions{ 0 };
+
+	std::function<std::string(long long)> commandDescriber;
+	std::function<std::string(long long)> errorDescriber;
+
+	static size_t slotFor(long long code) {
+		return edll::CodeSlots::instance().slotFor(code);
+	}
+
+	// Single writer increment. Readers from other threads may see the previous value, but never a torn one.
+	static void add(Counter& counter, unsigned long long value) {
+		counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	CounterBlock& local() {
+		thread_local ThreadBlock threadBlock;
+		if (threadBlock.block == nullptr) {
+			threadBlock.block = new CounterBlock();
+			threadBlock.owner = this;
+			std::lock_guard<std::mutex> lock(blocksMtx);
+			blocks.push_back(threadBlock.block);
+		}
+		return *threadBlock.block;
+	}
+
+	void retire(CounterBlock* block) {
+		std::lock_guard<std::mutex> lock(blocksMtx);
+		for (size_t c = 0; c < CodeCounter::COUNT; c++) {
+			for (size_t i = 0; i < SLOT_COUNT; i++) {
+				add(retired.codes[c][i], block->codes[c][i].load(std::memory_order_relaxed));
+			}
+		}
+		for (size_t i = 0; i < SLOT_COUNT; i++) {
+			add(retired.dllErrors[i], block->dllErrors[i].load(std::memory_order_relaxed));
+		}
+		add(retired.nacks, block->nacks.load(std::memory_order_relaxed));
+
+		blocks.erase(std::remove(blocks.begin(), blocks.end(), block), blocks.end());
+		delete block;
+	}
+
+	static std::string escapeLabel(const std::string& value) {
+		std::string escaped;
+		escaped.reserve(value.size());
+		for (char c : value) {
+			switch (c) {
+				case '\\': escaped += "\\\\"; break;
+				case '"': escaped += "\\\""; break;
+				case '\n': escaped += "\\n"; break;
+				default: escaped += c; break;
+			}
+		}
+		return escaped;
+	}
+
+	std::string codeLabels(size_t slot, const std::function<std::string(long long)>& describer) const {
+		long long code = 0;
+		bool known = edll::CodeSlots::instance().codeOf(slot, code);
+		std::string labels = "code=\"" + (known ? std::to_string(code) : std::string("other")) + "\"";
+		if (describer && known) {
+			labels += ",description=\"" + escapeLabel(describer(code)) + "\"";
+		}
+		return labels;
+	}
+
+public:
+	~ServiceMetrics() {
+		std::lock_guard<std::mutex> lock(blocksMtx);
+		for (CounterBlock* block : blocks) {
+			delete block;
+		}
+		blocks.clear();
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Define functions used to describe command codes and DLL error codes in the metric labels
+	 *
+	 * @param commandDescriber: Function returning the description of a command or response code
+	 * @param errorDescriber: Function returning the description of a DLL error code
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void setDescribers(std::function<std::string(long long)> commandDescriber, std::function<std::string(long long)> errorDescriber) {
+		std::lock_guard<std::mutex> lock(blocksMtx);
+		this->commandDescriber = commandDescriber;
+		this->errorDescriber = errorDescriber;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Increment a counter associated with a command code
+	 *
+	 * @param counter: Counter to be incremented, see ServiceMetrics::CodeCounter
+	 * @param code: Command or response code
+	 * @param value: Value to be added (default 1)
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void count(size_t counter, long long code, unsigned long long value = 1) {
+		add(local().codes[counter][slotFor(code)], value);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Increment the counter for a DLL error code
+	 *
+	 * @param errorCode: Error code returned by the DLL
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void countDLLError(long long errorCode) {
+		add(local().dllErrors[slotFor(errorCode)], 1);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Increment the counter of NACK messages sent to clients
+	 * @param None
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void countNack() {
+		add(local().nacks, 1);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Update the number of connected client sessions
+	 *
+	 * @param delta: +1 when a session is connected, -1 when disconnected
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void sessionChange(long long delta) {
+		sessions.fetch_add(delta, std::memory_order_relaxed);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Render all metrics in Prometheus text exposition format (version 0.0.4)
+	 *
+	 * @param queues: Current state of the message queues
+	 * @param tracer: Latency histograms to be rendered as summaries
+	 * @return std::string: Metrics in Prometheus text format
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	std::string render(const std::vector<QueueGauge>& queues, const LatencyTracer& tracer) {
+		CounterBlock total;
+		std::function<std::string(long long)> commandNames;
+		std::function<std::string(long long)> errorNames;
+		{
+			std::lock_guard<std::mutex> lock(blocksMtx);
+			std::vector<const CounterBlock*> all(blocks.begin(), blocks.end());
+			all.push_back(&retired);
+			for (const CounterBlock* block : all) {
+				for (size_t c = 0; c < CodeCounter::COUNT; c++) {
+					for (size_t i = 0; i < SLOT_COUNT; i++) {
+						add(total.codes[c][i], block->codes[c][i].load(std::memory_order_relaxed));
+					}
+				}
+				for (size_t i = 0; i < SLOT_COUNT; i++) {
+					add(total.dllErrors[i], block->dllErrors[i].load(std::memory_order_relaxed));
+				}
+				add(total.nacks, block->nacks.load(std::memory_order_relaxed));
+			}
+			commandNames = commandDescriber;
+			errorNames = errorDescriber;
+		}
+
+		std::string out;
+
+		out += "# HELP etherdll_queue_depth Number of messages waiting in the queue\n";
+		out += "# TYPE etherdll_queue_depth gauge\n";
+		for (const QueueGauge& queue : queues) {
+			out += "etherdll_queue_depth{queue=\"" + queue.name + "\"} " + std::to_string(queue.depth) + "\n";
+		}
+		out += "# HELP etherdll_queue_high_water_mark Maximum number of messages waiting in the queue since start\n";
+		out += "# TYPE etherdll_queue_high_water_mark gauge\n";
+		for (const QueueGauge& queue : queues) {
+			out += "etherdll_queue_high_water_mark{queue=\"" + queue.name + "\"} " + std::to_string(queue.highWaterMark) + "\n";
+		}
+
+		out += "# HELP etherdll_sessions_connected Number of connected client sessions\n";
+		out += "# TYPE etherdll_sessions_connected gauge\n";
+		out += "etherdll_sessions_connected " + std::to_string(sessions.load(std::memory_order_relaxed)) + "\n";
+
+		out += "# HELP etherdll_nack_total NACK messages sent to clients\n";
+		out += "# TYPE etherdll_nack_total counter\n";
+		out += "etherdll_nack_total " + std::to_string(total.nacks.load()) + "\n";
+
+		struct CodeMetric {
+			size_t counter;
+			const char* name;
+			const char* help;
+		};
+		const CodeMetric codeMetrics[] = {
+			{ CodeCounter::MSG_IN, "etherdll_messages_in_total", "Messages received from clients by command code" },
+			{ CodeCounter::BYTES_IN, "etherdll_bytes_in_total", "Bytes received from clients by command code" },
+			{ CodeCounter::MSG_OUT, "etherdll_messages_out_total", "Messages sent to clients by command code" },
+			{ CodeCounter::BYTES_OUT, "etherdll_bytes_out_total", "Bytes sent to clients by command code" },
+			{ CodeCounter::VALIDATION_FAIL, "etherdll_validation_failures_total", "Requests rejected by validation by command code" },
+			{ CodeCounter::CALLBACK, "etherdll_callbacks_total", "DLL callbacks received by message type" },
+			{ CodeCounter::DEADLINE_EXPIRED, "etherdll_deadline_expired_total", "Requests dropped after their deadline by command code" },
+		};
+		for (const CodeMetric& metric : codeMetrics) {
+			out += std::string("# HELP ") + metric.name + " " + metric.help + "\n";
+			out += std::string("# TYPE ") + metric.name + " counter\n";
+			for (size_t i = 0; i < SLOT_COUNT; i++) {
+				unsigned long long value = total.codes[metric.counter][i].load();
+				if (value > 0) {
+					out += std::string(metric.name) + "{" + codeLabels(i, commandNames) + "} " + std::to_string(value) + "\n";
+				}
+			}
+		}
+
+		out += "# HELP etherdll_dll_errors_total Error codes returned by DLL function calls\n";
+		out += "# TYPE etherdll_dll_errors_total counter\n";
+		for (size_t i = 0; i < SLOT_COUNT; i++) {
+			unsigned long long value = total.dllErrors[i].load();
+			if (value > 0) {
+				out += "etherdll_dll_errors_total{" + codeLabels(i, errorNames) + "} " + std::to_string(value) + "\n";
+			}
+		}
+
+		out += "# HELP etherdll_latency_seconds Time spent in each processing stage by command code\n";
+		out += "# TYPE etherdll_latency_seconds summary\n";
+		const std::vector<double> quantiles = { 0.5, 0.9, 0.99, 0.999 };
+		tracer.forEach([&out, &quantiles](const std::string& code, const char* stage, const LatencyHistogram& histogram) {
+			std::string labels = "code=\"" + code + "\",stage=\"" + stage + "\"";
+			std::vector<uint64_t> values = histogram.percentiles(quantiles);
+			for (size_t q = 0; q < quantiles.size(); q++) {
+				out += "etherdll_latency_seconds{" + labels + ",quantile=\"" + fmt::format("{}", quantiles[q]) + "\"} " + fmt::format("{}", values[q] / 1e6) + "\n";
+			}
+			out += "etherdll_latency_seconds_sum{" + labels + "} " + fmt::format("{}", histogram.getSum() / 1e6) + "\n";
+			out += "etherdll_latency_seconds_count{" + labels + "} " + std::to_string(histogram.getCount()) + "\n";
+			});
+
+		return out;
+	}
+};
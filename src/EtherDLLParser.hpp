@@ -0,0 +1,202 @@
+/**
+* @file EtherDLLParser.hpp
+*
+* @brief Header file for the on-demand scanner of frames received from the client
+*
+* Frames are scanned once, without building a JSON document, to test if they hold a complete JSON value
+* and to locate the command code, the client ID and the batch key at the top level.
+* Frames with a missing or unknown command code are rejected by the receive thread before the JSON document is built.
+*
+* * @author fslobao
+* * @date 2025-10-25
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+// ----------------------------------------------------------------------
+#pragma once
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+
+// Include general C++ libraries
+#include <string>
+#include <string_view>
+#include <charconv>
+
+// For convenience
+using json = nlohmann::json;
+
+// Test if a command code is handled by the DLL specific modules. Defined in etherDLLRequest.hpp
+bool isKnownCommandCode(long long code);
+
+// ----------------------------------------------------------------------
+namespace edll {
+
+	// ----------------------------------------------------------------------
+	/** @brief Top level keys located by scanFrame. Views refer to the scanned frame.
+	**/
+	struct FrameScan {
+		bool isArray = false;
+		bool hasBatch = false;
+		bool hasCode = false;		// Command code key present with an integer value
+		long long code = DefaultConfig::Service::TaskKeys::CommandCode::INIT_VALUE;
+		std::string_view id;		// Raw text of the client ID value, empty if missing
+	};
+
+	// ----------------------------------------------------------------------
+	/** @brief Scan a frame received from the client without building a JSON document
+	 *
+	 * Strings, escapes and nesting are followed to find the end of the top level object or array.
+	 * Values are not checked, so a frame accepted here may still be rejected by the JSON parser.
+	 *
+	 * @param frame: Data received from the client
+	 * @param idKey: Key used by the client to identify the messages
+	 * @param scan: Keys located in the frame, set only if the frame is complete
+	 * @return bool: True if the frame holds a single complete JSON object or array, surrounded only by whitespace
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	inline bool scanFrame(std::string_view frame, const std::string& idKey, FrameScan& scan) {
+		using taskKeys = DefaultConfig::Service::TaskKeys;
+
+		enum class TopKey { NONE, CODE, ID };
+
+		auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; };
+
+		size_t pos = 0;
+		while (pos < frame.size() && isSpace(frame[pos])) {
+			pos++;
+		}
+		if (pos == frame.size() || (frame[pos] != '{' && frame[pos] != '[')) {
+			return false;
+		}
+
+		FrameScan result;
+		result.isArray = frame[pos] == '[';
+
+		int depth = 0;
+		bool inString = false;
+		bool escaped = false;
+		bool expectKey = false;
+		size_t keyStart = 0;
+		TopKey topKey = TopKey::NONE;
+		size_t valueStart = 0;
+
+		// Store the value of a top level key, ending before the separator at the given position
+		auto closeValue = [&](size_t end) {
+			while (end > valueStart && isSpace(frame[end - 1])) {
+				end--;
+			}
+			std::string_view value = frame.substr(valueStart, end - valueStart);
+			if (topKey == TopKey::CODE) {
+				long long code = 0;
+				auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), code);
+				result.hasCode = ec == std::errc() && ptr == value.data() + value.size() && !value.empty();
+				if (result.hasCode) {
+					result.code = code;
+				}
+			}
+			else if (topKey == TopKey::ID) {
+				result.id = value;
+			}
+			topKey = TopKey::NONE;
+		};
+
+		for (; pos < frame.size(); pos++) {
+			char c = frame[pos];
+
+			if (inString) {
+				if (escaped) {
+					escaped = false;
+				}
+				else if (c == '\\') {
+					escaped = true;
+				}
+				else if (c == '"') {
+					inString = false;
+					if (expectKey) {
+						std::string_view key = frame.substr(keyStart, pos - keyStart);
+						expectKey = false;
+						if (key == taskKeys::CommandCode::VALUE) {
+							topKey = TopKey::CODE;
+						}
+						else if (key == idKey) {
+							topKey = TopKey::ID;
+						}
+						else if (key == taskKeys::Batch::VALUE) {
+							result.hasBatch = true;
+						}
+					}
+				}
+				continue;
+			}
+
+			switch (c) {
+				case '"':
+					inString = true;
+					if (expectKey) {
+						keyStart = pos + 1;
+					}
+					break;
+				case '{':
+				case '[':
+					depth++;
+					expectKey = depth == 1 && c == '{';
+					break;
+				case '}':
+				case ']':
+					if (depth == 1 && topKey != TopKey::NONE) {
+						closeValue(pos);
+					}
+					depth--;
+					if (depth == 0) {
+						for (pos++; pos < frame.size(); pos++) {
+							if (!isSpace(frame[pos])) {
+								return false;
+							}
+						}
+						scan = result;
+						return true;
+					}
+					break;
+				case ':':
+					if (depth == 1 && !result.isArray) {
+						valueStart = pos + 1;
+						while (valueStart < frame.size() && isSpace(frame[valueStart])) {
+							valueStart++;
+						}
+					}
+					break;
+				case ',':
+					if (depth == 1 && !result.isArray) {
+						if (topKey != TopKey::NONE) {
+							closeValue(pos);
+						}
+						expectKey = true;
+					}
+					break;
+				default:
+					break;
+			}
+		}
+
+		// Frame ended before the top level value was closed
+		return false;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Test if a command code may be enqueued, either handled by the service or by the DLL specific modules
+	 *
+	 * @param code: Command code read from the frame
+	 * @return bool: True if the command code is known, false otherwise
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	inline bool knownCommandCode(long long code) {
+		return ServiceCode::toString(code) != nullptr || isKnownCommandCode(code);
+	}
+}
@@ -0,0 +1,493 @@
+/**
+* @file EtherDLLTrace.hpp
+*
+* @brief Header file for end-to-end latency tracing
+*
+* Messages are stamped with a monotonic clock at each processing stage.
+* The time between stages is accumulated in lock-free log-linear histograms, one set for each command code,
+* allowing percentiles to be reported periodically in the log or on demand to the client.
+*
+* * @author fslobao
+* * @date 2025-10-20
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+// ----------------------------------------------------------------------
+#pragma once
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+// Include general C++ libraries
+#include <string>
+#include <array>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// For convenience
+using json = nlohmann::json;
+
+// Global variables
+extern spdlog::logger* loggerPtr;
+
+// ----------------------------------------------------------------------
+namespace edll {
+
+	// Key used to carry the trace timestamps inside queued messages. Removed before sending to the client.
+	constexpr const char* TRACE_KEY = "TRACE";
+
+	// ----------------------------------------------------------------------
+	/** @brief Current value of the monotonic clock used for tracing
+	 *
+	 * @param None
+	 * @return long long: Nanoseconds since an arbitrary epoch
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	inline long long traceNow() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Command code of a message, used to index the latency histograms
+	 *
+	 * @param msg: JSON message
+	 * @return long long: Value of the command code key, or its initial value if missing or not an integer
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	inline long long commandCodeOf(const json& msg) {
+		using CommandCode = DefaultConfig::Service::TaskKeys::CommandCode;
+		auto it = msg.find(CommandCode::VALUE);
+		if (it == msg.end() || !it->is_number_integer()) {
+			return CommandCode::INIT_VALUE;
+		}
+		return it->get<long long>();
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Read a timestamp from a trace array
+	 *
+	 * @param trace: JSON array with timestamps from edll::traceNow()
+	 * @param position: Position of the timestamp in the array
+	 * @return long long: Timestamp, or zero if not available
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	inline long long traceAt(const json& trace, size_t position) {
+		if (!trace.is_array() || position >= trace.size() || !trace[position].is_number_integer()) {
+			return 0;
+		}
+		return trace[position].get<long long>();
+	}
+
+	// Processing stages measured by the tracer
+	struct Stage {
+		static constexpr size_t RECV_TO_ENQUEUE = 0;	// Client data received until request pushed to queue
+		static constexpr size_t REQUEST_QUEUE = 1;		// Request pushed until popped by processRequestQueue
+		static constexpr size_t DLL_CALL = 2;			// Request popped until DLL function return
+		static constexpr size_t REQUEST_TOTAL = 3;		// Client data received until DLL function return
+		static constexpr size_t CONVERSION = 4;			// DLL callback entry until response converted to JSON
+		static constexpr size_t RESPONSE_QUEUE = 5;		// Response converted until popped by DLLResponseToClient
+		static constexpr size_t SEND = 6;				// Response popped until send complete
+		static constexpr size_t RESPONSE_TOTAL = 7;		// DLL callback entry until send complete
+		static constexpr size_t END_TO_END = 8;			// Client data received until first response send complete
+		static constexpr size_t COUNT = 9;
+
+		static constexpr const char* toString(size_t stage) {
+			switch (stage) {
+				case RECV_TO_ENQUEUE: return "recvToEnqueue";
+				case REQUEST_QUEUE: return "requestQueue";
+				case DLL_CALL: return "dllCall";
+				case REQUEST_TOTAL: return "requestTotal";
+				case CONVERSION: return "conversion";
+				case RESPONSE_QUEUE: return "responseQueue";
+				case SEND: return "send";
+				case RESPONSE_TOTAL: return "responseTotal";
+				case END_TO_END: return "endToEnd";
+				default: return "undefined";
+			}
+		}
+	};
+
+	// Position of each timestamp in the request trace array
+	struct RequestTrace {
+		static constexpr size_t RECV = 0;
+		static constexpr size_t ENQUEUE = 1;
+		static constexpr size_t DEQUEUE = 2;
+	};
+
+	// Position of each timestamp in the response trace array
+	struct ResponseTrace {
+		static constexpr size_t CALLBACK = 0;
+		static constexpr size_t CONVERTED = 1;
+		static constexpr size_t REQUEST_RECV = 2;	// Only present in the first response to a request
+	};
+
+	// ----------------------------------------------------------------------
+	/** @brief Lookup table from command, response and error codes to the slots of the counters and histograms
+	 *
+	 * Codes below DIRECT_CODES use their own value as slot. Codes above it, such as the service command codes,
+	 * get one of the EXTRA_CODES slots if registered at startup, before the service threads are started.
+	 * Unregistered codes share the overflow slot, rendered with the label "other".
+	**/
+	class CodeSlots {
+	public:
+		static constexpr long long DIRECT_CODES = 256;
+		static constexpr size_t EXTRA_CODES = 64;
+		static constexpr size_t COUNT = DIRECT_CODES + EXTRA_CODES + 1;
+		static constexpr size_t OVERFLOW_SLOT = COUNT - 1;
+
+	private:
+		std::array<long long, EXTRA_CODES> extraCodes{};
+		std::atomic<size_t> extraCount{ 0 };
+
+		CodeSlots() {
+			add(ServiceCode::LATENCY_REPORT);
+			add(BatchCode::VALUE);
+		}
+
+	public:
+		static CodeSlots& instance() {
+			static CodeSlots table;
+			return table;
+		}
+
+		// ----------------------------------------------------------------------
+		/** @brief Assign a slot to a code above DIRECT_CODES. Not thread-safe, must be called at startup.
+		 *
+		 * @param code: Command, response or error code
+		 * @return bool: True if the code has its own slot, false if the table is full
+		 * @throws NO EXCEPTION HANDLING
+		**/
+		bool add(long long code) {
+			if (slotFor(code) != OVERFLOW_SLOT || (code >= 0 && code < DIRECT_CODES)) {
+				return true;
+			}
+			size_t count = extraCount.load(std::memory_order_relaxed);
+			if (count == EXTRA_CODES) {
+				return false;
+			}
+			extraCodes[count] = code;
+			extraCount.store(count + 1, std::memory_order_release);
+			return true;
+		}
+
+		size_t slotFor(long long code) const {
+			if (code >= 0 && code < DIRECT_CODES) {
+				return static_cast<size_t>(code);
+			}
+			size_t count = extraCount.load(std::memory_order_acquire);
+			for (size_t i = 0; i < count; i++) {
+				if (extraCodes[i] == code) {
+					return static_cast<size_t>(DIRECT_CODES) + i;
+				}
+			}
+			return OVERFLOW_SLOT;
+		}
+
+		// ----------------------------------------------------------------------
+		/** @brief Code assigned to a slot
+		 *
+		 * @param slot: Slot returned by slotFor
+		 * @param code: Code assigned to the slot, set only if the slot is not the overflow slot
+		 * @return bool: True if a code is assigned to the slot, false for the overflow slot
+		 * @throws NO EXCEPTION HANDLING
+		**/
+		bool codeOf(size_t slot, long long& code) const {
+			if (slot < static_cast<size_t>(DIRECT_CODES)) {
+				code = static_cast<long long>(slot);
+				return true;
+			}
+			if (slot - static_cast<size_t>(DIRECT_CODES) < extraCount.load(std::memory_order_acquire)) {
+				code = extraCodes[slot - static_cast<size_t>(DIRECT_CODES)];
+				return true;
+			}
+			return false;
+		}
+
+		std::string label(size_t slot) const {
+			long long code = 0;
+			return codeOf(slot, code) ? std::to_string(code) : "other";
+		}
+	};
+}
+
+// ----------------------------------------------------------------------
+/** @brief Lock-free log-linear latency histogram
+ *
+ * Values are recorded in microseconds. Each power of two is divided in SUB_BUCKETS linear buckets,
+ * giving a relative error below 1/SUB_BUCKETS over the full range, similar to HDR histograms.
+ * Recording uses only relaxed atomic increments and may be called concurrently from any thread.
+**/
+class LatencyHistogram {
+private:
+	static constexpr unsigned SUB_BITS = 4;
+	static constexpr uint64_t SUB_BUCKETS = 1ULL << SUB_BITS;
+	static constexpr unsigned MAX_EXPONENT = 36;
+	static constexpr uint64_t MAX_VALUE = (1ULL << MAX_EXPONENT) - 1;
+	static constexpr size_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BITS + 1) * SUB_BUCKETS;
+
+	std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+	std::atomic<uint64_t> count{ 0 };
+	std::atomic<uint64_t> sum{ 0 };
+	std::atomic<uint64_t> maxRecorded{ 0 };
+
+	static size_t bucketIndex(uint64_t value) {
+		if (value < SUB_BUCKETS) {
+			return static_cast<size_t>(value);
+		}
+		unsigned exponent = SUB_BITS;
+		while ((value >> (exponent + 1)) != 0) {
+			exponent++;
+		}
+		uint64_t sub = (value >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+		return static_cast<size_t>((exponent - SUB_BITS + 1) * SUB_BUCKETS + sub);
+	}
+
+	static uint64_t bucketUpperValue(size_t index) {
+		if (index < SUB_BUCKETS) {
+			return index;
+		}
+		unsigned exponent = static_cast<unsigned>(index / SUB_BUCKETS) + SUB_BITS - 1;
+		uint64_t sub = index % SUB_BUCKETS;
+		return ((SUB_BUCKETS + sub + 1) << (exponent - SUB_BITS)) - 1;
+	}
+
+public:
+	// ----------------------------------------------------------------------
+	/** @brief Record a latency value
+	 *
+	 * @param valueUs: Latency in microseconds. Values above the histogram range are saturated.
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void record(uint64_t valueUs) {
+		if (valueUs > MAX_VALUE) {
+			valueUs = MAX_VALUE;
+		}
+		buckets[bucketIndex(valueUs)].fetch_add(1, std::memory_order_relaxed);
+		count.fetch_add(1, std::memory_order_relaxed);
+		sum.fetch_add(valueUs, std::memory_order_relaxed);
+
+		uint64_t currentMax = maxRecorded.load(std::memory_order_relaxed);
+		while (valueUs > currentMax && !maxRecorded.compare_exchange_weak(currentMax, valueUs, std::memory_order_relaxed)) {
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Get the number of recorded values
+	 * @param None
+	 * @return uint64_t: Number of values recorded
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	uint64_t getCount() const {
+		return count.load(std::memory_order_relaxed);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Get the sum of recorded values
+	 * @param None
+	 * @return uint64_t: Sum of all values recorded, in microseconds
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	uint64_t getSum() const {
+		return sum.load(std::memory_order_relaxed);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Compute the values at the requested quantiles from a snapshot of the buckets
+	 *
+	 * @param quantiles: Quantiles in ascending order, in the range [0, 1]
+	 * @return std::vector<uint64_t>: Upper bound of the bucket holding each quantile, in microseconds
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	std::vector<uint64_t> percentiles(const std::vector<double>& quantiles) const {
+		std::vector<uint64_t> result(quantiles.size(), 0);
+
+		std::array<uint64_t, BUCKET_COUNT> snapshot;
+		uint64_t total = 0;
+		for (size_t i = 0; i < BUCKET_COUNT; i++) {
+			snapshot[i] = buckets[i].load(std::memory_order_relaxed);
+			total += snapshot[i];
+		}
+		if (total == 0) {
+			return result;
+		}
+
+		size_t q = 0;
+		uint64_t accumulated = 0;
+		for (size_t i = 0; i < BUCKET_COUNT && q < quantiles.size(); i++) {
+			accumulated += snapshot[i];
+			while (q < quantiles.size() && accumulated >= static_cast<uint64_t>(quantiles[q] * total + 0.5) && accumulated > 0) {
+				result[q++] = bucketUpperValue(i);
+			}
+		}
+		uint64_t maxValue = maxRecorded.load(std::memory_order_relaxed);
+		for (; q < quantiles.size(); q++) {
+			result[q] = maxValue;
+		}
+		for (uint64_t& value : result) {
+			if (value > maxValue) {
+				value = maxValue;
+			}
+		}
+		return result;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Summary of the histogram as JSON
+	 *
+	 * @param None
+	 * @return json: count, mean, p50, p90, p99, p999 and max values, in milliseconds
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	json toJson() const {
+		json summary;
+		uint64_t n = getCount();
+		std::vector<uint64_t> p = percentiles({ 0.5, 0.9, 0.99, 0.999 });
+
+		summary["count"] = n;
+		summary["meanMs"] = n > 0 ? getSum() / 1000.0 / n : 0.0;
+		summary["p50Ms"] = p[0] / 1000.0;
+		summary["p90Ms"] = p[1] / 1000.0;
+		summary["p99Ms"] = p[2] / 1000.0;
+		summary["p999Ms"] = p[3] / 1000.0;
+		summary["maxMs"] = maxRecorded.load(std::memory_order_relaxed) / 1000.0;
+		return summary;
+	}
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Latency histograms for each processing stage, organized by command code
+ *
+ * Histograms for a command code are allocated on first use and never released.
+ * Command codes are mapped to slots by edll::CodeSlots. Unregistered codes above its direct range share a single overflow slot.
+**/
+class LatencyTracer {
+private:
+	using StageHistograms = std::array<LatencyHistogram, edll::Stage::COUNT>;
+
+	std::array<std::atomic<StageHistograms*>, edll::CodeSlots::COUNT> codes{};
+
+	// Reporting period in milliseconds, zero to disable, and time of the last report
+	std::atomic<long long> reportPeriodNs{ 0 };
+	std::atomic<long long> lastReport{ edll::traceNow() };
+
+	StageHistograms& histogramsFor(long long code) {
+		std::atomic<StageHistograms*>& slot = codes[edll::CodeSlots::instance().slotFor(code)];
+		StageHistograms* histograms = slot.load(std::memory_order_acquire);
+		if (histograms == nullptr) {
+			StageHistograms* created = new StageHistograms();
+			if (slot.compare_exchange_strong(histograms, created, std::memory_order_acq_rel)) {
+				histograms = created;
+			}
+			else {
+				delete created;
+			}
+		}
+		return *histograms;
+	}
+
+public:
+	~LatencyTracer() {
+		for (auto& slot : codes) {
+			delete slot.load();
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Set the period between latency reports in the log
+	 *
+	 * @param periodS: Period in seconds, zero to disable periodic reports
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void setReportPeriod(int periodS) {
+		reportPeriodNs = static_cast<long long>(periodS) * 1000000000LL;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Record the time between two trace timestamps
+	 * Invalid or missing timestamps (zero or negative interval) are ignored.
+	 *
+	 * @param code: Command code associated with the message
+	 * @param stage: Processing stage, see edll::Stage
+	 * @param startNs: Timestamp at the start of the stage, from edll::traceNow()
+	 * @param endNs: Timestamp at the end of the stage, from edll::traceNow()
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void record(long long code, size_t stage, long long startNs, long long endNs) {
+		if (startNs <= 0 || endNs < startNs || stage >= edll::Stage::COUNT) {
+			return;
+		}
+		histogramsFor(code)[stage].record(static_cast<uint64_t>((endNs - startNs) / 1000));
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Build a report with the latency summary for all command codes and stages with recorded values
+	 *
+	 * @param None
+	 * @return json: Object indexed by command code and stage name
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	json report() const {
+		json result = json::object();
+		forEach([&result](const std::string& code, const char* stage, const LatencyHistogram& histogram) {
+			result[code][stage] = histogram.toJson();
+			});
+		return result;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Visit all histograms with recorded values
+	 *
+	 * @param visitor: Function called with the command code label, stage name and histogram
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <typename Visitor>
+	void forEach(Visitor visitor) const {
+		for (size_t i = 0; i < codes.size(); i++) {
+			const StageHistograms* histograms = codes[i].load(std::memory_order_acquire);
+			if (histograms == nullptr) {
+				continue;
+			}
+			std::string codeStr = edll::CodeSlots::instance().label(i);
+			for (size_t stage = 0; stage < edll::Stage::COUNT; stage++) {
+				if ((*histograms)[stage].getCount() > 0) {
+					visitor(codeStr, edll::Stage::toString(stage), (*histograms)[stage]);
+				}
+			}
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Write the latency report to the log if the reporting period has elapsed
+	 * Only one caller will write the report for each period.
+	 *
+	 * @param None
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void logReportIfDue() {
+		long long period = reportPeriodNs.load(std::memory_order_relaxed);
+		if (period <= 0) {
+			return;
+		}
+		long long now = edll::traceNow();
+		long long last = lastReport.load(std::memory_order_relaxed);
+		if (now - last < period || !lastReport.compare_exchange_strong(last, now)) {
+			return;
+		}
+		loggerPtr->info("Latency report: " + report().dump());
+	}
+};
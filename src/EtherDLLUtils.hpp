@@ -27,8 +27,11 @@
 #include <sstream>
 #include <fstream>
 #include <string>
+#include <cstring>
 #include <vector>
 #include <functional>
+#include <type_traits>
+#include <algorithm>
 
 // Constants
 
@@ -38,12 +41,6 @@ static const std::string BASE64_CHARS =
 "abcdefghijklmnopqrstuvwxyz"
 "0123456789+/";
 
-constexpr std::size_t HASH_STRING = 479440892;   // djb2 hash for string "string"
-constexpr std::size_t HASH_NUMBER = 284762254;   // djb2 hash for string "number"
-constexpr std::size_t HASH_BOOLEAN = 2257391749;  // djb2 hash for string "boolean"
-constexpr std::size_t HASH_ARRAY = 695403079;    // djb2 hash for string "array"
-constexpr std::size_t HASH_OBJECT = 301260540;  // djb2 hash for string "object"
-
 constexpr const char* VALID_TYPE_STRING = "string";
 constexpr const char* VALID_TYPE_NUMBER = "number";
 constexpr const char* VALID_TYPE_BOOLEAN = "boolean";
@@ -71,6 +68,13 @@ constexpr std::size_t stringToHash(const char* str, std::size_t hash = 5381) {
     return (*str == 0) ? hash : stringToHash(str + 1, ((hash << 5) + hash) + *str);
 }
 
+// Hashes of the type names, computed with the size_t of the target platform
+constexpr std::size_t HASH_STRING = stringToHash(VALID_TYPE_STRING);   // djb2 hash for string "string"
+constexpr std::size_t HASH_NUMBER = stringToHash(VALID_TYPE_NUMBER);   // djb2 hash for string "number"
+constexpr std::size_t HASH_BOOLEAN = stringToHash(VALID_TYPE_BOOLEAN); // djb2 hash for string "boolean"
+constexpr std::size_t HASH_ARRAY = stringToHash(VALID_TYPE_ARRAY);     // djb2 hash for string "array"
+constexpr std::size_t HASH_OBJECT = stringToHash(VALID_TYPE_OBJECT);   // djb2 hash for string "object"
+
 // ----------------------------------------------------------------------
 // Class to validate JSON objects against expected schema
 class JsonValidator {
@@ -119,6 +123,42 @@ private:
         }
     }
 
+    // ----------------------------------------------------------------------
+    /** @brief Test if a JSON value is of the expected type
+     * @param field The JSON value to check
+     * @param typeName The expected type of the value
+     * @return bool
+     * @throws NO EXCEPTION HANDLING
+    **/
+    static bool hasType(const json& field, const char* typeName) {
+        if (std::strcmp(typeName, VALID_TYPE_STRING) == 0) return field.is_string();
+        if (std::strcmp(typeName, VALID_TYPE_NUMBER) == 0) return field.is_number();
+        if (std::strcmp(typeName, VALID_TYPE_BOOLEAN) == 0) return field.is_boolean();
+        if (std::strcmp(typeName, VALID_TYPE_ARRAY) == 0) return field.is_array();
+        if (std::strcmp(typeName, VALID_TYPE_OBJECT) == 0) return field.is_object();
+        return false;
+    }
+
+    template<typename T>
+    // ----------------------------------------------------------------------
+    /** @brief Read a field value already found in the JSON object, if it is of the expected type
+     * @tparam T The type of the destination value
+     * @param field The JSON value of the field
+     * @param fieldName The name of the field, used only in the error path
+     * @param typeName The expected type of the field
+     * @param value Destination of the field value, set only if the field is valid
+     * @return bool: True if the field is valid
+     * @throws NO EXCEPTION HANDLING
+    **/
+    bool readValue(const json& field, const char* fieldName, const char* typeName, T& value) {
+        if (!hasType(field, typeName)) {
+            addError(fieldName, "Type required: '" + std::string(typeName) + "'");
+            return false;
+        }
+        value = field.get<T>();
+        return true;
+    }
+
 public:
 
     // ----------------------------------------------------------------------
@@ -131,6 +171,17 @@ public:
         errors.push_back({ currentPath, message });
     }
 
+    // ----------------------------------------------------------------------
+    /** @brief Add a validation error with a path relative to the current JSON path
+     * @param path The JSON path of the field, relative to the current path
+     * @param message The error message to add
+     * @return void
+     * @throws NO EXCEPTION HANDLING
+    **/
+    void addError(const std::string& path, const std::string& message) {
+        errors.push_back({ currentPath.empty() ? path : currentPath + "." + path, message });
+    }
+
     // ----------------------------------------------------------------------
     /** @brief Clear previous validation results
 	 * @param None
@@ -295,8 +346,10 @@ public:
         return *this;
     }
 
+    template<typename T>
     // ----------------------------------------------------------------------
-    /** @brief Test if an optional integer field is within a specified range
+    /** @brief Test if an optional numeric field is within a specified range
+     * @tparam T The numeric type
      * @param obj The JSON object to validate
      * @param fieldName The name of the field to check
      * @param minValue The minimum allowed value
@@ -305,7 +358,7 @@ public:
 	 * @throws NO EXCEPTION HANDLING
     **/
     JsonValidator& optionalRange(const json& obj, const std::string& fieldName,
-        int minValue, int maxValue) {
+        T minValue, T maxValue) {
         if (obj.contains(fieldName) && !obj[fieldName].is_null()) {
             return requireRange(obj, fieldName, minValue, maxValue);
         }
@@ -313,9 +366,10 @@ public:
     }
 
 	// ----------------------------------------------------------------------
-    /** @brief Test if a required array field exists and meets minimum size
+    /** @brief Test if a required array field exists, meets minimum size and holds items of the given type only
      * @param obj The JSON object to validate
      * @param fieldName The name of the array field to check
+     * @param typeName The JSON type name required for every item
      * @param minItems The minimum number of items required in the array
      * @return JsonValidator&
 	 * @throws NO EXCEPTION HANDLING
@@ -336,8 +390,11 @@ public:
 			return *this;
         }
 
-		if (obj[fieldName][0].type_name() != typeName) {
-			addError("Array items must be of type '" + typeName + "'");
+		for (const auto& item : obj[fieldName]) {
+			if (item.type_name() != typeName) {
+				addError("Array items must be of type '" + typeName + "'");
+				break;
+			}
 		}
         popPath();
         return *this;
@@ -409,7 +466,442 @@ public:
         popPath();
         return *this;
     }
-}; 
+
+    // ----------------------------------------------------------------------
+    /** @brief Get the number of validation errors found so far
+     * @param None
+     * @return size_t
+     * @throws NO EXCEPTION HANDLING
+    **/
+    size_t errorCount() const {
+        return errors.size();
+    }
+
+    // ----------------------------------------------------------------------
+    /** @brief Prefix the path of the errors added after a given error count
+     * Used to locate errors found in array items or nested objects, building the path only on failure
+     * @param firstError Number of errors found before the item or object was validated
+     * @param prefix Path of the item or object, such as "band[0]"
+     * @return void
+     * @throws NO EXCEPTION HANDLING
+    **/
+    void prefixErrors(size_t firstError, const std::string& prefix) {
+        for (size_t i = firstError; i < errors.size(); ++i) {
+            errors[i].path = errors[i].path.empty() ? prefix : prefix + "." + errors[i].path;
+        }
+    }
+
+    template<typename T, typename L>
+    // ----------------------------------------------------------------------
+    /** @brief Test if a required numeric field is within a specified range and read its value
+     * Same test and error messages as requireRange, with a single lookup of the field.
+     * Used to convert the JSON object into a struct while it is validated.
+     * @tparam T The type of the destination value
+     * @tparam L The numeric type of the limits
+     * @param obj The JSON object to validate
+     * @param fieldName The name of the field to read
+     * @param minValue The minimum allowed value
+     * @param maxValue The maximum allowed value
+     * @param value Destination of the field value, set only if the field is valid
+     * @return bool: True if the field is valid
+     * @throws NO EXCEPTION HANDLING
+    **/
+    bool readRange(const json& obj, const char* fieldName, L minValue, L maxValue, T& value) {
+        auto it = obj.find(fieldName);
+        if (it == obj.end()) {
+            addError(fieldName, "Field required");
+            return false;
+        }
+        if (!it->is_number()) {
+            addError(fieldName, "Type required: '" + std::string(VALID_TYPE_NUMBER) + "'");
+            return false;
+        }
+        double number = it->get<double>();
+        if (number < minValue || number > maxValue) {
+            addError(fieldName, "Number must be between " + std::to_string(minValue) +
+                " and " + std::to_string(maxValue));
+            return false;
+        }
+        value = it->get<T>();
+        return true;
+    }
+
+    template<typename T>
+    // ----------------------------------------------------------------------
+    /** @brief Test if a required field is of the expected type and read its value
+     * @tparam T The type of the destination value
+     * @param obj The JSON object to validate
+     * @param fieldName The name of the field to read
+     * @param typeName The expected type of the field
+     * @param value Destination of the field value, set only if the field is valid
+     * @return bool: True if the field is valid
+     * @throws NO EXCEPTION HANDLING
+    **/
+    bool readType(const json& obj, const char* fieldName, const char* typeName, T& value) {
+        auto it = obj.find(fieldName);
+        if (it == obj.end()) {
+            addError(fieldName, "Field required");
+            return false;
+        }
+        return readValue(*it, fieldName, typeName, value);
+    }
+
+    template<typename T>
+    // ----------------------------------------------------------------------
+    /** @brief Test if an optional field is of the expected type and read its value
+     * Missing and null fields keep the value received.
+     * @tparam T The type of the destination value
+     * @param obj The JSON object to validate
+     * @param fieldName The name of the field to read
+     * @param typeName The expected type of the field
+     * @param value Destination of the field value, set only if the field is present and valid
+     * @return bool: True if the field is missing, null or valid
+     * @throws NO EXCEPTION HANDLING
+    **/
+    bool readOptional(const json& obj, const char* fieldName, const char* typeName, T& value) {
+        auto it = obj.find(fieldName);
+        if (it == obj.end() || it->is_null()) {
+            return true;
+        }
+        return readValue(*it, fieldName, typeName, value);
+    }
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Validation rules compiled once into a flat list of instructions
+ *
+ * Holds the same rules as the JsonValidator methods, without the JSON object, so that
+ * field names, expected types and limits are resolved once at startup instead of on every request.
+ * Items of object arrays are validated by a nested list of instructions stored inline, after the item instruction.
+ * Validation of a valid object does not allocate memory. Error paths and messages are built only on failure,
+ * with the same text produced by JsonValidator.
+**/
+class ValidationSchema {
+private:
+    enum class Op : unsigned char {
+        REQUIRE_TYPE,
+        OPTIONAL_TYPE,
+        REQUIRE_RANGE,
+        OPTIONAL_RANGE,
+        REQUIRE_ARRAY,
+        OBJECT_ITEMS,
+        LESS_THAN
+    };
+
+    enum class Type : unsigned char {
+        STRING,
+        NUMBER,
+        BOOLEAN,
+        ARRAY,
+        OBJECT,
+        UNKNOWN
+    };
+
+    struct Instruction {
+        Op op;
+        Type type = Type::UNKNOWN;
+        std::string field;
+        std::string typeName;       // Expected type as written in the error message
+        std::string otherField;     // Upper bound field for LESS_THAN
+        std::string message;        // Error message for LESS_THAN
+        double minValue = 0;
+        double maxValue = 0;
+        bool integerLimits = false; // Limits written as integers in the error message
+        size_t minItems = 0;
+        size_t bodySize = 0;        // Number of instructions applied to each item for OBJECT_ITEMS
+    };
+
+    // Position of an array item within the validated object, used to build the error path on failure
+    struct ItemFrame {
+        const ItemFrame* parent;
+        const std::string* field;
+        size_t index;
+    };
+
+    std::vector<Instruction> program;
+
+    // ----------------------------------------------------------------------
+    /** @brief Resolve the type name used by JsonValidator into the corresponding JSON type
+     * Names are compared directly, since this runs only while the schema is built
+     * @param typeName The expected type of the field
+     * @return Type
+     * @throws NO EXCEPTION HANDLING
+    **/
+    static Type typeFromName(const std::string& typeName) {
+        if (typeName == VALID_TYPE_STRING) return Type::STRING;
+        if (typeName == VALID_TYPE_NUMBER) return Type::NUMBER;
+        if (typeName == VALID_TYPE_BOOLEAN) return Type::BOOLEAN;
+        if (typeName == VALID_TYPE_ARRAY) return Type::ARRAY;
+        if (typeName == VALID_TYPE_OBJECT) return Type::OBJECT;
+        return Type::UNKNOWN;
+    }
+
+    static bool hasType(const json& value, Type type) {
+        switch (type) {
+            case Type::STRING: return value.is_string();
+            case Type::NUMBER: return value.is_number();
+            case Type::BOOLEAN: return value.is_boolean();
+            case Type::ARRAY: return value.is_array();
+            case Type::OBJECT: return value.is_object();
+            default: return false;
+        }
+    }
+
+    // ----------------------------------------------------------------------
+    /** @brief Build the path of a field, such as "band[0].channelBandwidth". Called only on failure.
+     * @param frame The array item that contains the field, or nullptr for the validated object
+     * @param field The name of the field
+     * @return std::string
+     * @throws NO EXCEPTION HANDLING
+    **/
+    static std::string buildPath(const ItemFrame* frame, const std::string& field) {
+        std::string path = field;
+        for (; frame != nullptr; frame = frame->parent) {
+            path = *frame->field + "[" + std::to_string(frame->index) + "]." + path;
+        }
+        return path;
+    }
+
+    static std::string limitToString(double value, bool integerLimits) {
+        return integerLimits ? std::to_string(static_cast<long long>(value)) : std::to_string(value);
+    }
+
+    // ----------------------------------------------------------------------
+    /** @brief Add an instruction that tests a number against a range
+     * @param op REQUIRE_RANGE or OPTIONAL_RANGE
+     * @param fieldName The name of the field to check
+     * @param minValue The minimum allowed value
+     * @param maxValue The maximum allowed value
+     * @param integerLimits True if the limits are integers
+     * @return ValidationSchema&
+     * @throws NO EXCEPTION HANDLING
+    **/
+    ValidationSchema& addRange(Op op, const std::string& fieldName, double minValue, double maxValue, bool integerLimits) {
+        Instruction instruction{ op };
+        instruction.type = Type::NUMBER;
+        instruction.field = fieldName;
+        instruction.typeName = VALID_TYPE_NUMBER;
+        instruction.minValue = minValue;
+        instruction.maxValue = maxValue;
+        instruction.integerLimits = integerLimits;
+        program.push_back(std::move(instruction));
+        return *this;
+    }
+
+    // ----------------------------------------------------------------------
+    /** @brief Run a range of instructions over a JSON object
+     * @param begin Index of the first instruction
+     * @param end Index after the last instruction
+     * @param obj The JSON object to validate
+     * @param frame The array item being validated, or nullptr for the validated object
+     * @param validator JsonValidator that receives the errors
+     * @return void
+     * @throws NO EXCEPTION HANDLING
+    **/
+    void run(size_t begin, size_t end, const json& obj, const ItemFrame* frame, JsonValidator& validator) const {
+
+        for (size_t pc = begin; pc < end; ++pc) {
+            const Instruction& ins = program[pc];
+            auto it = obj.find(ins.field);
+            bool found = it != obj.end();
+
+            switch (ins.op) {
+                case Op::OPTIONAL_TYPE:
+                case Op::OPTIONAL_RANGE: {
+                    if (!found || it->is_null()) {
+                        break;
+                    }
+                }
+                // Fall through intended
+                case Op::REQUIRE_TYPE:
+                case Op::REQUIRE_RANGE: {
+                    if (!found) {
+                        validator.addError(buildPath(frame, ins.field), "Field required");
+                        break;
+                    }
+                    if (!hasType(*it, ins.type)) {
+                        validator.addError(buildPath(frame, ins.field), "Type required: '" + ins.typeName + "'");
+                        break;
+                    }
+                    if (ins.op == Op::REQUIRE_TYPE || ins.op == Op::OPTIONAL_TYPE) {
+                        break;
+                    }
+                    double value = it->get<double>();
+                    if (value < ins.minValue || value > ins.maxValue) {
+                        validator.addError(buildPath(frame, ins.field), "Number must be between " +
+                            limitToString(ins.minValue, ins.integerLimits) + " and " +
+                            limitToString(ins.maxValue, ins.integerLimits));
+                    }
+                    break;
+                }
+                case Op::REQUIRE_ARRAY: {
+                    if (!found) {
+                        validator.addError(buildPath(frame, ins.field), "Field required");
+                        break;
+                    }
+                    if (!it->is_array()) {
+                        validator.addError(buildPath(frame, ins.field), std::string("Type required: '") + VALID_TYPE_ARRAY + "'");
+                        break;
+                    }
+                    if (it->size() < ins.minItems) {
+                        validator.addError(buildPath(frame, ins.field), "Array must have at least " + std::to_string(ins.minItems) + " items");
+                        break;
+                    }
+                    if (std::any_of(it->begin(), it->end(), [&ins](const json& item) { return !hasType(item, ins.type); })) {
+                        validator.addError(buildPath(frame, ins.field), "Array items must be of type '" + ins.typeName + "'");
+                    }
+                    break;
+                }
+                case Op::OBJECT_ITEMS: {
+                    if (!found) {
+                        validator.addError(buildPath(frame, ins.field), "Field required");
+                    }
+                    else if (it->is_array()) {
+                        for (size_t i = 0; i < it->size(); ++i) {
+                            ItemFrame item{ frame, &ins.field, i };
+                            run(pc + 1, pc + 1 + ins.bodySize, (*it)[i], &item, validator);
+                        }
+                    }
+                    pc += ins.bodySize;
+                    break;
+                }
+                case Op::LESS_THAN: {
+                    auto otherIt = obj.find(ins.otherField);
+                    if (found && otherIt != obj.end() && it->is_number() && otherIt->is_number() &&
+                        !(it->get<double>() < otherIt->get<double>())) {
+                        validator.addError(buildPath(frame, ins.field), ins.message);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+public:
+
+    // ----------------------------------------------------------------------
+    /** @brief Add a test for a required field of the expected type
+     * @param fieldName The name of the field to check
+     * @param typeName The expected type of the field
+     * @return ValidationSchema&
+     * @throws NO EXCEPTION HANDLING
+    **/
+    ValidationSchema& requireType(const std::string& fieldName, const std::string& typeName) {
+        Instruction instruction{ Op::REQUIRE_TYPE };
+        instruction.type = typeFromName(typeName);
+        instruction.field = fieldName;
+        instruction.typeName = typeName;
+        program.push_back(std::move(instruction));
+        return *this;
+    }
+
+    // ----------------------------------------------------------------------
+    /** @brief Add a test for an optional field of the expected type
+     * @param fieldName The name of the field to check
+     * @param typeName The expected type of the field
+     * @return ValidationSchema&
+     * @throws NO EXCEPTION HANDLING
+    **/
+    ValidationSchema& optionalType(const std::string& fieldName, const std::string& typeName) {
+        requireType(fieldName, typeName);
+        program.back().op = Op::OPTIONAL_TYPE;
+        return *this;
+    }
+
+    template<typename T>
+    // ----------------------------------------------------------------------
+    /** @brief Add a test for a required numeric field within a specified range
+     * Range limits are included (>= min and <= max)
+     * @tparam T The numeric type of the limits
+     * @param fieldName The name of the field to check
+     * @param minValue The minimum allowed value
+     * @param maxValue The maximum allowed value
+     * @return ValidationSchema&
+     * @throws NO EXCEPTION HANDLING
+    **/
+    ValidationSchema& requireRange(const std::string& fieldName, T minValue, T maxValue) {
+        return addRange(Op::REQUIRE_RANGE, fieldName, static_cast<double>(minValue), static_cast<double>(maxValue), std::is_integral<T>::value);
+    }
+
+    template<typename T>
+    // ----------------------------------------------------------------------
+    /** @brief Add a test for an optional numeric field within a specified range
+     * Range limits are included (>= min and <= max)
+     * @tparam T The numeric type of the limits
+     * @param fieldName The name of the field to check
+     * @param minValue The minimum allowed value
+     * @param maxValue The maximum allowed value
+     * @return ValidationSchema&
+     * @throws NO EXCEPTION HANDLING
+    **/
+    ValidationSchema& optionalRange(const std::string& fieldName, T minValue, T maxValue) {
+        return addRange(Op::OPTIONAL_RANGE, fieldName, static_cast<double>(minValue), static_cast<double>(maxValue), std::is_integral<T>::value);
+    }
+
+    // ----------------------------------------------------------------------
+    /** @brief Add a test for a required array field with a minimum size
+     * @param fieldName The name of the array field to check
+     * @param typeName The expected type of the array items
+     * @param minItems The minimum number of items required in the array
+     * @return ValidationSchema&
+     * @throws NO EXCEPTION HANDLING
+    **/
+    ValidationSchema& requireArray(const std::string& fieldName, const std::string& typeName, size_t minItems = 1) {
+        Instruction instruction{ Op::REQUIRE_ARRAY };
+        instruction.type = typeFromName(typeName);
+        instruction.field = fieldName;
+        instruction.typeName = typeName;
+        instruction.minItems = minItems;
+        program.push_back(std::move(instruction));
+        return *this;
+    }
+
+    // ----------------------------------------------------------------------
+    /** @brief Add a schema to be applied to each item of a required array field
+     * @param fieldName The name of the array field to check
+     * @param itemSchema The schema applied to each array item
+     * @return ValidationSchema&
+     * @throws NO EXCEPTION HANDLING
+    **/
+    ValidationSchema& validateObjectItems(const std::string& fieldName, const ValidationSchema& itemSchema) {
+        Instruction instruction{ Op::OBJECT_ITEMS };
+        instruction.field = fieldName;
+        instruction.bodySize = itemSchema.program.size();
+        program.push_back(std::move(instruction));
+        program.insert(program.end(), itemSchema.program.begin(), itemSchema.program.end());
+        return *this;
+    }
+
+    // ----------------------------------------------------------------------
+    /** @brief Add a test that a numeric field is less than another, when both exist
+     * @param fieldName The name of the field to check
+     * @param otherFieldName The name of the field used as upper bound
+     * @param errorMessage The error message to add if validation fails
+     * @return ValidationSchema&
+     * @throws NO EXCEPTION HANDLING
+    **/
+    ValidationSchema& lessThan(const std::string& fieldName, const std::string& otherFieldName, const std::string& errorMessage) {
+        Instruction instruction{ Op::LESS_THAN };
+        instruction.field = fieldName;
+        instruction.otherField = otherFieldName;
+        instruction.message = errorMessage;
+        program.push_back(std::move(instruction));
+        return *this;
+    }
+
+    // ----------------------------------------------------------------------
+    /** @brief Validate a JSON object, adding the errors found to the validator
+     * @param obj The JSON object to validate
+     * @param validator JsonValidator that receives the errors
+     * @return JsonValidator&
+     * @throws NO EXCEPTION HANDLING
+    **/
+    JsonValidator& validate(const json& obj, JsonValidator& validator) const {
+        run(0, program.size(), obj, nullptr, validator);
+        return validator;
+    }
+};
 
 
 // ------------------------------------------------------
@@ -0,0 +1,581 @@
+/**
+* @file EtherDLLWriter.hpp
+*
+* @brief Header file for the streaming JSON writer used to convert DLL responses
+*
+* Responses are written as JSON text directly into an output buffer, in a single pass, without building a JSON document.
+* The text is carried in the response queue under the body key and merged with the remaining keys of the message before sending.
+* Structures shared by several responses are described by compile time field lists, written either by the writer or into a JSON object.
+*
+* * @author fslobao
+* * @date 2025-10-26
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+* * @note Uses fmt library bundled with spdlog for number formatting
+*
+**/
+// ----------------------------------------------------------------------
+#pragma once
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+#include <spdlog/fmt/fmt.h>
+
+// Include general C++ libraries
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <tuple>
+#include <cmath>
+#include <cstdint>
+
+// For convenience
+using json = nlohmann::json;
+
+// ----------------------------------------------------------------------
+namespace edll {
+
+	// Key used to carry the JSON text written by JsonWriter inside queued messages. Merged with the message before sending to the client.
+	constexpr const char* BODY_KEY = "BODY";
+
+	// ----------------------------------------------------------------------
+	/** @brief Object key with its quoted form, followed by the name separator, built at compile time
+	**/
+	template <size_t N>
+	struct JsonKey {
+		const char* name;
+		char quoted[N + 2] = {};
+
+		constexpr JsonKey(const char (&key)[N]) : name(key) {
+			quoted[0] = '"';
+			for (size_t i = 0; i + 1 < N; i++) {
+				quoted[i + 1] = key[i];
+			}
+			quoted[N] = '"';
+			quoted[N + 1] = ':';
+		}
+	};
+
+	// ----------------------------------------------------------------------
+	/** @brief Write JSON text into a memory buffer, in a single pass
+	 *
+	 * Separators are inserted automatically between members and array elements.
+	 * Keys are string literals written as they are, so they must not require escaping.
+	 * Values are formatted according to their type. Types not handled directly are converted using nlohmann/json.
+	**/
+	class JsonWriter {
+	private:
+		fmt::memory_buffer buffer;
+		// Flag to indicate that the next member or element must be preceded by a separator
+		bool separate = false;
+
+		void append(std::string_view text) {
+			buffer.append(text.data(), text.data() + text.size());
+		}
+
+		void beginValue() {
+			if (separate) {
+				buffer.push_back(',');
+			}
+		}
+
+		template <typename T>
+		void writeInteger(T number) {
+			fmt::format_int text(number);
+			buffer.append(text.data(), text.data() + text.size());
+		}
+
+		template <typename T>
+		void writeFloat(T number) {
+			if (std::isfinite(number)) {
+				fmt::format_to(fmt::appender(buffer), "{}", number);
+			}
+			else {
+				append("null");
+			}
+		}
+
+		// Length of the valid UTF-8 sequence starting at the given position, or zero if the bytes are not valid UTF-8 (RFC 3629)
+		static size_t utf8Length(std::string_view text, size_t i) {
+			unsigned char c = static_cast<unsigned char>(text[i]);
+			size_t length = 0;
+			unsigned char low = 0x80;
+			unsigned char high = 0xBF;
+			if (c >= 0xC2 && c <= 0xDF) {
+				length = 2;
+			}
+			else if (c >= 0xE0 && c <= 0xEF) {
+				length = 3;
+				low = c == 0xE0 ? 0xA0 : low;
+				high = c == 0xED ? 0x9F : high;
+			}
+			else if (c >= 0xF0 && c <= 0xF4) {
+				length = 4;
+				low = c == 0xF0 ? 0x90 : low;
+				high = c == 0xF4 ? 0x8F : high;
+			}
+			if (length == 0 || i + length > text.size()) {
+				return 0;
+			}
+			unsigned char second = static_cast<unsigned char>(text[i + 1]);
+			if (second < low || second > high) {
+				return 0;
+			}
+			for (size_t k = 2; k < length; k++) {
+				if ((static_cast<unsigned char>(text[i + k]) & 0xC0) != 0x80) {
+					return 0;
+				}
+			}
+			return length;
+		}
+
+		// Strings from the DLL structures are not guaranteed to be UTF-8. Invalid bytes are replaced by U+FFFD, as done by nlohmann/json with error_handler_t::replace.
+		void writeString(std::string_view text) {
+			static const char HEX[] = "0123456789abcdef";
+
+			buffer.push_back('"');
+			size_t start = 0;
+			for (size_t i = 0; i < text.size(); i++) {
+				unsigned char c = static_cast<unsigned char>(text[i]);
+				if (c >= 0x80) {
+					size_t length = utf8Length(text, i);
+					if (length > 0) {
+						i += length - 1;
+						continue;
+					}
+					append(text.substr(start, i - start));
+					append("\\ufffd");
+					start = i + 1;
+					continue;
+				}
+				if (c >= 0x20 && c != '"' && c != '\\') {
+					continue;
+				}
+				append(text.substr(start, i - start));
+				switch (c) {
+					case '"': append("\\\""); break;
+					case '\\': append("\\\\"); break;
+					case '\n': append("\\n"); break;
+					case '\r': append("\\r"); break;
+					case '\t': append("\\t"); break;
+					case '\b': append("\\b"); break;
+					case '\f': append("\\f"); break;
+					default:
+						append("\\u00");
+						buffer.push_back(HEX[c >> 4]);
+						buffer.push_back(HEX[c & 0x0F]);
+						break;
+				}
+				start = i + 1;
+			}
+			append(text.substr(start));
+			buffer.push_back('"');
+		}
+
+	public:
+		// ----------------------------------------------------------------------
+		/** @brief Open an object, as a value or array element
+		 * @return JsonWriter&: This writer
+		**/
+		JsonWriter& beginObject() {
+			beginValue();
+			buffer.push_back('{');
+			separate = false;
+			return *this;
+		}
+
+		// ----------------------------------------------------------------------
+		/** @brief Close the current object
+		 * @return JsonWriter&: This writer
+		**/
+		JsonWriter& endObject() {
+			buffer.push_back('}');
+			separate = true;
+			return *this;
+		}
+
+		// ----------------------------------------------------------------------
+		/** @brief Open an array, as a value or array element
+		 * @return JsonWriter&: This writer
+		**/
+		JsonWriter& beginArray() {
+			beginValue();
+			buffer.push_back('[');
+			separate = false;
+			return *this;
+		}
+
+		// ----------------------------------------------------------------------
+		/** @brief Close the current array
+		 * @return JsonWriter&: This writer
+		**/
+		JsonWriter& endArray() {
+			buffer.push_back(']');
+			separate = true;
+			return *this;
+		}
+
+		// ----------------------------------------------------------------------
+		/** @brief Write the key of an object member. The value must be written next.
+		 *
+		 * @param name: String literal with the key, written without escaping
+		 * @return JsonWriter&: This writer
+		**/
+		template <size_t N>
+		JsonWriter& key(const char (&name)[N]) {
+			beginValue();
+			buffer.push_back('"');
+			buffer.append(name, name + N - 1);
+			append("\":");
+			separate = false;
+			return *this;
+		}
+
+		// ----------------------------------------------------------------------
+		/** @brief Write the key of an object member, already quoted. The value must be written next.
+		 *
+		 * @param name: Key built at compile time
+		 * @return JsonWriter&: This writer
+		**/
+		template <size_t N>
+		JsonWriter& key(const JsonKey<N>& name) {
+			beginValue();
+			buffer.append(name.quoted, name.quoted + sizeof(name.quoted));
+			separate = false;
+			return *this;
+		}
+
+		// ----------------------------------------------------------------------
+		/** @brief Write a value, as an object member value or array element
+		 *
+		 * Booleans, enumerations, integers, floating point numbers and strings are written directly.
+		 * Non finite floating point numbers are written as null, as done by nlohmann/json.
+		 *
+		 * @param data: Value to be written
+		 * @return JsonWriter&: This writer
+		**/
+		template <typename T>
+		JsonWriter& value(const T& data) {
+			beginValue();
+			if constexpr (std::is_same_v<T, bool>) {
+				append(data ? "true" : "false");
+			}
+			else if constexpr (std::is_enum_v<T>) {
+				writeInteger(static_cast<std::underlying_type_t<T>>(data));
+			}
+			else if constexpr (std::is_integral_v<T>) {
+				writeInteger(data);
+			}
+			else if constexpr (std::is_floating_point_v<T>) {
+				writeFloat(data);
+			}
+			else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+				writeString(data);
+			}
+			else if constexpr (std::is_same_v<T, json>) {
+				append(data.dump());
+			}
+			else {
+				append(json(data).dump());
+			}
+			separate = true;
+			return *this;
+		}
+
+		// ----------------------------------------------------------------------
+		/** @brief Write a block of bytes as a base64 string, as an object member value or array element
+		 *
+		 * Bytes are encoded directly into the buffer, so binary data never goes through string escaping.
+		 *
+		 * @param data: Pointer to the first byte
+		 * @param size: Number of bytes
+		 * @return JsonWriter&: This writer
+		**/
+		JsonWriter& binary(const void* data, size_t size) {
+			static const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+			beginValue();
+			const unsigned char* in = static_cast<const unsigned char*>(data);
+			size_t start = buffer.size();
+			buffer.resize(start + 2 + (size + 2) / 3 * 4);
+			char* out = buffer.data() + start;
+
+			*out++ = '"';
+			size_t i = 0;
+			for (; i + 2 < size; i += 3) {
+				uint32_t triple = (uint32_t(in[i]) << 16) | (uint32_t(in[i + 1]) << 8) | in[i + 2];
+				*out++ = BASE64[(triple >> 18) & 0x3F];
+				*out++ = BASE64[(triple >> 12) & 0x3F];
+				*out++ = BASE64[(triple >> 6) & 0x3F];
+				*out++ = BASE64[triple & 0x3F];
+			}
+			if (i < size) {
+				uint32_t triple = uint32_t(in[i]) << 16;
+				if (i + 1 < size) {
+					triple |= uint32_t(in[i + 1]) << 8;
+				}
+				*out++ = BASE64[(triple >> 18) & 0x3F];
+				*out++ = BASE64[(triple >> 12) & 0x3F];
+				*out++ = i + 1 < size ? BASE64[(triple >> 6) & 0x3F] : '=';
+				*out++ = '=';
+			}
+			*out = '"';
+
+			separate = true;
+			return *this;
+		}
+
+		// ----------------------------------------------------------------------
+		/** @brief Write an object member
+		 *
+		 * @param name: String literal with the key, written without escaping
+		 * @param data: Value to be written
+		 * @return JsonWriter&: This writer
+		**/
+		template <size_t N, typename T>
+		JsonWriter& field(const char (&name)[N], const T& data) {
+			key(name);
+			return value(data);
+		}
+
+		// ----------------------------------------------------------------------
+		/** @brief Test if nothing was written
+		 * @return bool: True if the buffer is empty
+		**/
+		bool empty() const {
+			return buffer.size() == 0;
+		}
+
+		// ----------------------------------------------------------------------
+		/** @brief Discard the text written, keeping the allocated buffer for reuse
+		 * @return void
+		**/
+		void clear() {
+			buffer.clear();
+			separate = false;
+		}
+
+		// ----------------------------------------------------------------------
+		/** @brief Copy of the text written
+		 * @return std::string: JSON text
+		**/
+		std::string str() const {
+			return std::string(buffer.data(), buffer.size());
+		}
+	};
+
+	// ----------------------------------------------------------------------
+	/** @brief Name of the element type of a binary column, as reported to the client
+	 *
+	 * @return const char*: Type name, such as float32 or int16. Data is little endian.
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <typename T>
+	constexpr const char* columnType() {
+		static_assert(std::is_arithmetic_v<T>, "Binary columns hold numbers only");
+		if constexpr (std::is_floating_point_v<T>) {
+			return sizeof(T) == 4 ? "float32" : "float64";
+		}
+		else if constexpr (std::is_signed_v<T>) {
+			return sizeof(T) == 1 ? "int8" : sizeof(T) == 2 ? "int16" : sizeof(T) == 4 ? "int32" : "int64";
+		}
+		else {
+			return sizeof(T) == 1 ? "uint8" : sizeof(T) == 2 ? "uint16" : sizeof(T) == 4 ? "uint32" : "uint64";
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Member of a field list, holding the key and the function reading the value from the structure
+	**/
+	template <size_t N, typename Getter>
+	struct JsonField {
+		JsonKey<N> key;
+		Getter get;
+	};
+
+	// ----------------------------------------------------------------------
+	/** @brief Nested object of a field list, holding the key, the function selecting the nested structure and its field list
+	**/
+	template <size_t N, typename Projection, typename Fields>
+	struct JsonObject {
+		JsonKey<N> key;
+		Projection get;
+		Fields fields;
+	};
+
+	// Projection used by nested objects written from the same structure
+	struct JsonSelf {
+		template <typename T>
+		constexpr const T& operator()(const T& data) const {
+			return data;
+		}
+	};
+
+	// ----------------------------------------------------------------------
+	/** @brief Build a member of a field list
+	 *
+	 * @param name: String literal with the key, written without escaping
+	 * @param get: Function receiving the structure and returning the value
+	 * @return JsonField: Member of the field list
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <size_t N, typename Getter>
+	constexpr JsonField<N, Getter> jsonField(const char (&name)[N], Getter get) {
+		return { JsonKey<N>(name), get };
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Build a nested object of a field list
+	 *
+	 * @param name: String literal with the key, written without escaping
+	 * @param get: Function receiving the structure and returning the nested structure, or JsonSelf to use the same structure
+	 * @param fields: Tuple with the field list of the nested structure
+	 * @return JsonObject: Nested object of the field list
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <size_t N, typename Projection, typename Fields>
+	constexpr JsonObject<N, Projection, Fields> jsonObject(const char (&name)[N], Projection get, Fields fields) {
+		return { JsonKey<N>(name), get, fields };
+	}
+
+	template <typename T, typename... Fields>
+	void writeFields(JsonWriter& writer, const T& data, const std::tuple<Fields...>& fields);
+
+	template <typename T, typename... Fields>
+	void writeFields(json& object, const T& data, const std::tuple<Fields...>& fields);
+
+	template <typename T, size_t N, typename Getter>
+	void writeField(JsonWriter& writer, const T& data, const JsonField<N, Getter>& field) {
+		writer.key(field.key).value(field.get(data));
+	}
+
+	template <typename T, size_t N, typename Projection, typename Fields>
+	void writeField(JsonWriter& writer, const T& data, const JsonObject<N, Projection, Fields>& field) {
+		writer.key(field.key).beginObject();
+		writeFields(writer, field.get(data), field.fields);
+		writer.endObject();
+	}
+
+	template <typename T, size_t N, typename Getter>
+	void writeField(json& object, const T& data, const JsonField<N, Getter>& field) {
+		object[field.key.name] = field.get(data);
+	}
+
+	template <typename T, size_t N, typename Projection, typename Fields>
+	void writeField(json& object, const T& data, const JsonObject<N, Projection, Fields>& field) {
+		writeFields(object[field.key.name], field.get(data), field.fields);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Write the members of a field list as members of the current object of the writer
+	 *
+	 * @param writer: Writer with an open object
+	 * @param data: Structure holding the values
+	 * @param fields: Tuple with the field list, built with jsonField and jsonObject
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <typename T, typename... Fields>
+	void writeFields(JsonWriter& writer, const T& data, const std::tuple<Fields...>& fields) {
+		std::apply([&](const auto&... field) { (writeField(writer, data, field), ...); }, fields);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Write the members of a field list into a JSON object
+	 *
+	 * @param object: JSON object receiving the members
+	 * @param data: Structure holding the values
+	 * @param fields: Tuple with the field list, built with jsonField and jsonObject
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <typename T, typename... Fields>
+	void writeFields(json& object, const T& data, const std::tuple<Fields...>& fields) {
+		std::apply([&](const auto&... field) { (writeField(object, data, field), ...); }, fields);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Find a member of the JSON object written by JsonWriter whose key is also a member of the envelope
+	 *
+	 * Only the keys of the outer object are compared. Nested objects and strings are skipped.
+	 *
+	 * @param body: JSON object written by JsonWriter
+	 * @param envelope: JSON object with the remaining keys of the message
+	 * @return std::string_view: Key present in both objects, or empty if there is none
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	inline std::string_view findCollision(std::string_view body, const json& envelope) {
+		int depth = 0;
+		bool expectKey = false;
+		for (size_t i = 0; i < body.size(); i++) {
+			switch (body[i]) {
+				case '"': {
+					size_t end = i + 1;
+					while (end < body.size() && body[end] != '"') {
+						end += body[end] == '\\' ? 2 : 1;
+					}
+					if (expectKey) {
+						std::string_view key = body.substr(i + 1, end - i - 1);
+						if (envelope.find(std::string(key)) != envelope.end()) {
+							return key;
+						}
+						expectKey = false;
+					}
+					i = end;
+					break;
+				}
+				case '{':
+				case '[':
+					depth++;
+					expectKey = depth == 1;
+					break;
+				case '}':
+				case ']':
+					depth--;
+					break;
+				case ',':
+					expectKey = depth == 1;
+					break;
+				default:
+					break;
+			}
+		}
+		return {};
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Build the message sent to the client by merging the members of the body, serialized as text, with the envelope
+	 *
+	 * The body must not hold keys of the envelope, such as the command code or the client ID, since the client would receive duplicated keys.
+	 *
+	 * @param body: JSON object written by JsonWriter
+	 * @param envelope: JSON object with the remaining keys of the message
+	 * @param message: Output with the JSON object holding the members of both objects
+	 * @return std::string_view: Key present in both objects, in which case the message is not built, or empty on success
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	inline std::string_view mergeBody(std::string_view body, const json& envelope, std::string& message) {
+		std::string_view collision = findCollision(body, envelope);
+		if (!collision.empty()) {
+			return collision;
+		}
+		if (body.size() <= 2) {
+			message = envelope.dump();
+			return {};
+		}
+		if (envelope.empty()) {
+			message.assign(body);
+			return {};
+		}
+
+		std::string text = envelope.dump();
+		message.clear();
+		message.reserve(body.size() + text.size());
+		message.append(body.substr(0, body.size() - 1));
+		message.push_back(',');
+		message.append(text, 1);
+		return {};
+	}
+}
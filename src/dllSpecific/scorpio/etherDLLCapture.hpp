@@ -0,0 +1,566 @@
+/**
+* @file etherDLLCapture.hpp
+*
+* @brief Header file for the capture and replay of the raw DLL callbacks
+*
+* Every call to OnDataFunc, OnRealTimeDataFunc and OnErrorFunc may be captured with its arguments, the raw body bytes
+* and the time elapsed since the capture started. Captured calls are copied into a bounded queue of reusable slots
+* and appended to a binary file by a separate thread, the callback thread never waits for the disk.
+* A capture file may be replayed into the same callbacks at the original pace, N times faster or as fast as possible,
+* so the response pipeline can be exercised and profiled without a station.
+*
+* File layout, little endian: a CaptureFileHeader followed by records, each a CapturedCallback and its body padded to 8 bytes.
+* Bodies are stored with the size read by the service for their response type, trimmed to their last non zero byte,
+* and padded with zeros when replayed.
+* Error messages are stored as UTF-16 code units.
+*
+* * @author fslobao
+* * @date 2025-10-30
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+*
+**/
+
+// ----------------------------------------------------------------------
+#pragma once
+
+// Include DLL specific libraries
+#include "etherDLLRecorder.hpp"
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+
+// Include project libraries
+#include <spdlog/spdlog.h>
+#include <spdlog/fmt/chrono.h>
+
+// Include general C++ libraries
+#include <string>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <ctime>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <condition_variable>
+
+// Global variables
+extern spdlog::logger* loggerPtr;
+
+
+// ----------------------------------------------------------------------
+/** @brief Callback that produced a captured record
+**/
+enum class CallbackKind : uint16_t {
+	DATA = 1,			// OnDataFunc
+	REALTIME = 2,		// OnRealTimeDataFunc
+	ERROR_MESSAGE = 3	// OnErrorFunc
+};
+
+// ----------------------------------------------------------------------
+/** @brief Header of a capture file
+**/
+struct CaptureFileHeader {
+	static constexpr char MAGIC[8] = { 'E', 'D', 'L', 'L', 'C', 'A', 'P', '\0' };
+	static constexpr uint32_t VERSION = 1;
+
+	char magic[8];
+	uint32_t version;
+	uint32_t recordSize;	// sizeof(CapturedCallback) when written
+	int64_t startTimeNs;	// Capture start time in nanoseconds since the Unix epoch
+};
+static_assert(sizeof(CaptureFileHeader) == 24, "Capture file header must be packed");
+
+// ----------------------------------------------------------------------
+/** @brief Captured callback invocation, followed in the file by its body
+**/
+struct CapturedCallback {
+	static constexpr uint16_t NULL_BODY = 1;	// The callback received a null body pointer
+
+	uint16_t kind;			// CallbackKind
+	uint16_t flags;
+	uint32_t respType;		// ECSMSDllMsgType, zero for errors
+	uint32_t serverId;
+	uint32_t sourceAddr;	// OnDataFunc only
+	uint32_t requestID;		// OnDataFunc only
+	uint32_t size;			// Body bytes stored after the record
+	int64_t offsetNs;		// Time since the capture started
+
+	static size_t padded(size_t bytes) { return (bytes + 7) & ~size_t(7); }
+};
+static_assert(sizeof(CapturedCallback) == 32, "Captured callback record must be packed");
+
+// ----------------------------------------------------------------------
+/** @brief Size of a DLL body up to the last element used in its trailing array
+ *
+ * Body types end in arrays sized for the largest payload, so only the elements used by the response are captured.
+ *
+ * @param body: Body received by the callback, as the type read for its response type
+ * @param end: Pointer past the last element used, within the trailing array of the body
+ * @return size_t: Number of bytes to capture, at most the size of the body type
+ * @throws NO EXCEPTION HANDLING
+**/
+template <typename Body>
+size_t capturedBodySize(const Body& body, const void* end) {
+	size_t size = static_cast<size_t>(static_cast<const char*>(end) - reinterpret_cast<const char*>(&body));
+	return (std::min)(size, sizeof(Body));
+}
+
+
+// ----------------------------------------------------------------------
+/** @brief Capture of the DLL callbacks into a binary file
+ *
+ * Slots are reused, so no memory is allocated in the callback thread once the queue has seen the largest body.
+**/
+class CallbackCapture {
+private:
+	enum class SlotState { FREE, FILLING, READY };
+
+	struct Slot {
+		SlotState state = SlotState::FREE;
+		CapturedCallback record{};
+		std::vector<char> body;
+	};
+
+	std::mutex mtx;
+	std::condition_variable cv;
+
+	// Configuration, set before the service starts
+	bool enabled = false;
+	std::filesystem::path filePath;
+	std::chrono::steady_clock::time_point start;
+
+	// Queue shared by the callback threads and the writer thread
+	std::vector<Slot> slots;
+	size_t head = 0;
+	size_t tail = 0;
+	unsigned long long droppedCallbacks = 0;
+	bool dropping = false;
+
+	// ----------------------------------------------------------------------
+	/** @brief Number of bytes of a body up to its last non zero byte
+	 *
+	 * Unused space at the end of the fixed size body types is left zeroed, so trimming it keeps the file close to the payload size.
+	 *
+	 * @param body: Pointer to the body
+	 * @param size: Bytes of the body read for its response type
+	 * @return size_t: Number of bytes to store
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static size_t usedSize(const void* body, size_t size) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(body);
+
+		// Skip the zeroed tail a word at a time, then finish byte by byte
+		while (size >= sizeof(uint64_t)) {
+			uint64_t word;
+			std::memcpy(&word, bytes + size - sizeof(uint64_t), sizeof(uint64_t));
+			if (word != 0) {
+				break;
+			}
+			size -= sizeof(uint64_t);
+		}
+		while (size > 0 && bytes[size - 1] == 0) {
+			size--;
+		}
+		return size;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Reserve the next free slot. Called from the callback threads.
+	 *
+	 * @return Slot*: Slot owned by the caller until released, or nullptr if the queue is full
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	Slot* acquire() {
+		std::lock_guard<std::mutex> lock(mtx);
+		if (slots[head].state != SlotState::FREE) {
+			droppedCallbacks++;
+			if (!dropping) {
+				loggerPtr->warn("Callback capture queue full. Dropping callbacks");
+			}
+			dropping = true;
+			return nullptr;
+		}
+		dropping = false;
+		Slot* slot = &slots[head];
+		slot->state = SlotState::FILLING;
+		head = (head + 1) % slots.size();
+		return slot;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Hand a filled slot to the writer thread
+	 *
+	 * @param slot: Slot returned by acquire
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void release(Slot* slot) {
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			slot->state = SlotState::READY;
+		}
+		cv.notify_one();
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Time elapsed since the capture started, in nanoseconds
+	**/
+	int64_t elapsedNs() const {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	}
+
+public:
+	CallbackCapture() = default;
+
+	// ----------------------------------------------------------------------
+	/** @brief Set the capture configuration. Must be called before the service starts.
+	 *
+	 * @param enable: Capture the callbacks received from the DLL
+	 * @param path: Folder receiving the capture file, created if missing. Each service start creates a new file.
+	 * @param queueCallbacks: Number of callbacks waiting to be written before new callbacks are dropped
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void configure(bool enable, const std::string& path, long long queueCallbacks) {
+		enabled = enable && queueCallbacks > 0;
+		slots = std::vector<Slot>(enabled ? static_cast<size_t>(queueCallbacks) : 0);
+		start = std::chrono::steady_clock::now();
+
+		if (!enabled) {
+			return;
+		}
+
+		std::filesystem::path directory = path;
+		std::error_code ec;
+		std::filesystem::create_directories(directory, ec);
+		if (ec) {
+			loggerPtr->error("Callback capture disabled. Failed to create " + directory.string() + ": " + ec.message());
+			enabled = false;
+			return;
+		}
+
+		std::time_t now = std::time(nullptr);
+		filePath = directory / fmt::format("callbacks_{:%Y%m%dT%H%M%SZ}.edcap", fmt::gmtime(now));
+	}
+
+	bool isEnabled() const { return enabled; }
+
+	// ----------------------------------------------------------------------
+	/** @brief Queue a data or realtime callback. Called from the DLL callback threads, never waits for the disk.
+	 *
+	 * @param kind: Callback that received the body
+	 * @param serverId: Server id received by the callback
+	 * @param respType: Response type received by the callback
+	 * @param sourceAddr: Source address received by OnDataFunc, zero otherwise
+	 * @param requestID: Request id received by OnDataFunc, zero otherwise
+	 * @param body: Body received by the callback, may be null
+	 * @param bodySize: Bytes of the body read for its response type, zero if the service does not read the body
+	 * @return bool: True if the callback was queued, false if the capture is disabled or the queue is full
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool capture(CallbackKind kind, unsigned long serverId, unsigned long respType, unsigned long sourceAddr, unsigned long requestID, const void* body, size_t bodySize) {
+		if (!enabled) {
+			return false;
+		}
+
+		int64_t offsetNs = elapsedNs();
+		Slot* slot = acquire();
+		if (slot == nullptr) {
+			return false;
+		}
+
+		// Copy outside the lock, the slot is owned by this thread until ready
+		size_t bytes = body == nullptr ? 0 : usedSize(body, bodySize);
+		slot->record = { static_cast<uint16_t>(kind), body == nullptr ? CapturedCallback::NULL_BODY : uint16_t(0),
+			static_cast<uint32_t>(respType), static_cast<uint32_t>(serverId), static_cast<uint32_t>(sourceAddr), static_cast<uint32_t>(requestID),
+			static_cast<uint32_t>(bytes), offsetNs };
+		slot->body.resize(bytes);
+		if (bytes > 0) {
+			std::memcpy(slot->body.data(), body, bytes);
+		}
+
+		release(slot);
+		return true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Queue an error callback. Called from the DLL callback threads, never waits for the disk.
+	 *
+	 * @param serverId: Server id received by the callback
+	 * @param errorMsg: Error message received by the callback
+	 * @return bool: True if the callback was queued, false if the capture is disabled or the queue is full
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool captureError(unsigned long serverId, const std::wstring& errorMsg) {
+		if (!enabled) {
+			return false;
+		}
+
+		int64_t offsetNs = elapsedNs();
+		Slot* slot = acquire();
+		if (slot == nullptr) {
+			return false;
+		}
+
+		size_t bytes = errorMsg.size() * sizeof(uint16_t);
+		slot->record = { static_cast<uint16_t>(CallbackKind::ERROR_MESSAGE), 0, 0, static_cast<uint32_t>(serverId), 0, 0,
+			static_cast<uint32_t>(bytes), offsetNs };
+		slot->body.resize(bytes);
+		for (size_t i = 0; i < errorMsg.size(); i++) {
+			uint16_t unit = static_cast<uint16_t>(errorMsg[i]);
+			std::memcpy(slot->body.data() + i * sizeof(uint16_t), &unit, sizeof(uint16_t));
+		}
+
+		release(slot);
+		return true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Write the queued callbacks until the service is interrupted
+	 *
+	 * This function will lock the thread. Must be run in a separate thread.
+	 * The file is flushed whenever the queue is empty for a second and closed when the service is interrupted.
+	 *
+	 * @param interruptionCode: Signal interruption for service interruption
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void run(const edll::INT_CODE& interruptionCode) {
+		if (!enabled) {
+			return;
+		}
+
+		std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			loggerPtr->error("Callback capture stopped. Failed to create " + filePath.string());
+			return;
+		}
+
+		CaptureFileHeader header{};
+		std::memcpy(header.magic, CaptureFileHeader::MAGIC, sizeof(header.magic));
+		header.version = CaptureFileHeader::VERSION;
+		header.recordSize = sizeof(CapturedCallback);
+		header.startTimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count() - elapsedNs();
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		loggerPtr->info("Capturing DLL callbacks to " + filePath.string());
+
+		const char padding[8] = {};
+		unsigned long long written = 0;
+		unsigned long long reportedDrops = 0;
+
+		std::unique_lock<std::mutex> lock(mtx);
+		while (interruptionCode == edll::Code::RUNNING || slots[tail].state == SlotState::READY) {
+
+			bool ready = cv.wait_for(lock, std::chrono::seconds(1), [this, &interruptionCode] {
+				return slots[tail].state == SlotState::READY || interruptionCode != edll::Code::RUNNING;
+				});
+
+			if (!ready || slots[tail].state != SlotState::READY) {
+				lock.unlock();
+				file.flush();
+				lock.lock();
+				continue;
+			}
+
+			Slot& slot = slots[tail];
+			unsigned long long dropped = droppedCallbacks - reportedDrops;
+			reportedDrops = droppedCallbacks;
+
+			lock.unlock();
+			if (dropped > 0) {
+				loggerPtr->warn("Callback capture dropped " + std::to_string(dropped) + " callbacks");
+			}
+			file.write(reinterpret_cast<const char*>(&slot.record), sizeof(slot.record));
+			file.write(slot.body.data(), slot.body.size());
+			file.write(padding, CapturedCallback::padded(slot.body.size()) - slot.body.size());
+			written++;
+			lock.lock();
+
+			slot.state = SlotState::FREE;
+			tail = (tail + 1) % slots.size();
+		}
+		lock.unlock();
+
+		file.close();
+		loggerPtr->info("Callback capture closed after " + std::to_string(written) + " callbacks, " + std::to_string(reportedDrops) + " dropped");
+	}
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Zero initialized buffer sized for a DLL body type, refilled with each replayed body
+ *
+ * Only the bytes written by the previous body are cleared, instead of the whole body type.
+**/
+class ReplayBody {
+private:
+	std::unique_ptr<std::max_align_t[]> storage;
+	size_t capacity = 0;
+	size_t used = 0;
+
+public:
+	explicit ReplayBody(size_t size)
+		: storage(new std::max_align_t[(size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t)]), capacity(size) {
+		// Value initialization may leave the padding of std::max_align_t members uninitialized
+		std::memset(storage.get(), 0, capacity);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Copy a stored body into the buffer, leaving the rest zeroed
+	 *
+	 * @param bytes: Stored body
+	 * @param size: Number of stored bytes
+	 * @return void*: Pointer to the body, or nullptr if the stored body does not fit the body type
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void* fill(const char* bytes, size_t size) {
+		if (size > capacity) {
+			return nullptr;
+		}
+		char* buffer = reinterpret_cast<char*>(storage.get());
+		if (used > size) {
+			std::memset(buffer + size, 0, used - size);
+		}
+		std::memcpy(buffer, bytes, size);
+		used = size;
+		return buffer;
+	}
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Replay of a capture file into the DLL callbacks
+**/
+class CallbackReplay {
+private:
+	// Configuration, set before the service starts
+	bool enabled = false;
+	std::filesystem::path filePath;
+	double speed = 1.0;
+	bool loop = false;
+
+	// ----------------------------------------------------------------------
+	/** @brief Replay the capture file once
+	 *
+	 * @param file: Mapped capture file
+	 * @param interruptionCode: Signal interruption for service interruption
+	 * @param dispatch: Function receiving each CapturedCallback and a pointer to its stored body
+	 * @return bool: True if the whole file was replayed, false if interrupted or corrupted
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <typename Dispatch>
+	bool replayOnce(const MappedFile& file, const edll::INT_CODE& interruptionCode, Dispatch& dispatch) {
+		const char* data = file.data();
+		size_t size = file.size();
+		size_t offset = sizeof(CaptureFileHeader);
+
+		unsigned long long callbacks = 0;
+		unsigned long long bytes = 0;
+		auto start = std::chrono::steady_clock::now();
+
+		while (offset + sizeof(CapturedCallback) <= size) {
+			if (interruptionCode != edll::Code::RUNNING) {
+				return false;
+			}
+
+			CapturedCallback record;
+			std::memcpy(&record, data + offset, sizeof(record));
+			size_t bodyOffset = offset + sizeof(record);
+			if (record.size > size - bodyOffset) {
+				loggerPtr->error("Callback replay stopped. Truncated record at offset " + std::to_string(offset) + " of " + filePath.string());
+				return false;
+			}
+
+			// Wait in short steps to follow service interruption
+			if (speed > 0) {
+				auto due = start + std::chrono::nanoseconds(static_cast<long long>(record.offsetNs / speed));
+				while (std::chrono::steady_clock::now() < due && interruptionCode == edll::Code::RUNNING) {
+					std::this_thread::sleep_until((std::min)(due, std::chrono::steady_clock::now() + std::chrono::milliseconds(100)));
+				}
+			}
+
+			dispatch(record, record.flags & CapturedCallback::NULL_BODY ? nullptr : data + bodyOffset);
+
+			callbacks++;
+			bytes += record.size;
+			offset = bodyOffset + CapturedCallback::padded(record.size);
+		}
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		loggerPtr->info(fmt::format("Replayed {} callbacks, {:.1f} MB in {:.3f} s: {:.0f} callbacks/s, {:.1f} MB/s",
+			callbacks, bytes / 1e6, seconds, callbacks / (std::max)(seconds, 1e-9), bytes / 1e6 / (std::max)(seconds, 1e-9)));
+		return true;
+	}
+
+public:
+	CallbackReplay() = default;
+
+	// ----------------------------------------------------------------------
+	/** @brief Set the replay configuration. Must be called before the service starts.
+	 *
+	 * @param enable: Replay the capture file instead of connecting to the station
+	 * @param path: Capture file to replay
+	 * @param replaySpeed: Pace relative to the capture, e.g. 1 for the original pace, 10 for ten times faster or 0 for as fast as possible
+	 * @param repeat: Replay the file again once finished, until the service is interrupted
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void configure(bool enable, const std::string& path, double replaySpeed, bool repeat) {
+		enabled = enable && !path.empty() && replaySpeed >= 0;
+		filePath = path;
+		speed = replaySpeed;
+		loop = repeat;
+	}
+
+	bool isEnabled() const { return enabled; }
+
+	// ----------------------------------------------------------------------
+	/** @brief Replay the capture file into the callbacks
+	 *
+	 * This function will lock the thread. Must be run in a separate thread.
+	 * Callbacks are dispatched from this thread, one at a time, as the DLL does for a single station.
+	 *
+	 * @param interruptionCode: Signal interruption for service interruption
+	 * @param dispatch: Function receiving each CapturedCallback and a pointer to its stored body, or nullptr for null bodies
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <typename Dispatch>
+	void run(const edll::INT_CODE& interruptionCode, Dispatch dispatch) {
+		if (!enabled) {
+			return;
+		}
+
+		MappedFile file;
+		CaptureFileHeader header{};
+		if (file.openRead(filePath) && file.size() >= sizeof(header)) {
+			std::memcpy(&header, file.data(), sizeof(header));
+		}
+		if (std::memcmp(header.magic, CaptureFileHeader::MAGIC, sizeof(header.magic)) != 0 ||
+			header.version != CaptureFileHeader::VERSION || header.recordSize != sizeof(CapturedCallback)) {
+			loggerPtr->error("Callback replay disabled. " + filePath.string() + " is not a valid capture file");
+			return;
+		}
+
+		loggerPtr->info(fmt::format("Replaying DLL callbacks from {} at {}", filePath.string(), speed > 0 ? fmt::format("{}x speed", speed) : std::string("full speed")));
+		bool completed = true;
+		do {
+			completed = replayOnce(file, interruptionCode, dispatch);
+		} while (completed && loop);
+	}
+};
+
+
+// Callback capture fed by the DLL callbacks and drained by its own thread
+extern CallbackCapture callbackCapture;
+
+// Replay of a capture file, used instead of the station connection when enabled
+extern CallbackReplay callbackReplay;
@@ -0,0 +1,517 @@
+/**
+* @file etherDLLChannelMap.hpp
+*
+* @brief Header file for the server side assembly of chunked occupancy results into full band maps
+*
+* Occupancy and occupancy DF results are received from the DLL in chunks, each one covering the channels
+* from occHdr.firstChannel to occHdr.firstChannel + occHdr.numChannels of a band with occHdr.numTotalChannels.
+* The service merges the chunks of each task into contiguous columns, one for each member of the results.
+* The full band is sent when it wraps or is complete, and optionally at a fixed period, replacing the chunks,
+* or on request by the client with command code 9102.
+*
+* * @author fslobao
+* * @date 2025-10-28
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+
+// ----------------------------------------------------------------------
+#pragma once
+
+// Include provided DLL libraries
+#include "StdAfx.h"
+#include "EquipCtrlMsg.h"
+
+// Include DLL specific libraries
+#include "etherDLLCodes.hpp"
+#include "etherDLLSerializers.hpp"
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+#include "EtherDLLClient.hpp"
+#include "EtherDLLWriter.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+// Include general C++ libraries
+#include <string>
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <type_traits>
+#include <utility>
+#include <tuple>
+
+// For convenience
+using json = nlohmann::json;
+
+// Global variables
+extern spdlog::logger* loggerPtr;
+extern MessageQueue response;
+extern std::string clientIdKey;
+
+
+// ----------------------------------------------------------------------
+/** @brief Columns assembled from OCCDF_SCANDF_VS_CHANNEL chunks, read for each channel of the chunk
+**/
+constexpr auto SCANDF_COLUMNS = std::make_tuple(
+	edll::jsonField("chanData", [](const SEquipCtrlMsg::SScanDfVsChannelResp& chunk, size_t i) { return chunk.scanDfData[i]; }),
+	edll::jsonField("aveRange", [](const SEquipCtrlMsg::SScanDfVsChannelResp& chunk, size_t i) { return chunk.aveRange[i]; }),
+	edll::jsonField("aveFldStr", [](const SEquipCtrlMsg::SScanDfVsChannelResp& chunk, size_t i) { return chunk.aveFldStr[i]; })
+);
+
+// ----------------------------------------------------------------------
+/** @brief Columns assembled from OCC_CHANNEL_RESULT, OCC_EFLD_CHANNEL_RESULT and OCC_MSGLEN_CHANNEL_RESULT chunks
+**/
+constexpr auto OCC_RESULT_COLUMNS = std::make_tuple(
+	edll::jsonField("avg", [](const SEquipCtrlMsg::SOccResult& chunk, size_t i) { return chunk.resultData[i].avg; }),
+	edll::jsonField("max", [](const SEquipCtrlMsg::SOccResult& chunk, size_t i) { return chunk.resultData[i].max; })
+);
+
+
+// ----------------------------------------------------------------------
+/** @brief Full band maps of the occupancy and occupancy DF tasks, by DLL request ID and response type
+ *
+ * Updated by the DLL callback with each chunk and read by the request thread.
+ * A band is kept until its task reports the completed or terminated status, or until the session disconnects.
+ * The DLL is never called and no callback is waited for while holding the lock.
+**/
+class ChannelMap {
+private:
+	// Values of one member of the results over the band, stored as little endian bytes
+	struct Column {
+		const char* type = nullptr;
+		size_t elementSize = 0;
+		std::vector<unsigned char> bytes;
+	};
+
+	// Band of a single task and response type
+	struct Band {
+		RequestEntry owner;
+		ECSMSDllMsgType respType = ECSMSDllMsgType(0);
+		SEquipCtrlMsg::SOccupancyHeader occHdr{};	// Header of the latest chunk
+		unsigned long numAzimuths = 0;
+		std::vector<Column> columns;
+
+		size_t nextChannel = 0;						// Channel following the latest chunk, to detect the band wrap
+		size_t passChannels = 0;					// Channels received since the band was last sent
+		unsigned long long updates = 0;
+		unsigned long long sequence = 0;
+		std::chrono::steady_clock::time_point lastSent;
+	};
+
+	std::mutex mtx;
+	std::unordered_map<uint64_t, Band> bands;
+
+	// Assembly configuration
+	bool enabled = false;
+	std::chrono::milliseconds period{ 0 };
+
+	// Status codes of SEquipTaskStatusResp reporting the end of the task, as in eStatusToString
+	static constexpr unsigned long TASK_COMPLETED = 2;
+	static constexpr unsigned long TASK_TERMINATED = 3;
+
+	static uint64_t bandKey(unsigned long requestID, ECSMSDllMsgType respType) {
+		return (uint64_t(requestID) << 32) | uint32_t(respType);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Copy the channels of a chunk into the columns of the band, allocating the columns for the whole band if needed
+	 *
+	 * @param band: Band receiving the chunk
+	 * @param chunk: Results received in the DLL callback
+	 * @param numTotalChannels: Number of channels of the band
+	 * @param firstChannel: First channel of the chunk
+	 * @param numChannels: Number of valid channels in the chunk
+	 * @param columns: Tuple with the column list of the results
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <typename Chunk, typename Columns>
+	static void storeChunk(Band& band, const Chunk& chunk, size_t numTotalChannels, size_t firstChannel, size_t numChannels, const Columns& columns) {
+		if (band.columns.size() != std::tuple_size_v<Columns> || band.columns[0].bytes.size() != numTotalChannels * band.columns[0].elementSize) {
+			band.columns.assign(std::tuple_size_v<Columns>, Column());
+			size_t c = 0;
+			std::apply([&](const auto&... column) {
+				(initColumn(band.columns[c++], chunk, numTotalChannels, column), ...);
+				}, columns);
+			band.nextChannel = 0;
+			band.passChannels = 0;
+		}
+
+		size_t c = 0;
+		std::apply([&](const auto&... column) {
+			(storeColumn(band.columns[c++], chunk, firstChannel, numChannels, column), ...);
+			}, columns);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Allocate a column for the whole band, with the element type returned by the column getter
+	 *
+	 * @param target: Column to be allocated, filled with zeros
+	 * @param chunk: Results received in the DLL callback, used to deduce the element type
+	 * @param numTotalChannels: Number of channels of the band
+	 * @param column: Column of the column list
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <typename Chunk, typename Field>
+	static void initColumn(Column& target, const Chunk& chunk, size_t numTotalChannels, const Field& column) {
+		using Value = decltype(column.get(chunk, size_t(0)));
+
+		target.type = edll::columnType<Value>();
+		target.elementSize = sizeof(Value);
+		target.bytes.assign(numTotalChannels * sizeof(Value), 0);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Copy the values of one column of a chunk into the band
+	 *
+	 * @param target: Column of the band, already allocated
+	 * @param chunk: Results received in the DLL callback
+	 * @param firstChannel: First channel of the chunk
+	 * @param numChannels: Number of valid channels in the chunk
+	 * @param column: Column of the column list
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <typename Chunk, typename Field>
+	static void storeColumn(Column& target, const Chunk& chunk, size_t firstChannel, size_t numChannels, const Field& column) {
+		using Value = decltype(column.get(chunk, size_t(0)));
+
+		unsigned char* out = target.bytes.data() + firstChannel * sizeof(Value);
+		for (size_t i = 0; i < numChannels; i++) {
+			Value value = column.get(chunk, i);
+			std::memcpy(out + i * sizeof(Value), &value, sizeof(Value));
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Write the columns of a band, using the keys of the column list
+	 *
+	 * @param band: Band to be written
+	 * @param columns: Tuple with the column list used to assemble the band
+	 * @param writer: Writer receiving the columns as members of the current object
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <typename Columns>
+	static void writeColumns(const Band& band, const Columns& columns, edll::JsonWriter& writer) {
+		size_t c = 0;
+		std::apply([&](const auto&... column) {
+			((writer.key(column.key).beginObject()
+				.field("type", band.columns[c].type)
+				.key("data").binary(band.columns[c].bytes.data(), band.columns[c].bytes.size())
+				.endObject(),
+				c++), ...);
+			}, columns);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Write a band as the members of the current object, in the same layout used for the chunks. Must be called with the lock held.
+	 *
+	 * @param band: Band to be written
+	 * @param complete: True if every channel of the band was received since it was last sent
+	 * @param writer: Writer receiving the members of the response object
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static void writeBand(const Band& band, bool complete, edll::JsonWriter& writer) {
+		size_t numTotalChannels = band.columns.empty() || band.columns[0].elementSize == 0 ? 0 : band.columns[0].bytes.size() / band.columns[0].elementSize;
+
+		SEquipCtrlMsg::SOccupancyHeader occHdr = band.occHdr;
+		occHdr.firstChannel = 0;
+		occHdr.numChannels = static_cast<decltype(occHdr.numChannels)>(numTotalChannels);
+		edll::writeFields(writer, occHdr, OCCUPANCY_HEADER_FIELDS);
+
+		writer.key("band").beginObject();
+		writer.field("sequence", band.sequence);
+		writer.field("complete", complete);
+		writer.field("channelsReceived", (unsigned long)(std::min)(band.passChannels, numTotalChannels));
+		writer.field("updates", band.updates);
+		writer.endObject();
+
+		if (band.respType == ECSMSDllMsgType::OCCDF_SCANDF_VS_CHANNEL) {
+			writer.key("channel").beginObject();
+			writer.key("Occupancy").beginObject();
+			writer.field("numAzimuths", band.numAzimuths);
+			writer.field("firstChannel", 0UL);
+			writer.field("numChannels", (unsigned long)numTotalChannels);
+			writer.field("numTotalChannels", (unsigned long)numTotalChannels);
+			writeColumns(band, SCANDF_COLUMNS, writer);
+			writer.endObject();
+			writer.endObject();
+		}
+		else {
+			writer.key("SOccResult").beginObject();
+			writer.field("firstChannel", 0UL);
+			writer.field("numChannels", (unsigned long)numTotalChannels);
+			writeColumns(band, OCC_RESULT_COLUMNS, writer);
+			writer.endObject();
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Merge a chunk into the band of its task and write the band if it must be sent
+	 *
+	 * The band is sent when a chunk starts before the end of the previous one (band wrap),
+	 * when the last channel of the band is received (band complete), or when the period expires.
+	 *
+	 * @param requestID: Request ID received in the DLL callback
+	 * @param respType: Type of the response message
+	 * @param owner: Registry entry of the request that started the task
+	 * @param chunk: Results received in the DLL callback
+	 * @param capacity: Maximum number of channels in a chunk
+	 * @param numAzimuths: Number of azimuths of occupancy DF results, zero otherwise
+	 * @param columns: Tuple with the column list of the results
+	 * @return std::string: Response body with the full band, empty if the band is not to be sent
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <typename Chunk, typename Columns>
+	std::string assemble(unsigned long requestID, ECSMSDllMsgType respType, const RequestEntry& owner, const Chunk& chunk, size_t capacity, unsigned long numAzimuths, const Columns& columns) {
+		size_t numTotalChannels = chunk.occHdr.numTotalChannels;
+		size_t firstChannel = chunk.occHdr.firstChannel;
+		size_t numChannels = (std::min)(static_cast<size_t>(chunk.occHdr.numChannels), capacity);
+		if (numTotalChannels == 0 || firstChannel >= numTotalChannels) {
+			return std::string();
+		}
+		numChannels = (std::min)(numChannels, numTotalChannels - firstChannel);
+
+		std::lock_guard<std::mutex> lock(mtx);
+
+		uint64_t key = bandKey(requestID, respType);
+		auto it = bands.find(key);
+		if (it == bands.end()) {
+			it = bands.emplace(key, Band()).first;
+			it->second.owner = owner;
+			it->second.respType = respType;
+			it->second.lastSent = std::chrono::steady_clock::now();
+		}
+
+		Band& band = it->second;
+		edll::JsonWriter writer;
+
+		// The band restarted before the previous pass was complete
+		bool wrapped = band.passChannels > 0 && firstChannel < band.nextChannel;
+		if (wrapped && enabled) {
+			sendBand(band, false, writer);
+		}
+		if (wrapped) {
+			band.passChannels = 0;
+		}
+
+		storeChunk(band, chunk, numTotalChannels, firstChannel, numChannels, columns);
+		band.occHdr = chunk.occHdr;
+		band.numAzimuths = numAzimuths;
+		band.nextChannel = firstChannel + numChannels;
+		band.passChannels += numChannels;
+		band.updates++;
+
+		bool complete = band.nextChannel >= numTotalChannels;
+		bool expired = period.count() > 0 && std::chrono::steady_clock::now() - band.lastSent >= period;
+		if (enabled && writer.empty() && (complete || expired)) {
+			sendBand(band, complete && band.passChannels >= numTotalChannels, writer);
+		}
+		if (complete) {
+			band.nextChannel = 0;
+			band.passChannels = 0;
+		}
+
+		return writer.str();
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Write the band to be sent and restart the period. Must be called with the lock held.
+	 *
+	 * @param band: Band to be sent
+	 * @param complete: True if every channel of the band was received since it was last sent
+	 * @param writer: Empty writer receiving the response body
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static void sendBand(Band& band, bool complete, edll::JsonWriter& writer) {
+		band.sequence++;
+		band.lastSent = std::chrono::steady_clock::now();
+
+		writer.beginObject();
+		writeBand(band, complete, writer);
+		writer.endObject();
+	}
+
+public:
+	// ----------------------------------------------------------------------
+	/** @brief Set the assembly parameters. Must be called before the DLL callbacks are registered.
+	 *
+	 * @param enable: True to send the full bands instead of the chunks
+	 * @param periodMs: Period to send the band even if it is not complete, in milliseconds. Zero to send it only on wrap
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void configure(bool enable, long long periodMs) {
+		std::lock_guard<std::mutex> lock(mtx);
+		enabled = enable;
+		period = std::chrono::milliseconds((std::max)(periodMs, 0LL));
+
+		if (enabled) {
+			loggerPtr->info("Occupancy results sent as full bands, on band wrap" + (period.count() > 0 ? " or every " + std::to_string(period.count()) + " ms" : std::string()));
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Test if the chunks of a response type are replaced by the full band
+	 * Called from the DLL callback thread, without locking, since the configuration is set before the callbacks are registered.
+	 *
+	 * @param respType: Type of the response message
+	 * @return bool: True if the chunks must not be sent to the client
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool replacesChunks(ECSMSDllMsgType respType) const {
+		return enabled && assembles(respType);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Test if a response type is assembled into full bands
+	 *
+	 * @param respType: Type of the response message
+	 * @return bool: True for the channel results of occupancy and occupancy DF tasks
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static bool assembles(ECSMSDllMsgType respType) {
+		switch (respType) {
+		case ECSMSDllMsgType::OCCDF_SCANDF_VS_CHANNEL:
+		case ECSMSDllMsgType::OCC_CHANNEL_RESULT:
+		case ECSMSDllMsgType::OCC_EFLD_CHANNEL_RESULT:
+		case ECSMSDllMsgType::OCC_MSGLEN_CHANNEL_RESULT:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Merge a chunk received from the DLL into the band of its task, or drop the bands of the task when it ends
+	 * Called from the DLL callback thread. Other response types are ignored.
+	 *
+	 * @param requestID: Request ID received in the DLL callback
+	 * @param respType: Type of the response message
+	 * @param owner: Registry entry of the request that started the task
+	 * @param data: Pointer to the response data
+	 * @return std::string: Response body with the full band if it must be sent, empty otherwise
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	std::string update(unsigned long requestID, ECSMSDllMsgType respType, const RequestEntry& owner, const SEquipCtrlMsg::UBody* data) {
+		switch (respType) {
+		case ECSMSDllMsgType::OCCDF_SCANDF_VS_CHANNEL:
+		{
+			const auto& chunk = *reinterpret_cast<const SEquipCtrlMsg::SScanDfVsChannelResp*>(data);
+			return assemble(requestID, respType, owner, chunk, sizeof(chunk.scanDfData) / sizeof(chunk.scanDfData[0]), chunk.numAzimuths, SCANDF_COLUMNS);
+		}
+		case ECSMSDllMsgType::OCC_CHANNEL_RESULT:
+		case ECSMSDllMsgType::OCC_EFLD_CHANNEL_RESULT:
+		case ECSMSDllMsgType::OCC_MSGLEN_CHANNEL_RESULT:
+		{
+			const auto& chunk = *reinterpret_cast<const SEquipCtrlMsg::SOccResult*>(data);
+			return assemble(requestID, respType, owner, chunk, sizeof(chunk.resultData) / sizeof(chunk.resultData[0]), 0UL, OCC_RESULT_COLUMNS);
+		}
+		case ECSMSDllMsgType::OCC_STATUS:
+		case ECSMSDllMsgType::OCCDF_STATUS:
+		{
+			const auto& status = *reinterpret_cast<const SEquipCtrlMsg::SEquipTaskStatusResp*>(data);
+			if (status.status == TASK_COMPLETED || status.status == TASK_TERMINATED) {
+				eraseRequest(requestID);
+			}
+			return std::string();
+		}
+		default:
+			return std::string();
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Answer a snapshot request with the bands of the tasks owned by the requesting session
+	 *
+	 * One response is pushed for each band, identified by the client ID of the snapshot request.
+	 * The client ID of the request that started the task is written as taskClientId and the response type as resultCode.
+	 *
+	 * @param request: Snapshot request received from the client
+	 * @return size_t: Number of responses pushed
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	size_t snapshot(const json& request) {
+		using TaskKeys = edll::DefaultConfig::Service::TaskKeys;
+
+		unsigned long sessionId = request.value(TaskKeys::SessionId::VALUE, TaskKeys::SessionId::INIT_VALUE);
+		edll::JsonWriter writer;
+		size_t count = 0;
+
+		std::lock_guard<std::mutex> lock(mtx);
+		for (const auto& [key, band] : bands) {
+			if (band.owner.sessionId != sessionId) {
+				continue;
+			}
+
+			size_t numTotalChannels = band.columns.empty() ? 0 : band.columns[0].bytes.size() / band.columns[0].elementSize;
+
+			writer.clear();
+			writer.beginObject();
+			writer.field("taskClientId", band.owner.clientId);
+			writer.field("resultCode", int(band.respType));
+			writeBand(band, band.passChannels >= numTotalChannels, writer);
+			writer.endObject();
+
+			json snapshotResponse;
+			snapshotResponse[TaskKeys::CommandCode::VALUE] = StreamMsgType::BAND_SNAPSHOT;
+			snapshotResponse[TaskKeys::CommandName::VALUE] = StreamMsgType::toString(StreamMsgType::BAND_SNAPSHOT);
+			snapshotResponse[TaskKeys::Arguments::VALUE] = json::object();
+			snapshotResponse[TaskKeys::SessionId::VALUE] = sessionId;
+			snapshotResponse[clientIdKey] = request.value(clientIdKey, json(TaskKeys::ClientId::INIT_VALUE));
+			snapshotResponse[edll::BODY_KEY] = writer.str();
+			response.push(snapshotResponse, "ChannelMap");
+
+			loggerPtr->info("[" + band.owner.commandName + "] band sent after " + std::to_string(band.updates) + " updates");
+			count++;
+		}
+		return count;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Drop the bands of a task, of every response type
+	 *
+	 * @param requestID: Request ID of the task
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void eraseRequest(unsigned long requestID) {
+		std::lock_guard<std::mutex> lock(mtx);
+		for (auto band = bands.begin(); band != bands.end();) {
+			band = (band->first >> 32) == requestID ? bands.erase(band) : std::next(band);
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Drop the bands owned by a session
+	 *
+	 * @param sessionId: Session disconnected
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void eraseSession(unsigned long sessionId) {
+		std::lock_guard<std::mutex> lock(mtx);
+		for (auto band = bands.begin(); band != bands.end();) {
+			band = band->second.owner.sessionId == sessionId ? bands.erase(band) : std::next(band);
+		}
+	}
+};
+
+
+// Full band maps of the occupancy tasks, shared by the request thread and the DLL callbacks
+extern ChannelMap channelMap;
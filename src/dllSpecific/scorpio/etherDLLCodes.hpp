@@ -38,6 +38,52 @@
 // For convenience
 using json = nlohmann::json;
 
+// ----------------------------------------------------------------------
+/** @brief Command codes handled by the service on top of the DLL functions
+ *
+ * Codes are above the range used by ECSMSDllMsgType, so they never collide with DLL message types.
+**/
+struct StreamMsgType {
+	static constexpr unsigned long STREAM_PAN_START = 9100;
+	static constexpr unsigned long STREAM_PAN_STOP = 9101;
+	static constexpr unsigned long BAND_SNAPSHOT = 9102;
+	static constexpr unsigned long SWEEP_QUERY = 9103;
+	static constexpr unsigned long TRACE_SUBSCRIBE = 9104;
+	static constexpr unsigned long TRACE_UNSUBSCRIBE = 9105;
+	static constexpr unsigned long TRACE_RESET = 9106;
+	static constexpr unsigned long WATERFALL = 9107;
+
+	static constexpr unsigned long CODES[] = { STREAM_PAN_START, STREAM_PAN_STOP, BAND_SNAPSHOT, SWEEP_QUERY,
+		TRACE_SUBSCRIBE, TRACE_UNSUBSCRIBE, TRACE_RESET, WATERFALL };
+
+	static constexpr const char* toString(unsigned long code) {
+		switch (code) {
+			case STREAM_PAN_START: return "StreamPanStart";
+			case STREAM_PAN_STOP: return "StreamPanStop";
+			case BAND_SNAPSHOT: return "BandSnapshot";
+			case SWEEP_QUERY: return "SweepQuery";
+			case TRACE_SUBSCRIBE: return "TraceSubscribe";
+			case TRACE_UNSUBSCRIBE: return "TraceUnsubscribe";
+			case TRACE_RESET: return "TraceReset";
+			case WATERFALL: return "Waterfall";
+			default: return nullptr;
+		}
+	}
+};
+
+// ----------------------------------------------------------------------
+/** @brief Event that completes a command, releasing its admission control slot
+ *
+ * Task control commands take the request ID of the task they address and their replies carry that task ID,
+ * so they complete when the DLL call returns and are not added to the request registry.
+ * The event of each command is set in the command table of etherDLLRequest.hpp.
+**/
+struct CommandCompletion {
+	static constexpr int SERVICE = 0;		// Answered by the service, without calling the DLL
+	static constexpr int DLL_RETURN = 1;	// DLL call returned
+	static constexpr int DLL_RESPONSE = 2;	// First DLL response carrying the request ID returned by the call
+};
+
 // ----------------------------------------------------------------------
 /** @brief Function to convert ERetCode to string
  *
@@ -81,6 +127,10 @@ std::string ERetCodeToString(ERetCode code)
 **/
 std::string ECSMSDllMsgTypeToString(ECSMSDllMsgType code)
 {
+	if (StreamMsgType::toString(code) != nullptr) {
+		return std::string(StreamMsgType::toString(code)) + ". Code " + std::to_string(code);
+	}
+
 	switch (code)
 	{
 	case GET_MSG_VERSION: return "Get message version. Code " + std::to_string(code);
@@ -26,6 +26,7 @@
 
 // Include DLL specific libraries
 #include "etherDLLResponse.hpp"
+#include "etherDLLPeaks.hpp"
 
 // Include core EtherDLL libraries
 #include "EtherDLLConfig.hpp"
@@ -37,6 +38,13 @@
 #include <vector>
 #include <cstdint>
 #include <limits>
+#include <cmath>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ETHERDLL_DECIMATE_SSE2
+#endif
 
 // For convenience
 
@@ -47,9 +55,15 @@ struct SpectrumInfo {
     double binSize;         // Hz
 };
 
+// Reduction of the bins merged into one output bin when a spectrum is decimated
+enum class Decimation : int {
+    MAX = 0,    // Peak preserving
+    MEAN = 1,
+    MIN = 2
+};
+
 // Constants
 constexpr double FREQ_FACTOR = 1920.0;
-constexpr float BYTE_POWER_OFFSET = 192.0;
 
 // ----------------------------------------------------------------------
 /** @brief Expand scan data from compressed format
@@ -128,6 +142,172 @@ const unsigned char* parsedBinData(const unsigned char* binData, unsigned short
 }
 
 
+// ----------------------------------------------------------------------
+/** @brief Read a decimation name received from the client
+ *
+ * @param name: Decimation name, "max", "mean" or "min"
+ * @param decimation: Decimation matching the name, unchanged if the name is unknown
+ * @return bool: True if the name is known, false otherwise
+ * @throws NO EXCEPTION HANDLING
+**/
+bool decimationFromString(const std::string& name, Decimation& decimation)
+{
+    if (name == "max") { decimation = Decimation::MAX; return true; }
+    if (name == "mean") { decimation = Decimation::MEAN; return true; }
+    if (name == "min") { decimation = Decimation::MIN; return true; }
+    return false;
+}
+
+const char* decimationToString(Decimation decimation)
+{
+    switch (decimation) {
+    case Decimation::MEAN: return "mean";
+    case Decimation::MIN: return "min";
+    default: return "max";
+    }
+}
+
+// ----------------------------------------------------------------------
+/** @brief Number of bins sent to the client for a spectrum of numBins bins
+ *
+ * @param numBins: Number of bins received from the station
+ * @param outputBins: Number of bins requested by the client, zero to send every bin
+ * @return size_t: Number of bins sent, never more than numBins
+ * @throws NO EXCEPTION HANDLING
+**/
+inline size_t outputBinCount(size_t numBins, size_t outputBins)
+{
+    return (outputBins == 0 || outputBins >= numBins) ? numBins : outputBins;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Reduce a group of 8-bit bins to one value
+ *
+ * The group is reduced 16 bins at a time with SSE2 when available, max and min are exact in 8 bits
+ * and the mean is computed from the exact sum of the bins.
+ *
+ * @tparam D: Reduction applied to the group
+ * @param bins: Pointer to the first bin of the group
+ * @param count: Number of bins in the group, at least one
+ * @return float: Reduced value, in the 8-bit scale of the bins
+ * @throws NO EXCEPTION HANDLING
+**/
+template <Decimation D>
+inline float reduceBinGroup(const unsigned char* bins, size_t count)
+{
+    size_t i = 0;
+
+    if constexpr (D == Decimation::MEAN) {
+        uint32_t sum = 0;
+#ifdef ETHERDLL_DECIMATE_SSE2
+        if (count >= 16) {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i acc = _mm_setzero_si128();
+            for (; i + 16 <= count; i += 16) {
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bins + i));
+                acc = _mm_add_epi64(acc, _mm_sad_epu8(b, zero));
+            }
+            // Each 64-bit lane holds at most 65535 * 255, well within 32 bits
+            sum = static_cast<uint32_t>(_mm_cvtsi128_si32(acc)) + static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+        }
+#endif
+        for (; i < count; i++) {
+            sum += bins[i];
+        }
+        return static_cast<float>(double(sum) / double(count));
+    }
+    else {
+        auto pick = [](unsigned char a, unsigned char b) { return D == Decimation::MAX ? (std::max)(a, b) : (std::min)(a, b); };
+        unsigned char value = bins[0];
+#ifdef ETHERDLL_DECIMATE_SSE2
+        if (count >= 16) {
+            auto combine = [](__m128i a, __m128i b) { return D == Decimation::MAX ? _mm_max_epu8(a, b) : _mm_min_epu8(a, b); };
+            __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bins));
+            for (i = 16; i + 16 <= count; i += 16) {
+                acc = combine(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(bins + i)));
+            }
+            // Fold the 16 lanes into the first one
+            acc = combine(acc, _mm_srli_si128(acc, 8));
+            acc = combine(acc, _mm_srli_si128(acc, 4));
+            acc = combine(acc, _mm_srli_si128(acc, 2));
+            acc = combine(acc, _mm_srli_si128(acc, 1));
+            value = static_cast<unsigned char>(_mm_cvtsi128_si32(acc));
+        }
+#endif
+        for (; i < count; i++) {
+            value = pick(value, bins[i]);
+        }
+        return static_cast<float>(value);
+    }
+}
+
+// ----------------------------------------------------------------------
+/** @brief Decimate numInput 8-bit bins into numOutput float32 values with offset
+ *
+ * Output bin j merges the input bins from floor(j * numInput / numOutput) up to floor((j + 1) * numInput / numOutput),
+ * so every input bin is used exactly once.
+ *
+ * @tparam D: Reduction applied to the bins merged into each output bin
+ * @param binData: Pointer to the input binary data array (uint8)
+ * @param numInput: Number of elements in the input array
+ * @param output: Pointer to the output array
+ * @param numOutput: Number of elements in the output array, less than numInput
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+template <Decimation D>
+void decimateBins(const unsigned char* binData, size_t numInput, float* output, size_t numOutput)
+{
+    size_t first = 0;
+    for (size_t j = 0; j < numOutput; ++j) {
+        size_t last = (j + 1) * numInput / numOutput;
+        output[j] = reduceBinGroup<D>(binData + first, last - first) - BYTE_POWER_OFFSET;
+        first = last;
+    }
+}
+
+// ----------------------------------------------------------------------
+/** @brief Decimate 8-bit binary data to outputBins float32 values with offset
+ *
+ * Equivalent to decimating the output of parsedBinData, but the bins are reduced in their 8-bit form
+ * and only the decimated values are converted.
+ * Without decimation, the result is the same as parsedBinData.
+ *
+ * @param binData: Pointer to the input binary data array (uint8)
+ * @param numBins: Number of elements in the input binary data array
+ * @param outputBins: Number of bins requested by the client, zero to keep every bin
+ * @param decimation: Reduction applied to the bins merged into each output bin
+ * @return const unsigned char*: Pointer to the output data array (uint8) containing outputBinCount float32 values
+ * @throws NO EXCEPTION HANDLING
+**/
+const unsigned char* decimatedBinData(const unsigned char* binData, unsigned short numBins, size_t outputBins, Decimation decimation)
+{
+    const size_t nInput = static_cast<size_t>(numBins);
+    const size_t nOutput = outputBinCount(nInput, outputBins);
+    if (nOutput == nInput) {
+        return parsedBinData(binData, numBins);
+    }
+
+    thread_local static std::vector<unsigned char> decimatedData;
+    decimatedData.resize(nOutput * sizeof(float));
+
+    float* outFloats = reinterpret_cast<float*>(decimatedData.data());
+
+    switch (decimation) {
+    case Decimation::MEAN:
+        decimateBins<Decimation::MEAN>(binData, nInput, outFloats, nOutput);
+        break;
+    case Decimation::MIN:
+        decimateBins<Decimation::MIN>(binData, nInput, outFloats, nOutput);
+        break;
+    default:
+        decimateBins<Decimation::MAX>(binData, nInput, outFloats, nOutput);
+        break;
+    }
+
+    return decimatedData.data();
+}
+
 // ----------------------------------------------------------------------
 /** @brief Calculate spectrum information from pan response
  *
@@ -136,12 +316,14 @@ const unsigned char* parsedBinData(const unsigned char* binData, unsigned short
  * Bin size is converted from internal units to Hz
  * Start and stop frequencies are calculated based on central frequency and half span
  * Half span is calculated as (bin size * floor(numBins / 2)) / 1,000,000 to convert to MHz
+ * When the spectrum is decimated, the span is kept and the bin size is scaled to the number of output bins
  *
  * @param panResponse: Pointer to the SGetPanResp structure containing pan response data
+ * @param outputBins: Number of bins requested by the client, zero to keep every bin
  * @return SpectrumInfo: Structure containing start frequency, stop frequency and bin size
  * @throws NO EXCEPTION HANDLING
 **/
-SpectrumInfo calculateSpectrumInfo(const SEquipCtrlMsg::SGetPanResp* panResponse)
+SpectrumInfo calculateSpectrumInfo(const SEquipCtrlMsg::SGetPanResp* panResponse, size_t outputBins = 0)
 {
     // Convert central frequency from internal units to MHz
     double centralFrequency = double(panResponse->freq.internal) / (FREQ_FACTOR * edll::MHZ_MULTIPLIER);
@@ -156,5 +338,11 @@ SpectrumInfo calculateSpectrumInfo(const SEquipCtrlMsg::SGetPanResp* panResponse
     double startFrequency = centralFrequency - halfSpan;
     double stopFrequency = centralFrequency + halfSpan;
 
+    // Each output bin covers the bins merged into it
+    size_t nOutput = outputBinCount(panResponse->numBins, outputBins);
+    if (nOutput != panResponse->numBins) {
+        binSize *= double(panResponse->numBins) / double(nOutput);
+    }
+
     return { startFrequency, stopFrequency, binSize };
 }
@@ -49,6 +49,7 @@
 #include "EtherDLLUtils.hpp"
 #include "EtherDLLLog.hpp"
 #include "EtherDLLConfig.hpp"
+#include "EtherDLLMetrics.hpp"
 
 // Include project libraries
 #include <nlohmann/json.hpp>
@@ -65,6 +66,7 @@ using json = nlohmann::json;
 
 // Global variables
 extern spdlog::logger* loggerPtr;
+extern ServiceMetrics serviceMetrics;
 
 // 
 // ----------------------------------------------------------------------
@@ -179,6 +181,164 @@ struct DefaultDLLParam {
 			};
 		};
 	};
+
+	struct BandSnapshot {
+		static constexpr const char* KEY = "bandSnapshot";
+
+		struct Enabled {
+			static constexpr const char* KEY = "enabled";
+			static constexpr bool VALUE = false; // send each chunk of occupancy results
+		};
+		struct PeriodMs {
+			static constexpr const char* KEY = "periodMs";
+			static constexpr long long VALUE = 0; // send the band only on wrap
+		};
+	};
+
+	struct IqRecorder {
+		static constexpr const char* KEY = "iqRecorder";
+
+		struct Enabled {
+			static constexpr const char* KEY = "enabled";
+			static constexpr bool VALUE = false;
+		};
+		struct Directory {
+			static constexpr const char* KEY = "directory";
+			static constexpr const char* VALUE = "recordings";
+		};
+		struct FileSizeMB {
+			static constexpr const char* KEY = "fileSizeMB";
+			static constexpr long long VALUE = 256; // data file rotation size, in MiB
+		};
+		struct QueueBlocks {
+			static constexpr const char* KEY = "queueBlocks";
+			static constexpr long long VALUE = 256; // blocks waiting for the disk before new blocks are dropped
+		};
+	};
+
+	struct SweepStore {
+		static constexpr const char* KEY = "sweepStore";
+
+		struct Enabled {
+			static constexpr const char* KEY = "enabled";
+			static constexpr bool VALUE = false;
+		};
+		struct Directory {
+			static constexpr const char* KEY = "directory";
+			static constexpr const char* VALUE = "sweeps";
+		};
+		struct SegmentMB {
+			static constexpr const char* KEY = "segmentMB";
+			static constexpr long long VALUE = 64;
+		};
+		struct MaxAgeS {
+			static constexpr const char* KEY = "maxAgeS";
+			static constexpr long long VALUE = 86400; // zero to keep the sweeps regardless of age
+		};
+		struct MaxTotalMB {
+			static constexpr const char* KEY = "maxTotalMB";
+			static constexpr long long VALUE = 1024; // zero for no size limit
+		};
+		struct QueueSweeps {
+			static constexpr const char* KEY = "queueSweeps";
+			static constexpr long long VALUE = 1024; // sweeps waiting for the disk before new sweeps are dropped
+		};
+		struct MaxBins {
+			static constexpr const char* KEY = "maxBins";
+			static constexpr long long VALUE = 32768; // bins allocated for each queued sweep, larger sweeps are dropped
+		};
+	};
+
+	struct SweepQuery {
+		static constexpr const char* KEY = "sweepQuery";
+
+		struct Threads {
+			static constexpr const char* KEY = "threads";
+			static constexpr long long VALUE = 2; // threads scanning the sweeps of each query
+		};
+		struct MaxPending {
+			static constexpr const char* KEY = "maxPending";
+			static constexpr long long VALUE = 4; // queries waiting to be answered before new queries are refused
+		};
+		struct MaxMemoryMB {
+			static constexpr const char* KEY = "maxMemoryMB";
+			static constexpr long long VALUE = 256; // memory of the accumulators of each query
+		};
+	};
+
+	struct CallbackCapture {
+		static constexpr const char* KEY = "callbackCapture";
+
+		struct Enabled {
+			static constexpr const char* KEY = "enabled";
+			static constexpr bool VALUE = false;
+		};
+		struct Directory {
+			static constexpr const char* KEY = "directory";
+			static constexpr const char* VALUE = "captures";
+		};
+		struct QueueCallbacks {
+			static constexpr const char* KEY = "queueCallbacks";
+			static constexpr long long VALUE = 1024; // callbacks waiting for the disk before new callbacks are dropped
+		};
+	};
+
+	struct CallbackReplay {
+		static constexpr const char* KEY = "callbackReplay";
+
+		struct Enabled {
+			static constexpr const char* KEY = "enabled";
+			static constexpr bool VALUE = false; // replaces the station connection when enabled
+		};
+		struct File {
+			static constexpr const char* KEY = "file";
+			static constexpr const char* VALUE = "";
+		};
+		struct Speed {
+			static constexpr const char* KEY = "speed";
+			static constexpr double VALUE = 1.0; // 1 for the original pace, N for N times faster, 0 for as fast as possible
+		};
+		struct Loop {
+			static constexpr const char* KEY = "loop";
+			static constexpr bool VALUE = false;
+		};
+	};
+	struct PanTraces {
+		static constexpr const char* KEY = "panTraces";
+
+		struct Enabled {
+			static constexpr const char* KEY = "enabled";
+			static constexpr bool VALUE = false;
+		};
+		struct AverageSweeps {
+			static constexpr const char* KEY = "averageSweeps";
+			static constexpr long long VALUE = 10; // sweeps in the linear average, also sets the exponential average weight
+		};
+		struct MaxConfigurations {
+			static constexpr const char* KEY = "maxConfigurations";
+			static constexpr long long VALUE = 8; // pan configurations with traces, the least recently updated is replaced
+		};
+	};
+	struct Waterfall {
+		static constexpr const char* KEY = "waterfall";
+
+		struct Enabled {
+			static constexpr const char* KEY = "enabled";
+			static constexpr bool VALUE = false;
+		};
+		struct Depth {
+			static constexpr const char* KEY = "depth";
+			static constexpr long long VALUE = 256; // sweeps kept in each waterfall
+		};
+		struct MaxWaterfalls {
+			static constexpr const char* KEY = "maxWaterfalls";
+			static constexpr long long VALUE = 8; // pan configurations and realtime bands, the least recently updated is replaced
+		};
+		struct MaxPending {
+			static constexpr const char* KEY = "maxPending";
+			static constexpr long long VALUE = 4; // requests waiting to be answered, new requests are refused beyond it
+		};
+	};
 };
 
 // ----------------------------------------------------------------------
@@ -209,6 +369,36 @@ json buildDLLDefaultParamJson(json default_param = json::object()) {
 	default_param[DefaultDLLParam::KEY][DefaultDLLParam::OCCRequest::KEY][DefaultDLLParam::OCCRequest::occflags::KEY][DefaultDLLParam::OCCRequest::occflags::msglengthDistribution::KEY] = DefaultDLLParam::OCCRequest::occflags::msglengthDistribution::VALUE;
 	default_param[DefaultDLLParam::KEY][DefaultDLLParam::OCCRequest::KEY][DefaultDLLParam::OCCRequest::occflags::KEY][DefaultDLLParam::OCCRequest::occflags::spectrogram::KEY] = DefaultDLLParam::OCCRequest::occflags::spectrogram::VALUE;
 	default_param[DefaultDLLParam::KEY][DefaultDLLParam::OCCRequest::KEY][DefaultDLLParam::OCCRequest::occflags::KEY][DefaultDLLParam::OCCRequest::occflags::timegram::KEY] = DefaultDLLParam::OCCRequest::occflags::timegram::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::BandSnapshot::KEY][DefaultDLLParam::BandSnapshot::Enabled::KEY] = DefaultDLLParam::BandSnapshot::Enabled::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::BandSnapshot::KEY][DefaultDLLParam::BandSnapshot::PeriodMs::KEY] = DefaultDLLParam::BandSnapshot::PeriodMs::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::IqRecorder::KEY][DefaultDLLParam::IqRecorder::Enabled::KEY] = DefaultDLLParam::IqRecorder::Enabled::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::IqRecorder::KEY][DefaultDLLParam::IqRecorder::Directory::KEY] = DefaultDLLParam::IqRecorder::Directory::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::IqRecorder::KEY][DefaultDLLParam::IqRecorder::FileSizeMB::KEY] = DefaultDLLParam::IqRecorder::FileSizeMB::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::IqRecorder::KEY][DefaultDLLParam::IqRecorder::QueueBlocks::KEY] = DefaultDLLParam::IqRecorder::QueueBlocks::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::SweepStore::KEY][DefaultDLLParam::SweepStore::Enabled::KEY] = DefaultDLLParam::SweepStore::Enabled::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::SweepStore::KEY][DefaultDLLParam::SweepStore::Directory::KEY] = DefaultDLLParam::SweepStore::Directory::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::SweepStore::KEY][DefaultDLLParam::SweepStore::SegmentMB::KEY] = DefaultDLLParam::SweepStore::SegmentMB::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::SweepStore::KEY][DefaultDLLParam::SweepStore::MaxAgeS::KEY] = DefaultDLLParam::SweepStore::MaxAgeS::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::SweepStore::KEY][DefaultDLLParam::SweepStore::MaxTotalMB::KEY] = DefaultDLLParam::SweepStore::MaxTotalMB::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::SweepStore::KEY][DefaultDLLParam::SweepStore::QueueSweeps::KEY] = DefaultDLLParam::SweepStore::QueueSweeps::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::SweepStore::KEY][DefaultDLLParam::SweepStore::MaxBins::KEY] = DefaultDLLParam::SweepStore::MaxBins::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::SweepQuery::KEY][DefaultDLLParam::SweepQuery::Threads::KEY] = DefaultDLLParam::SweepQuery::Threads::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::SweepQuery::KEY][DefaultDLLParam::SweepQuery::MaxPending::KEY] = DefaultDLLParam::SweepQuery::MaxPending::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::SweepQuery::KEY][DefaultDLLParam::SweepQuery::MaxMemoryMB::KEY] = DefaultDLLParam::SweepQuery::MaxMemoryMB::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::CallbackCapture::KEY][DefaultDLLParam::CallbackCapture::Enabled::KEY] = DefaultDLLParam::CallbackCapture::Enabled::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::CallbackCapture::KEY][DefaultDLLParam::CallbackCapture::Directory::KEY] = DefaultDLLParam::CallbackCapture::Directory::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::CallbackCapture::KEY][DefaultDLLParam::CallbackCapture::QueueCallbacks::KEY] = DefaultDLLParam::CallbackCapture::QueueCallbacks::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::CallbackReplay::KEY][DefaultDLLParam::CallbackReplay::Enabled::KEY] = DefaultDLLParam::CallbackReplay::Enabled::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::CallbackReplay::KEY][DefaultDLLParam::CallbackReplay::File::KEY] = DefaultDLLParam::CallbackReplay::File::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::CallbackReplay::KEY][DefaultDLLParam::CallbackReplay::Speed::KEY] = DefaultDLLParam::CallbackReplay::Speed::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::CallbackReplay::KEY][DefaultDLLParam::CallbackReplay::Loop::KEY] = DefaultDLLParam::CallbackReplay::Loop::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::PanTraces::KEY][DefaultDLLParam::PanTraces::Enabled::KEY] = DefaultDLLParam::PanTraces::Enabled::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::PanTraces::KEY][DefaultDLLParam::PanTraces::AverageSweeps::KEY] = DefaultDLLParam::PanTraces::AverageSweeps::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::PanTraces::KEY][DefaultDLLParam::PanTraces::MaxConfigurations::KEY] = DefaultDLLParam::PanTraces::MaxConfigurations::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::Waterfall::KEY][DefaultDLLParam::Waterfall::Enabled::KEY] = DefaultDLLParam::Waterfall::Enabled::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::Waterfall::KEY][DefaultDLLParam::Waterfall::Depth::KEY] = DefaultDLLParam::Waterfall::Depth::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::Waterfall::KEY][DefaultDLLParam::Waterfall::MaxWaterfalls::KEY] = DefaultDLLParam::Waterfall::MaxWaterfalls::VALUE;
+	default_param[DefaultDLLParam::KEY][DefaultDLLParam::Waterfall::KEY][DefaultDLLParam::Waterfall::MaxPending::KEY] = DefaultDLLParam::Waterfall::MaxPending::VALUE;
 
 	return default_param;
 }
@@ -360,6 +550,14 @@ bool connectAPI(DLLConnectionData& stationConnID, const nlohmann::json& config)
 	std::string message;
 	SScorpioAPIClient station;
 
+	// Count the service commands apart in the metrics and describe DLL codes
+	for (unsigned long code : StreamMsgType::CODES) {
+		edll::CodeSlots::instance().add(code);
+	}
+	serviceMetrics.setDescribers(
+		[](long long code) { return ECSMSDllMsgTypeToString(static_cast<ECSMSDllMsgType>(code)); },
+		[](long long code) { return ERetCodeToString(static_cast<ERetCode>(code)); });
+
 	using station_conf = DefaultDLLParam::Station;
 	json station_config = config[DefaultDLLParam::KEY][station_conf::KEY].get<json>();
 	
@@ -370,6 +568,13 @@ bool connectAPI(DLLConnectionData& stationConnID, const nlohmann::json& config)
 		return true;
 	}
 
+	// Captured callbacks are fed to the service instead of the station data
+	if (callbackReplay.isEnabled()) {
+		loggerPtr->warn("Starting EtherDLL service in REPLAY mode. No connection to station will be attempted.");
+		stationConnID = DEFAULT_DLL_CONNECTION_DATA;
+		return true;
+	}
+
 	// Prepare station data structure from the config data
 	std::string hostNameStr = station_config[station_conf::Address::KEY].get<std::string>();
 	station.hostName = stringToWString(hostNameStr);
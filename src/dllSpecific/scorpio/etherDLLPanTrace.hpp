@@ -0,0 +1,571 @@
+/**
+* @file etherDLLPanTrace.hpp
+*
+* @brief Header file for the max-hold, min-hold and average traces kept by the service for each pan configuration
+*
+* Every GET_PAN sweep updates the traces of its configuration (center frequency, bin size and number of bins)
+* with the SIMD kernels used by the sweep query, over the raw uint8 bins:
+* max-hold, min-hold, linear average over the last N sweeps and exponential average with the weight of an N sweep average.
+* Clients subscribe to a set of traces with command code 9104 and receive them at the requested rate,
+* only for the configurations updated since the previous frame, instead of receiving every sweep.
+* Command code 9105 stops the subscription and 9106 clears the traces of the configuration at the requested center frequency.
+*
+* * @author fslobao
+* * @date 2025-11-01
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+
+// ----------------------------------------------------------------------
+#pragma once
+
+// Include DLL specific libraries
+#include "etherDLLCodes.hpp"
+#include "etherDLLDataProcess.hpp"
+#include "etherDLLSweepQuery.hpp"
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+#include "EtherDLLClient.hpp"
+#include "EtherDLLWriter.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+// Include general C++ libraries
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <condition_variable>
+
+// For convenience
+using json = nlohmann::json;
+
+// Global variables
+extern spdlog::logger* loggerPtr;
+extern MessageQueue response;
+
+
+// ----------------------------------------------------------------------
+/** @brief Traces accumulated from the pan sweeps and the clients subscribed to them
+**/
+class PanTraces {
+public:
+	// Detectors, combined as a mask in the subscriptions
+	static constexpr unsigned MAX_HOLD = 1;
+	static constexpr unsigned MIN_HOLD = 2;
+	static constexpr unsigned AVERAGE = 4;
+	static constexpr unsigned EXP_AVERAGE = 8;
+
+private:
+	static constexpr unsigned DETECTORS[] = { MAX_HOLD, MIN_HOLD, AVERAGE, EXP_AVERAGE };
+
+	struct Trace {
+		std::mutex mtx;
+
+		// Configuration of the sweeps
+		unsigned long long id = 0;
+		double centerHz = 0;
+		double binHz = 0;
+		size_t numBins = 0;
+
+		// Accumulators over the raw uint8 bins
+		unsigned long long sweeps = 0;		// Since the last reset
+		unsigned long long version = 0;		// Updates since created, used to send only updated traces
+		std::atomic<long long> lastUpdate{ 0 };	// steady_clock ticks of the last sweep, compared without the trace lock
+		std::vector<uint8_t> maxHold;
+		std::vector<uint8_t> minHold;
+		std::vector<uint8_t> window;		// Last averageSweeps sweeps, one after the other
+		std::vector<uint32_t> sum;			// Sum of the sweeps in the window
+		std::vector<float> expAverage;
+		size_t windowPos = 0;
+		size_t windowFill = 0;
+	};
+
+	struct Subscriber {
+		unsigned long sessionId = 0;
+		json clientId;
+		unsigned detectors = 0;
+		std::chrono::steady_clock::duration period{};
+		std::chrono::steady_clock::time_point nextDue;
+		std::unordered_map<unsigned long long, unsigned long long> sentVersion;	// By trace id
+	};
+
+	std::mutex mtx;
+	std::condition_variable cv;
+
+	// Configuration, set before the service starts
+	bool enabled = false;
+	size_t averageSweeps = 0;
+	size_t maxConfigurations = 0;
+	float expWeight = 0;
+
+	// Traces and subscribers, protected by mtx. Each trace is also protected by its own mutex.
+	std::vector<std::shared_ptr<Trace>> traces;
+	std::vector<Subscriber> subscribers;
+	unsigned long long nextTraceId = 1;
+
+	// ----------------------------------------------------------------------
+	/** @brief Name of a detector, as used by the clients
+	**/
+	static const char* detectorName(unsigned detector) {
+		switch (detector) {
+		case MAX_HOLD: return "maxHold";
+		case MIN_HOLD: return "minHold";
+		case AVERAGE: return "average";
+		default: return "expAverage";
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Find the trace of a sweep configuration, creating it if needed. Must be called with the lock held.
+	 *
+	 * The least recently updated trace is replaced when maxConfigurations traces already exist.
+	 *
+	 * @param centerHz: Center frequency of the sweep, in Hz
+	 * @param binHz: Bin size of the sweep, in Hz
+	 * @param numBins: Number of bins of the sweep
+	 * @return std::shared_ptr<Trace>: Trace of the configuration
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	std::shared_ptr<Trace> traceFor(double centerHz, double binHz, size_t numBins) {
+		for (auto& trace : traces) {
+			if (trace->centerHz == centerHz && trace->binHz == binHz && trace->numBins == numBins) {
+				return trace;
+			}
+		}
+
+		auto trace = std::make_shared<Trace>();
+		trace->id = nextTraceId++;
+		trace->centerHz = centerHz;
+		trace->binHz = binHz;
+		trace->numBins = numBins;
+		trace->maxHold.resize(numBins);
+		trace->minHold.resize(numBins);
+		trace->window.resize(averageSweeps * numBins);
+		trace->sum.resize(numBins);
+		trace->expAverage.resize(numBins);
+
+		if (traces.size() < maxConfigurations) {
+			traces.push_back(trace);
+		}
+		else {
+			auto oldest = std::min_element(traces.begin(), traces.end(), [](const auto& a, const auto& b) { return a->lastUpdate.load() < b->lastUpdate.load(); });
+			*oldest = trace;
+		}
+		return trace;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Add a sweep to the accumulators of a trace. Must be called with the trace lock held.
+	 *
+	 * @param trace: Trace receiving the sweep
+	 * @param bins: Raw uint8 bins of the sweep, numBins of the trace
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void accumulate(Trace& trace, const uint8_t* bins) {
+		size_t n = trace.numBins;
+
+		if (trace.sweeps == 0) {
+			std::memcpy(trace.maxHold.data(), bins, n);
+			std::memcpy(trace.minHold.data(), bins, n);
+			std::fill(trace.sum.begin(), trace.sum.end(), 0);
+			std::transform(bins, bins + n, trace.expAverage.begin(), [](uint8_t bin) { return float(bin); });
+			trace.windowPos = 0;
+			trace.windowFill = 0;
+		}
+		else {
+			sweepKernel::max(trace.maxHold.data(), bins, n);
+			sweepKernel::min(trace.minHold.data(), bins, n);
+			sweepKernel::smooth(trace.expAverage.data(), bins, n, expWeight);
+		}
+
+		// The oldest sweep in the window is replaced by the new one
+		uint8_t* slot = trace.window.data() + trace.windowPos * n;
+		if (trace.windowFill == averageSweeps) {
+			sweepKernel::subtract(trace.sum.data(), slot, n);
+		}
+		else {
+			trace.windowFill++;
+		}
+		std::memcpy(slot, bins, n);
+		sweepKernel::add(trace.sum.data(), bins, n);
+		trace.windowPos = (trace.windowPos + 1) % averageSweeps;
+
+		trace.sweeps++;
+		trace.version++;
+		trace.lastUpdate.store(std::chrono::steady_clock::now().time_since_epoch().count());
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Copy of the selected traces of a configuration, converted to levels
+	**/
+	struct Snapshot {
+		double centerHz = 0;
+		double binHz = 0;
+		size_t numBins = 0;
+		unsigned long long sweeps = 0;
+		size_t averageSweeps = 0;
+		std::vector<std::pair<unsigned, std::vector<float>>> levels;	// By detector
+	};
+
+	// ----------------------------------------------------------------------
+	/** @brief Convert the selected traces of a configuration to levels. Must be called with the trace lock held.
+	 *
+	 * Levels use the same scale as the GET_PAN sweep data.
+	 *
+	 * @param trace: Trace to be sent
+	 * @param detectors: Mask of the detectors to be sent
+	 * @return Snapshot: Levels of the selected detectors
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static Snapshot snapshot(const Trace& trace, unsigned detectors) {
+		Snapshot copy{ trace.centerHz, trace.binHz, trace.numBins, trace.sweeps, trace.windowFill, {} };
+
+		for (unsigned detector : DETECTORS) {
+			if (!(detectors & detector)) {
+				continue;
+			}
+			std::vector<float> levels(trace.numBins);
+			switch (detector) {
+			case MAX_HOLD:
+				std::transform(trace.maxHold.begin(), trace.maxHold.end(), levels.begin(), [](uint8_t bin) { return float(bin) - BYTE_POWER_OFFSET; });
+				break;
+			case MIN_HOLD:
+				std::transform(trace.minHold.begin(), trace.minHold.end(), levels.begin(), [](uint8_t bin) { return float(bin) - BYTE_POWER_OFFSET; });
+				break;
+			case AVERAGE: {
+				float scale = 1.0f / float((std::max)(trace.windowFill, size_t(1)));
+				std::transform(trace.sum.begin(), trace.sum.end(), levels.begin(), [scale](uint32_t total) { return float(total) * scale - BYTE_POWER_OFFSET; });
+				break;
+			}
+			default:
+				std::transform(trace.expAverage.begin(), trace.expAverage.end(), levels.begin(), [](float level) { return level - BYTE_POWER_OFFSET; });
+				break;
+			}
+			copy.levels.emplace_back(detector, std::move(levels));
+		}
+		return copy;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Write the frame body with the traces of a configuration
+	 *
+	 * @param copy: Levels of the selected detectors
+	 * @param writer: Writer receiving the frame body
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static void writeSnapshot(const Snapshot& copy, edll::JsonWriter& writer) {
+		double halfSpan = copy.binHz * std::floor(copy.numBins / 2.0);
+
+		writer.beginObject();
+		writer.field("numBins", copy.numBins);
+		writer.field("startFrequency", (copy.centerHz - halfSpan) / edll::MHZ_MULTIPLIER);
+		writer.field("stopFrequency", (copy.centerHz + halfSpan) / edll::MHZ_MULTIPLIER);
+		writer.field("frequencyUnit", "MHz");
+		writer.field("binSize", copy.binHz);
+		writer.field("binSizeUnit", "Hz");
+		writer.field("sweeps", copy.sweeps);
+		writer.field("averageSweeps", copy.averageSweeps);
+
+		writer.key("traces").beginObject();
+		for (const auto& [detector, levels] : copy.levels) {
+			switch (detector) {
+			case MAX_HOLD: writer.key("maxHold"); break;
+			case MIN_HOLD: writer.key("minHold"); break;
+			case AVERAGE: writer.key("average"); break;
+			default: writer.key("expAverage"); break;
+			}
+			writer.beginObject();
+			writer.field("type", edll::columnType<float>());
+			writer.key("data").binary(levels.data(), levels.size() * sizeof(float));
+			writer.endObject();
+		}
+		writer.endObject();
+
+		writer.endObject();
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Send to a subscriber the traces updated since its previous frame. Called without the lock held.
+	 *
+	 * @param subscriber: Copy of the subscriber, updated with the versions sent
+	 * @param current: Traces existing when the subscriber became due
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void publish(Subscriber& subscriber, const std::vector<std::shared_ptr<Trace>>& current) const {
+		using TaskKeys = edll::DefaultConfig::Service::TaskKeys;
+
+		std::unordered_map<unsigned long long, unsigned long long> sent;
+		for (const auto& trace : current) {
+			Snapshot copy;
+			{
+				std::lock_guard<std::mutex> lock(trace->mtx);
+				unsigned long long version = trace->version;
+				auto previous = subscriber.sentVersion.find(trace->id);
+				sent[trace->id] = version;
+				if (trace->sweeps == 0 || (previous != subscriber.sentVersion.end() && previous->second == version)) {
+					continue;
+				}
+				copy = snapshot(*trace, subscriber.detectors);
+			}
+
+			edll::JsonWriter writer;
+			writeSnapshot(copy, writer);
+
+			json frame;
+			frame[TaskKeys::CommandCode::VALUE] = StreamMsgType::TRACE_SUBSCRIBE;
+			frame[TaskKeys::CommandName::VALUE] = StreamMsgType::toString(StreamMsgType::TRACE_SUBSCRIBE);
+			frame[TaskKeys::Arguments::VALUE] = json::object();
+			frame[TaskKeys::SessionId::VALUE] = subscriber.sessionId;
+			frame[clientIdKey] = subscriber.clientId;
+			frame[edll::BODY_KEY] = writer.str();
+			response.push(frame, "PanTraces");
+		}
+		// Versions of evicted traces are forgotten
+		subscriber.sentVersion = std::move(sent);
+	}
+
+public:
+	PanTraces() = default;
+
+	// ----------------------------------------------------------------------
+	/** @brief Set the trace configuration. Must be called before the service starts.
+	 *
+	 * @param enable: Keep the traces of the pan sweeps
+	 * @param numAverageSweeps: Number of sweeps in the linear average. The exponential average uses a weight of 2 / (N + 1)
+	 * @param numConfigurations: Number of pan configurations with traces, the least recently updated is replaced beyond it
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void configure(bool enable, long long numAverageSweeps, long long numConfigurations) {
+		enabled = enable && numAverageSweeps > 0 && numConfigurations > 0;
+		averageSweeps = enabled ? static_cast<size_t>(numAverageSweeps) : 0;
+		maxConfigurations = enabled ? static_cast<size_t>(numConfigurations) : 0;
+		expWeight = enabled ? 2.0f / float(averageSweeps + 1) : 0;
+	}
+
+	bool isEnabled() const { return enabled; }
+
+	// ----------------------------------------------------------------------
+	/** @brief Update the traces with a pan sweep. Called from the DLL callback thread.
+	 *
+	 * @param centerHz: Center frequency of the sweep, in Hz
+	 * @param binHz: Bin size of the sweep, in Hz
+	 * @param bins: Raw uint8 bins of the sweep
+	 * @param numBins: Number of bins of the sweep
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void update(double centerHz, double binHz, const uint8_t* bins, size_t numBins) {
+		if (!enabled || numBins == 0) {
+			return;
+		}
+
+		std::shared_ptr<Trace> trace;
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			trace = traceFor(centerHz, binHz, numBins);
+		}
+
+		std::lock_guard<std::mutex> lock(trace->mtx);
+		accumulate(*trace, bins);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Subscribe the client session to a set of traces, replacing its previous subscription
+	 *
+	 * Arguments are the detectors, a non empty array with "maxHold", "minHold", "average" or "expAverage",
+	 * and rateHz, the maximum rate of the frames sent for each configuration, 1 Hz by default,
+	 * within MIN_TRACE_RATE_HZ and MAX_TRACE_RATE_HZ.
+	 *
+	 * @param request: Request received from the client
+	 * @return std::string: Error message, empty if the subscription is active
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	std::string subscribe(const json& request) {
+		using TaskKeys = edll::DefaultConfig::Service::TaskKeys;
+
+		if (!enabled) {
+			return "Pan traces are disabled";
+		}
+
+		const json& arguments = request[TaskKeys::Arguments::VALUE];
+		Subscriber subscriber;
+		for (const auto& name : arguments["detectors"]) {
+			if (!name.is_string()) {
+				return "Detectors must be strings. Use 'maxHold', 'minHold', 'average' or 'expAverage'";
+			}
+			unsigned detector = 0;
+			for (unsigned candidate : DETECTORS) {
+				if (name.get<std::string>() == detectorName(candidate)) {
+					detector = candidate;
+				}
+			}
+			if (detector == 0) {
+				return "Unknown detector '" + name.get<std::string>() + "'. Use 'maxHold', 'minHold', 'average' or 'expAverage'";
+			}
+			subscriber.detectors |= detector;
+		}
+		if (subscriber.detectors == 0) {
+			return "At least one detector is required. Use 'maxHold', 'minHold', 'average' or 'expAverage'";
+		}
+
+		// Bounded so the period fits the clock duration and the frames never keep the thread busy
+		double rateHz = arguments.value("rateHz", 1.0);
+		if (!(rateHz >= MIN_TRACE_RATE_HZ && rateHz <= MAX_TRACE_RATE_HZ)) {
+			return "rateHz must be between " + std::to_string(MIN_TRACE_RATE_HZ) + " and " + std::to_string(MAX_TRACE_RATE_HZ);
+		}
+
+		subscriber.sessionId = request.value(TaskKeys::SessionId::VALUE, TaskKeys::SessionId::INIT_VALUE);
+		subscriber.clientId = request.value(clientIdKey, json(TaskKeys::ClientId::INIT_VALUE));
+		subscriber.period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / rateHz));
+		subscriber.nextDue = std::chrono::steady_clock::now();
+
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			auto previous = std::find_if(subscribers.begin(), subscribers.end(), [&](const Subscriber& s) { return s.sessionId == subscriber.sessionId; });
+			if (previous != subscribers.end()) {
+				*previous = std::move(subscriber);
+			}
+			else {
+				subscribers.push_back(std::move(subscriber));
+			}
+		}
+		cv.notify_all();
+		return std::string();
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Remove the subscription of a client session
+	 *
+	 * @param sessionId: Session to be unsubscribed
+	 * @return bool: True if the session was subscribed, false otherwise
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool unsubscribe(unsigned long sessionId) {
+		std::lock_guard<std::mutex> lock(mtx);
+		auto end = std::remove_if(subscribers.begin(), subscribers.end(), [sessionId](const Subscriber& s) { return s.sessionId == sessionId; });
+		bool found = end != subscribers.end();
+		subscribers.erase(end, subscribers.end());
+		return found;
+	}
+
+	void eraseSession(unsigned long sessionId) { unsubscribe(sessionId); }
+
+	// ----------------------------------------------------------------------
+	/** @brief Clear the accumulators of the configurations selected by a request, restarting them from the next sweep
+	 *
+	 * Arguments select the configurations whose center frequency is within half a bin of centerFrequency, in Hz,
+	 * optionally only those with numBins bins. Other configurations, followed by other clients, are kept.
+	 *
+	 * @param request: Request received from the client
+	 * @return std::string: Error message, empty if at least one configuration was cleared
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	std::string reset(const json& request) {
+		using TaskKeys = edll::DefaultConfig::Service::TaskKeys;
+
+		if (!enabled) {
+			return "Pan traces are disabled";
+		}
+
+		const json& arguments = request[TaskKeys::Arguments::VALUE];
+		double centerHz = arguments["centerFrequency"].get<double>();
+		bool anyBins = !arguments.contains("numBins");
+		size_t numBins = anyBins ? 0 : arguments["numBins"].get<size_t>();
+
+		size_t cleared = 0;
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			for (auto& trace : traces) {
+				std::lock_guard<std::mutex> traceLock(trace->mtx);
+				if (std::fabs(trace->centerHz - centerHz) > trace->binHz / 2 || (!anyBins && trace->numBins != numBins)) {
+					continue;
+				}
+				trace->sweeps = 0;
+				trace->version++;
+				cleared++;
+			}
+		}
+		if (cleared == 0) {
+			return "No pan trace configuration matching the request";
+		}
+		loggerPtr->info("Pan traces of " + std::to_string(cleared) + " configurations cleared");
+		return std::string();
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Send the traces to the subscribers until the service is interrupted
+	 *
+	 * This function will lock the thread. Must be run in a separate thread.
+	 *
+	 * @param interruptionCode: Signal interruption for service interruption
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void run(const edll::INT_CODE& interruptionCode) {
+		if (!enabled) {
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(mtx);
+		while (interruptionCode == edll::Code::RUNNING) {
+
+			auto now = std::chrono::steady_clock::now();
+			auto wake = now + std::chrono::seconds(1);
+			for (const auto& subscriber : subscribers) {
+				wake = (std::min)(wake, subscriber.nextDue);
+			}
+			cv.wait_until(lock, wake);
+
+			// Due subscribers are served from copies, so the DLL callbacks never wait for the frames
+			now = std::chrono::steady_clock::now();
+			std::vector<std::shared_ptr<Trace>> current = traces;
+			std::vector<Subscriber> due;
+			for (auto& subscriber : subscribers) {
+				if (subscriber.nextDue <= now) {
+					subscriber.nextDue = now + subscriber.period;
+					due.push_back(subscriber);
+				}
+			}
+			if (due.empty()) {
+				continue;
+			}
+
+			lock.unlock();
+			for (auto& subscriber : due) {
+				publish(subscriber, current);
+			}
+			lock.lock();
+
+			// Keep the versions sent, unless the subscription was replaced or removed meanwhile
+			for (auto& sent : due) {
+				for (auto& subscriber : subscribers) {
+					if (subscriber.sessionId == sent.sessionId && subscriber.clientId == sent.clientId && subscriber.detectors == sent.detectors) {
+						subscriber.sentVersion = std::move(sent.sentVersion);
+					}
+				}
+			}
+		}
+	}
+};
+
+
+// Pan traces updated by the DLL callbacks and sent to the subscribers by their own thread
+extern PanTraces panTraces;
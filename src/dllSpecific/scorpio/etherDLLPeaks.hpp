@@ -0,0 +1,187 @@
+/**
+ * @file etherDLLPeaks.hpp
+ * @brief Noise floor and peak detection over the 8-bit bins of a spectrum
+ *
+ * Kept apart from etherDLLDataProcess.hpp, without dependencies on the Scorpio API,
+ * so that the detection can be used by tools built outside the service project, such as the benchmarks in test/benchmark.
+ *
+ * @author fslobao
+ * @date 2025-10-31
+ * @version 1.0
+ *
+ * @note Requires C++17 or later
+ *
+ **/
+ // ----------------------------------------------------------------------
+#pragma once
+
+// Include general C++ libraries
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ETHERDLL_DECIMATE_SSE2
+#endif
+
+// Data structures
+// Peak detected in a spectrum, with the bins within PEAK_BANDWIDTH_DB of its level
+struct SpectrumPeak {
+    size_t bin;             // Bin with the highest level
+    unsigned char value;    // 8-bit value of the bin
+    size_t firstBin;        // First bin of the peak bandwidth
+    size_t lastBin;         // Last bin of the peak bandwidth
+};
+
+// Constants
+constexpr float BYTE_POWER_OFFSET = 192.0;
+constexpr unsigned char PEAK_BANDWIDTH_DB = 3;  // One dB for each step of the 8-bit bins
+
+// ----------------------------------------------------------------------
+/** @brief Value of the 8-bit bins at a percentile, from their histogram
+ *
+ * Runs in O(n) without sorting. Four histograms are filled in turn, so that repeated values
+ * do not serialize the increments of the same counter.
+ *
+ * @param bins: Pointer to the 8-bit bins
+ * @param numBins: Number of bins, at least one
+ * @param percentile: Percentile, from 0 to 100
+ * @return unsigned char: Lowest value with at least percentile % of the bins less or equal to it
+ * @throws NO EXCEPTION HANDLING
+**/
+unsigned char binPercentile(const unsigned char* bins, size_t numBins, double percentile)
+{
+    uint32_t histogram[4][256] = {};
+
+    size_t i = 0;
+    for (; i + 4 <= numBins; i += 4) {
+        histogram[0][bins[i]]++;
+        histogram[1][bins[i + 1]]++;
+        histogram[2][bins[i + 2]]++;
+        histogram[3][bins[i + 3]]++;
+    }
+    for (; i < numBins; i++) {
+        histogram[0][bins[i]]++;
+    }
+
+    size_t rank = (std::max)(static_cast<size_t>(std::ceil(percentile / 100.0 * double(numBins))), size_t(1));
+    size_t count = 0;
+    for (size_t value = 0; value < 256; value++) {
+        count += size_t(histogram[0][value]) + histogram[1][value] + histogram[2][value] + histogram[3][value];
+        if (count >= rank) {
+            return static_cast<unsigned char>(value);
+        }
+    }
+    return 255;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Find the next bin at or above a value, or below it
+ *
+ * Bins are tested 16 at a time with SSE2 when available, so spans of noise are skipped quickly.
+ *
+ * @tparam Above: True to find a bin at or above minValue, false to find a bin below it
+ * @param bins: Pointer to the 8-bit bins
+ * @param numBins: Number of bins
+ * @param first: First bin tested
+ * @param minValue: Value compared to the bins
+ * @return size_t: Index of the bin found, numBins if none
+ * @throws NO EXCEPTION HANDLING
+**/
+template <bool Above>
+inline size_t findBin(const unsigned char* bins, size_t numBins, size_t first, unsigned char minValue)
+{
+    size_t i = first;
+#ifdef ETHERDLL_DECIMATE_SSE2
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(minValue));
+    for (; i + 16 <= numBins; i += 16) {
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bins + i));
+        int atOrAbove = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(b, limit), b));
+        if (Above ? atOrAbove != 0 : atOrAbove != 0xFFFF) {
+            break;
+        }
+    }
+#endif
+    for (; i < numBins; i++) {
+        if ((bins[i] >= minValue) == Above) {
+            return i;
+        }
+    }
+    return numBins;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Lowest 8-bit bin value with a level above a threshold
+ *
+ * @param threshold: Level threshold, in the scale of parsedBinData
+ * @return unsigned int: Lowest bin value above the threshold, more than 255 if no bin can be above it
+ * @throws NO EXCEPTION HANDLING
+**/
+inline unsigned int binValueAbove(float threshold)
+{
+    double value = std::floor(double(threshold) + BYTE_POWER_OFFSET) + 1.0;
+    return static_cast<unsigned int>((std::min)((std::max)(value, 0.0), 256.0));
+}
+
+// ----------------------------------------------------------------------
+/** @brief Find the peaks of a spectrum above a value
+ *
+ * Each run of contiguous bins at or above minValue gives one peak, at its highest bin.
+ * The peak bandwidth covers the contiguous bins within PEAK_BANDWIDTH_DB of the peak, without reaching the neighbouring runs,
+ * so every bin is visited a bounded number of times.
+ * A peak closer than minSpacing bins to the previous one replaces it if higher, and is dropped otherwise.
+ *
+ * @param bins: Pointer to the 8-bit bins
+ * @param numBins: Number of bins
+ * @param minValue: Lowest value of the bins of a peak
+ * @param minSpacing: Minimum distance between peaks, in bins
+ * @return const std::vector<SpectrumPeak>&: Peaks in increasing bin order, valid until the next call from the same thread
+ * @throws NO EXCEPTION HANDLING
+**/
+const std::vector<SpectrumPeak>& findPeaks(const unsigned char* bins, size_t numBins, unsigned char minValue, size_t minSpacing)
+{
+    thread_local static std::vector<SpectrumPeak> peaks;
+    peaks.clear();
+
+    size_t previousEnd = 0;
+    size_t first = findBin<true>(bins, numBins, 0, minValue);
+    while (first < numBins) {
+        size_t end = findBin<false>(bins, numBins, first, minValue);
+        size_t next = findBin<true>(bins, numBins, end, minValue);
+
+        size_t top = first;
+        for (size_t i = first + 1; i < end; i++) {
+            if (bins[i] > bins[top]) {
+                top = i;
+            }
+        }
+
+        unsigned char edge = bins[top] > PEAK_BANDWIDTH_DB ? bins[top] - PEAK_BANDWIDTH_DB : 0;
+        size_t low = top;
+        while (low > previousEnd && bins[low - 1] >= edge) {
+            low--;
+        }
+        size_t high = top;
+        while (high + 1 < next && bins[high + 1] >= edge) {
+            high++;
+        }
+
+        SpectrumPeak peak{ top, bins[top], low, high };
+        if (!peaks.empty() && top - peaks.back().bin < minSpacing) {
+            if (peak.value > peaks.back().value) {
+                peaks.back() = peak;
+            }
+        }
+        else {
+            peaks.push_back(peak);
+        }
+
+        previousEnd = end;
+        first = next;
+    }
+
+    return peaks;
+}
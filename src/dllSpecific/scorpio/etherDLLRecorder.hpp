@@ -0,0 +1,578 @@
+/**
+* @file etherDLLRecorder.hpp
+*
+* @brief Header file for the server side recording of IQ streams in SigMF files
+*
+* IQ blocks received in the RT_IQ_DATA callback are copied into a bounded queue of reusable slots and written by a separate thread.
+* The callback thread never waits for the disk: if the queue is full, the block is dropped and counted.
+* Samples are appended to a preallocated memory mapped .sigmf-data file, rotated when it reaches the configured size
+* or when the data type, the sample rate or the stream changes. Each data file has a .sigmf-meta sidecar,
+* with a new capture segment whenever the frequency changes or samples are missing.
+*
+* * @author fslobao
+* * @date 2025-10-29
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+
+// ----------------------------------------------------------------------
+#pragma once
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <spdlog/fmt/chrono.h>
+
+// Include general C++ libraries
+#include <string>
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <ctime>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <condition_variable>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+// For convenience
+using json = nlohmann::json;
+
+// Global variables
+extern spdlog::logger* loggerPtr;
+
+
+// ----------------------------------------------------------------------
+/** @brief Description of an IQ block, filled in the DLL callback thread
+**/
+struct IqBlockInfo {
+	unsigned long long streamID = 0;
+	unsigned long long seqNumber = 0;
+	unsigned long long sampleOffset = 0;	// Index of the first sample of the block since the stream start
+	unsigned long long startTimestamp = 0;	// Stream start time as reported by the station
+	long long startTimeNs = 0;				// Stream start time in nanoseconds since the Unix epoch
+	const char* datatype = nullptr;			// SigMF data type of the samples, e.g. "ci16_le"
+	size_t sampleSize = 0;					// Bytes per complex sample
+	size_t numSamples = 0;
+	double frequencyHz = 0;
+	double sampleRate = 0;
+	double scaleFactor = 0;
+	bool endOfStream = false;
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Data file preallocated to a fixed size and written through a memory mapping, or an existing file mapped for reading
+ *
+ * Files opened for writing are truncated to the bytes written when closed.
+**/
+class MappedFile {
+private:
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#else
+	int fd = -1;
+#endif
+	char* view = nullptr;
+	size_t capacity = 0;
+	size_t used = 0;
+	bool writable = false;
+
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile() { close(); }
+
+	// ----------------------------------------------------------------------
+	/** @brief Create the file, replacing any existing one, and map it with the given size
+	 *
+	 * @param path: Path of the file
+	 * @param size: Size preallocated for the file, in bytes
+	 * @return bool: True if the file is mapped, false otherwise
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool open(const std::filesystem::path& path, size_t size) {
+		close();
+
+#ifdef _WIN32
+		file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		// The mapping extends the file to its full size
+		ULARGE_INTEGER mapSize;
+		mapSize.QuadPart = size;
+		mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, mapSize.HighPart, mapSize.LowPart, nullptr);
+		if (mapping != nullptr) {
+			view = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size));
+		}
+#else
+		fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) {
+			return false;
+		}
+		if (posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0 || ftruncate(fd, static_cast<off_t>(size)) == 0) {
+			void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			view = address == MAP_FAILED ? nullptr : static_cast<char*>(address);
+		}
+#endif
+
+		capacity = size;
+		used = 0;
+		writable = true;
+		if (view == nullptr) {
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Map an existing file for reading, with all its bytes taken as written
+	 *
+	 * @param path: Path of the file
+	 * @return bool: True if the file is mapped, false otherwise
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool openRead(const std::filesystem::path& path) {
+		close();
+
+		std::error_code ec;
+		size_t size = static_cast<size_t>(std::filesystem::file_size(path, ec));
+		if (ec || size == 0) {
+			return false;
+		}
+
+#ifdef _WIN32
+		file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != nullptr) {
+			view = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size));
+		}
+#else
+		fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			return false;
+		}
+		void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+		view = address == MAP_FAILED ? nullptr : static_cast<char*>(address);
+#endif
+
+		capacity = size;
+		used = size;
+		writable = false;
+		if (view == nullptr) {
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Unmap the file and truncate it to the bytes written
+	 *
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void close() {
+#ifdef _WIN32
+		if (view != nullptr) {
+			UnmapViewOfFile(view);
+		}
+		if (mapping != nullptr) {
+			CloseHandle(mapping);
+		}
+		if (file != INVALID_HANDLE_VALUE) {
+			if (writable) {
+				LARGE_INTEGER end;
+				end.QuadPart = static_cast<LONGLONG>(used);
+				SetFilePointerEx(file, end, nullptr, FILE_BEGIN);
+				SetEndOfFile(file);
+			}
+			CloseHandle(file);
+		}
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (view != nullptr) {
+			munmap(view, capacity);
+		}
+		if (fd >= 0) {
+			if (writable && ftruncate(fd, static_cast<off_t>(used)) != 0) {
+				loggerPtr->warn("IQ recorder failed to truncate data file");
+			}
+			::close(fd);
+		}
+		fd = -1;
+#endif
+		view = nullptr;
+		capacity = 0;
+		used = 0;
+		writable = false;
+	}
+
+	bool isOpen() const { return view != nullptr; }
+	const char* data() const { return view; }
+	size_t size() const { return used; }
+	size_t available() const { return capacity - used; }
+
+	// ----------------------------------------------------------------------
+	/** @brief Append data to the file. The caller must not exceed the available space.
+	 *
+	 * @param data: Pointer to the data
+	 * @param size: Number of bytes to append
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void append(const char* data, size_t size) {
+		std::memcpy(view + used, data, size);
+		used += size;
+	}
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Recorder of the IQ streams received from the station
+ *
+ * A single recording is open at a time, following the stream of the last block received.
+ * Slots are reused, so no memory is allocated in the callback thread once the queue has seen the largest block.
+**/
+class IqRecorder {
+private:
+	enum class SlotState { FREE, FILLING, READY };
+
+	struct Slot {
+		SlotState state = SlotState::FREE;
+		IqBlockInfo info;
+		std::vector<char> data;
+	};
+
+	std::mutex mtx;
+	std::condition_variable cv;
+
+	// Configuration, set before the service starts
+	bool enabled = false;
+	std::filesystem::path directory;
+	size_t fileSize = 0;
+
+	// Queue shared by the callback thread and the writer thread
+	std::vector<Slot> slots;
+	size_t head = 0;
+	size_t tail = 0;
+	unsigned long long droppedBlocks = 0;
+	bool dropping = false;
+
+	// State of the recording, used only by the writer thread
+	MappedFile dataFile;
+	std::filesystem::path basePath;
+	IqBlockInfo global;
+	json captures = json::array();
+	unsigned long long fileDroppedBlocks = 0;
+	unsigned long long nextSampleOffset = 0;
+	unsigned int fileIndex = 0;
+
+	// ----------------------------------------------------------------------
+	/** @brief Convert a time in nanoseconds since the Unix epoch to an ISO 8601 string, as required by core:datetime
+	 *
+	 * @param unixNs: Time in nanoseconds since the Unix epoch
+	 * @return std::string: ISO 8601 formatted string
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static std::string isoTime(long long unixNs) {
+		const long long NS_PER_SECOND = 1000000000LL;
+
+		std::time_t seconds = static_cast<std::time_t>(unixNs / NS_PER_SECOND);
+		return fmt::format("{:%Y-%m-%dT%H:%M:%S}.{:09d}Z", fmt::gmtime(seconds), unixNs % NS_PER_SECOND);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Write the SigMF metadata of the open recording
+	 *
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void writeMeta() {
+		json meta;
+		meta["global"] = {
+			{ "core:datatype", global.datatype },
+			{ "core:sample_rate", global.sampleRate },
+			{ "core:version", "1.0.0" },
+			{ "core:num_channels", 1 },
+			{ "core:recorder", "EtherDLL" },
+			{ "core:extensions", json::array({ { { "name", "etherdll" }, { "version", "1.0.0" }, { "optional", true } } }) },
+			{ "etherdll:scale_factor", global.scaleFactor },
+			{ "etherdll:stream_id", global.streamID },
+			{ "etherdll:stream_start_timestamp", global.startTimestamp },
+			{ "etherdll:dropped_blocks", fileDroppedBlocks }
+		};
+		meta["captures"] = captures;
+		meta["annotations"] = json::array();
+
+		std::filesystem::path metaPath = basePath;
+		metaPath += ".sigmf-meta";
+		std::ofstream file(metaPath, std::ios::trunc);
+		file << meta.dump(4);
+		if (!file) {
+			loggerPtr->error("IQ recorder failed to write " + metaPath.string());
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Close the open recording, if any, truncating the data file and updating the metadata
+	 *
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void closeFile() {
+		if (!dataFile.isOpen()) {
+			return;
+		}
+		size_t samples = dataFile.size() / global.sampleSize;
+		dataFile.close();
+		writeMeta();
+		loggerPtr->info("IQ recording " + basePath.string() + " closed with " + std::to_string(samples) + " samples and " +
+			std::to_string(fileDroppedBlocks) + " blocks dropped");
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Open a new recording for the given block
+	 *
+	 * @param info: Block starting the recording
+	 * @return bool: True if the data file was created, false otherwise
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool openFile(const IqBlockInfo& info) {
+		if (global.streamID != info.streamID || global.startTimestamp != info.startTimestamp) {
+			fileIndex = 0;
+		}
+		global = info;
+		captures = json::array();
+		fileDroppedBlocks = 0;
+
+		long long nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		std::string stamp = isoTime(info.startTimeNs != 0 ? info.startTimeNs : nowNs).substr(0, 19);
+		stamp.erase(std::remove(stamp.begin(), stamp.end(), ':'), stamp.end());
+		stamp.erase(std::remove(stamp.begin(), stamp.end(), '-'), stamp.end());
+
+		basePath = directory / ("iq_" + std::to_string(info.streamID) + "_" + stamp + "_" + std::to_string(fileIndex++));
+		std::filesystem::path dataPath = basePath;
+		dataPath += ".sigmf-data";
+
+		// Keep whole samples in each file
+		size_t size = (std::max)(fileSize - fileSize % info.sampleSize, info.sampleSize);
+		if (!dataFile.open(dataPath, size)) {
+			loggerPtr->error("IQ recorder failed to create " + dataPath.string());
+			return false;
+		}
+		loggerPtr->info("IQ recording " + basePath.string() + " opened");
+		writeMeta();
+		return true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Start a capture segment at the current end of the data file
+	 *
+	 * @param info: Block starting the segment
+	 * @param sampleOffset: Index of the first sample of the segment since the stream start
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void addCapture(const IqBlockInfo& info, unsigned long long sampleOffset) {
+		json capture = {
+			{ "core:sample_start", dataFile.size() / info.sampleSize },
+			{ "core:global_index", sampleOffset },
+			{ "core:frequency", info.frequencyHz }
+		};
+		if (info.startTimeNs != 0 && info.sampleRate > 0) {
+			capture["core:datetime"] = isoTime(info.startTimeNs + static_cast<long long>(sampleOffset * 1e9 / info.sampleRate));
+		}
+		captures.push_back(capture);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Append a block to the recording, rotating the data file as needed
+	 *
+	 * @param slot: Slot holding the block
+	 * @param dropped: Blocks dropped from the queue before this one
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void writeBlock(const Slot& slot, unsigned long long dropped) {
+		const IqBlockInfo& info = slot.info;
+
+		if (dataFile.isOpen() && (info.streamID != global.streamID || info.startTimestamp != global.startTimestamp ||
+			info.sampleSize != global.sampleSize || info.sampleRate != global.sampleRate || std::strcmp(info.datatype, global.datatype) != 0)) {
+			closeFile();
+		}
+
+		const char* data = slot.data.data();
+		size_t remaining = info.numSamples * info.sampleSize;
+		unsigned long long sampleOffset = info.sampleOffset;
+		bool newSegment = !dataFile.isOpen() || sampleOffset != nextSampleOffset || info.frequencyHz != captures.back()["core:frequency"].get<double>();
+		fileDroppedBlocks += dataFile.isOpen() ? dropped : 0;
+
+		while (remaining > 0) {
+			if (!dataFile.isOpen() || dataFile.available() == 0) {
+				closeFile();
+				if (!openFile(info)) {
+					break;
+				}
+				newSegment = true;
+			}
+			if (newSegment) {
+				addCapture(info, sampleOffset);
+				newSegment = false;
+			}
+			size_t chunk = (std::min)(remaining, dataFile.available());
+			dataFile.append(data, chunk);
+			data += chunk;
+			remaining -= chunk;
+			sampleOffset += chunk / info.sampleSize;
+		}
+		nextSampleOffset = sampleOffset;
+
+		if (info.endOfStream) {
+			closeFile();
+		}
+	}
+
+public:
+	// ----------------------------------------------------------------------
+	/** @brief Set the recorder configuration. Must be called before the service starts.
+	 *
+	 * @param enable: Record the IQ streams received from the station
+	 * @param path: Folder receiving the recordings, created if missing
+	 * @param fileSizeMB: Size of each data file before rotation, in MiB
+	 * @param queueBlocks: Number of IQ blocks waiting to be written before new blocks are dropped
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void configure(bool enable, const std::string& path, long long fileSizeMB, long long queueBlocks) {
+		enabled = enable && fileSizeMB > 0 && queueBlocks > 0;
+		directory = path;
+		fileSize = enabled ? static_cast<size_t>(fileSizeMB) << 20 : 0;
+		slots = std::vector<Slot>(enabled ? static_cast<size_t>(queueBlocks) : 0);
+
+		if (enabled) {
+			std::error_code ec;
+			std::filesystem::create_directories(directory, ec);
+			if (ec) {
+				loggerPtr->error("IQ recorder disabled. Failed to create " + directory.string() + ": " + ec.message());
+				enabled = false;
+			}
+		}
+	}
+
+	bool isEnabled() const { return enabled; }
+
+	// ----------------------------------------------------------------------
+	/** @brief Queue an IQ block to be recorded. Called from the DLL callback thread, never waits for the disk.
+	 *
+	 * @param info: Description of the block
+	 * @param samples: Pointer to the samples, numSamples * sampleSize bytes
+	 * @return bool: True if the block was queued, false if the recorder is disabled or the queue is full
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool record(const IqBlockInfo& info, const void* samples) {
+		if (!enabled || info.datatype == nullptr || info.sampleSize == 0) {
+			return false;
+		}
+
+		Slot* slot = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			if (slots[head].state != SlotState::FREE) {
+				droppedBlocks++;
+				if (!dropping) {
+					loggerPtr->warn("IQ recorder queue full. Dropping blocks from stream " + std::to_string(info.streamID));
+				}
+				dropping = true;
+				return false;
+			}
+			dropping = false;
+			slot = &slots[head];
+			slot->state = SlotState::FILLING;
+			head = (head + 1) % slots.size();
+		}
+
+		// Copy outside the lock, the slot is owned by this thread until ready
+		size_t bytes = info.numSamples * info.sampleSize;
+		slot->info = info;
+		slot->data.resize(bytes);
+		std::memcpy(slot->data.data(), samples, bytes);
+
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			slot->state = SlotState::READY;
+		}
+		cv.notify_one();
+		return true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Write the queued blocks until the service is interrupted
+	 *
+	 * This function will lock the thread. Must be run in a separate thread.
+	 * The open recording is closed when the service is interrupted.
+	 *
+	 * @param interruptionCode: Signal interruption for service interruption
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void run(const edll::INT_CODE& interruptionCode) {
+		if (!enabled) {
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(mtx);
+		unsigned long long reportedDrops = 0;
+		while (interruptionCode == edll::Code::RUNNING || slots[tail].state == SlotState::READY) {
+
+			cv.wait_for(lock, std::chrono::seconds(1), [this, &interruptionCode] {
+				return slots[tail].state == SlotState::READY || interruptionCode != edll::Code::RUNNING;
+				});
+
+			if (slots[tail].state != SlotState::READY) {
+				continue;
+			}
+
+			Slot& slot = slots[tail];
+			unsigned long long dropped = droppedBlocks - reportedDrops;
+			reportedDrops = droppedBlocks;
+
+			lock.unlock();
+			writeBlock(slot, dropped);
+			lock.lock();
+
+			slot.state = SlotState::FREE;
+			tail = (tail + 1) % slots.size();
+		}
+		lock.unlock();
+
+		closeFile();
+	}
+};
+
+
+// IQ recorder fed by the DLL callbacks and drained by its own thread
+extern IqRecorder iqRecorder;
@@ -28,12 +28,19 @@
 // Include DLL specific libraries
 #include "etherDLLCodes.hpp"
 #include "etherDLLInit.hpp"
+#include "etherDLLStream.hpp"
+#include "etherDLLChannelMap.hpp"
+#include "etherDLLSweepQuery.hpp"
 #include "EtherDLLValidation.hpp"
 
 // Include core EtherDLL libraries
 #include "EtherDLLClient.hpp"
 #include "EtherDLLConfig.hpp"
 #include "EtherDLLUtils.hpp"
+#include "EtherDLLTrace.hpp"
+#include "EtherDLLMetrics.hpp"
+#include "EtherDLLAdmission.hpp"
+#include "EtherDLLDeadline.hpp"
 
 // Include project libraries
 #include <nlohmann/json.hpp>
@@ -41,6 +48,7 @@
 
 // Include general C++ libraries
 #include <string>
+#include <memory>
 
 // For convenience
 using json = nlohmann::json;
@@ -48,545 +56,1194 @@ using TaskKeys = edll::DefaultConfig::Service::TaskKeys;
 
 // Global variables
 extern spdlog::logger* loggerPtr;
+extern RequestRegistry requestRegistry;
+extern LatencyTracer latencyTracer;
+extern ServiceMetrics serviceMetrics;
+extern AdmissionControl admissionControl;
+extern PanStreamer panStreamer;
+extern ChannelMap channelMap;
 
 
 // ----------------------------------------------------------------------
 /**
-  * @brief Convert JSON object in SAudioParams struct
+* @brief Validate an optional frequency in Hz and convert it into the raw units of the Scorpio API
+*
+* @param obj: JSON object containing the field
+* @param fieldName: Name of the field
+* @param raw: Raw frequency, set only if the field is present and valid
+* @param validator: JsonValidator instance to accumulate validation results
+* @return void
+* @throws NO EXCEPTION HANDLING
+**/
+template <typename R>
+void readOptionalFrequency(const json& obj, const char* fieldName, R& raw, JsonValidator& validator) {
+	auto it = obj.find(fieldName);
+	if (it == obj.end() || it->is_null()) {
+		return;
+	}
+	unsigned long frequency = 0;
+	if (validator.readOptional(obj, fieldName, VALID_TYPE_NUMBER, frequency)) {
+		raw = Units::Frequency(frequency).GetRaw();
+	}
+}
+
+// ----------------------------------------------------------------------
+/**
+* @brief Validate an optional boolean and store it in a member of any integer type
+*
+* @param obj: JSON object containing the field
+* @param fieldName: Name of the field
+* @param flag: Member set to the field value, or false if the field is missing
+* @param validator: JsonValidator instance to accumulate validation results
+* @return void
+* @throws NO EXCEPTION HANDLING
+**/
+template <typename B>
+void readOptionalFlag(const json& obj, const char* fieldName, B& flag, JsonValidator& validator) {
+	bool value = false;
+	validator.readOptional(obj, fieldName, VALID_TYPE_BOOLEAN, value);
+	flag = value;
+}
+
+// ----------------------------------------------------------------------
+/**
+* @brief Find an optional object field
+*
+* @param obj: JSON object containing the field
+* @param fieldName: Name of the field
+* @param validator: JsonValidator instance to accumulate validation results
+* @return const json*: Object found, nullptr if the field is missing, null or not an object
+* @throws NO EXCEPTION HANDLING
+**/
+const json* readOptionalObject(const json& obj, const char* fieldName, JsonValidator& validator) {
+	auto it = obj.find(fieldName);
+	if (it == obj.end() || it->is_null()) {
+		return nullptr;
+	}
+	if (!it->is_object()) {
+		validator.addError(fieldName, "Type required: '" + std::string(VALID_TYPE_OBJECT) + "'");
+		return nullptr;
+	}
+	return &*it;
+}
+
+// ----------------------------------------------------------------------
+/**
+  * @brief Validate JSON object and convert it in SAudioParams struct in a single pass
+  *
+  * Applies the audio parameters validation rules, including the test fields not used by SAudioParams.
   *
   * @param jsonObj: JSON object containing the parameters
-  * @return SAudioParams: structure populated with values from the JSON object
+  * @param structSO: structure to be populated with values from the JSON object
+  * @param validator: JsonValidator instance to accumulate validation results
+  * @return bool: True if the JSON object is valid, false otherwise
   * @throws NO EXCEPTION HANDLING
  **/
-SAudioParams jsonToSAudioParams(nlohmann::json jsonObj) {
-	SAudioParams structSO{};
+bool readSAudioParams(const json& jsonObj, SAudioParams& structSO, JsonValidator& validator) {
+	size_t firstError = validator.errorCount();
 
-	structSO.anyChannel = jsonObj["anyChannel"].is_null() == true ? NULL : jsonObj["anyChannel"].get<bool>();
-	if (jsonObj["bandwidth"].is_null() == false) {
-		structSO.bandwidth = Units::Frequency(jsonObj["bandwidth"].get<unsigned long>()).GetRaw();
-	}
-	// TODO: handle null cases and throw error if necessary
-	if (jsonObj["bfo"].is_null() == false) {
-		structSO.bfo = Units::Frequency(jsonObj["bfo"].get<unsigned long>()).GetRaw();
+	unsigned long freq = 0;
+	if (validator.readRange(jsonObj, "freq", MIN_FREQ, MAX_FREQ, freq)) {
+		structSO.freq = Units::Frequency(freq).GetRaw();
 	}
-	structSO.channel = jsonObj["channel"].is_null() == true ? NULL : jsonObj["channel"].get<unsigned long>();
-	structSO.detMode = jsonObj["detMode"].is_null() == true ? (SSmsMsg::SRcvrCtrlCmdV1::EDetMode)NULL : jsonObj["detMode"].get<SSmsMsg::SRcvrCtrlCmdV1::EDetMode>();
-	structSO.doModRec = jsonObj["doModRec"].is_null() == true ? NULL : jsonObj["doModRec"].get<bool>();;
-	structSO.doRDS = jsonObj["doRDS"].is_null() == true ? NULL : jsonObj["doRDS"].get<bool>();
-	if (jsonObj["freq"].is_null() == false) {
-		structSO.freq = Units::Frequency(jsonObj["freq"].get<unsigned long>()).GetRaw();
+	unsigned long bandwidth = 0;
+	if (validator.readRange(jsonObj, "bandwidth", MIN_BANDWIDTH, MAX_BANDWIDTH, bandwidth)) {
+		structSO.bandwidth = Units::Frequency(bandwidth).GetRaw();
 	}
+	readOptionalFrequency(jsonObj, "bfo", structSO.bfo, validator);
+
+	readOptionalFlag(jsonObj, "anyChannel", structSO.anyChannel, validator);
+	readOptionalFlag(jsonObj, "doModRec", structSO.doModRec, validator);
+	readOptionalFlag(jsonObj, "doRDS", structSO.doRDS, validator);
+	validator.readOptional(jsonObj, "channel", VALID_TYPE_NUMBER, structSO.channel);
+	validator.readOptional(jsonObj, "detMode", VALID_TYPE_NUMBER, structSO.detMode);
+	validator.readOptional(jsonObj, "streamID", VALID_TYPE_NUMBER, structSO.streamID);
+
+	validator.requireArray(jsonObj, "test_array", VALID_TYPE_NUMBER, 2)
+		.requireArray(jsonObj, "test_string_array", VALID_TYPE_STRING, 2)
+		.requireType(jsonObj, "test_float", VALID_TYPE_NUMBER)
+		.requireType(jsonObj, "test_string", VALID_TYPE_STRING);
 
-	structSO.streamID = jsonObj["streamID"].is_null() == true ? NULL : jsonObj["streamID"].get<unsigned long>();
 	strcpy_s(structSO.ipAddressRDSRadio, "");
-	return structSO;
+	return validator.errorCount() == firstError;
 }
 
 // ----------------------------------------------------------------------
 /**
-* @brief Convert JSON object in SGetPanParams struct
-* 
+* @brief Validate JSON object and convert it in SPanParams struct in a single pass
+*
 * @param jsonObj: JSON object containing the parameters
-* @return SGetPanParams structure populated with values from the JSON object
+* @param structSO: structure to be populated with values from the JSON object
+* @param validator: JsonValidator instance to accumulate validation results
+* @return bool: True if the JSON object is valid, false otherwise
 * @throws NO EXCEPTION HANDLING
 **/
-SGetPanParams jsonToSGetPanParams(nlohmann::json jsonObj) {
-	SGetPanParams structSO{};
+bool readSPanParams(const json& jsonObj, SPanParams& structSO, JsonValidator& validator) {
+	size_t firstError = validator.errorCount();
 
-	unsigned long bandwidth = jsonObj["span"].get<unsigned long>();
-	//loggerPtr->debug("Bandwidth (Hz): {}", bandwidth);
-	structSO.bandwidth = Units::Frequency(bandwidth).GetRaw();
+	validator.readType(jsonObj, "antenna", VALID_TYPE_NUMBER, structSO.antenna);
 
-	unsigned long freq = jsonObj["centerFrequency"].get<unsigned long>();
-	//loggerPtr->debug("Frequency (Hz): {}", freq);
-	structSO.freq = Units::Frequency(freq).GetRaw();
+	auto rcvrIt = jsonObj.find("rcvr");
+	if (rcvrIt == jsonObj.end()) {
+		validator.addError("rcvr", "Field required");
+	}
+	else if (!rcvrIt->is_object()) {
+		validator.addError("rcvr", "Type required: '" + std::string(VALID_TYPE_OBJECT) + "'");
+	}
+	else {
+		size_t firstRcvrError = validator.errorCount();
+		unsigned long freq = 0;
+		unsigned long bandwidth = 0;
+		unsigned long bfo = 0;
+		if (validator.readType(*rcvrIt, "freq", VALID_TYPE_NUMBER, freq)) {
+			structSO.rcvr.freq = Units::Frequency(freq).GetRaw();
+		}
+		if (validator.readType(*rcvrIt, "bandwidth", VALID_TYPE_NUMBER, bandwidth)) {
+			structSO.rcvr.bandwidth = Units::Frequency(bandwidth).GetRaw();
+		}
+		if (validator.readType(*rcvrIt, "bfo", VALID_TYPE_NUMBER, bfo)) {
+			structSO.rcvr.bfo = Units::Frequency(bfo).GetRaw();
+		}
+		validator.readOptional(*rcvrIt, "detMode", VALID_TYPE_NUMBER, structSO.rcvr.detMode);
+		validator.readOptional(*rcvrIt, "agcTime", VALID_TYPE_NUMBER, structSO.rcvr.agcTime);
+		validator.prefixErrors(firstRcvrError, "rcvr");
+	}
 
-	unsigned char rcvrAtten = jsonObj["rcvrAtten"].get<unsigned char>();
-	//loggerPtr->debug("Receiver Attenuation (dB): {}", (unsigned int)rcvrAtten);
-	structSO.rcvrAtten = rcvrAtten;
-	
-	return structSO;
+	return validator.errorCount() == firstError;
 }
 
 // ----------------------------------------------------------------------
 /**
-* @brief Convert JSON object in SPanParams struct
-* 
+* @brief Validate JSON object and convert it in SMeasReqData struct in a single pass
+*
+* Applies the measurement validation rules. The bwCmd, dfCmd, fieldStrengthCmd, freqCmd, iqCmd and modulationCmd objects are optional,
+* missing fields are left at zero.
+*
 * @param jsonObj: JSON object containing the parameters
-* @return SPanParams structure populated with values from the JSON object
+* @param validator: JsonValidator instance to accumulate validation results
+* @return SMeasReqData: structure populated with values from the JSON object, or nullptr if the JSON object is invalid
 * @throws NO EXCEPTION HANDLING
 **/
-SPanParams jsonToSPanParams(nlohmann::json jsonObj) {
-	SPanParams structSO{};
+SMeasReqData* readSMeasReqData(const json& jsonObj, JsonValidator& validator) {
+	size_t firstError = validator.errorCount();
 
-	structSO.antenna = jsonObj["antenna"].get<SEquipCtrlMsg::EAnt>();
-	
-	SEquipCtrlMsg::SRcvrCtrlCmd rcvr;
-	rcvr.freq = Units::Frequency(jsonObj["rcvr"]["freq"].get<unsigned long>()).GetRaw();
-	rcvr.bandwidth = Units::Frequency(jsonObj["rcvr"]["bandwidth"].get<unsigned long>()).GetRaw();
-	rcvr.bfo = Units::Frequency(jsonObj["rcvr"]["bfo"].get<unsigned long>()).GetRaw();
+	std::unique_ptr<SMeasReqData, decltype(&free)> measReqMsg((SMeasReqData*)malloc(sizeof(SMeasReqData)), &free);
+	if (measReqMsg == nullptr) {
+		loggerPtr->error("Memory allocation failed in readSMeasReqData. Size: {}", sizeof(SMeasReqData));
+		validator.addError("Memory allocation failed for the measurement request");
+		return nullptr;
+	}
+	memset(measReqMsg.get(), 0, sizeof(SMeasReqData));
 
-	rcvr.detMode = jsonObj["rcvr"]["detMode"].is_null() == true ? (SSmsMsg::SRcvrCtrlCmdV1::EDetMode)NULL : jsonObj["rcvr"]["detMode"].get<SSmsMsg::SRcvrCtrlCmdV1::EDetMode>();
-	rcvr.agcTime = jsonObj["rcvr"]["agcTime"].is_null() == true ? NULL : jsonObj["rcvr"]["agcTime"].get<unsigned long>();
-	
-	structSO.rcvr = rcvr;
-	return structSO;
+	unsigned long freq = 0;
+	if (validator.readRange(jsonObj, "freq", MIN_FREQ, MAX_FREQ, freq)) {
+		measReqMsg->freq = Units::Frequency(freq).GetRaw();
+	}
+	unsigned long bandwidth = 0;
+	if (validator.readRange(jsonObj, "bandwidth", MIN_BANDWIDTH, MAX_BANDWIDTH, bandwidth)) {
+		measReqMsg->bandwidth = Units::Frequency(bandwidth).GetRaw();
+	}
+	validator.readRange(jsonObj, "ant", MIN_ANT, MAX_ANT, measReqMsg->ant);
+
+	size_t firstCmdError = validator.errorCount();
+	if (const json* bwCmd = readOptionalObject(jsonObj, "bwCmd", validator)) {
+		validator.readOptional(*bwCmd, "dwellTime", VALID_TYPE_NUMBER, measReqMsg->bwCmd.dwellTime);
+		validator.readOptional(*bwCmd, "betaParam", VALID_TYPE_NUMBER, measReqMsg->bwCmd.betaParam);
+		validator.readOptional(*bwCmd, "yParam", VALID_TYPE_NUMBER, measReqMsg->bwCmd.yParam);
+		validator.readOptional(*bwCmd, "x1Param", VALID_TYPE_NUMBER, measReqMsg->bwCmd.x1Param);
+		validator.readOptional(*bwCmd, "x2Param", VALID_TYPE_NUMBER, measReqMsg->bwCmd.x2Param);
+		validator.readOptional(*bwCmd, "repeatCount", VALID_TYPE_NUMBER, measReqMsg->bwCmd.repeatCount);
+		validator.readOptional(*bwCmd, "aveMethod", VALID_TYPE_NUMBER, measReqMsg->bwCmd.aveMethod);
+		validator.readOptional(*bwCmd, "outputType", VALID_TYPE_NUMBER, measReqMsg->bwCmd.outputType);
+		validator.prefixErrors(firstCmdError, "bwCmd");
+	}
+
+	firstCmdError = validator.errorCount();
+	if (const json* dfCmd = readOptionalObject(jsonObj, "dfCmd", validator)) {
+		validator.readOptional(*dfCmd, "confThreshold", VALID_TYPE_NUMBER, measReqMsg->dfCmd.confThreshold);
+		validator.readOptional(*dfCmd, "dwellTime", VALID_TYPE_NUMBER, measReqMsg->dfCmd.dwellTime);
+		validator.readOptional(*dfCmd, "repeatCount", VALID_TYPE_NUMBER, measReqMsg->dfCmd.repeatCount);
+		readOptionalFrequency(*dfCmd, "dfBandwidth", measReqMsg->dfCmd.dfBandwidth, validator);
+		validator.readOptional(*dfCmd, "outputType", VALID_TYPE_NUMBER, measReqMsg->dfCmd.outputType);
+		validator.readOptional(*dfCmd, "srcOfRequest", VALID_TYPE_NUMBER, measReqMsg->dfCmd.srcOfRequest);
+		validator.prefixErrors(firstCmdError, "dfCmd");
+	}
+
+	firstCmdError = validator.errorCount();
+	if (const json* fieldStrengthCmd = readOptionalObject(jsonObj, "fieldStrengthCmd", validator)) {
+		validator.readOptional(*fieldStrengthCmd, "fieldMethod", VALID_TYPE_NUMBER, measReqMsg->fieldStrengthCmd.fieldMethod);
+		validator.readOptional(*fieldStrengthCmd, "dwellTime", VALID_TYPE_NUMBER, measReqMsg->fieldStrengthCmd.dwellTime);
+		validator.readOptional(*fieldStrengthCmd, "repeatCount", VALID_TYPE_NUMBER, measReqMsg->fieldStrengthCmd.repeatCount);
+		validator.readOptional(*fieldStrengthCmd, "aveMethod", VALID_TYPE_NUMBER, measReqMsg->fieldStrengthCmd.aveMethod);
+		validator.readOptional(*fieldStrengthCmd, "outputType", VALID_TYPE_NUMBER, measReqMsg->fieldStrengthCmd.outputType);
+		validator.prefixErrors(firstCmdError, "fieldStrengthCmd");
+	}
+
+	firstCmdError = validator.errorCount();
+	if (const json* freqCmd = readOptionalObject(jsonObj, "freqCmd", validator)) {
+		validator.readOptional(*freqCmd, "freqMethod", VALID_TYPE_NUMBER, measReqMsg->freqCmd.freqMethod);
+		validator.readOptional(*freqCmd, "dwellTime", VALID_TYPE_NUMBER, measReqMsg->freqCmd.dwellTime);
+		validator.readOptional(*freqCmd, "repeatCount", VALID_TYPE_NUMBER, measReqMsg->freqCmd.repeatCount);
+		validator.readOptional(*freqCmd, "aveMethod", VALID_TYPE_NUMBER, measReqMsg->freqCmd.aveMethod);
+		validator.readOptional(*freqCmd, "outputType", VALID_TYPE_NUMBER, measReqMsg->freqCmd.outputType);
+		validator.prefixErrors(firstCmdError, "freqCmd");
+	}
+
+	firstCmdError = validator.errorCount();
+	if (const json* iqCmd = readOptionalObject(jsonObj, "iqCmd", validator)) {
+		validator.readOptional(*iqCmd, "bwFactor", VALID_TYPE_NUMBER, measReqMsg->iqCmd.bwFactor);
+		validator.readOptional(*iqCmd, "numSamples", VALID_TYPE_NUMBER, measReqMsg->iqCmd.numSamples);
+		validator.readOptional(*iqCmd, "outputType", VALID_TYPE_NUMBER, measReqMsg->iqCmd.outputType);
+		validator.readOptional(*iqCmd, "startTime", VALID_TYPE_NUMBER, measReqMsg->iqCmd.startTime);
+		readOptionalFlag(*iqCmd, "tdoa", measReqMsg->iqCmd.tdoa, validator);
+		validator.prefixErrors(firstCmdError, "iqCmd");
+	}
+
+	firstCmdError = validator.errorCount();
+	if (const json* modulationCmd = readOptionalObject(jsonObj, "modulationCmd", validator)) {
+		validator.readOptional(*modulationCmd, "dwellTime", VALID_TYPE_NUMBER, measReqMsg->modulationCmd.dwellTime);
+		validator.readOptional(*modulationCmd, "repeatCount", VALID_TYPE_NUMBER, measReqMsg->modulationCmd.repeatCount);
+		validator.readOptional(*modulationCmd, "aveMethod", VALID_TYPE_NUMBER, measReqMsg->modulationCmd.aveMethod);
+		validator.readOptional(*modulationCmd, "outputType", VALID_TYPE_NUMBER, measReqMsg->modulationCmd.outputType);
+		validator.prefixErrors(firstCmdError, "modulationCmd");
+	}
+
+	if (validator.errorCount() > firstError) {
+		return nullptr;
+	}
+	return measReqMsg.release();
+}
+
+// ----------------------------------------------------------------------
+/**
+ * @brief Validate band JSON object and convert it in SBandV4 struct in a single pass
+ *
+ * Every field is optional, missing fields are left at zero.
+ *
+ * @param bandJson: JSON object containing the band parameters
+ * @param band: Reference to the SBandV4 struct to be filled
+ * @param validator: JsonValidator instance to accumulate validation results
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void readBandV4Data(const json& bandJson, SSmsMsg::SBandV4& band, JsonValidator& validator) {
+	readOptionalFrequency(bandJson, "channelBandwidth", band.channelBandwidth, validator);
+	readOptionalFlag(bandJson, "exclude", band.exclude, validator);
+	readOptionalFrequency(bandJson, "highFrequency", band.highFrequency, validator);
+	readOptionalFrequency(bandJson, "lowFrequency", band.lowFrequency, validator);
+
+	size_t firstError = validator.errorCount();
+	const json* sType = readOptionalObject(bandJson, "sType", validator);
+	const json* signalType = sType != nullptr ? readOptionalObject(*sType, "signalType", validator) : nullptr;
+	if (signalType != nullptr) {
+		unsigned long horizPol = 0;
+		unsigned long narrow = 0;
+		unsigned long unused0 = 0;
+		unsigned long unused1 = 0;
+		size_t firstSignalError = validator.errorCount();
+		validator.readOptional(*signalType, "horizPol", VALID_TYPE_NUMBER, horizPol);
+		validator.readOptional(*signalType, "narrow", VALID_TYPE_NUMBER, narrow);
+		validator.readOptional(*signalType, "unused0", VALID_TYPE_NUMBER, unused0);
+		validator.readOptional(*signalType, "unused1", VALID_TYPE_NUMBER, unused1);
+		validator.prefixErrors(firstSignalError, "signalType");
+
+		band.sType.signalType.horizPol = horizPol;
+		band.sType.signalType.narrow = narrow;
+		band.sType.signalType.unused0 = unused0;
+		band.sType.signalType.unused1 = unused1;
+	}
+	if (sType != nullptr) {
+		validator.prefixErrors(firstError, "sType");
+	}
+}
+
+// ----------------------------------------------------------------------
+/**
+ * @brief Validate the bands of a request and allocate the request struct with one SBandV4 for each band
+ *
+ * The band may be a single object or an array of objects. numBands is set to the number of bands received.
+ *
+ * @tparam T: Request struct ending with the SBandV4 band array, SOccupReqData or SAVDReqData
+ * @param jsonObj: JSON object containing the parameters
+ * @param validator: JsonValidator instance to accumulate validation results
+ * @return std::unique_ptr<T, decltype(&free)>: Zero initialized request with the bands filled, nullptr if the bands are missing or of the wrong type
+ * @throws NO EXCEPTION HANDLING
+**/
+template <typename T>
+std::unique_ptr<T, decltype(&free)> readBandRequest(const json& jsonObj, JsonValidator& validator) {
+	std::unique_ptr<T, decltype(&free)> reqMsg(nullptr, &free);
+
+	auto bandIt = jsonObj.find("band");
+	if (bandIt == jsonObj.end()) {
+		validator.addError("band", "Field required");
+		return reqMsg;
+	}
+	bool bandArray = bandIt->is_array();
+	if (!bandArray && !bandIt->is_object()) {
+		validator.addError("band", "Type required: '" + std::string(VALID_TYPE_ARRAY) + "'");
+		return reqMsg;
+	}
+	size_t numBands = bandArray ? bandIt->size() : 1;
+	if (numBands < static_cast<size_t>(MIN_NUM_BANDS) || numBands > static_cast<size_t>(MAX_NUM_BANDS)) {
+		validator.addError("band", "Number of bands must be between " + std::to_string(MIN_NUM_BANDS) + " and " + std::to_string(MAX_NUM_BANDS));
+		return reqMsg;
+	}
+
+	size_t bodySize = offsetof(T, band) + numBands * sizeof(SSmsMsg::SBandV4);
+	reqMsg.reset((T*)malloc(bodySize));
+	if (reqMsg == nullptr) {
+		loggerPtr->error("Memory allocation failed in readBandRequest. Size: {}", bodySize);
+		validator.addError("band", "Memory allocation failed for " + std::to_string(numBands) + " bands");
+		return reqMsg;
+	}
+	memset(reqMsg.get(), 0, bodySize);
+	reqMsg->numBands = static_cast<unsigned short>(numBands);
+
+	for (size_t i = 0; i < numBands; ++i) {
+		size_t firstBandError = validator.errorCount();
+		readBandV4Data(bandArray ? (*bandIt)[i] : *bandIt, reqMsg->band[i], validator);
+		if (validator.errorCount() > firstBandError) {
+			validator.prefixErrors(firstBandError, bandArray ? "band[" + std::to_string(i) + "]" : "band");
+		}
+	}
+	return reqMsg;
 }
 
 // ----------------------------------------------------------------------
 /**
-* @brief Convert JSON object in SMeasReqData struct
-* 
+* @brief Validate JSON object and convert it in SOccupReqData struct in a single pass
+*
+* Applies the occupancy validation rules, including the fields shared with the occupancy DF request and not used by SOccupReqData.
+* The band may be a single object or an array of objects.
+*
 * @param jsonObj: JSON object containing the parameters
-* @return SMeasReqData structure populated with values from the JSON object
+* @param validator: JsonValidator instance to accumulate validation results
+* @return SOccupReqData: structure populated with values from the JSON object, or nullptr if the JSON object is invalid
 * @throws NO EXCEPTION HANDLING
 **/
-SMeasReqData* jsonToSMeasReqData(nlohmann::json jsonObj) {
-	SMeasReqData structSO{};
-	
-	if (jsonObj["freq"].is_null() == false) {
-		structSO.freq = Units::Frequency(jsonObj["freq"].get<unsigned long>()).GetRaw();
-	}
-	if (jsonObj["bandwidth"].is_null() == false) {
-		structSO.bandwidth = Units::Frequency(jsonObj["bandwidth"].get<unsigned long>()).GetRaw();
-	}
-	structSO.ant = jsonObj["ant"].is_null() == true ? (SEquipCtrlMsg::EAnt)NULL : jsonObj["ant"].get<SEquipCtrlMsg::EAnt>();
-
-	SSmsMsg::SGetBwCmd bwCmd;
-	bwCmd.dwellTime = jsonObj["bwCmd"]["dwellTime"].is_null() == true ? NULL : jsonObj["bwCmd"]["dwellTime"].get<unsigned long>();
-	bwCmd.betaParam = jsonObj["bwCmd"]["betaParam"].is_null() == true ? NULL : jsonObj["bwCmd"]["betaParam"].get<unsigned long>();
-	bwCmd.yParam = jsonObj["bwCmd"]["yParam"].is_null() == true ? NULL : jsonObj["bwCmd"]["yParam"].get<unsigned long>();
-	bwCmd.x1Param = jsonObj["bwCmd"]["x1Param"].is_null() == true ? NULL : jsonObj["bwCmd"]["x1Param"].get<unsigned long>();
-	bwCmd.x2Param = jsonObj["bwCmd"]["x2Param"].is_null() == true ? NULL : jsonObj["bwCmd"]["x2Param"].get<unsigned long>();
-	bwCmd.repeatCount = jsonObj["bwCmd"]["repeatCount"].is_null() == true ? NULL : jsonObj["bwCmd"]["repeatCount"].get<unsigned long>();
-	bwCmd.aveMethod = jsonObj["bwCmd"]["aveMethod"].is_null() == true ? (SSmsMsg::EAveMethod)NULL : jsonObj["bwCmd"]["aveMethod"].get<SSmsMsg::EAveMethod>();
-	bwCmd.outputType = jsonObj["bwCmd"]["outputType"].is_null() == true ? (SSmsMsg::EOutputType)NULL : jsonObj["bwCmd"]["outputType"].get<SSmsMsg::EOutputType>();
-	
-	structSO.bwCmd = bwCmd;
-	
-	SSmsMsg::SGetMeasCmdV5::SGetDfCmd dfCmd;
-	dfCmd.confThreshold = jsonObj["dfCmd"]["confThreshold"].is_null() == true ? NULL : jsonObj["dfCmd"]["confThreshold"].get<unsigned char>();
-	dfCmd.dwellTime = jsonObj["dfCmd"]["dwellTime"].is_null() == true ? NULL : jsonObj["dfCmd"]["dwellTime"].get<unsigned long>();
-	dfCmd.repeatCount = jsonObj["dfCmd"]["repeatCount"].is_null() == true ? NULL : jsonObj["dfCmd"]["repeatCount"].get<unsigned long>();
-	if (jsonObj["dfCmd"]["dfBandwidth"].is_null() == false) {
-		dfCmd.dfBandwidth = Units::Frequency(jsonObj["dfCmd"]["dfBandwidth"].get<unsigned long>()).GetRaw();
-	}
-	dfCmd.outputType = jsonObj["dfCmd"]["outputType"].is_null() == true ? (SSmsMsg::SGetMeasCmdV5::SGetDfCmd::EOutputType)NULL : jsonObj["dfCmd"]["outputType"].get<SSmsMsg::SGetMeasCmdV5::SGetDfCmd::EOutputType>();
-	dfCmd.srcOfRequest = jsonObj["dfCmd"]["srcOfRequest"].is_null() == true ? (SSmsMsg::SGetMeasCmdV5::SGetDfCmd::ESource)NULL : jsonObj["dfCmd"]["srcOfRequest"].get<SSmsMsg::SGetMeasCmdV5::SGetDfCmd::ESource>();
-
-	structSO.dfCmd = dfCmd;
-
-	SSmsMsg::SGetFieldStrengthCmd fieldStrengthCmd;
-	fieldStrengthCmd.fieldMethod = jsonObj["fieldStrengthCmd"]["fieldMethod"].is_null() == true ? (SSmsMsg::EFieldMethod)NULL : jsonObj["fieldStrengthCmd"]["fieldMethod"].get<SSmsMsg::EFieldMethod>();
-	fieldStrengthCmd.dwellTime = jsonObj["fieldStrengthCmd"]["dwellTime"].is_null() == true ? NULL : jsonObj["fieldStrengthCmd"]["dwellTime"].get<unsigned long>();
-	fieldStrengthCmd.repeatCount = jsonObj["fieldStrengthCmd"]["repeatCount"].is_null() == true ? NULL : jsonObj["fieldStrengthCmd"]["repeatCount"].get<unsigned long>();
-	fieldStrengthCmd.aveMethod = jsonObj["fieldStrengthCmd"]["aveMethod"].is_null() == true ? (SSmsMsg::EAveMethod)NULL : jsonObj["fieldStrengthCmd"]["aveMethod"].get<SSmsMsg::EAveMethod>();
-	fieldStrengthCmd.outputType = jsonObj["fieldStrengthCmd"]["outputType"].is_null() == true ? (SSmsMsg::EOutputType)NULL : jsonObj["fieldStrengthCmd"]["outputType"].get<SSmsMsg::EOutputType>();
-
-	structSO.fieldStrengthCmd = fieldStrengthCmd;
-		
-	SSmsMsg::SGetFreqCmd freqCmd;
-	freqCmd.freqMethod = jsonObj["freqCmd"]["freqMethod"].is_null() == true ? (SSmsMsg::SGetFreqCmd::EFreqMethod)NULL : jsonObj["freqCmd"]["freqMethod"].get<SSmsMsg::SGetFreqCmd::EFreqMethod>();
-	freqCmd.dwellTime = jsonObj["freqCmd"]["dwellTime"].is_null() == true ? NULL : jsonObj["freqCmd"]["dwellTime"].get<unsigned long>();
-	freqCmd.repeatCount = jsonObj["freqCmd"]["repeatCount"].is_null() == true ? NULL : jsonObj["freqCmd"]["repeatCount"].get<unsigned long>();
-	freqCmd.aveMethod = jsonObj["freqCmd"]["aveMethod"].is_null() == true ? (SSmsMsg::EAveMethod)NULL : jsonObj["freqCmd"]["aveMethod"].get<SSmsMsg::EAveMethod>();
-	freqCmd.outputType = jsonObj["freqCmd"]["outputType"].is_null() == true ? (SSmsMsg::EOutputType)NULL : jsonObj["freqCmd"]["outputType"].get<SSmsMsg::EOutputType>();
-	
-	structSO.freqCmd = freqCmd;
-
-	SSmsMsg::SGetMeasCmdV5::SGetIQCmd iqCmd;
-	iqCmd.bwFactor = jsonObj["iqCmd"]["bwFactor"].is_null() == true ? NULL : jsonObj["iqCmd"]["bwFactor"].get<float>();
-	iqCmd.numSamples = jsonObj["iqCmd"]["numSamples"].is_null() == true ? NULL : jsonObj["iqCmd"]["numSamples"].get<unsigned long>();
-	iqCmd.outputType = jsonObj["iqCmd"]["outputType"].is_null() == true ? (SSmsMsg::EOutputType)NULL : jsonObj["iqCmd"]["outputType"].get<SSmsMsg::EOutputType>();
-	iqCmd.startTime = jsonObj["iqCmd"]["startTime"].is_null() == true ? NULL : jsonObj["iqCmd"]["startTime"].get<DATE>();
-	iqCmd.tdoa = jsonObj["iqCmd"]["tdoa"].is_null() == true ? NULL : jsonObj["iqCmd"]["tdoa"].get<bool>();
-
-	structSO.iqCmd = iqCmd;
-
-	SSmsMsg::SGetModulationCmd modulationCmd;
-	modulationCmd.dwellTime = jsonObj["modulationCmd"]["dwellTime"].is_null() == true ? NULL : jsonObj["modulationCmd"]["dwellTime"].get<unsigned long>();
-	modulationCmd.repeatCount = jsonObj["modulationCmd"]["repeatCount"].is_null() == true ? NULL : jsonObj["modulationCmd"]["repeatCount"].get<unsigned long>();
-	modulationCmd.aveMethod = jsonObj["modulationCmd"]["aveMethod"].is_null() == true ? (SSmsMsg::EAveMethod)NULL : jsonObj["modulationCmd"]["aveMethod"].get<SSmsMsg::EAveMethod>();
-	modulationCmd.outputType = jsonObj["modulationCmd"]["outputType"].is_null() == true ? (SSmsMsg::EOutputType)NULL : jsonObj["modulationCmd"]["outputType"].get<SSmsMsg::EOutputType>();
-
-	structSO.modulationCmd = modulationCmd;
-		
-	SMeasReqData* m_measureReqMsg = (SMeasReqData*)malloc(sizeof(SMeasReqData));
-	memcpy(m_measureReqMsg, &structSO, sizeof(SMeasReqData));
-	return m_measureReqMsg;
+SOccupReqData* readSOccupReqData(const json& jsonObj, JsonValidator& validator) {
+	size_t firstError = validator.errorCount();
+
+	std::unique_ptr<SOccupReqData, decltype(&free)> occReqMsg = readBandRequest<SOccupReqData>(jsonObj, validator);
+	if (occReqMsg == nullptr) {
+		return nullptr;
+	}
+
+	int numBandsArg = 0;
+	int numAzimuths = 0;
+	int confidence = 0;
+	int recordHoldoff = 0;
+	int scanDfThreshold = 0;
+	bool recordAudioDf = false;
+	validator.readRange(jsonObj, "ant", MIN_ANT, MAX_ANT, occReqMsg->ant);
+	validator.readRange(jsonObj, "numBands", MIN_NUM_BANDS, MAX_NUM_BANDS, numBandsArg);
+	validator.readRange(jsonObj, "storageTime", MIN_STORAGE_TIME, MAX_STORAGE_TIME, occReqMsg->storageTime);
+	validator.readRange(jsonObj, "measurementTime", MIN_MEASUREMENT_TIME, MAX_MEASUREMENT_TIME, occReqMsg->measurementTime);
+	validator.readRange(jsonObj, "numAzimuths", MIN_AZIMUTHS, MAX_AZIMUTHS, numAzimuths);
+	validator.readRange(jsonObj, "confidence", MIN_DF_CONFIDENCE, MAX_DF_CONFIDENCE, confidence);
+	validator.readRange(jsonObj, "recordHoldoff", MIN_RECORD_HOLDOFF, MAX_RECORD_HOLDOFF, recordHoldoff);
+	validator.readRange(jsonObj, "scanDfThreshold", MIN_SCAN_DF_THRESHOLD, MAX_SCAN_DF_THRESHOLD, scanDfThreshold);
+	validator.readType(jsonObj, "recordAudioDf", VALID_TYPE_BOOLEAN, recordAudioDf);
+
+	validator.readOptional(jsonObj, "confidenceLevel", VALID_TYPE_NUMBER, occReqMsg->confidenceLevel);
+	validator.readOptional(jsonObj, "desiredAccuracy", VALID_TYPE_NUMBER, occReqMsg->desiredAccuracy);
+	validator.readOptional(jsonObj, "durationMethod", VALID_TYPE_NUMBER, occReqMsg->durationMethod);
+	validator.readOptional(jsonObj, "occupancyMinGap", VALID_TYPE_NUMBER, occReqMsg->occupancyMinGap);
+	validator.readOptional(jsonObj, "thresholdMethod", VALID_TYPE_NUMBER, occReqMsg->thresholdMethod);
+
+	auto thresholdIt = jsonObj.find("occPrimaryThreshold");
+	if (thresholdIt != jsonObj.end() && !thresholdIt->is_null()) {
+		if (!thresholdIt->is_array()) {
+			validator.addError("occPrimaryThreshold", "Type required: '" + std::string(VALID_TYPE_ARRAY) + "'");
+		}
+		else if (!thresholdIt->empty()) {
+			if ((*thresholdIt)[0].is_number()) {
+				occReqMsg->occPrimaryThreshold[0] = (*thresholdIt)[0].get<short>();
+			}
+			else {
+				validator.addError("occPrimaryThreshold[0]", "Type required: '" + std::string(VALID_TYPE_NUMBER) + "'");
+			}
+		}
+	}
+
+	if (validator.errorCount() > firstError) {
+		return nullptr;
+	}
+	return occReqMsg.release();
+}
+
+// ----------------------------------------------------------------------
+/**
+* @brief Validate JSON object and convert it in SAVDReqData struct in a single pass
+*
+* Applies the AVD validation rules. The band may be a single object or an array of objects.
+*
+* @param jsonObj: JSON object containing the parameters
+* @param validator: JsonValidator instance to accumulate validation results
+* @return SAVDReqData: structure populated with values from the JSON object, or nullptr if the JSON object is invalid
+* @throws NO EXCEPTION HANDLING
+*/
+SAVDReqData* readSAVDReqData(const json& jsonObj, JsonValidator& validator) {
+	size_t firstError = validator.errorCount();
+
+	std::unique_ptr<SAVDReqData, decltype(&free)> avdReqMsg = readBandRequest<SAVDReqData>(jsonObj, validator);
+	if (avdReqMsg == nullptr) {
+		return nullptr;
+	}
+
+	unsigned long freq = 0;
+	unsigned long bandwidth = 0;
+	int duration = 0;
+	std::string modulation;
+	validator.readRange(jsonObj, "freq", MIN_FREQ, MAX_FREQ, freq);
+	validator.readRange(jsonObj, "bandwidth", MIN_BANDWIDTH, MAX_BANDWIDTH, bandwidth);
+	validator.readRange(jsonObj, "duration", MIN_DURATION, MAX_DURATION, duration);
+	validator.readType(jsonObj, "modulation", VALID_TYPE_STRING, modulation);
+
+	validator.readOptional(jsonObj, "ant", VALID_TYPE_NUMBER, avdReqMsg->ant);
+	validator.readOptional(jsonObj, "avdThreshold", VALID_TYPE_NUMBER, avdReqMsg->avdThreshold);
+	validator.readOptional(jsonObj, "measurementRate", VALID_TYPE_NUMBER, avdReqMsg->measurementRate);
+	validator.readOptional(jsonObj, "measurementTime", VALID_TYPE_NUMBER, avdReqMsg->measurementTime);
+	validator.readOptional(jsonObj, "storageTime", VALID_TYPE_NUMBER, avdReqMsg->storageTime);
+
+	if (validator.errorCount() > firstError) {
+		return nullptr;
+	}
+	return avdReqMsg.release();
 }
 
+// ----------------------------------------------------------------------
+/**
+* @brief Request arguments converted into Scorpio API structs while the request is validated
+*
+* Filled by the read functions of the command table. Buffers not submitted to the DLL are released with the structure.
+**/
+struct DLLRequestData {
+	SGetPanParams panParams{};
+	double rateHz = 0;
+	SpectrumOutput output;
+	SAudioParams audioParams{};
+	SPanParams setPanParams{};
+	std::unique_ptr<SMeasReqData, decltype(&free)> measReqMsg{ nullptr, &free };
+	std::unique_ptr<SOccupReqData, decltype(&free)> occReqMsg{ nullptr, &free };
+	std::unique_ptr<SAVDReqData, decltype(&free)> avdReqMsg{ nullptr, &free };
+	std::unique_ptr<SOccDFReqData, decltype(&free)> occDFReqMsg{ nullptr, &free };
+};
 
 // ----------------------------------------------------------------------
 /**
-* @brief Convert JSON object in SOccupReqData struct
-* 
+* @brief Validate JSON object and convert it in SGetPanParams struct in a single pass
+*
 * @param jsonObj: JSON object containing the parameters
-* @return SOccupReqData structure populated with values from the JSON object
+* @param structSO: structure to be populated with values from the JSON object
+* @param validator: JsonValidator instance to accumulate validation results
+* @return bool: True if the JSON object is valid, false otherwise
 * @throws NO EXCEPTION HANDLING
 **/
-SOccupReqData* jsonToSOccupReqData(nlohmann::json jsonObj) {
-	SOccupReqData structSO;
-	SSmsMsg::SBandV4 band;
+bool readSGetPanParams(const json& jsonObj, SGetPanParams& structSO, JsonValidator& validator) {
+	size_t firstError = validator.errorCount();
 
+	unsigned long freq = 0;
+	if (validator.readRange(jsonObj, "centerFrequency", MIN_FREQ, MAX_FREQ, freq)) {
+		structSO.freq = Units::Frequency(freq).GetRaw();
+	}
 
-	// If 'band' is an array, set the number of bands accordingly
-	// otherwise set it to 1 and convert it to an array
-	if (jsonObj["band"].is_array() == true) {
-		structSO.numBands = jsonObj["band"].size();
-	} else {
-		structSO.numBands = 1; 
-		json singleBand = jsonObj["band"];
-		jsonObj["band"] = json::array({ singleBand });
+	unsigned long bandwidth = 0;
+	if (validator.readRange(jsonObj, "span", MIN_BANDWIDTH, MAX_BANDWIDTH, bandwidth)) {
+		structSO.bandwidth = Units::Frequency(bandwidth).GetRaw();
 	}
 
-	// create a vector of band objects and fill it with data from the JSON object
-	
+	validator.readRange(jsonObj, "rcvrAtten", MIN_RCVD_ATTEN, MAX_RCVD_ATTEN, structSO.rcvrAtten);
 
-	// TODO: Handle multiple bands, using vector and dynamic memory allocation
-	// TODO: Handle default values from config, replacing NULL
-	// TODO: Reorder the field handling to match the struct order
+	return validator.errorCount() == firstError;
+}
 
+// ----------------------------------------------------------------------
+/**
+* @brief Validate and read the optional output options of a spectrum request
+*
+* outputBins sets the number of bins sent to the client, decimating the spectrum with the "max", "mean" or "min" decimation.
+* peakThreshold (level) or peakMargin (dB above the noise floor at noisePercentile) request the peaks of the spectrum,
+* at least peakSpacing Hz apart. sweepData false sends only the peaks.
+*
+* @param jsonObj: JSON object containing the parameters
+* @param data: Structure to be filled with the output options
+* @param validator: JsonValidator instance to accumulate validation results
+* @return bool: True if the options are missing or valid, false otherwise
+* @throws NO EXCEPTION HANDLING
+**/
+bool readSpectrumOutput(const json& jsonObj, DLLRequestData& data, JsonValidator& validator) {
+	size_t firstError = validator.errorCount();
 
-	if (jsonObj["band"]["channelBandwidth"].is_null() == false) {
-		band.channelBandwidth = Units::Frequency(jsonObj["band"]["channelBandwidth"].get<unsigned long>()).GetRaw();
+	validator.optionalRange(jsonObj, "outputBins", MIN_OUTPUT_BINS, MAX_OUTPUT_BINS);
+	if (validator.errorCount() == firstError) {
+		validator.readOptional(jsonObj, "outputBins", VALID_TYPE_NUMBER, data.output.bins);
 	}
-	band.exclude = jsonObj["band"]["exclude"].is_null() ? NULL : jsonObj["band"]["exclude"].get<bool>();
-	
-	if (jsonObj["band"]["highFrequency"].is_null() == false) {
-		band.highFrequency = Units::Frequency(jsonObj["band"]["highFrequency"].get<unsigned long>()).GetRaw();
+
+	Decimation decimation = static_cast<Decimation>(data.output.decimation);
+	std::string decimationName = decimationToString(decimation);
+	if (validator.readOptional(jsonObj, "decimation", VALID_TYPE_STRING, decimationName) && !decimationFromString(decimationName, decimation)) {
+		validator.addError("decimation", "Value must be 'max', 'mean' or 'min'");
 	}
-	
-	if (jsonObj["band"]["lowFrequency"].is_null() == false) {
-		band.lowFrequency = Units::Frequency(jsonObj["band"]["lowFrequency"].get<unsigned long>()).GetRaw();
-	}
-
-	band.sType.signalType.horizPol = jsonObj["band"]["signalType"]["horizPol"].is_null() == true ? NULL : jsonObj["band"]["sType"]["signalType"]["horizPol"].get<unsigned long>();
-	band.sType.signalType.narrow = jsonObj["band"]["signalType"]["narrow"].is_null() == true ? NULL : jsonObj["band"]["sType"]["signalType"]["narrow"].get<unsigned long>();
-	band.sType.signalType.unused0 = 0;
-	band.sType.signalType.unused1 = 0;
-
-	structSO.band[0] = band;
-
-	structSO.ant = jsonObj["ant"].is_null() ? (SEquipCtrlMsg::EAnt)NULL : jsonObj["ant"].get<SEquipCtrlMsg::EAnt>();
-	structSO.confidenceLevel = jsonObj["confidenceLevel"].is_null() ? NULL : jsonObj["confidenceLevel"].get<unsigned char>();
-	structSO.desiredAccuracy = jsonObj["desiredAccuracy"].is_null() ? NULL : jsonObj["desiredAccuracy"].get<unsigned char>();
-	structSO.durationMethod = jsonObj["durationMethod"].is_null() ? (SEquipCtrlMsg::EDurationMethod)NULL : jsonObj["durationMethod"].get<SEquipCtrlMsg::EDurationMethod>();
-	structSO.measurementTime = jsonObj["measurementTime"].is_null() ? NULL : jsonObj["measurementTime"].get<unsigned long>();
-	structSO.occPrimaryThreshold[0] = jsonObj["occPrimaryThreshold"][0].is_null() ? NULL : jsonObj["occPrimaryThreshold"][0].get<short>();
-	structSO.occupancyMinGap = jsonObj["occupancyMinGap"].is_null() ? NULL : jsonObj["occupancyMinGap"].get<unsigned long>();
-	structSO.storageTime = jsonObj["storageTime"].is_null() ? NULL : jsonObj["storageTime"].get<unsigned long>();
-	structSO.thresholdMethod = jsonObj["thresholdMethod"].is_null() ? (SEquipCtrlMsg::EThresholdMethod)NULL : jsonObj["thresholdMethod"].get<SEquipCtrlMsg::EThresholdMethod>();
-	
-	auto occupbodySize = offsetof(SOccupReqData, band) + structSO.numBands * sizeof(SEquipCtrlMsg::SBandV4);
-	SOccupReqData* m_occReqMsg = (SOccupReqData*)malloc(occupbodySize);
-	memcpy(m_occReqMsg, &structSO, occupbodySize);
-	
-	return m_occReqMsg;
-}
+	data.output.decimation = static_cast<int>(decimation);
 
+	validator.readOptional(jsonObj, "peakThreshold", VALID_TYPE_NUMBER, data.output.peakThreshold);
+	if (validator.readOptional(jsonObj, "peakMargin", VALID_TYPE_NUMBER, data.output.peakMargin) && data.output.peakMargin < 0) {
+		validator.addError("peakMargin", "Number must not be negative");
+	}
+	if (validator.readOptional(jsonObj, "peakSpacing", VALID_TYPE_NUMBER, data.output.peakSpacing) &&
+		!(data.output.peakSpacing >= MIN_PEAK_SPACING && data.output.peakSpacing <= MAX_PEAK_SPACING)) {
+		validator.addError("peakSpacing", "Number must be between " + std::to_string(MIN_PEAK_SPACING) + " and " + std::to_string(MAX_PEAK_SPACING));
+	}
+	if (validator.readOptional(jsonObj, "noisePercentile", VALID_TYPE_NUMBER, data.output.noisePercentile) &&
+		(data.output.noisePercentile < MIN_NOISE_PERCENTILE || data.output.noisePercentile > MAX_NOISE_PERCENTILE)) {
+		validator.addError("noisePercentile", "Number must be between " + std::to_string(MIN_NOISE_PERCENTILE) + " and " + std::to_string(MAX_NOISE_PERCENTILE));
+	}
+	validator.readOptional(jsonObj, "sweepData", VALID_TYPE_BOOLEAN, data.output.sweepData);
+
+	return validator.errorCount() == firstError;
+}
 
 // ----------------------------------------------------------------------
 /**
- * @brief
- * @brief Helper function to fill in band data from JSON object
- * @param band: Reference to the SBand struct to be filled
+ * @brief Validate band JSON object and convert it in SBand struct in a single pass
+ *
  * @param bandJson: JSON object containing the band parameters
+ * @param band: Reference to the SBand struct to be filled
+ * @param validator: JsonValidator instance to accumulate validation results
+ * @return void
  * @throws NO EXCEPTION HANDLING
 **/
-void fillBandData(SSmsMsg::SGetScanDfCmdV1::SBand& band, const json& bandJson) {
-	if (!bandJson["channelBandwidth"].is_null()) {
-		band.channelBandwidth = Units::Frequency(bandJson["channelBandwidth"].get<unsigned long>()).GetRaw();
-	}
-	band.exclude = bandJson["exclude"].is_null() ? false : bandJson["exclude"].get<bool>();
-	if (!bandJson["stopFrequency"].is_null()) {
-		band.highFrequency = Units::Frequency(bandJson["stopFrequency"].get<unsigned long>()).GetRaw();
-	}
-	if (!bandJson["startFrequency"].is_null()) {
-		band.lowFrequency = Units::Frequency(bandJson["startFrequency"].get<unsigned long>()).GetRaw();
-	}
-
-	// TODO: #25 Improve to add default values if signalType is missing.
-	// The implementation of default values should be in the Validation module.
-	if (bandJson.find("signalType") == bandJson.end()) {
-		loggerPtr->debug("signalType object missing in band JSON. Using default values.");
-		band.signalType.gsm = 0;
-		band.signalType.horizPol = 0;
-		band.signalType.narrow = 0;
-		band.signalType.unused = 0;
-		return;
+void readBandData(const json& bandJson, SSmsMsg::SGetScanDfCmdV1::SBand& band, JsonValidator& validator) {
+	unsigned long channelBandwidth = 0;
+	if (validator.readRange(bandJson, "channelBandwidth", MIN_BANDWIDTH, MAX_BANDWIDTH, channelBandwidth)) {
+		band.channelBandwidth = Units::Frequency(channelBandwidth).GetRaw();
 	}
 
-	band.signalType.gsm = bandJson["signalType"]["gsm"].is_null() ? 0 : bandJson["signalType"]["gsm"].get<unsigned char>();
-	band.signalType.horizPol = bandJson["signalType"]["horizPol"].is_null() ? 0 : bandJson["signalType"]["horizPol"].get<unsigned char>();
-	band.signalType.narrow = bandJson["signalType"]["narrow"].is_null() ? 0 : bandJson["signalType"]["narrow"].get<unsigned char>();
-	band.signalType.unused = bandJson["signalType"]["unused"].is_null() ? 0 : bandJson["signalType"]["unused"].get<unsigned char>();
-}
+	bool exclude = false;
+	validator.readType(bandJson, "exclude", VALID_TYPE_BOOLEAN, exclude);
+	band.exclude = exclude;
+
+	unsigned long stopFrequency = 0;
+	bool validStop = validator.readRange(bandJson, "stopFrequency", MIN_FREQ, MAX_FREQ, stopFrequency);
+	if (validStop) {
+		band.highFrequency = Units::Frequency(stopFrequency).GetRaw();
+	}
 
+	unsigned long startFrequency = 0;
+	if (validator.readRange(bandJson, "startFrequency", MIN_FREQ, MAX_FREQ, startFrequency)) {
+		band.lowFrequency = Units::Frequency(startFrequency).GetRaw();
+		if (validStop && startFrequency >= stopFrequency) {
+			validator.addError("startFrequency", "startFrequency must be less than stopFrequency");
+		}
+	}
+
+	// Missing signalType keeps the zero initialization
+	auto signalTypeIt = bandJson.find("signalType");
+	if (signalTypeIt == bandJson.end() || signalTypeIt->is_null()) {
+		return;
+	}
+	unsigned char gsm = 0;
+	unsigned char horizPol = 0;
+	unsigned char narrow = 0;
+	unsigned char unused = 0;
+	size_t firstError = validator.errorCount();
+	validator.readOptional(*signalTypeIt, "gsm", VALID_TYPE_NUMBER, gsm);
+	validator.readOptional(*signalTypeIt, "horizPol", VALID_TYPE_NUMBER, horizPol);
+	validator.readOptional(*signalTypeIt, "narrow", VALID_TYPE_NUMBER, narrow);
+	validator.readOptional(*signalTypeIt, "unused", VALID_TYPE_NUMBER, unused);
+	validator.prefixErrors(firstError, "signalType");
+
+	band.signalType.gsm = gsm;
+	band.signalType.horizPol = horizPol;
+	band.signalType.narrow = narrow;
+	band.signalType.unused = unused;
+}
 
 // ----------------------------------------------------------------------
 /**
- * @brief Convert JSON object in SOccDFReqData struct
- * 
+ * @brief Validate JSON object and convert it in SOccDFReqData struct in a single pass
+ *
+ * Applies the occupancy and occupancy DF validation rules. The band may be a single object or an array of objects.
+ *
  * @param jsonObj: JSON object containing the parameters
- * @return SOccDFReqData structure populated with values from the JSON object
+ * @param validator: JsonValidator instance to accumulate validation results
+ * @return SOccDFReqData: structure populated with values from the JSON object, or nullptr if the JSON object is invalid
  * @throws NO EXCEPTION HANDLING
 **/
-SOccDFReqData* jsonToSOccDFReqData(nlohmann::json jsonObj) {
-	// Determine number of bands
-	unsigned short numBands;
-	if (jsonObj["band"].is_array()) {
-		numBands = static_cast<unsigned short>(jsonObj["band"].size());
+SOccDFReqData* readSOccDFReqData(const json& jsonObj, JsonValidator& validator) {
+	size_t firstError = validator.errorCount();
+
+	auto bandIt = jsonObj.find("band");
+	if (bandIt == jsonObj.end()) {
+		validator.addError("band", "Field required");
+		return nullptr;
 	}
-	else {
-		numBands = 1;
-		json singleBand = jsonObj["band"];
-		jsonObj["band"] = json::array({ singleBand });
+	bool bandArray = bandIt->is_array();
+	if (!bandArray && !bandIt->is_object()) {
+		validator.addError("band", "Type required: '" + std::string(VALID_TYPE_ARRAY) + "'");
+		return nullptr;
+	}
+	size_t numBands = bandArray ? bandIt->size() : 1;
+	if (numBands < static_cast<size_t>(MIN_NUM_BANDS) || numBands > static_cast<size_t>(MAX_NUM_BANDS)) {
+		validator.addError("band", "Number of bands must be between " + std::to_string(MIN_NUM_BANDS) + " and " + std::to_string(MAX_NUM_BANDS));
+		return nullptr;
 	}
 
 	// Allocate memory for the structure with correct size
 	auto occupDFbodySize = offsetof(SOccDFReqData, band) + numBands * sizeof(SSmsMsg::SGetScanDfCmdV1::SBand);
-	SOccDFReqData* occDFReqMsg = (SOccDFReqData*)malloc(occupDFbodySize);
+	std::unique_ptr<SOccDFReqData, decltype(&free)> occDFReqMsg((SOccDFReqData*)malloc(occupDFbodySize), &free);
 
 	if (occDFReqMsg == nullptr) {
-		loggerPtr->error("Memory allocation failed in jsonToSOccDFReqData. Size: {}", occupDFbodySize);
+		loggerPtr->error("Memory allocation failed in readSOccDFReqData. Size: {}", occupDFbodySize);
+		validator.addError("band", "Memory allocation failed for " + std::to_string(numBands) + " bands");
 		return nullptr;
 	}
 
 	// Initialize the struct
-	memset(occDFReqMsg, 0, occupDFbodySize);
-	occDFReqMsg->numBands = numBands;
+	memset(occDFReqMsg.get(), 0, occupDFbodySize);
+	occDFReqMsg->numBands = static_cast<unsigned short>(numBands);
 
 	// Fill in band data directly in the allocated structure
 	for (size_t i = 0; i < numBands; ++i) {
-		fillBandData(occDFReqMsg->band[i], jsonObj["band"][i]);
-		loggerPtr->trace("Processed band {}", i);
+		size_t firstBandError = validator.errorCount();
+		readBandData(bandArray ? (*bandIt)[i] : *bandIt, occDFReqMsg->band[i], validator);
+		if (validator.errorCount() > firstBandError) {
+			validator.prefixErrors(firstBandError, bandArray ? "band[" + std::to_string(i) + "]" : "band");
+		}
 	}
 
 	// Fill in other fields
-	occDFReqMsg->storageTime = jsonObj["storageTime"].is_null() ? 0 : jsonObj["storageTime"].get<unsigned long>();
-	occDFReqMsg->measurementTime = jsonObj["measurementTime"].is_null() ? 0 : jsonObj["measurementTime"].get<unsigned long>();
-	occDFReqMsg->numAzimuths = jsonObj["numAzimuths"].is_null() ? 0 : jsonObj["numAzimuths"].get<unsigned long>();
-	occDFReqMsg->confidence = jsonObj["confidence"].is_null() ? 0 : jsonObj["confidence"].get<unsigned long>();
-	occDFReqMsg->recordHoldoff = jsonObj["recordHoldoff"].is_null() ? 0 : jsonObj["recordHoldoff"].get<unsigned long>();
-	occDFReqMsg->scanDfThreshold = jsonObj["scanDfThreshold"].is_null() ? 0 : jsonObj["scanDfThreshold"].get<unsigned char>();
-	occDFReqMsg->recordAudioDf = jsonObj["recordAudioDf"].is_null() ? false : jsonObj["recordAudioDf"].get<bool>();
-	// Fill rcvrCtrl
-	occDFReqMsg->rcvrCtrl.agcTime = jsonObj["rcvrCtrl"]["agcTime"].is_null() ? 0 : jsonObj["rcvrCtrl"]["agcTime"].get<unsigned long>();
+	int ant = 0;
+	int numBandsArg = 0;
+	bool recordAudioDf = false;
+	validator.readRange(jsonObj, "ant", MIN_ANT, MAX_ANT, ant);
+	validator.readRange(jsonObj, "numBands", MIN_NUM_BANDS, MAX_NUM_BANDS, numBandsArg);
+	validator.readRange(jsonObj, "storageTime", MIN_STORAGE_TIME, MAX_STORAGE_TIME, occDFReqMsg->storageTime);
+	validator.readRange(jsonObj, "measurementTime", MIN_MEASUREMENT_TIME, MAX_MEASUREMENT_TIME, occDFReqMsg->measurementTime);
+	validator.readRange(jsonObj, "numAzimuths", MIN_AZIMUTHS, MAX_AZIMUTHS, occDFReqMsg->numAzimuths);
+	validator.readRange(jsonObj, "confidence", MIN_DF_CONFIDENCE, MAX_DF_CONFIDENCE, occDFReqMsg->confidence);
+	validator.readRange(jsonObj, "recordHoldoff", MIN_RECORD_HOLDOFF, MAX_RECORD_HOLDOFF, occDFReqMsg->recordHoldoff);
+	validator.readRange(jsonObj, "scanDfThreshold", MIN_SCAN_DF_THRESHOLD, MAX_SCAN_DF_THRESHOLD, occDFReqMsg->scanDfThreshold);
+	validator.readType(jsonObj, "recordAudioDf", VALID_TYPE_BOOLEAN, recordAudioDf);
+	occDFReqMsg->recordAudioDf = recordAudioDf;
 
-	if (jsonObj["rcvrCtrl"]["bandwidth"].is_null() == false) {
-		occDFReqMsg->rcvrCtrl.bandwidth = Units::Frequency(jsonObj["rcvrCtrl"]["bandwidth"].get<unsigned long>()).GetRaw();
+	// Fill rcvrCtrl
+	auto rcvrIt = jsonObj.find("rcvrCtrl");
+	if (rcvrIt == jsonObj.end()) {
+		validator.addError("rcvrCtrl", "Field required");
 	}
-	if (jsonObj["rcvrCtrl"]["bfo"].is_null() == false) {
-		occDFReqMsg->rcvrCtrl.bfo = Units::Frequency(jsonObj["rcvrCtrl"]["bfo"].get<unsigned long>()).GetRaw();
+	else if (!rcvrIt->is_object()) {
+		validator.addError("rcvrCtrl", "Type required: '" + std::string(VALID_TYPE_OBJECT) + "'");
 	}
-	occDFReqMsg->rcvrCtrl.detMode = jsonObj["rcvrCtrl"]["detMode"].is_null() ? (SSmsMsg::SRcvrCtrlCmdV1::EDetMode)0 : jsonObj["rcvrCtrl"]["detMode"].get<SSmsMsg::SRcvrCtrlCmdV1::EDetMode>();
-	if (jsonObj["rcvrCtrl"]["freq"].is_null() == false) {
-		occDFReqMsg->rcvrCtrl.freq = Units::Frequency(jsonObj["rcvrCtrl"]["freq"].get<unsigned long>()).GetRaw();
+	else {
+		size_t firstRcvrError = validator.errorCount();
+		unsigned long freq = 0;
+		unsigned long bandwidth = 0;
+		unsigned long bfo = 0;
+		if (validator.readRange(*rcvrIt, "freq", MIN_FREQ, MAX_FREQ, freq)) {
+			occDFReqMsg->rcvrCtrl.freq = Units::Frequency(freq).GetRaw();
+		}
+		if (validator.readRange(*rcvrIt, "bandwidth", MIN_BANDWIDTH, MAX_BANDWIDTH, bandwidth)) {
+			occDFReqMsg->rcvrCtrl.bandwidth = Units::Frequency(bandwidth).GetRaw();
+		}
+		if (validator.readRange(*rcvrIt, "bfo", MIN_BFO, MAX_BFO, bfo)) {
+			occDFReqMsg->rcvrCtrl.bfo = Units::Frequency(bfo).GetRaw();
+		}
+		validator.readRange(*rcvrIt, "detMode", MIN_DET_MODE, MAX_DET_MODE, occDFReqMsg->rcvrCtrl.detMode);
+		validator.readRange(*rcvrIt, "agcTime", MIN_AGC_TIME, MAX_AGC_TIME, occDFReqMsg->rcvrCtrl.agcTime);
+		validator.prefixErrors(firstRcvrError, "rcvrCtrl");
 	}
 
-	return occDFReqMsg;
+	if (validator.errorCount() > firstError) {
+		return nullptr;
+	}
+	return occDFReqMsg.release();
 }
 
 // ----------------------------------------------------------------------
 /**
-* @brief Convert JSON object in SAVDReqData struct
-* 
-* @param jsonObj: JSON object containing the parameters
-* @return SAVDReqData structure populated with values from the JSON object
-* @throws NO EXCEPTION HANDLING
-*/
-SAVDReqData* jsonToSAVDReqData(nlohmann::json jsonObj) {
-	SAVDReqData structSO{};
-	
-	structSO.ant = jsonObj["ant"].is_null() == true ? (SEquipCtrlMsg::EAnt)NULL : jsonObj["ant"].get<SEquipCtrlMsg::EAnt>();
-	structSO.avdThreshold = jsonObj["avdThreshold"].is_null() == true ? NULL : jsonObj["avdThreshold"].get<unsigned char>();
+* @brief Context of a command handler, called by DLLFunctionCall
+**/
+struct CommandCall {
+	DLLConnectionData connection;
+	const json& request;
+	const json& arguments;
+	DLLRequestData& data;
+	const RequestEntry& entry;
+	unsigned long* requestID;	// Request ID returned by the DLL. Holds the queue ID on input, used as task ID by task control commands
+};
 
-	SSmsMsg::SBandV4 band{};
+// ----------------------------------------------------------------------
+/**
+* @brief Definition of a command handled by the DLL specific modules
+*
+* Single table used by the receive thread to accept the command code, by readRequest to validate the arguments
+* and by DLLFunctionCall to call the DLL and release the admission control slot.
+* Commands with a read function are validated while converted into DLLRequestData, in a single pass.
+* Other commands are validated by their schema, if any, and converted by their call function.
+**/
+struct CommandSpec {
+	unsigned long code;
+	int completion;													// CommandCompletion event of the command
+	const ValidationSchema* schema;									// Validation of the arguments, nullptr if not validated
+	bool (*read)(const json& arguments, DLLRequestData& data, JsonValidator& validator);	// Single pass conversion, nullptr if not used
+	ERetCode (*call)(CommandCall& call);
+};
 
-	if (jsonObj["band"]["channelBandwidth"].is_null() == false) {
-		band.channelBandwidth = Units::Frequency(jsonObj["band"]["channelBandwidth"].get<unsigned long>()).GetRaw();
+// ----------------------------------------------------------------------
+/**
+* @brief Answer the client with an error if a service command handler failed
+*
+* @param call: Context of the command
+* @param message: Error message returned by the handler, empty on success
+* @return ERetCode: API_SUCCESS, since the command was handled by the service
+* @throws NO EXCEPTION HANDLING
+**/
+ERetCode answerServiceCommand(const CommandCall& call, const std::string& message)
+{
+	if (!message.empty()) {
+		loggerPtr->warn(message);
+		response.push(buildErrorResponse(call.request, message), "DLLFunctionCall");
 	}
+	return ERetCode::API_SUCCESS;
+}
 
-	band.exclude = jsonObj["band"]["exclude"].is_null() == true ? NULL : jsonObj["band"]["exclude"].get<bool>();
-
-	if (jsonObj["band"]["highFrequency"].is_null() == false) {
-		band.highFrequency = Units::Frequency(jsonObj["band"]["highFrequency"].get<unsigned long>()).GetRaw();
-	}
+const CommandSpec COMMANDS[] = {
+	{ ECSMSDllMsgType::GET_OCCUPANCY, CommandCompletion::DLL_RESPONSE, nullptr,
+		[](const json& arguments, DLLRequestData& data, JsonValidator& validator) -> bool {
+			data.occReqMsg.reset(readSOccupReqData(arguments, validator));
+			return data.occReqMsg != nullptr;
+		},
+		[](CommandCall& call) -> ERetCode {
+			ERetCode errCode = RequestOccupancy(call.connection, call.data.occReqMsg.get(), call.requestID);
+			call.data.occReqMsg.release();
+			return errCode;
+		} },
+	{ ECSMSDllMsgType::GET_OCCUPANCYDF, CommandCompletion::DLL_RESPONSE, nullptr,
+		[](const json& arguments, DLLRequestData& data, JsonValidator& validator) -> bool {
+			data.occDFReqMsg.reset(readSOccDFReqData(arguments, validator));
+			return data.occDFReqMsg != nullptr;
+		},
+		[](CommandCall& call) -> ERetCode {
+			// request realtime data for output, owned by the request from the first realtime callback
+			requestRegistry.setRealTimeOwner(call.entry);
+			ERetCode errCode = RequestRealTime(call.connection, true, call.requestID);
+
+			// Converted by readRequest. Released on exception, kept once submitted, as done by the other converters
+			errCode = RequestOccupancyDF(call.connection, call.data.occDFReqMsg.get(), call.requestID);
+			call.data.occDFReqMsg.release();
+			return errCode;
+		} },
+	{ ECSMSDllMsgType::GET_AVD, CommandCompletion::DLL_RESPONSE, nullptr,
+		[](const json& arguments, DLLRequestData& data, JsonValidator& validator) -> bool {
+			data.avdReqMsg.reset(readSAVDReqData(arguments, validator));
+			return data.avdReqMsg != nullptr;
+		},
+		[](CommandCall& call) -> ERetCode {
+			ERetCode errCode = RequestAVD(call.connection, call.data.avdReqMsg.get(), call.requestID);
+			call.data.avdReqMsg.release();
+			return errCode;
+		} },
+	{ ECSMSDllMsgType::GET_MEAS, CommandCompletion::DLL_RESPONSE, nullptr,
+		[](const json& arguments, DLLRequestData& data, JsonValidator& validator) -> bool {
+			data.measReqMsg.reset(readSMeasReqData(arguments, validator));
+			return data.measReqMsg != nullptr;
+		},
+		[](CommandCall& call) -> ERetCode {
+			ERetCode errCode = RequestMeasurement(call.connection, call.data.measReqMsg.get(), call.requestID);
+			call.data.measReqMsg.release();
+			return errCode;
+		} },
+	{ ECSMSDllMsgType::GET_TASK_STATUS, CommandCompletion::DLL_RETURN, nullptr, nullptr,
+		[](CommandCall& call) -> ERetCode {
+			return RequestTaskStatus(call.connection, *call.requestID);
+		} },
+	{ ECSMSDllMsgType::GET_TASK_STATE, CommandCompletion::DLL_RETURN, nullptr, nullptr,
+		[](CommandCall& call) -> ERetCode {
+			return RequestTaskState(call.connection, (ECSMSDllMsgType)call.arguments, *call.requestID);
+		} },
+	{ ECSMSDllMsgType::TASK_SUSPEND, CommandCompletion::DLL_RETURN, nullptr, nullptr,
+		[](CommandCall& call) -> ERetCode {
+			return SuspendTask(call.connection, (ECSMSDllMsgType)call.arguments, *call.requestID);
+		} },
+	{ ECSMSDllMsgType::TASK_RESUME, CommandCompletion::DLL_RETURN, nullptr, nullptr,
+		[](CommandCall& call) -> ERetCode {
+			return ResumeTask(call.connection, (ECSMSDllMsgType)call.arguments, *call.requestID);
+		} },
+	{ ECSMSDllMsgType::TASK_TERMINATE, CommandCompletion::DLL_RETURN, nullptr, nullptr,
+		[](CommandCall& call) -> ERetCode {
+			return TerminateTask(call.connection, *call.requestID);
+		} },
+	{ ECSMSDllMsgType::GET_BIST, CommandCompletion::DLL_RESPONSE, nullptr, nullptr,
+		[](CommandCall& call) -> ERetCode {
+			return RequestBist(call.connection, (EBistScope)call.arguments, call.requestID);
+		} },
+	{ ECSMSDllMsgType::SET_AUDIO_PARAMS, CommandCompletion::DLL_RESPONSE, nullptr,
+		[](const json& arguments, DLLRequestData& data, JsonValidator& validator) -> bool {
+			return readSAudioParams(arguments, data.audioParams, validator);
+		},
+		[](CommandCall& call) -> ERetCode {
+			return SetAudio(call.connection, call.data.audioParams, call.requestID);
+		} },
+	{ ECSMSDllMsgType::FREE_AUDIO_CHANNEL, CommandCompletion::DLL_RESPONSE, nullptr, nullptr,
+		[](CommandCall& call) -> ERetCode {
+			ERetCode errCode = FreeAudio(call.connection, call.arguments, call.requestID);
+			loggerPtr->info("Finished audio capture.");
+			return errCode;
+		} },
+	{ ECSMSDllMsgType::SET_PAN_PARAMS, CommandCompletion::DLL_RESPONSE, nullptr,
+		[](const json& arguments, DLLRequestData& data, JsonValidator& validator) -> bool {
+			return readSPanParams(arguments, data.setPanParams, validator);
+		},
+		[](CommandCall& call) -> ERetCode {
+			return SetPanParams(call.connection, call.data.setPanParams, call.requestID);
+		} },
+	{ ECSMSDllMsgType::GET_PAN, CommandCompletion::DLL_RESPONSE, nullptr,
+		[](const json& arguments, DLLRequestData& data, JsonValidator& validator) -> bool {
+			bool valid = readSGetPanParams(arguments, data.panParams, validator);
+			return readSpectrumOutput(arguments, data, validator) && valid;
+		},
+		[](CommandCall& call) -> ERetCode {
+			return RequestPan(call.connection, call.data.panParams, call.requestID);
+		} },
+	{ StreamMsgType::STREAM_PAN_START, CommandCompletion::DLL_RESPONSE, nullptr,
+		[](const json& arguments, DLLRequestData& data, JsonValidator& validator) -> bool {
+			bool valid = readSGetPanParams(arguments, data.panParams, validator);
+			if (validator.readOptional(arguments, "rateHz", VALID_TYPE_NUMBER, data.rateHz) &&
+				(data.rateHz < MIN_STREAM_RATE_HZ || data.rateHz > MAX_STREAM_RATE_HZ)) {
+				validator.addError("rateHz", "Number must be between " + std::to_string(MIN_STREAM_RATE_HZ) + " and " + std::to_string(MAX_STREAM_RATE_HZ));
+				valid = false;
+			}
+			return readSpectrumOutput(arguments, data, validator) && valid;
+		},
+		[](CommandCall& call) -> ERetCode {
+			return panStreamer.start(call.connection, call.request, call.data.panParams, call.data.rateHz, call.data.output, call.requestID);
+		} },
+	{ StreamMsgType::STREAM_PAN_STOP, CommandCompletion::SERVICE, nullptr, nullptr,
+		[](CommandCall& call) -> ERetCode {
+			if (!panStreamer.stop(call.entry.sessionId, "Pan stream stopped by client")) {
+				loggerPtr->warn("No active pan stream owned by the client to be stopped");
+			}
+			return ERetCode::API_SUCCESS;
+		} },
+	{ StreamMsgType::BAND_SNAPSHOT, CommandCompletion::SERVICE, nullptr, nullptr,
+		[](CommandCall& call) -> ERetCode {
+			return answerServiceCommand(call, channelMap.snapshot(call.request) == 0 ? "No occupancy band owned by the client" : "");
+		} },
+	{ StreamMsgType::SWEEP_QUERY, CommandCompletion::SERVICE, &SWEEP_QUERY_SCHEMA, nullptr,
+		[](CommandCall& call) -> ERetCode {
+			return answerServiceCommand(call, sweepQueries.submit(call.request));
+		} },
+	{ StreamMsgType::TRACE_SUBSCRIBE, CommandCompletion::SERVICE, &TRACE_SUBSCRIBE_SCHEMA, nullptr,
+		[](CommandCall& call) -> ERetCode {
+			return answerServiceCommand(call, panTraces.subscribe(call.request));
+		} },
+	{ StreamMsgType::TRACE_UNSUBSCRIBE, CommandCompletion::SERVICE, nullptr, nullptr,
+		[](CommandCall& call) -> ERetCode {
+			if (!panTraces.unsubscribe(call.entry.sessionId)) {
+				loggerPtr->warn("No pan trace subscription owned by the client to be removed");
+			}
+			return ERetCode::API_SUCCESS;
+		} },
+	{ StreamMsgType::TRACE_RESET, CommandCompletion::SERVICE, &TRACE_RESET_SCHEMA, nullptr,
+		[](CommandCall& call) -> ERetCode {
+			return answerServiceCommand(call, panTraces.reset(call.request));
+		} },
+	{ StreamMsgType::WATERFALL, CommandCompletion::SERVICE, &WATERFALL_SCHEMA, nullptr,
+		[](CommandCall& call) -> ERetCode {
+			return answerServiceCommand(call, waterfalls.submit(call.request));
+		} }
+};
 
-	if (jsonObj["band"]["lowFrequency"].is_null() == false) {
-		band.lowFrequency = Units::Frequency(jsonObj["band"]["lowFrequency"].get<unsigned long>()).GetRaw();
+// ----------------------------------------------------------------------
+/**
+* @brief Find the definition of a command in the command table
+*
+* @param code: Command code received from the client
+* @return const CommandSpec*: Definition of the command, nullptr if the command is not handled
+* @throws NO EXCEPTION HANDLING
+**/
+const CommandSpec* findCommand(long long code)
+{
+	for (const CommandSpec& command : COMMANDS) {
+		if (static_cast<long long>(command.code) == code) {
+			return &command;
+		}
 	}
+	return nullptr;
+}
 
-	band.sType.signalType.horizPol = jsonObj["band"]["sType"]["signalType"]["horizPol"].is_null() == true ? NULL : jsonObj["band"]["sType"]["signalType"]["horizPol"].get<unsigned long>();
-	band.sType.signalType.narrow = jsonObj["band"]["sType"]["signalType"]["narrow"].is_null() == true ? NULL : jsonObj["band"]["sType"]["signalType"]["narrow"].get<unsigned long>();
-	band.sType.signalType.unused0 = jsonObj["band"]["sType"]["signalType"]["unused0"].is_null() == true ? NULL : jsonObj["band"]["sType"]["signalType"]["unused0"].get<unsigned long>();
-	band.sType.signalType.unused1 = jsonObj["band"]["sType"]["signalType"]["unused1"].is_null() == true ? NULL : jsonObj["band"]["sType"]["signalType"]["unused1"].get<unsigned long>();
+// ----------------------------------------------------------------------
+/** @brief Test if a command code is handled by the request processing
+ *
+ * Called by the receive thread to reject unknown commands before the request is parsed and enqueued.
+ *
+ * @param code: Command code received from the client
+ * @return bool: True if the command code is handled, false otherwise
+ * @throws NO EXCEPTION HANDLING
+**/
+bool isKnownCommandCode(long long code)
+{
+	return findCommand(code) != nullptr;
+}
 
-	structSO.band[0] = band;
+// ----------------------------------------------------------------------
+/**
+* @brief Validate the request and, for the commands that support it, convert its arguments in the same pass
+*
+* Commands with a read function in the command table are validated while converted into DLLRequestData, reading the request by reference.
+* Other commands are validated by validRequest with the schema of the command table, if any, and read their arguments in their call function.
+* Invalid requests are answered with the same error response used by validRequest.
+*
+* @param request: JSON object containing the request
+* @param msgType: Message type to be validated (see ECSMSDllMsgType enum)
+* @param data: Structure to be filled with the converted arguments
+* @param response: Thread-safe message queue containing messages to be sent to the client
+* @return bool: True if the request is valid, false otherwise
+* @throws NO EXCEPTION HANDLING
+**/
+bool readRequest(const json& request, unsigned long msgType, DLLRequestData& data, MessageQueue& response)
+{
+	const CommandSpec* command = findCommand(msgType);
+	if (command == nullptr) {
+		loggerPtr->error("Unknown message type for validation: " + std::to_string(msgType));
+		return false;
+	}
+	if (command->read == nullptr) {
+		return validRequest(request, command->schema, response);
+	}
 
-	structSO.measurementRate = jsonObj["measurementRate"].is_null() == true ? (SEquipCtrlMsg::EAvdRate)NULL : jsonObj["measurementRate"].get<SEquipCtrlMsg::EAvdRate>();
-	structSO.measurementTime = jsonObj["measurementTime"].is_null() == true ? NULL : jsonObj["measurementTime"].get<unsigned long>();
-	structSO.numBands = jsonObj["numBands"].is_null() == true ? NULL : jsonObj["numBands"].get<unsigned short>();
-	structSO.storageTime = jsonObj["storageTime"].is_null() == true ? NULL : jsonObj["storageTime"].get<unsigned long>();
+	JsonValidator validator;
+	REQUEST_SCHEMA.validate(request, validator);
 
-	auto avdbodySize = offsetof(SAVDReqData, band) + structSO.numBands * sizeof(SEquipCtrlMsg::SBandV4);
-	SAVDReqData* avdReqMsg;
-	avdReqMsg = (SAVDReqData*)malloc(avdbodySize);
-	memcpy(avdReqMsg, &structSO, avdbodySize);
+	auto argsIt = request.find(TaskKeys::Arguments::VALUE);
+	if (argsIt != request.end() && argsIt->is_object()) {
+		command->read(*argsIt, data, validator);
+	}
 
-	return avdReqMsg;
+	return validationResult(request, validator, response);
 }
 
 // ----------------------------------------------------------------------
 /**
  * @brief Call the appropriate DLL function based on the request in JSON format
  *
- * Include the identification of the funciton based on request type
- * conversion from JSON to the appropriate struct for each function call.
+ * The function of each command is taken from the command table, which also gives the event that completes the command.
+ * Calls are reserved in the request registry before the DLL is called and committed once it returns the request ID,
+ * so DLL callbacks can be routed to the client session even if they arrive before the call returns.
  * 
  * @param DLLConnID: Connection ID obtained from the DLL during initialization
  * @param request: JSON object containing the parameters
  * @param msgType: Message type to be validated (see ECSMSDllMsgType enum)
- * @return void
+ * @return ERetCode: Code returned by the DLL function
  * @throws NO EXCEPTION HANDLING
 **/
-void DLLFunctionCall(DLLConnectionData DLLConnID, json request, unsigned long msgType)
+ERetCode DLLFunctionCall(DLLConnectionData DLLConnID, const json& request, unsigned long msgType, DLLRequestData& data)
 {
 	ERetCode errCode = ERetCode::API_SUCCESS;
 
-	loggerPtr->debug("Processing request: " + request.dump());
+	if (loggerPtr->should_log(spdlog::level::debug)) {
+		loggerPtr->debug("Processing request: " + request.dump());
+	}
 	
 	unsigned long requestID = request.value(TaskKeys::QueueId::VALUE, TaskKeys::QueueId::INIT_VALUE);
 
-	json reqArguments = request.value(TaskKeys::Arguments::VALUE, json::object());
+	static const json noArguments = json::object();
+	auto argsIt = request.find(TaskKeys::Arguments::VALUE);
+	const json& reqArguments = argsIt != request.end() ? *argsIt : noArguments;
 
-	switch (msgType) {
-		case ECSMSDllMsgType::GET_OCCUPANCY:
-		{
-			SOccupReqData* occupDFReqMsg = jsonToSOccupReqData(reqArguments);
-			errCode = RequestOccupancy(DLLConnID, occupDFReqMsg, &requestID);
-			break;
-		}
-		case ECSMSDllMsgType::GET_OCCUPANCYDF:
-		{
-			// request realtime data for output
-			errCode = RequestRealTime(DLLConnID, true, &requestID);
-
-			SOccDFReqData* occDFReqMsg = jsonToSOccDFReqData(reqArguments);
-			if (occDFReqMsg == nullptr) {
-				errCode = ERetCode::MEMORY_ALLOC_ERROR;
-				break;
-			}
-			try
-			{
-				errCode = RequestOccupancyDF(DLLConnID, occDFReqMsg, &requestID);
-			}
-			catch (const std::exception&)
-			{
-				free(occDFReqMsg);
-				throw;
+	json trace = request.value(edll::TRACE_KEY, json::array());
+	long long recvNs = edll::traceAt(trace, edll::RequestTrace::RECV);
+	std::string reqName = request.value(TaskKeys::CommandName::VALUE, TaskKeys::CommandName::INIT_VALUE);
 
-			}
-			break;
-		}
-		case ECSMSDllMsgType::GET_AVD:
-		{
-			SAVDReqData* avdReqMsg = jsonToSAVDReqData(reqArguments);
-			errCode = RequestAVD(DLLConnID, avdReqMsg, &requestID);
-			break;
-		}
-		case ECSMSDllMsgType::GET_MEAS:
-		{
-			SMeasReqData* m_measureReqMsg = jsonToSMeasReqData(reqArguments);
-			errCode = RequestMeasurement(DLLConnID, m_measureReqMsg, &requestID);
-			break;
-		}
-		case ECSMSDllMsgType::GET_TASK_STATUS:
-		{
-			errCode = RequestTaskStatus(DLLConnID, requestID);
-			break;
-		}
-		case ECSMSDllMsgType::GET_TASK_STATE:
-		{
-			errCode = RequestTaskState(DLLConnID, (ECSMSDllMsgType)reqArguments, requestID);
-			break;
-		}
-		case ECSMSDllMsgType::TASK_SUSPEND:
-		{
-			errCode = SuspendTask(DLLConnID, (ECSMSDllMsgType)reqArguments, requestID);
-			break;
-		}
-		case ECSMSDllMsgType::TASK_RESUME:
-		{
-			errCode = ResumeTask(DLLConnID, (ECSMSDllMsgType)reqArguments, requestID);
-			break;
-		}
-		case ECSMSDllMsgType::TASK_TERMINATE:
-		{
-			errCode = TerminateTask(DLLConnID, requestID);
-			break;
-		}
-		case ECSMSDllMsgType::GET_BIST:
-		{
-			errCode = RequestBist(DLLConnID, (EBistScope)reqArguments, &requestID);
-			break;
-		}
-		case ECSMSDllMsgType::SET_AUDIO_PARAMS:
-		{
-			SAudioParams audioParams = jsonToSAudioParams(reqArguments);
-			errCode = SetAudio(DLLConnID, audioParams, &requestID);
-
-			/* Todo: Start audio streaming service and send link to client
-			if (errCode == ERetCode::API_SUCCESS) {
-				DWORD processId = wcstoul(L"123", nullptr, 0);
-				HRESULT hr = loopbackCapture.StartCaptureAsync(processId, false, L"audio");
-				if (FAILED(hr))
-				{
-					logger_ptr->error("Failed to start audio capture");
-				}
-				else {
-					logger_ptr->info("Capturing audio.");
-				}
-			}
-			*/
-			break;
-		}
-		case ECSMSDllMsgType::FREE_AUDIO_CHANNEL:
-		{
-			errCode = FreeAudio(DLLConnID, reqArguments, &requestID);
-			loggerPtr->info("Finished audio capture.");
-			break;
-		}
-		case ECSMSDllMsgType::SET_PAN_PARAMS:
-		{
-			SPanParams panParams = jsonToSPanParams(reqArguments);
-			errCode = SetPanParams(DLLConnID, panParams, &requestID);
-			break;
-		}
-		case ECSMSDllMsgType::GET_PAN:
-		{
-			SGetPanParams panParamsGet = jsonToSGetPanParams(reqArguments);
-			errCode = RequestPan(DLLConnID, panParamsGet, &requestID);
-			break;
-		}
-		default:
-		{
-			loggerPtr->error("Unknown message type");
-			errCode = ERetCode::CMD_SENT_ERROR;
-			break;
-		}
+	RequestEntry entry;
+	entry.sessionId = request.value(TaskKeys::SessionId::VALUE, TaskKeys::SessionId::INIT_VALUE);
+	entry.clientId = request.value(clientIdKey, json(TaskKeys::ClientId::INIT_VALUE));
+	entry.commandCode = msgType;
+	entry.commandName = reqName;
+	entry.recvTraceNs = recvNs;
+	entry.output = data.output;
+
+	// Reserved before the call, since the DLL may answer before returning the request ID
+	requestRegistry.reserve();
+
+	const CommandSpec* command = findCommand(msgType);
+	if (command != nullptr) {
+		CommandCall call{ DLLConnID, request, reqArguments, data, entry, &requestID };
+		errCode = command->call(call);
+	}
+	else {
+		loggerPtr->error("Unknown message type");
+		errCode = ERetCode::CMD_SENT_ERROR;
 	}
 
-	std::string reqName = request.value(TaskKeys::CommandName::VALUE, TaskKeys::CommandName::INIT_VALUE);
+	long long dllReturnNs = edll::traceNow();
+	latencyTracer.record(msgType, edll::Stage::DLL_CALL, edll::traceAt(trace, edll::RequestTrace::DEQUEUE), dllReturnNs);
+	latencyTracer.record(msgType, edll::Stage::REQUEST_TOTAL, recvNs, dllReturnNs);
+
 	if (errCode != ERetCode::API_SUCCESS)
 	{
+		requestRegistry.rollback();
+		serviceMetrics.countDLLError(errCode);
+		admissionControl.release(request.value(TaskKeys::SessionId::VALUE, TaskKeys::SessionId::INIT_VALUE), msgType);
 		loggerPtr->error("[" + reqName + "] ERROR. " + ERetCodeToString(errCode));
 	}
+	else if (command->completion == CommandCompletion::SERVICE)
+	{
+		// Answered by the service, no DLL response is expected
+		requestRegistry.rollback();
+		admissionControl.release(entry.sessionId, msgType);
+	}
+	else if (command->completion == CommandCompletion::DLL_RETURN)
+	{
+		// Replies carry the ID of the addressed task, not a new request ID
+		requestRegistry.rollback();
+		admissionControl.release(entry.sessionId, msgType);
+		loggerPtr->info("[" + reqName + "] command executed");
+	}
 	else
 	{
+		requestRegistry.commit(requestID, entry);
+
 		loggerPtr->info("[" + reqName + "] command executed");
-		loggerPtr->debug("Request ID " + std::to_string(requestID) + ": " + reqArguments.dump() + "");
+		if (loggerPtr->should_log(spdlog::level::debug)) {
+			loggerPtr->debug("Request ID " + std::to_string(requestID) + ": " + reqArguments.dump() + "");
+		}
+	}
+	return errCode;
+}
+
+
+// ----------------------------------------------------------------------
+/** @brief Test if the request deadline has passed and, if so, answer the client with a timeout error
+ *
+ * Expired requests are counted by command code and release their admission control slot.
+ *
+ * @param request: Request popped from the request queue
+ * @param cmd: Command code of the request
+ * @param response: Thread-safe message queue containing messages to be sent to the client
+ * @return bool: True if the request expired and must not be submitted to the DLL, false otherwise
+ * @throws NO EXCEPTION HANDLING
+**/
+bool expiredRequest(const json& request, unsigned long cmd, MessageQueue& response)
+{
+	const std::string funcName = "expiredRequest";
+
+	long long lateMs = 0;
+	if (!DeadlinePolicy::expired(request, edll::traceNow(), lateMs)) {
+		return false;
+	}
+
+	std::string message = "Request timeout. Deadline expired " + std::to_string(lateMs) + " ms before submission to the station";
+	loggerPtr->warn("[" + request.value(TaskKeys::CommandName::VALUE, TaskKeys::CommandName::INIT_VALUE) + "] " + message);
+	response.push(buildErrorResponse(request, message), funcName);
+
+	serviceMetrics.count(ServiceMetrics::CodeCounter::DEADLINE_EXPIRED, cmd);
+	admissionControl.release(request.value(TaskKeys::SessionId::VALUE, TaskKeys::SessionId::INIT_VALUE), cmd);
+	return true;
+}
+
+
+// ----------------------------------------------------------------------
+/** @brief Answer a single command popped from the request queue, on its own or as part of a batch
+ *
+ * Service commands are answered directly. Other commands have their deadline tested before validation
+ * and before the DLL call. Invalid commands are answered by the validation and release their admission control slot.
+ *
+ * @param DLLConnID: Connection ID obtained from the DLL during initialization
+ * @param request: Command popped from the request queue
+ * @param cmd: Command code of the request
+ * @param response: Thread-safe message queue containing messages to be sent to the client
+ * @return std::string: Result of the command, reported in the batch results
+ * @throws NO EXCEPTION HANDLING
+**/
+std::string dispatchRequest(DLLConnectionData DLLConnID, const json& request, unsigned long cmd, MessageQueue& response)
+{
+	const std::string funcName = "dispatchRequest";
+
+	unsigned long sessionId = request.value(TaskKeys::SessionId::VALUE, TaskKeys::SessionId::INIT_VALUE);
+
+	json reply;
+	if (buildServiceReply(cmd, sessionId, reply)) {
+		reply[clientIdKey] = request.value(clientIdKey, json(TaskKeys::ClientId::INIT_VALUE));
+		response.push(reply, funcName);
+		admissionControl.release(sessionId, cmd);
+		return "Answered by the service";
+	}
+
+	if (expiredRequest(request, cmd, response)) {
+		return "Request timeout";
+	}
+
+	DLLRequestData data;
+	if (!readRequest(request, cmd, data, response)) {
+		serviceMetrics.count(ServiceMetrics::CodeCounter::VALIDATION_FAIL, cmd);
+		admissionControl.release(sessionId, cmd);
+		return "Request validation failed";
+	}
+
+	// Test the deadline again right before the DLL call
+	if (expiredRequest(request, cmd, response)) {
+		return "Request timeout";
+	}
+
+	return ERetCodeToString(DLLFunctionCall(DLLConnID, request, cmd, data));
+}
+
+
+// ----------------------------------------------------------------------
+/** @brief Execute the commands of a batch in order and optionally report the result of each one
+ *
+ * Commands inherit the session, source and trace of the batch and are answered by dispatchRequest, as single requests.
+ * Invalid commands do not stop the batch.
+ * If the batch requests results, a single response lists the ID, code, command and result message for each command.
+ *
+ * @param DLLConnID: Connection ID obtained from the DLL during initialization
+ * @param batch: Batch popped from the request queue
+ * @param response: Thread-safe message queue containing messages to be sent to the client
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void processBatch(DLLConnectionData DLLConnID, json& batch, MessageQueue& response)
+{
+	const std::string funcName = "processBatch";
+
+	auto resultsIt = batch.find(TaskKeys::Results::VALUE);
+	bool reportResults = resultsIt != batch.end() && resultsIt->is_boolean() ? resultsIt->get<bool>() : TaskKeys::Results::INIT_VALUE;
+	json results = json::array();
+
+	for (json& item : batch[TaskKeys::Batch::VALUE]) {
+		item[TaskKeys::SessionId::VALUE] = batch[TaskKeys::SessionId::VALUE];
+		item[TaskKeys::ClientIp::VALUE] = batch[TaskKeys::ClientIp::VALUE];
+		if (batch.contains(edll::TRACE_KEY)) {
+			item[edll::TRACE_KEY] = batch[edll::TRACE_KEY];
+		}
+
+		unsigned long cmd = static_cast<unsigned long>(edll::commandCodeOf(item));
+		std::string resultMsg = dispatchRequest(DLLConnID, item, cmd, response);
+
+		if (reportResults) {
+			json result;
+			result[clientIdKey] = item[clientIdKey];
+			result[TaskKeys::CommandCode::VALUE] = item.value(TaskKeys::CommandCode::VALUE, json(TaskKeys::CommandCode::INIT_VALUE));
+			result[TaskKeys::CommandName::VALUE] = item.value(TaskKeys::CommandName::VALUE, json(TaskKeys::CommandName::INIT_VALUE));
+			result[TaskKeys::Message::VALUE] = resultMsg;
+			results.push_back(std::move(result));
+		}
+	}
+
+	loggerPtr->info(funcName + " executed batch " + batch[clientIdKey].dump() + " with " + std::to_string(batch[TaskKeys::Batch::VALUE].size()) + " commands");
+
+	if (reportResults) {
+		json batchResponse;
+		batchResponse[TaskKeys::CommandCode::VALUE] = edll::BatchCode::VALUE;
+		batchResponse[TaskKeys::CommandName::VALUE] = edll::BatchCode::NAME;
+		batchResponse[TaskKeys::Arguments::VALUE] = json::object();
+		batchResponse[TaskKeys::SessionId::VALUE] = batch[TaskKeys::SessionId::VALUE];
+		batchResponse[clientIdKey] = batch[clientIdKey];
+		batchResponse[TaskKeys::Results::VALUE] = std::move(results);
+		response.push(batchResponse, funcName);
 	}
 }
 
@@ -616,10 +1273,18 @@ void processRequestQueue(DLLConnectionData DLLConnID, MessageQueue& request, Mes
 
 		unsigned long cmd = oneRequest.value(TaskKeys::CommandCode::VALUE, TaskKeys::CommandCode::INIT_VALUE);
 
-		if (!validRequest(oneRequest, cmd, response)) {
+		auto traceIt = oneRequest.find(edll::TRACE_KEY);
+		if (traceIt != oneRequest.end() && traceIt->is_array()) {
+			long long dequeueNs = edll::traceNow();
+			latencyTracer.record(cmd, edll::Stage::REQUEST_QUEUE, edll::traceAt(*traceIt, edll::RequestTrace::ENQUEUE), dequeueNs);
+			traceIt->push_back(dequeueNs);
+		}
+
+		if (oneRequest.contains(TaskKeys::Batch::VALUE)) {
+			processBatch(DLLConnID, oneRequest, response);
 			continue;
 		}
 
-		DLLFunctionCall(DLLConnID, oneRequest, cmd);
+		dispatchRequest(DLLConnID, oneRequest, cmd, response);
 	}
 }
@@ -4,6 +4,7 @@
 * @brief Header file for functions that convert Scorpio DLL responses to JSON
 * * Define function prototypes for callback functions used by the Scorpio API
 * * Define function prototypes for converting DLL data structures to JSON
+* * High rate responses are written as JSON text using edll::JsonWriter, without building a JSON document
 *
 * * @author fslobao
 * * @date 2025-09-17
@@ -28,12 +29,25 @@
 // Include DLL specific libraries
 #include "etherDLLDataProcess.hpp"
 #include "etherDLLCodes.hpp"
+#include "etherDLLSerializers.hpp"
+#include "etherDLLChannelMap.hpp"
+#include "etherDLLRecorder.hpp"
+#include "etherDLLSweepStore.hpp"
+#include "etherDLLCapture.hpp"
+#include "etherDLLPanTrace.hpp"
+#include "etherDLLWaterfall.hpp"
+#include "etherDLLIqBlock.hpp"
+#include "etherDLLSpectrumLevels.hpp"
 
 // Include core EtherDLL libraries
 #include "EtherDLLConfig.hpp"
 #include "EtherDLLUtils.hpp"
 #include "EtherDLLClient.hpp"
 #include "EtherDLLLog.hpp"
+#include "EtherDLLTrace.hpp"
+#include "EtherDLLMetrics.hpp"
+#include "EtherDLLAdmission.hpp"
+#include "EtherDLLWriter.hpp"
 
 // Include project libraries
 #include <nlohmann/json.hpp>
@@ -44,55 +58,35 @@
 #include <algorithm>
 #include <vector>
 #include <cstdint>
+#include <chrono>
 #include <limits>
 #include <locale>
 #include <codecvt>
+#include <type_traits>
+#include <mutex>
+#include <unordered_map>
+#include <cstddef>
 
 // For convenience
 using json = nlohmann::json;
 
 // Global variables
 extern MessageQueue response;
+extern RequestRegistry requestRegistry;
+extern LatencyTracer latencyTracer;
+extern ServiceMetrics serviceMetrics;
+extern AdmissionControl admissionControl;
+extern ChannelMap channelMap;
+extern IqRecorder iqRecorder;
+extern SweepStore sweepStore;
+extern PanTraces panTraces;
+extern Waterfalls waterfalls;
+
+// Defined in etherDLLStream.hpp
+void onPanStreamResponse(unsigned long requestID);
 extern spdlog::logger* loggerPtr;
 
 
-// ----------------------------------------------------------------------
-/** @brief Convert GPS response structure into JSON
- *
- * @param gpsResponse Pointer to the GPS response structure
- * @return json JSON object representing the GPS data
- * @throws NO EXCEPTION HANDLING
-**/
-json ProcessGpsData(SEquipCtrlMsg::SGpsResponse* gpsResponse)
-{
-    json jsonObj;
-
-    jsonObj["dateTime"] = COleTimeToIsoStr(gpsResponse->dateTime); // using COleTime format
-    jsonObj["latitude"] = double(gpsResponse->latitude); // degrees (+ North, - South)
-    jsonObj["longitude"] = double(gpsResponse->longitude); // degrees (+ East, - West)
-    jsonObj["status"]["numSats"] = int(gpsResponse->status.numSats); // >7 stored as 7
-	/* Data which use is unclear at the moment
-    jsonObj["status"]["accuracy"] = int(gpsResponse->status.accuracy); // = A,B,C,D
-    jsonObj["status"]["antenna"] = int(gpsResponse->status.antenna);  //  = -,O,S
-    jsonObj["status"]["batVolt"] = int(gpsResponse->status.batVolt); // = -,B
-    jsonObj["status"]["lockHist"] = int(gpsResponse->status.lockHist); //  = -,a,A
-    jsonObj["status"]["mode"] = int(gpsResponse->status.mode); // = T,A,S,D
-    jsonObj["status"]["noGps"] = int(gpsResponse->status.noGps);
-    jsonObj["status"]["notTested"] = int(gpsResponse->status.notTested); //
-    jsonObj["status"]["nvRam"] = int(gpsResponse->status.nvRam); // = -,N
-    jsonObj["status"]["oscVolt"] = int(gpsResponse->status.oscVolt); // = -,X
-    jsonObj["status"]["pllSynth"] = int(gpsResponse->status.pllSynth); // = -,P
-    jsonObj["status"]["receiver"] = int(gpsResponse->status.receiver); // = -,R
-    jsonObj["status"]["satLock"] = int(gpsResponse->status.satLock); // = L,U
-    jsonObj["status"]["timErr1"] = int(gpsResponse->status.timErr1); // = -,U
-    jsonObj["status"]["timErr2"] = int(gpsResponse->status.timErr2); // = -,U
-    jsonObj["status"]["timSrce"] = int(gpsResponse->status.timSrce); //= G,F,I,N
-    jsonObj["status"]["tracking"] = int(gpsResponse->status.tracking); // = -,T
-    */
-    return jsonObj;
-}
-
-
 // ----------------------------------------------------------------------
 /** @brief Convert response of BIT command in JSON
  *
@@ -163,17 +157,17 @@ json ProcessAntListResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMsg::U
 }
 
 // ----------------------------------------------------------------------
-/** @brief Convert response of types AVD_FREQ_VS_CHANNEL, AVD_OCC_CHANNEL_RESULT, AVD_FREQ_MEAS, AVD_BW_MEAS, AVD_SOLICIT_STATE_RESPONSE, AVD_STATE_RESPONSE and AVD_STATUS  in JSON
+/** @brief Convert response of types AVD_FREQ_VS_CHANNEL, AVD_OCC_CHANNEL_RESULT, AVD_FREQ_MEAS, AVD_BW_MEAS, AVD_SOLICIT_STATE_RESPONSE, AVD_STATE_RESPONSE and AVD_STATUS in JSON
  *
  * @param respType Type of the response message
  * @param data Pointer to the response data
- * @return json JSON object representing the AVD response
+ * @param writer Writer receiving the JSON object representing the AVD response
+ * @return void
  * @throws NO EXCEPTION HANDLING
 **/
-json processAutoViolateResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMsg::UBody* data)
+void processAutoViolateResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMsg::UBody* data, _Out_ edll::JsonWriter& writer)
 {
-    SEquipCtrlMsg::SOccupancyHeader* pOccHdr = nullptr;
-    json jsonObj;
+    writer.beginObject();
 
     switch (respType)
     {
@@ -182,171 +176,83 @@ json processAutoViolateResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMs
     {
         SEquipCtrlMsg::SStateResp* AVDResponse = (SEquipCtrlMsg::SStateResp*)data;
 
-        jsonObj["task"]["completionTime"] = double(AVDResponse->completionTime);
-        jsonObj["task"]["state"] = eStateRespToString(AVDResponse->state);
+        edll::writeFields(writer, *AVDResponse, STATE_RESP_FIELDS);
     }
     break;
 
     case ECSMSDllMsgType::AVD_FREQ_VS_CHANNEL:
     {
         SEquipCtrlMsg::SFrequencyVsChannelResp* AVDResponse = (SEquipCtrlMsg::SFrequencyVsChannelResp*)data;
-        jsonObj["SFrequencyVsChannelResp"]["frequencies"]["internal"] = AVDResponse->frequencies->internal;
-        jsonObj["SFrequencyVsChannelResp"]["hostName"] = AVDResponse->hostName;
-        jsonObj["SFrequencyVsChannelResp"]["numBands"] = AVDResponse->numBands;
-        jsonObj["SFrequencyVsChannelResp"]["numChannels"] = AVDResponse->numChannels;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["firstChannel"] = AVDResponse->occHdr.firstChannel;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["dateTime"] = AVDResponse->occHdr.gpsResponse.dateTime;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["latitude"] = AVDResponse->occHdr.gpsResponse.latitude;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["longitude"] = AVDResponse->occHdr.gpsResponse.longitude;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["accuracy"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.accuracy;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["antenna"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.antenna;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["batVolt"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.batVolt;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["lockHist"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.lockHist;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["mode"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.mode;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["noGps"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.noGps;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["notTested"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.notTested;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["numSats"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.numSats;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["nvRam"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.nvRam;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["oscVolt"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.oscVolt;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["pllSynth"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.pllSynth;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["receiver"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.receiver;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["satLock"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.satLock;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["timErr1"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.timErr1;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["timErr2"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.timErr2;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["timSrce"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.timSrce;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["gpsResponse"]["status"]["tracking"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.tracking;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["numChannels"] = AVDResponse->occHdr.numChannels;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["numTimeOfDays"] = AVDResponse->occHdr.numTimeOfDays;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["numTotalChannels"] = AVDResponse->occHdr.numTotalChannels;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["status"] = AVDResponse->occHdr.status;
-        jsonObj["SFrequencyVsChannelResp"]["occPrimaryThreshold"] = AVDResponse->occPrimaryThreshold;
-        jsonObj["SFrequencyVsChannelResp"]["occSecondaryThreshold"] = AVDResponse->occSecondaryThreshold;
-        jsonObj["SFrequencyVsChannelResp"]["saveIntermediateData"] = AVDResponse->saveIntermediateData;
-        jsonObj["SFrequencyVsChannelResp"]["selectedAntenna"] = AVDResponse->selectedAntenna;
-        jsonObj["SFrequencyVsChannelResp"]["useSecondaryThreshold"] = AVDResponse->useSecondaryThreshold;
-    }
-    break;
 
-    case ECSMSDllMsgType::AVD_FREQ_MEAS:
-    {
-        SEquipCtrlMsg::SAvdMeasureResult* AVDResponse = (SEquipCtrlMsg::SAvdMeasureResult*)data;
-        // TODO #16: Check the origin of the loop total. Why 1000?
-        for (size_t i = 0; i < 1000; ++i) {
-            jsonObj["SAvdMeasureResult"]["measData"][i]["result"] = AVDResponse->measData[i].result;
-            jsonObj["SAvdMeasureResult"]["measData"][i]["stdDev"] = AVDResponse->measData[i].stdDev;
-        }
-        jsonObj["SAvdMeasureResult"]["occHdr"]["firstChannel"] = AVDResponse->occHdr.firstChannel;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["dateTime"] = AVDResponse->occHdr.gpsResponse.dateTime;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["latitude"] = AVDResponse->occHdr.gpsResponse.latitude;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["longitude"] = AVDResponse->occHdr.gpsResponse.longitude;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["accuracy"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.accuracy;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["antenna"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.antenna;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["batVolt"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.batVolt;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["lockHist"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.lockHist;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["mode"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.mode;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["noGps"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.noGps;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["notTested"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.notTested;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["numSats"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.numSats;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["nvRam"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.nvRam;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["oscVolt"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.oscVolt;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["pllSynth"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.pllSynth;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["receiver"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.receiver;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["satLock"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.satLock;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["timErr1"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.timErr1;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["timErr2"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.timErr2;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["timSrce"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.timSrce;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["tracking"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.tracking;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["numChannels"] = AVDResponse->occHdr.numChannels;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["numTimeOfDays"] = AVDResponse->occHdr.numTimeOfDays;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["numTotalChannels"] = AVDResponse->occHdr.numTotalChannels;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["status"] = AVDResponse->occHdr.status;
+        edll::writeFields(writer, AVDResponse->occHdr, OCCUPANCY_HEADER_FIELDS);
+
+        writer.key("SFrequencyVsChannelResp").beginObject();
+        writer.key("frequencies").beginObject();
+        writer.field("internal", AVDResponse->frequencies->internal);
+        writer.endObject();
+        writer.field("hostName", AVDResponse->hostName);
+        writer.field("numBands", AVDResponse->numBands);
+        writer.field("numChannels", AVDResponse->numChannels);
+        writer.field("occPrimaryThreshold", AVDResponse->occPrimaryThreshold);
+        writer.field("occSecondaryThreshold", AVDResponse->occSecondaryThreshold);
+        writer.field("saveIntermediateData", AVDResponse->saveIntermediateData);
+        writer.field("selectedAntenna", AVDResponse->selectedAntenna);
+        writer.field("useSecondaryThreshold", AVDResponse->useSecondaryThreshold);
+        writer.endObject();
     }
     break;
 
+    case ECSMSDllMsgType::AVD_FREQ_MEAS: /* Fall through to apply the same processing to both cases */
     case ECSMSDllMsgType::AVD_BW_MEAS:
     {
         SEquipCtrlMsg::SAvdMeasureResult* AVDResponse = (SEquipCtrlMsg::SAvdMeasureResult*)data;
-        for (size_t i = 0; i < 1000; ++i) {
-            jsonObj["SAvdMeasureResult"]["measData"][i]["result"] = AVDResponse->measData[i].result;
-            jsonObj["SAvdMeasureResult"]["measData"][i]["stdDev"] = AVDResponse->measData[i].stdDev;
-        }
-        jsonObj["SAvdMeasureResult"]["occHdr"]["firstChannel"] = AVDResponse->occHdr.firstChannel;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["dateTime"] = AVDResponse->occHdr.gpsResponse.dateTime;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["latitude"] = AVDResponse->occHdr.gpsResponse.latitude;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["longitude"] = AVDResponse->occHdr.gpsResponse.longitude;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["accuracy"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.accuracy;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["antenna"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.antenna;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["batVolt"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.batVolt;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["lockHist"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.lockHist;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["mode"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.mode;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["noGps"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.noGps;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["notTested"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.notTested;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["numSats"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.numSats;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["nvRam"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.nvRam;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["oscVolt"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.oscVolt;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["pllSynth"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.pllSynth;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["receiver"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.receiver;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["satLock"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.satLock;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["timErr1"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.timErr1;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["timErr2"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.timErr2;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["timSrce"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.timSrce;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["gpsResponse"]["status"]["tracking"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.tracking;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["numChannels"] = AVDResponse->occHdr.numChannels;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["numTimeOfDays"] = AVDResponse->occHdr.numTimeOfDays;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["numTotalChannels"] = AVDResponse->occHdr.numTotalChannels;
-        jsonObj["SAvdMeasureResult"]["occHdr"]["status"] = AVDResponse->occHdr.status;
+
+        // Only the channels in the chunk are valid, starting at the first channel
+        size_t capacity = sizeof(AVDResponse->measData) / sizeof(AVDResponse->measData[0]);
+        size_t numChannels = (std::min)(static_cast<size_t>(AVDResponse->occHdr.numChannels), capacity);
+
+        edll::writeFields(writer, AVDResponse->occHdr, OCCUPANCY_HEADER_FIELDS);
+
+        writer.key("SAvdMeasureResult").beginObject();
+        writer.field("firstChannel", (unsigned long)AVDResponse->occHdr.firstChannel);
+        writer.field("numChannels", (unsigned long)numChannels);
+        writer.key("result");
+        writeChannelColumn(writer, AVDResponse->measData, numChannels, [](const auto& meas) { return meas.result; });
+        writer.key("stdDev");
+        writeChannelColumn(writer, AVDResponse->measData, numChannels, [](const auto& meas) { return meas.stdDev; });
+        writer.endObject();
     }
     break;
 
     case ECSMSDllMsgType::AVD_STATUS:
     {
         SEquipCtrlMsg::SEquipTaskStatusResp* AVDResponse = (SEquipCtrlMsg::SEquipTaskStatusResp*)data;
-        jsonObj["SEquipTaskStatusResp"]["dateTime"] = AVDResponse->dateTime;
-        jsonObj["SEquipTaskStatusResp"]["key"] = AVDResponse->key;
-        jsonObj["SEquipTaskStatusResp"]["status"] = AVDResponse->status;
-        jsonObj["SEquipTaskStatusResp"]["taskId"] = AVDResponse->taskId;
+
+        edll::writeFields(writer, *AVDResponse, TASK_STATUS_RESP_FIELDS);
     }
     break;
 
     case ECSMSDllMsgType::AVD_OCC_CHANNEL_RESULT:
     {
         SEquipCtrlMsg::SOccResult* AVDResponse = (SEquipCtrlMsg::SOccResult*)data;
-        jsonObj["SOccResult"]["occHdr"]["firstChannel"] = AVDResponse->occHdr.firstChannel;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["dateTime"] = AVDResponse->occHdr.gpsResponse.dateTime;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["latitude"] = AVDResponse->occHdr.gpsResponse.latitude;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["longitude"] = AVDResponse->occHdr.gpsResponse.longitude;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["accuracy"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.accuracy;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["antenna"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.antenna;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["batVolt"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.batVolt;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["lockHist"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.lockHist;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["mode"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.mode;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["noGps"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.noGps;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["notTested"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.notTested;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["numSats"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.numSats;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["nvRam"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.nvRam;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["oscVolt"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.oscVolt;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["pllSynth"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.pllSynth;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["receiver"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.receiver;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["satLock"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.satLock;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["timErr1"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.timErr1;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["timErr2"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.timErr2;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["timSrce"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.timSrce;
-        jsonObj["SOccResult"]["occHdr"]["gpsResponse"]["status"]["tracking"] = (unsigned long)AVDResponse->occHdr.gpsResponse.status.tracking;
-        jsonObj["SOccResult"]["occHdr"]["numChannels"] = AVDResponse->occHdr.numChannels;
-        jsonObj["SOccResult"]["occHdr"]["numTimeOfDays"] = AVDResponse->occHdr.numTimeOfDays;
-        jsonObj["SOccResult"]["occHdr"]["numTotalChannels"] = AVDResponse->occHdr.numTotalChannels;
-        jsonObj["SOccResult"]["occHdr"]["status"] = AVDResponse->occHdr.status;
-        jsonObj["SOccResult"]["resultData"]["avg"] = AVDResponse->resultData->avg;
-        jsonObj["SOccResult"]["resultData"]["avg"] = AVDResponse->resultData->max;
+
+        edll::writeFields(writer, AVDResponse->occHdr, OCCUPANCY_HEADER_FIELDS);
+
+        writer.key("SOccResult").beginObject();
+        writer.key("resultData").beginObject();
+        writer.field("avg", AVDResponse->resultData->avg);
+        writer.field("max", AVDResponse->resultData->max);
+        writer.endObject();
+        writer.endObject();
     }
     break;
 
     default:
-        jsonObj["Error"] = std::string("Unexpected processAutoViolateResponse type ") + ECSMSDllMsgTypeToString(respType);
+        writer.field("Error", std::string("Unexpected processAutoViolateResponse type ") + ECSMSDllMsgTypeToString(respType));
         break;
     }
 
-    return jsonObj;
+    writer.endObject();
 }
 
 // ----------------------------------------------------------------------
@@ -460,47 +366,193 @@ json processDemodCtrlResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMsg:
     return jsonObj;
 }
 
+// ----------------------------------------------------------------------
+/** @brief Queue a GET_PAN sweep in the sweep store, with its raw bins
+ * Called from the DLL callback thread. Returns immediately if the store is disabled or its queue is full.
+ *
+ * @param data Pointer to the SGetPanResp
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void storePanSweep(_In_ SEquipCtrlMsg::UBody* data)
+{
+    if (!sweepStore.isEnabled()) {
+        return;
+    }
+
+    const SEquipCtrlMsg::SGetPanResp* PanResponse = (SEquipCtrlMsg::SGetPanResp*)data;
+
+    long long timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    sweepStore.record(static_cast<uint32_t>(ECSMSDllMsgType::GET_PAN), timeNs,
+        double(PanResponse->freq.internal) / FREQ_FACTOR,
+        double(PanResponse->binSize.internal) / FREQ_FACTOR,
+        PanResponse->binData, PanResponse->numBins);
+}
+
+// ----------------------------------------------------------------------
+/** @brief Fold a GET_PAN sweep into the max-hold, min-hold and average traces of its configuration
+ * Called from the DLL callback thread. Returns immediately if the traces are disabled.
+ *
+ * @param data Pointer to the SGetPanResp
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void tracePanSweep(_In_ SEquipCtrlMsg::UBody* data)
+{
+    if (!panTraces.isEnabled()) {
+        return;
+    }
+
+    const SEquipCtrlMsg::SGetPanResp* PanResponse = (SEquipCtrlMsg::SGetPanResp*)data;
+
+    panTraces.update(double(PanResponse->freq.internal) / FREQ_FACTOR,
+        double(PanResponse->binSize.internal) / FREQ_FACTOR,
+        PanResponse->binData, PanResponse->numBins);
+}
+
+// ----------------------------------------------------------------------
+/** @brief Add a GET_PAN sweep to the waterfall of its configuration
+ * Called from the DLL callback thread. Returns immediately if the waterfalls are disabled.
+ *
+ * @param data Pointer to the SGetPanResp
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void waterfallPanSweep(_In_ SEquipCtrlMsg::UBody* data)
+{
+    if (!waterfalls.isEnabled()) {
+        return;
+    }
+
+    const SEquipCtrlMsg::SGetPanResp* PanResponse = (SEquipCtrlMsg::SGetPanResp*)data;
+
+    waterfalls.update(Waterfalls::PAN, 0, 0,
+        double(PanResponse->freq.internal) / FREQ_FACTOR,
+        double(PanResponse->binSize.internal) / FREQ_FACTOR,
+        PanResponse->binData, PanResponse->numBins);
+}
+
+// ----------------------------------------------------------------------
+/** @brief Write the noise floor and the peaks of a GET_PAN sweep, from its full resolution bins
+ *
+ * The noise floor is the level at the requested percentile of the bins. Peaks are reported above the requested level,
+ * or above the noise floor plus the requested margin, the highest of both if both are requested.
+ * Each peak has its frequency in MHz, level and bandwidth in Hz at PEAK_BANDWIDTH_DB below the peak.
+ *
+ * @param PanResponse Pointer to the SGetPanResp
+ * @param output Spectrum output options requested by the client
+ * @param writer Writer receiving the members of the spectrum object
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void writePanPeaks(_In_ const SEquipCtrlMsg::SGetPanResp* PanResponse, _In_ const SpectrumOutput& output, _Out_ edll::JsonWriter& writer)
+{
+    size_t numBins = PanResponse->numBins;
+    if (numBins == 0) {
+        writer.key("peaks").beginArray().endArray();
+        return;
+    }
+
+    auto spectrumInfo = calculateSpectrumInfo(PanResponse);
+
+    float noiseFloor = static_cast<float>(binPercentile(PanResponse->binData, numBins, output.noisePercentile)) - BYTE_POWER_OFFSET;
+    float threshold = -std::numeric_limits<float>::infinity();
+    if (!std::isnan(output.peakThreshold)) {
+        threshold = output.peakThreshold;
+    }
+    if (!std::isnan(output.peakMargin)) {
+        threshold = (std::max)(threshold, noiseFloor + output.peakMargin);
+    }
+
+    writer.field("noiseFloor", noiseFloor);
+    writer.field("peakThreshold", threshold);
+    writer.key("peaks").beginArray();
+
+    unsigned int minValue = binValueAbove(threshold);
+    if (minValue <= 255) {
+        // Spacing in bins, limited to the sweep so that the conversion from double is always defined
+        double spacingBins = spectrumInfo.binSize > 0 ? std::ceil(output.peakSpacing / spectrumInfo.binSize) : 0.0;
+        size_t minSpacing = spacingBins < double(numBins) ? static_cast<size_t>((std::max)(spacingBins, 0.0)) : numBins;
+        for (const SpectrumPeak& peak : findPeaks(PanResponse->binData, numBins, static_cast<unsigned char>(minValue), minSpacing)) {
+            writer.beginObject();
+            writer.field("frequency", spectrumInfo.startFrequency + double(peak.bin) * spectrumInfo.binSize / edll::MHZ_MULTIPLIER);
+            writer.field("level", static_cast<float>(peak.value) - BYTE_POWER_OFFSET);
+            writer.field("bandwidth", double(peak.lastBin - peak.firstBin + 1) * spectrumInfo.binSize);
+            writer.endObject();
+        }
+    }
+
+    writer.endArray();
+}
+
 // ----------------------------------------------------------------------
 /** @brief Convert response of type GET_PAN in JSON
  *
  * @param respType Type of the response message
  * @param data Pointer to the response data
- * @return json JSON object representing the panadapter response
+ * @param writer Writer receiving the JSON object representing the panadapter response
+ * @param output Spectrum output options requested by the client: decimation, peaks and sweep data
+ * @return void
  * @throws NO EXCEPTION HANDLING
 **/
-json processPanResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMsg::UBody* data)
+void processPanResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMsg::UBody* data, _Out_ edll::JsonWriter& writer, _In_ const SpectrumOutput& output = SpectrumOutput())
 {
-    json jsonObj;
-
     SEquipCtrlMsg::SGetPanResp* PanResponse = (SEquipCtrlMsg::SGetPanResp*)data;
 
-    jsonObj["measure"]["status"] = PanResponse->status;
-    jsonObj["measure"]["dateTime"] = COleTimeToIsoStr(PanResponse->dateTime);
-    jsonObj["measure"]["powerDbm"] = PanResponse->powerDbm;
-    jsonObj["setting"]["attenuation"] = PanResponse->rcvrAtten;
+    size_t outputBins = output.bins;
+    Decimation decimation = static_cast<Decimation>(output.decimation);
+    auto spectrumInfo = calculateSpectrumInfo(PanResponse, outputBins);
+    size_t numBins = outputBinCount(PanResponse->numBins, outputBins);
+    size_t sweepByteLen = numBins * sizeof(float);
+
+    writer.beginObject();
+
+    writer.key("measure").beginObject();
+    writer.field("status", PanResponse->status);
+    writer.field("dateTime", COleTimeToIsoStr(PanResponse->dateTime));
+    writer.field("powerDbm", PanResponse->powerDbm);
+    writer.endObject();
+
+    writer.key("setting").beginObject();
+    writer.field("attenuation", PanResponse->rcvrAtten);
+    writer.endObject();
+
+    writer.key("spectrum").beginObject();
+    writer.field("numBins", numBins);
+    if (numBins != PanResponse->numBins) {
+        writer.field("decimation", decimationToString(decimation));
+        writer.field("sourceNumBins", PanResponse->numBins);
+    }
+    writer.field("startFrequency", spectrumInfo.startFrequency);
+    writer.field("stopFrequency", spectrumInfo.stopFrequency);
+    writer.field("frequencyUnit", "MHz");
+    writer.field("binSize", spectrumInfo.binSize);
+    writer.field("binSizeUnit", "Hz");
+    if (output.sweepData) {
+        writer.field("sweepData", base64Encode(
+            decimatedBinData(PanResponse->binData, PanResponse->numBins, outputBins, decimation),
+            static_cast<unsigned int>(sweepByteLen)
+        ));
+    }
+    writer.field("conversionFactorForFS", PanResponse->conversionFactorForFS);
+    if (output.detectPeaks()) {
+        writePanPeaks(PanResponse, output, writer);
+    }
+    writer.endObject();
 
-    auto spectrumInfo = calculateSpectrumInfo(PanResponse);
-    size_t sweepByteLen = static_cast<size_t>(PanResponse->numBins) * sizeof(float);
-
-    jsonObj["spectrum"]["numBins"] = PanResponse->numBins;
-    jsonObj["spectrum"]["startFrequency"] = spectrumInfo.startFrequency;
-    jsonObj["spectrum"]["stopFrequency"] = spectrumInfo.stopFrequency;
-    jsonObj["spectrum"]["frequencyUnit"] = "MHz";
-    jsonObj["spectrum"]["binSize"] = spectrumInfo.binSize;
-    jsonObj["spectrum"]["binSizeUnit"] = "Hz";
-    jsonObj["spectrum"]["sweepData"] = base64Encode(
-        parsedBinData(PanResponse->binData, PanResponse->numBins),
-        static_cast<unsigned int>(sweepByteLen)
-    );
-    jsonObj["spectrum"]["conversionFactorForFS"] = PanResponse->conversionFactorForFS;
-
-    jsonObj["demod"]["nActiveAudioChannels"] = PanResponse->nActiveAudioChannels;
-    jsonObj["demod"]["audioPower"]["active"] = PanResponse->audioPower->active;
+    writer.key("demod").beginObject();
+    writer.field("nActiveAudioChannels", PanResponse->nActiveAudioChannels);
+    writer.key("audioPower").beginArray();
     for (size_t i = 0; i < PanResponse->nActiveAudioChannels; ++i) {
-        jsonObj["demod"]["audioPower"][i]["powerdBm"] = PanResponse->audioPower[i].powerdBm;
+        writer.beginObject();
+        writer.field("active", PanResponse->audioPower[i].active);
+        writer.field("powerdBm", PanResponse->audioPower[i].powerdBm);
+        writer.endObject();
     }
+    writer.endArray();
+    writer.endObject();
 
-    return jsonObj;
+    writer.endObject();
 }
 
 // ----------------------------------------------------------------------
@@ -521,23 +573,22 @@ json processOccupancyResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMsg:
     {
         SEquipCtrlMsg::SMsgLengthDistributionResp* OCCResponse = (SEquipCtrlMsg::SMsgLengthDistributionResp*)data;
 
+        edll::writeFields(jsonObj, OCCResponse->occHdr, OCCUPANCY_HEADER_FIELDS);
         jsonObj["SMsgLengthDistributionResp"]["histData"]["channel"] = OCCResponse->histData->channel;
         jsonObj["SMsgLengthDistributionResp"]["histData"]["length"] = OCCResponse->histData->length;
-        jsonObj["SMsgLengthDistributionResp"]["occHdr"]["firstChannel"] = OCCResponse->occHdr.firstChannel;
-        jsonObj["site"] = ProcessGpsData(&(OCCResponse->occHdr.gpsResponse));
     }
     break;
 
-    case ECSMSDllMsgType::OCC_SPECTRUM_RESPONSE:
+    case ECSMSDllMsgType::OCC_SPECTRUM_RESPONSE: /* Fall through to apply the same processing to all results */
+    case ECSMSDllMsgType::OCC_CHANNEL_RESULT:
+    case ECSMSDllMsgType::OCC_EFLD_CHANNEL_RESULT:
+    case ECSMSDllMsgType::OCC_TIMEOFDAY_RESULT:
+    case ECSMSDllMsgType::OCC_MSGLEN_CHANNEL_RESULT:
+    case ECSMSDllMsgType::OCC_EFLD_TIMEOFDAY_RESULT:
     {
         SEquipCtrlMsg::SOccResult* OCCResponse = (SEquipCtrlMsg::SOccResult*)data;
 
-        jsonObj["site"] = ProcessGpsData(&(OCCResponse->occHdr.gpsResponse));
-        jsonObj["SOccResult"]["occHdr"]["firstChannel"] = OCCResponse->occHdr.firstChannel;
-        jsonObj["SOccResult"]["occHdr"]["numChannels"] = (unsigned long)OCCResponse->occHdr.numChannels;
-        jsonObj["SOccResult"]["occHdr"]["numTimeOfDays"] = (unsigned long)OCCResponse->occHdr.numTimeOfDays;
-        jsonObj["SOccResult"]["occHdr"]["numTotalChannels"] = (unsigned long)OCCResponse->occHdr.numTotalChannels;
-        jsonObj["SOccResult"]["occHdr"]["status"] = (unsigned long)OCCResponse->occHdr.status;
+        edll::writeFields(jsonObj, OCCResponse->occHdr, OCCUPANCY_HEADER_FIELDS);
         jsonObj["SOccResult"]["resultData"] = (unsigned long)OCCResponse->resultData;
     }
     break;
@@ -546,8 +597,8 @@ json processOccupancyResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMsg:
     case ECSMSDllMsgType::OCC_SOLICIT_STATE_RESPONSE:
     {
         SEquipCtrlMsg::SStateResp* OCCResponse = (SEquipCtrlMsg::SStateResp*)data;
-        jsonObj["task"]["completionTime"] = (unsigned long)OCCResponse->completionTime;
-        jsonObj["task"]["state"] = eStateRespToString(OCCResponse->state);
+
+        edll::writeFields(jsonObj, *OCCResponse, STATE_RESP_FIELDS);
     }
     break;
 
@@ -555,16 +606,11 @@ json processOccupancyResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMsg:
     {
         SEquipCtrlMsg::SFrequencyVsChannelResp* OCCResponse = (SEquipCtrlMsg::SFrequencyVsChannelResp*)data;
 
+        edll::writeFields(jsonObj, OCCResponse->occHdr, OCCUPANCY_HEADER_FIELDS);
         jsonObj["SFrequencyVsChannelResp"]["frequencies"]["internal"] = OCCResponse->frequencies->internal;
         jsonObj["SFrequencyVsChannelResp"]["hostName"] = OCCResponse->hostName;
-        jsonObj["site"] = ProcessGpsData(&(OCCResponse->occHdr.gpsResponse));
         jsonObj["SFrequencyVsChannelResp"]["numBands"] = OCCResponse->numBands;
         jsonObj["SFrequencyVsChannelResp"]["numChannels"] = OCCResponse->numChannels;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["firstChannel"] = OCCResponse->occHdr.firstChannel;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["numChannels"] = OCCResponse->occHdr.numChannels;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["numTimeOfDays"] = OCCResponse->occHdr.numTimeOfDays;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["numTotalChannels"] = OCCResponse->occHdr.numTotalChannels;
-        jsonObj["SFrequencyVsChannelResp"]["occHdr"]["status"] = OCCResponse->occHdr.status;
         jsonObj["SFrequencyVsChannelResp"]["occPrimaryThreshold"] = OCCResponse->occPrimaryThreshold;
         jsonObj["SFrequencyVsChannelResp"]["occSecondaryThreshold"] = OCCResponse->occSecondaryThreshold;
         jsonObj["SFrequencyVsChannelResp"]["saveIntermediateData"] = OCCResponse->saveIntermediateData;
@@ -573,83 +619,11 @@ json processOccupancyResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMsg:
     }
     break;
 
-    case ECSMSDllMsgType::OCC_CHANNEL_RESULT:
-    {
-        SEquipCtrlMsg::SOccResult* OCCResponse = (SEquipCtrlMsg::SOccResult*)data;
-
-        jsonObj["site"] = ProcessGpsData(&(OCCResponse->occHdr.gpsResponse));
-        jsonObj["SOccResult"]["occHdr"]["firstChannel"] = OCCResponse->occHdr.firstChannel;
-        jsonObj["SOccResult"]["occHdr"]["numChannels"] = (unsigned long)OCCResponse->occHdr.numChannels;
-        jsonObj["SOccResult"]["occHdr"]["numTimeOfDays"] = (unsigned long)OCCResponse->occHdr.numTimeOfDays;
-        jsonObj["SOccResult"]["occHdr"]["numTotalChannels"] = (unsigned long)OCCResponse->occHdr.numTotalChannels;
-        jsonObj["SOccResult"]["occHdr"]["status"] = (unsigned long)OCCResponse->occHdr.status;
-        jsonObj["SOccResult"]["resultData"] = (unsigned long)OCCResponse->resultData;
-    }
-    break;
-
-    case ECSMSDllMsgType::OCC_EFLD_CHANNEL_RESULT:
-    {
-        SEquipCtrlMsg::SOccResult* OCCResponse = (SEquipCtrlMsg::SOccResult*)data;
-
-        jsonObj["site"] = ProcessGpsData(&(OCCResponse->occHdr.gpsResponse));
-        jsonObj["SOccResult"]["occHdr"]["firstChannel"] = OCCResponse->occHdr.firstChannel;
-        jsonObj["SOccResult"]["occHdr"]["numChannels"] = (unsigned long)OCCResponse->occHdr.numChannels;
-        jsonObj["SOccResult"]["occHdr"]["numTimeOfDays"] = (unsigned long)OCCResponse->occHdr.numTimeOfDays;
-        jsonObj["SOccResult"]["occHdr"]["numTotalChannels"] = (unsigned long)OCCResponse->occHdr.numTotalChannels;
-        jsonObj["SOccResult"]["occHdr"]["status"] = (unsigned long)OCCResponse->occHdr.status;
-        jsonObj["SOccResult"]["resultData"] = (unsigned long)OCCResponse->resultData;
-    }
-    break;
-
-    case ECSMSDllMsgType::OCC_TIMEOFDAY_RESULT:
-    {
-        SEquipCtrlMsg::SOccResult* OCCResponse = (SEquipCtrlMsg::SOccResult*)data;
-
-        jsonObj["site"] = ProcessGpsData(&(OCCResponse->occHdr.gpsResponse));
-        jsonObj["SOccResult"]["occHdr"]["firstChannel"] = OCCResponse->occHdr.firstChannel;
-        jsonObj["SOccResult"]["occHdr"]["numChannels"] = (unsigned long)OCCResponse->occHdr.numChannels;
-        jsonObj["SOccResult"]["occHdr"]["numTimeOfDays"] = (unsigned long)OCCResponse->occHdr.numTimeOfDays;
-        jsonObj["SOccResult"]["occHdr"]["numTotalChannels"] = (unsigned long)OCCResponse->occHdr.numTotalChannels;
-        jsonObj["SOccResult"]["occHdr"]["status"] = (unsigned long)OCCResponse->occHdr.status;
-        jsonObj["SOccResult"]["resultData"] = (unsigned long)OCCResponse->resultData;
-    }
-    break;
-
-    case ECSMSDllMsgType::OCC_MSGLEN_CHANNEL_RESULT:
-    {
-        SEquipCtrlMsg::SOccResult* OCCResponse = (SEquipCtrlMsg::SOccResult*)data;
-
-        jsonObj["site"] = ProcessGpsData(&(OCCResponse->occHdr.gpsResponse));
-        jsonObj["SOccResult"]["occHdr"]["firstChannel"] = OCCResponse->occHdr.firstChannel;
-        jsonObj["SOccResult"]["occHdr"]["numChannels"] = (unsigned long)OCCResponse->occHdr.numChannels;
-        jsonObj["SOccResult"]["occHdr"]["numTimeOfDays"] = (unsigned long)OCCResponse->occHdr.numTimeOfDays;
-        jsonObj["SOccResult"]["occHdr"]["numTotalChannels"] = (unsigned long)OCCResponse->occHdr.numTotalChannels;
-        jsonObj["SOccResult"]["occHdr"]["status"] = (unsigned long)OCCResponse->occHdr.status;
-        jsonObj["SOccResult"]["resultData"] = (unsigned long)OCCResponse->resultData;
-    }
-    break;
-
-    case ECSMSDllMsgType::OCC_EFLD_TIMEOFDAY_RESULT:
-    {
-        SEquipCtrlMsg::SOccResult* OCCResponse = (SEquipCtrlMsg::SOccResult*)data;
-
-        jsonObj["site"] = ProcessGpsData(&(OCCResponse->occHdr.gpsResponse));
-        jsonObj["SOccResult"]["occHdr"]["firstChannel"] = OCCResponse->occHdr.firstChannel;
-        jsonObj["SOccResult"]["occHdr"]["numChannels"] = (unsigned long)OCCResponse->occHdr.numChannels;
-        jsonObj["SOccResult"]["occHdr"]["numTimeOfDays"] = (unsigned long)OCCResponse->occHdr.numTimeOfDays;
-        jsonObj["SOccResult"]["occHdr"]["numTotalChannels"] = (unsigned long)OCCResponse->occHdr.numTotalChannels;
-        jsonObj["SOccResult"]["occHdr"]["status"] = (unsigned long)OCCResponse->occHdr.status;
-        jsonObj["SOccResult"]["resultData"] = (unsigned long)OCCResponse->resultData;
-    }
-    break;
-
     case ECSMSDllMsgType::OCC_STATUS:
     {
         SEquipCtrlMsg::SEquipTaskStatusResp* OCCResponse = (SEquipCtrlMsg::SEquipTaskStatusResp*)data;
-        jsonObj["SEquipTaskStatusResp"]["dateTime"] = OCCResponse->dateTime;
-        jsonObj["SEquipTaskStatusResp"]["key"] = OCCResponse->key;
-        jsonObj["SEquipTaskStatusResp"]["status"] = OCCResponse->status;
-        jsonObj["SEquipTaskStatusResp"]["taskId"] = OCCResponse->taskId;
+
+        edll::writeFields(jsonObj, *OCCResponse, TASK_STATUS_RESP_FIELDS);
     }
     break;
 
@@ -706,29 +680,27 @@ json processOccupancyResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMsg:
  *
  * @param respType Type of the response message
  * @param data Pointer to the response data
- * @return json JSON object representing the occupancy DF response
+ * @param writer Writer receiving the JSON object representing the occupancy DF response
+ * @return void
  * @throws NO EXCEPTION HANDLING
 **/
-json processOccupancyDFResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMsg::UBody* data)
+void processOccupancyDFResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMsg::UBody* data, _Out_ edll::JsonWriter& writer)
 {
-    json jsonObj;
+    writer.beginObject();
 
     switch (respType)
     {
     case ECSMSDllMsgType::OCCDF_STATE_RESPONSE: /* Fall through to apply the same processing to both cases */
     case ECSMSDllMsgType::OCCDF_SOLICIT_STATE_RESPONSE:
     {
-        //SEquipCtrlMsg::SStateResp* OCCDFResponse = (SEquipCtrlMsg::SStateResp*)data;
         SEquipCtrlMsg::SStateResp* OCCDFResponse = reinterpret_cast<SEquipCtrlMsg::SStateResp*>(data);
 
-        jsonObj["task"]["completionTime"] = OCCDFResponse->completionTime;
-        jsonObj["task"]["state"] = eStateRespToString(OCCDFResponse->state);
+        edll::writeFields(writer, *OCCDFResponse, STATE_RESP_FIELDS);
     }
     break;
 
     case ECSMSDllMsgType::OCCDF_FREQ_VS_CHANNEL:
     {
-        //SEquipCtrlMsg::SFrequencyVsChannelResp* OCCDFResponse = (SEquipCtrlMsg::SFrequencyVsChannelResp*)data;
         SEquipCtrlMsg::SFrequencyVsChannelResp* OCCDFResponse = reinterpret_cast<SEquipCtrlMsg::SFrequencyVsChannelResp*>(data);
 
         std::vector<float> freqVsChanData(OCCDFResponse->occHdr.numTotalChannels);
@@ -740,46 +712,47 @@ json processOccupancyDFResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMs
         float maxDelta = (std::numeric_limits<float>::lowest)();
         float minDelta = (std::numeric_limits<float>::max)();
 
-		loggerPtr->trace("maxDelta initial: {}, minDelta initial: {}", maxDelta, minDelta);
-
-        // int j = (int)OCCDFResponse->occHdr.firstChannel;
-        for (int i = 1; i < int(OCCDFResponse->occHdr.numChannels); i++) // j++
+        for (int i = 1; i < int(OCCDFResponse->occHdr.numChannels); i++)
         {
-            freqVsChanData[i] = static_cast<float>(Units::Frequency(OCCDFResponse->frequencies[i]).Hz<double>() / edll::MHZ_MULTIPLIER); // freqVsChanData[j]
-            if (freqVsChanData[i] < minFrequency) minFrequency = freqVsChanData[i]; // freqVsChanData[j]
-            if (freqVsChanData[i] > maxFrequency) maxFrequency = freqVsChanData[i]; // freqVsChanData[j]
+            freqVsChanData[i] = static_cast<float>(Units::Frequency(OCCDFResponse->frequencies[i]).Hz<double>() / edll::MHZ_MULTIPLIER);
+            if (freqVsChanData[i] < minFrequency) minFrequency = freqVsChanData[i];
+            if (freqVsChanData[i] > maxFrequency) maxFrequency = freqVsChanData[i];
 
             frequencyDelta = freqVsChanData[i] - freqVsChanData[i - 1];
-			if (frequencyDelta < minDelta) minDelta = frequencyDelta;
-			if (frequencyDelta > maxDelta) maxDelta = frequencyDelta;
+            if (frequencyDelta < minDelta) minDelta = frequencyDelta;
+            if (frequencyDelta > maxDelta) maxDelta = frequencyDelta;
         }
 
         loggerPtr->trace("maxDelta: {}, minDelta: {}", maxDelta, minDelta);
 
+        writer.key("spectrum").beginObject();
         if (maxDelta - minDelta < 0.00001f)
         {
-            jsonObj["spectrum"]["numBins"] = OCCDFResponse->occHdr.numChannels;
-            jsonObj["spectrum"]["startFrequency"] = minFrequency;
-            jsonObj["spectrum"]["stopFrequency"] = maxFrequency;
-            jsonObj["spectrum"]["frequencyUnit"] = "MHz";
-            jsonObj["spectrum"]["binSize"] = frequencyDelta;
-            jsonObj["spectrum"]["binSizeUnit"] = "Hz";
-		}
+            writer.field("numBins", OCCDFResponse->occHdr.numChannels);
+            writer.field("startFrequency", minFrequency);
+            writer.field("stopFrequency", maxFrequency);
+            writer.field("frequencyUnit", "MHz");
+            writer.field("binSize", frequencyDelta);
+            writer.field("binSizeUnit", "Hz");
+        }
         else
         {
-            jsonObj["spectrum"]["FrequencyData"] = base64Encode(
-                reinterpret_cast<const unsigned char*>(freqVsChanData.data()), 
+            writer.field("FrequencyData", base64Encode(
+                reinterpret_cast<const unsigned char*>(freqVsChanData.data()),
                 static_cast<unsigned int>(freqVsChanData.size() * sizeof(float))
-            );
-            jsonObj["spectrum"]["startFrequency"] = minFrequency;
-            jsonObj["spectrum"]["stopFrequency"] = maxFrequency;
-            jsonObj["spectrum"]["frequencyUnit"] = "MHz";
-		}
+            ));
+            writer.field("startFrequency", minFrequency);
+            writer.field("stopFrequency", maxFrequency);
+            writer.field("frequencyUnit", "MHz");
+        }
+        writer.endObject();
 
-        jsonObj["site"] = ProcessGpsData(&(OCCDFResponse->occHdr.gpsResponse));
-        jsonObj["equipment"]["hostName"] = OCCDFResponse->hostName;
-        jsonObj["equipment"]["selectedAntenna"] = eAntToString(OCCDFResponse->selectedAntenna);
+        edll::writeFields(writer, OCCDFResponse->occHdr, OCCUPANCY_HEADER_FIELDS);
 
+        writer.key("equipment").beginObject();
+        writer.field("hostName", OCCDFResponse->hostName);
+        writer.field("selectedAntenna", eAntToString(OCCDFResponse->selectedAntenna));
+        writer.endObject();
 
         /* TODO: Get fields exclusive to the band into the band item
         jsonObj["band"]["Spectrum"]["status"] = eErrorCodeToString(OCCDFResponse->occHdr.status);
@@ -791,71 +764,172 @@ json processOccupancyDFResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMs
         jsonObj["band"]["Spectrum"]["numBands"] = OCCDFResponse->numBands;
         */
 
-        jsonObj["settings"]["primaryThreshold"]["dBuV/m absolute"] = static_cast<int>(OCCDFResponse->occPrimaryThreshold[0]); // dBuV/m
-        jsonObj["settings"]["primaryThreshold"]["dB aboveNoise"] = static_cast<int>(OCCDFResponse->occPrimaryThreshold[1]); // dB
-        jsonObj["settings"]["secondaryThreshold"]["dBuV/m absolute"] = static_cast<int>(OCCDFResponse->occSecondaryThreshold[0]); // dBuV/m
-        jsonObj["settings"]["secondaryThreshold"]["dB aboveNoise"] = static_cast<int>(OCCDFResponse->occSecondaryThreshold[1]); // dB
-        jsonObj["settings"]["saveIntermediateData"] = bool(OCCDFResponse->saveIntermediateData);
-        jsonObj["settings"]["useSecondaryThreshold"] = bool(OCCDFResponse->useSecondaryThreshold);
+        writer.key("settings").beginObject();
+        writer.key("primaryThreshold").beginObject();
+        writer.field("dBuV/m absolute", static_cast<int>(OCCDFResponse->occPrimaryThreshold[0])); // dBuV/m
+        writer.field("dB aboveNoise", static_cast<int>(OCCDFResponse->occPrimaryThreshold[1])); // dB
+        writer.endObject();
+        writer.key("secondaryThreshold").beginObject();
+        writer.field("dBuV/m absolute", static_cast<int>(OCCDFResponse->occSecondaryThreshold[0])); // dBuV/m
+        writer.field("dB aboveNoise", static_cast<int>(OCCDFResponse->occSecondaryThreshold[1])); // dB
+        writer.endObject();
+        writer.field("saveIntermediateData", bool(OCCDFResponse->saveIntermediateData));
+        writer.field("useSecondaryThreshold", bool(OCCDFResponse->useSecondaryThreshold));
+        writer.endObject();
     }
     break;
 
     case ECSMSDllMsgType::OCCDF_SCANDF_VS_CHANNEL:
     {
-        // SEquipCtrlMsg::SScanDfVsChannelResp* OCCDFResponse = (SEquipCtrlMsg::SScanDfVsChannelResp*)data;
         SEquipCtrlMsg::SScanDfVsChannelResp* OCCDFResponse = reinterpret_cast<SEquipCtrlMsg::SScanDfVsChannelResp*>(data);
 
-        jsonObj["channel"]["Occupancy"]["status"] = eErrorCodeToString(OCCDFResponse->occHdr.status);
-
-        jsonObj["site"] = ProcessGpsData(&(OCCDFResponse->occHdr.gpsResponse));
+        // Only the channels in the chunk are sent. The full band is assembled by channelMap
+        size_t capacity = sizeof(OCCDFResponse->scanDfData) / sizeof(OCCDFResponse->scanDfData[0]);
+        size_t numChannels = (std::min)(static_cast<size_t>(OCCDFResponse->occHdr.numChannels), capacity);
+        auto identity = [](auto value) { return value; };
+
+        edll::writeFields(writer, OCCDFResponse->occHdr, OCCUPANCY_HEADER_FIELDS);
+
+        writer.key("channel").beginObject();
+        writer.key("Occupancy").beginObject();
+        writer.field("numAzimuths", OCCDFResponse->numAzimuths);
+        writer.field("firstChannel", (unsigned long)OCCDFResponse->occHdr.firstChannel);
+        writer.field("numChannels", (unsigned long)numChannels);
+        writer.field("numTotalChannels", (unsigned long)OCCDFResponse->occHdr.numTotalChannels);
+        writer.key("chanData");
+        writeChannelColumn(writer, OCCDFResponse->scanDfData, numChannels, identity);
+        writer.key("aveRange");
+        writeChannelColumn(writer, OCCDFResponse->aveRange, numChannels, identity);
+        writer.key("aveFldStr");
+        writeChannelColumn(writer, OCCDFResponse->aveFldStr, numChannels, identity);
+        writer.endObject();
+        writer.endObject();
+    }
+    break;
 
-        jsonObj["channel"]["Occupancy"]["numTotalChannels"] = OCCDFResponse->occHdr.numTotalChannels;
-        jsonObj["channel"]["Occupancy"]["firstChannel"] = OCCDFResponse->occHdr.firstChannel;
+    case ECSMSDllMsgType::OCCDF_STATUS:
+    {
+        SEquipCtrlMsg::SEquipTaskStatusResp* OCCDFResponse = reinterpret_cast<SEquipCtrlMsg::SEquipTaskStatusResp*>(data);
 
-        jsonObj["channel"]["Occupancy"]["numTimeOfDays"] = OCCDFResponse->occHdr.numTimeOfDays;
+        edll::writeFields(writer, *OCCDFResponse, TASK_STATUS_RESP_FIELDS);
+    }
+    break;
 
-        int numChannels = OCCDFResponse->occHdr.numTotalChannels;
+    default:
+        writer.field("error", std::string("Unexpected processOccupancyDFResponse type ") + ECSMSDllMsgTypeToString(respType));
+        break;
+    }
 
-        jsonObj["channel"]["Occupancy"]["numAzimuths"] = OCCDFResponse->numAzimuths;
-        jsonObj["channel"]["Occupancy"]["numChannels"] = numChannels;
+    writer.endObject();
+}
 
-        std::vector<int> chanData(numChannels);
-        std::copy(OCCDFResponse->scanDfData,
-            OCCDFResponse->scanDfData + OCCDFResponse->occHdr.numChannels,
-            chanData.begin() + OCCDFResponse->occHdr.firstChannel);
-        jsonObj["channel"]["Occupancy"]["chanData"] = chanData;
+// ----------------------------------------------------------------------
+/** @brief Queue a realtime spectrum in the sweep store and add it to the waterfall of its task and band
+ * Called from the DLL callback thread. Only spectra with uint8 levels are kept, as the GET_PAN bins.
+ * The center frequency is taken at the same bin as in the pan response, so the first bin frequency is kept.
+ *
+ * @param respType Type of the response message
+ * @param spectrum Realtime spectrum
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+template <typename Spectrum>
+void storeSpectrum(ECSMSDllMsgType respType, const Spectrum& spectrum)
+{
+    using Level = std::decay_t<decltype(spectrum.chanData[0])>;
 
-        std::vector<int> aveRange(numChannels);
-        std::copy(OCCDFResponse->aveRange,
-            OCCDFResponse->aveRange + OCCDFResponse->occHdr.numChannels,
-			aveRange.begin() + OCCDFResponse->occHdr.firstChannel);
-        jsonObj["channel"]["Occupancy"]["aveRange"] = aveRange;
+    if constexpr (std::is_same_v<Level, unsigned char>) {
+        if (!sweepStore.isEnabled() && !waterfalls.isEnabled()) {
+            return;
+        }
 
-        std::vector<int> aveFldStr(numChannels);
-        std::copy(OCCDFResponse->aveFldStr,
-            OCCDFResponse->aveFldStr + OCCDFResponse->occHdr.numChannels,
-            aveFldStr.begin() + OCCDFResponse->occHdr.firstChannel);
-        jsonObj["channel"]["Occupancy"]["aveFldStr"] = aveFldStr;
+        double binSize = Units::Frequency(spectrum.chanSize).Hz<double>();
+        double centerFrequency = Units::Frequency(spectrum.firstChanFreq).Hz<double>() + binSize * (spectrum.numChan / 2);
+        if (sweepStore.isEnabled()) {
+            long long timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            sweepStore.record(static_cast<uint32_t>(respType), timeNs, centerFrequency, binSize, spectrum.chanData, spectrum.numChan);
+        }
+        waterfalls.update(Waterfalls::REALTIME, spectrum.taskId, spectrum.bandIndex, centerFrequency, binSize, spectrum.chanData, spectrum.numChan);
     }
-    break;
+}
 
-    case ECSMSDllMsgType::OCCDF_STATUS:
+// ----------------------------------------------------------------------
+/** @brief Number of samples that fit in the member of SIq selected by the data type of the block
+ *
+ * @param block IQ block received from the DLL
+ * @return size_t Capacity of the sample member, zero for an unknown data type
+ * @throws NO EXCEPTION HANDLING
+**/
+size_t iqSampleCapacity(const SSmsRealtimeMsg::SIqDataV4& block)
+{
+    switch (static_cast<unsigned long>(block.dataType))
     {
-        // SEquipCtrlMsg::SEquipTaskStatusResp* OCCDFResponse = (SEquipCtrlMsg::SEquipTaskStatusResp*)data;
-        SEquipCtrlMsg::SEquipTaskStatusResp* OCCDFResponse = reinterpret_cast<SEquipCtrlMsg::SEquipTaskStatusResp*>(data);
+    case IqDataType::INT16:
+        return sizeof(block.SIq.samplesInt16) / sizeof(block.SIq.samplesInt16[0]);
+    case IqDataType::INT32:
+        return sizeof(block.SIq.samplesInt32) / sizeof(block.SIq.samplesInt32[0]);
+    case IqDataType::FLOAT32:
+        return sizeof(block.SIq.samplesFloat32) / sizeof(block.SIq.samplesFloat32[0]);
+    default:
+        return 0;
+    }
+}
+
+// ----------------------------------------------------------------------
+/** @brief Queue an RT_IQ_DATA block in the IQ recorder
+ * Called from the DLL callback thread. Returns immediately if the recorder is disabled or its queue is full.
+ * The stream start time is taken as a FILETIME value, counting 100 ns intervals since January 1, 1601 (UTC).
+ *
+ * @param data Pointer to the SIqDataV4 block
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void recordIqData(const SSmsRealtimeMsg::UBody* data)
+{
+    const unsigned long long FILETIME_UNIX_EPOCH = 116444736000000000ULL;
 
-        jsonObj["SEquipTaskStatusResp"]["dateTime"] = OCCDFResponse->dateTime;
-        jsonObj["SEquipTaskStatusResp"]["key"] = OCCDFResponse->key;
-        jsonObj["SEquipTaskStatusResp"]["status"] = eStatusToString(OCCDFResponse->status);
-        jsonObj["SEquipTaskStatusResp"]["taskId"] = OCCDFResponse->taskId;
+    if (!iqRecorder.isEnabled()) {
+        return;
     }
-    break;
 
-    default:
-        jsonObj["error"] = std::string("Unexpected processOccupancyDFResponse type ") + ECSMSDllMsgTypeToString(respType);
+    const SSmsRealtimeMsg::SIqDataV4* RTResponse = (const SSmsRealtimeMsg::SIqDataV4*)data;
+
+    IqBlockInfo info;
+    const void* samples = nullptr;
+    switch (static_cast<unsigned long>(RTResponse->dataType))
+    {
+    case IqDataType::INT16:
+        info.datatype = "ci16_le";
+        info.sampleSize = sizeof(RTResponse->SIq.samplesInt16[0]);
+        samples = RTResponse->SIq.samplesInt16;
+        break;
+    case IqDataType::INT32:
+        info.datatype = "ci32_le";
+        info.sampleSize = sizeof(RTResponse->SIq.samplesInt32[0]);
+        samples = RTResponse->SIq.samplesInt32;
+        break;
+    case IqDataType::FLOAT32:
+        info.datatype = "cf32_le";
+        info.sampleSize = sizeof(RTResponse->SIq.samplesFloat32[0]);
+        samples = RTResponse->SIq.samplesFloat32;
         break;
+    default:
+        return;
     }
-    return jsonObj;
+
+    unsigned long long timestamp = RTResponse->streamStartTime.timestamp;
+    info.streamID = RTResponse->streamID;
+    info.seqNumber = RTResponse->seqNumber;
+    info.sampleOffset = RTResponse->sampleOffset;
+    info.startTimestamp = timestamp;
+    info.startTimeNs = timestamp > FILETIME_UNIX_EPOCH ? static_cast<long long>(timestamp - FILETIME_UNIX_EPOCH) * 100 : 0;
+    info.numSamples = (std::min)(static_cast<size_t>(RTResponse->numSamples), iqSampleCapacity(*RTResponse));
+    info.frequencyHz = Units::Frequency(RTResponse->freq).Hz<double>();
+    info.sampleRate = static_cast<double>(RTResponse->actualSampleRate);
+    info.scaleFactor = static_cast<double>(RTResponse->scaleFactor);
+    info.endOfStream = RTResponse->EOS;
+
+    iqRecorder.record(info, samples);
 }
 
 // ----------------------------------------------------------------------
@@ -863,37 +937,44 @@ json processOccupancyDFResponse(_In_ ECSMSDllMsgType respType, _In_ SEquipCtrlMs
  *
  * @param respType Type of the response message
  * @param data Pointer to the response data
- * @return json JSON object representing the real-time data response
+ * @param writer Writer receiving the JSON object representing the real-time data response
+ * @return void
  * @throws NO EXCEPTION HANDLING
 **/
-json ProcessRealTimeData(_In_ ECSMSDllMsgType respType, _In_ SSmsRealtimeMsg::UBody* data)
+void ProcessRealTimeData(_In_ ECSMSDllMsgType respType, _In_ SSmsRealtimeMsg::UBody* data, _Out_ edll::JsonWriter& writer)
 {
-    json jsonObj;
+    writer.beginObject();
 
     switch (respType)
     {
     case ECSMSDllMsgType::RT_SPECTRUM_START:
     {
         const SSmsRealtimeMsg::SStartV2* RTResponse = (SSmsRealtimeMsg::SStartV2*)data;
-        unsigned int i;
 
-        jsonObj["SStart"]["taskId"] = RTResponse->taskId;
-        jsonObj["SStart"]["numBands"] = RTResponse->numBands;
-        for (i = 0; i < RTResponse->numBands; i++)
+        writer.key("SStart").beginObject();
+        writer.field("taskId", RTResponse->taskId);
+        writer.field("numBands", RTResponse->numBands);
+        writer.key("band").beginArray();
+        for (unsigned int i = 0; i < RTResponse->numBands; i++)
         {
-            json bandObj;
-            bandObj["binSize"] = RTResponse->band[i].chanSize.internal;
-            bandObj["startFreq"] = RTResponse->band[i].firstChanFreq.internal;
-            bandObj["numChan"] = RTResponse->band[i].numChan;
-            jsonObj["SStart"]["band"].push_back(bandObj);
+            writer.beginObject();
+            writer.field("binSize", RTResponse->band[i].chanSize.internal);
+            writer.field("startFreq", RTResponse->band[i].firstChanFreq.internal);
+            writer.field("numChan", RTResponse->band[i].numChan);
+            writer.endObject();
         }
+        writer.endArray();
+        writer.endObject();
     }
     break;
 
     case ECSMSDllMsgType::RT_SPECTRUM_STOP:
     {
         const SSmsRealtimeMsg::SStop* RTResponse = (const SSmsRealtimeMsg::SStop*)data;
-        jsonObj["SStop"]["taskId"] = RTResponse->taskId;
+
+        writer.key("SStop").beginObject();
+        writer.field("taskId", RTResponse->taskId);
+        writer.endObject();
     }
     break;
 
@@ -901,13 +982,14 @@ json ProcessRealTimeData(_In_ ECSMSDllMsgType respType, _In_ SSmsRealtimeMsg::UB
     {
         const SSmsRealtimeMsg::SSpectrum* RTResponse = (SSmsRealtimeMsg::SSpectrum*)data;
 
-        jsonObj["Spectrum"]["taskId"] = RTResponse->taskId;
-        jsonObj["Spectrum"]["bandIndex"] = RTResponse->bandIndex;
-        jsonObj["Spectrum"]["startFreq"] = RTResponse->firstChanFreq;
-        jsonObj["Spectrum"]["binSize"] = RTResponse->chanSize;
-        jsonObj["Spectrum"]["numChan"] = RTResponse->numChan;
-        jsonObj["Spectrum"]["noiseFloor"] = RTResponse->noiseFloor;
-        jsonObj["Spectrum"]["levelData"] = std::string(reinterpret_cast<const char*>(RTResponse->chanData), RTResponse->numChan);
+        writer.key("Spectrum").beginObject();
+        writer.field("taskId", RTResponse->taskId);
+        writer.field("bandIndex", RTResponse->bandIndex);
+        writer.field("startFreq", RTResponse->firstChanFreq);
+        writer.field("binSize", RTResponse->chanSize);
+        writer.field("numChan", RTResponse->numChan);
+        writeLevelData(writer, *RTResponse);
+        writer.endObject();
     }
     break;
 
@@ -915,152 +997,437 @@ json ProcessRealTimeData(_In_ ECSMSDllMsgType respType, _In_ SSmsRealtimeMsg::UB
     {
         const SSmsRealtimeMsg::SSpectrumV2* RTResponse = (SSmsRealtimeMsg::SSpectrumV2*)data;
 
-        jsonObj["Spectrum"]["taskId"] = RTResponse->taskId;
-        jsonObj["Spectrum"]["bandIndex"] = RTResponse->bandIndex;
-        jsonObj["Spectrum"]["startFreq"]["internal"] = RTResponse->firstChanFreq.internal;
-        jsonObj["Spectrum"]["binSize"]["internal"] = RTResponse->chanSize.internal;
-        jsonObj["Spectrum"]["numChan"] = RTResponse->numChan;
-        jsonObj["Spectrum"]["noiseFloor"] = RTResponse->noiseFloor;
-        jsonObj["Spectrum"]["levelData"] = std::string(reinterpret_cast<const char*>(RTResponse->chanData), RTResponse->numChan);
+        writer.key("Spectrum").beginObject();
+        writer.field("taskId", RTResponse->taskId);
+        writer.field("bandIndex", RTResponse->bandIndex);
+        writer.key("startFreq").beginObject().field("internal", RTResponse->firstChanFreq.internal).endObject();
+        writer.key("binSize").beginObject().field("internal", RTResponse->chanSize.internal).endObject();
+        writer.field("numChan", RTResponse->numChan);
+        writeLevelData(writer, *RTResponse);
+        writer.endObject();
     }
     break;
+
     case ECSMSDllMsgType::RT_SPECTRUM_RESPONSE:
     {
         const SSmsRealtimeMsg::SSpectrumV3* RTResponse = (SSmsRealtimeMsg::SSpectrumV3*)data;
 
-        jsonObj["Spectrum"]["taskId"] = RTResponse->taskId;
-        jsonObj["Spectrum"]["bandIndex"] = RTResponse->bandIndex;
-        jsonObj["Spectrum"]["startFreq"]["internal"] = RTResponse->firstChanFreq.internal;
-        jsonObj["Spectrum"]["binSize"]["internal"] = RTResponse->chanSize.internal;
-        jsonObj["Spectrum"]["numChan"] = RTResponse->numChan;
-        jsonObj["Spectrum"]["noiseFloor"] = RTResponse->noiseFloor;
-        jsonObj["Spectrum"]["efield"] = RTResponse->efield;
-        jsonObj["Spectrum"]["zeroVal"] = RTResponse->zeroVal;
-        jsonObj["Spectrum"]["levelData"] = std::string(reinterpret_cast<const char*>(RTResponse->chanData), RTResponse->numChan);
+        writer.key("Spectrum").beginObject();
+        writer.field("taskId", RTResponse->taskId);
+        writer.field("bandIndex", RTResponse->bandIndex);
+        writer.key("startFreq").beginObject().field("internal", RTResponse->firstChanFreq.internal).endObject();
+        writer.key("binSize").beginObject().field("internal", RTResponse->chanSize.internal).endObject();
+        writer.field("numChan", RTResponse->numChan);
+        writer.field("efield", RTResponse->efield);
+        writeLevelData(writer, *RTResponse);
+        writer.endObject();
     }
     break;
 
     case ECSMSDllMsgType::RT_DF_START:
     {
         const SSmsRealtimeMsg::SStartV2* RTResponse = (SSmsRealtimeMsg::SStartV2*)data;
-        unsigned int i;
-
-        jsonObj["RTDFStart"]["taskId"] = RTResponse->taskId;
-        jsonObj["RTDFStart"]["numBands"] = RTResponse->numBands;
 
-        for (i = 0; i < RTResponse->numBands; i++)
+        writer.key("RTDFStart").beginObject();
+        writer.field("taskId", RTResponse->taskId);
+        writer.field("numBands", RTResponse->numBands);
+        writer.key("band").beginArray();
+        for (unsigned int i = 0; i < RTResponse->numBands; i++)
         {
-            json bandObj;
-            bandObj["binSize"] = RTResponse->band[i].chanSize.internal;
-            bandObj["startFreq"] = RTResponse->band[i].firstChanFreq.internal;
-            bandObj["numChan"] = RTResponse->band[i].numChan;
-            jsonObj["RTDFStart"]["band"].push_back(bandObj);
+            writer.beginObject();
+            writer.field("binSize", RTResponse->band[i].chanSize.internal);
+            writer.field("startFreq", RTResponse->band[i].firstChanFreq.internal);
+            writer.field("numChan", RTResponse->band[i].numChan);
+            writer.endObject();
         }
+        writer.endArray();
+        writer.endObject();
     }
     break;
 
     case ECSMSDllMsgType::RT_DF_STARTV1:
     {
         const SSmsRealtimeMsg::SStart* RTResponse = (SSmsRealtimeMsg::SStart*)data;
-        unsigned int i;
 
-        jsonObj["RTDFStart"]["taskId"] = RTResponse->taskId;
-        jsonObj["RTDFStart"]["numBands"] = RTResponse->numBands;
-        jsonObj["RTDFStart"]["MAX_OCCBANDS"] = RTResponse->MAX_OCCBANDS;
-        for (i = 0; i < RTResponse->numBands; i++)
+        writer.key("RTDFStart").beginObject();
+        writer.field("taskId", RTResponse->taskId);
+        writer.field("numBands", RTResponse->numBands);
+        writer.field("MAX_OCCBANDS", RTResponse->MAX_OCCBANDS);
+        writer.key("band").beginArray();
+        for (unsigned int i = 0; i < RTResponse->numBands; i++)
         {
-            json bandObj;
-            bandObj["binSize"]["internal"] = RTResponse->chanSize[i];
-            bandObj["startFreq"]["internal"] = RTResponse->firstChanFreq[i];
-            bandObj["numChan"] = RTResponse->numChan[i];
-            jsonObj["RTDFStart"]["band"].push_back(bandObj);
+            writer.beginObject();
+            writer.key("binSize").beginObject().field("internal", RTResponse->chanSize[i]).endObject();
+            writer.key("startFreq").beginObject().field("internal", RTResponse->firstChanFreq[i]).endObject();
+            writer.field("numChan", RTResponse->numChan[i]);
+            writer.endObject();
         }
+        writer.endArray();
+        writer.endObject();
     }
     break;
 
     case ECSMSDllMsgType::RT_DF_STOP:
     {
         const SSmsRealtimeMsg::SStop* RTResponse = (SSmsRealtimeMsg::SStop*)data;
-        jsonObj["SStop"]["taskId"] = RTResponse->taskId;
+
+        writer.key("SStop").beginObject();
+        writer.field("taskId", RTResponse->taskId);
+        writer.endObject();
     }
     break;
 
     case ECSMSDllMsgType::RT_DF_DATAV1:
     {
         const SSmsRealtimeMsg::SDfData* RTResponse = (SSmsRealtimeMsg::SDfData*)data;
-        jsonObj["SDfData"]["bandIndex"] = RTResponse->bandIndex;
-        jsonObj["SDfData"]["chanData"]["azimData"] = RTResponse->chanData->azimData;
-        jsonObj["SDfData"]["chanData"]["specData"] = RTResponse->chanData->specData;
-        jsonObj["SDfData"]["chanSize"] = RTResponse->chanSize;
-        jsonObj["SDfData"]["firstChanFreq"] = RTResponse->firstChanFreq;
-        jsonObj["SDfData"]["noiseFloor"] = RTResponse->noiseFloor;
-        jsonObj["SDfData"]["numChan"] = RTResponse->numChan;
-        jsonObj["SDfData"]["taskId"] = RTResponse->taskId;
+
+        writer.key("SDfData").beginObject();
+        writer.field("bandIndex", RTResponse->bandIndex);
+        writer.key("chanData").beginObject();
+        writer.field("azimData", RTResponse->chanData->azimData);
+        writer.field("specData", RTResponse->chanData->specData);
+        writer.endObject();
+        writer.field("chanSize", RTResponse->chanSize);
+        writer.field("firstChanFreq", RTResponse->firstChanFreq);
+        writer.field("noiseFloor", RTResponse->noiseFloor);
+        writer.field("numChan", RTResponse->numChan);
+        writer.field("taskId", RTResponse->taskId);
+        writer.endObject();
     }
     break;
 
     case ECSMSDllMsgType::RT_DF_DATAV2:
     {
         const SSmsRealtimeMsg::SDfDataV2* RTResponse = (SSmsRealtimeMsg::SDfDataV2*)data;
-        jsonObj["SDfDataV2"]["bandIndex"] = RTResponse->bandIndex;
-        jsonObj["SDfDataV2"]["chanData"]["azimData"] = RTResponse->chanData->azimData;
-        jsonObj["SDfDataV2"]["chanData"]["specData"] = RTResponse->chanData->specData;
-        jsonObj["SDfDataV2"]["chanSize"] = RTResponse->chanSize;
-        jsonObj["SDfDataV2"]["firstChanFreq"] = RTResponse->firstChanFreq;
-        jsonObj["SDfDataV2"]["noiseFloor"] = RTResponse->noiseFloor;
-        jsonObj["SDfDataV2"]["numChan"] = RTResponse->numChan;
-        jsonObj["SDfDataV2"]["taskId"] = RTResponse->taskId;
-        jsonObj["SDfDataV2"]["horizPol"] = RTResponse->horizPol;
+
+        writer.key("SDfDataV2").beginObject();
+        writer.field("bandIndex", RTResponse->bandIndex);
+        writer.key("chanData").beginObject();
+        writer.field("azimData", RTResponse->chanData->azimData);
+        writer.field("specData", RTResponse->chanData->specData);
+        writer.endObject();
+        writer.field("chanSize", RTResponse->chanSize);
+        writer.field("firstChanFreq", RTResponse->firstChanFreq);
+        writer.field("noiseFloor", RTResponse->noiseFloor);
+        writer.field("numChan", RTResponse->numChan);
+        writer.field("taskId", RTResponse->taskId);
+        writer.field("horizPol", RTResponse->horizPol);
+        writer.endObject();
     }
     break;
 
     case ECSMSDllMsgType::RT_DF_DATA:
     {
         const SSmsRealtimeMsg::SDfDataV3* RTResponse = (SSmsRealtimeMsg::SDfDataV3*)data;
-        jsonObj["SDfDataV3"]["bandIndex"] = RTResponse->bandIndex;
-        jsonObj["SDfDataV3"]["chanData"]["azimData"] = RTResponse->chanData->azimData;
-        jsonObj["SDfDataV3"]["chanData"]["specData"] = RTResponse->chanData->specData;
-        jsonObj["SDfDataV3"]["chanSize"]["internal"] = RTResponse->chanSize.internal;
-        jsonObj["SDfDataV3"]["firstChanFreq"]["internal"] = RTResponse->firstChanFreq.internal;
-        jsonObj["SDfDataV3"]["noiseFloor"] = RTResponse->noiseFloor;
-        jsonObj["SDfDataV3"]["numChan"] = RTResponse->numChan;
-        jsonObj["SDfDataV3"]["taskId"] = RTResponse->taskId;
-        jsonObj["SDfDataV3"]["horizPol"] = RTResponse->horizPol;
+
+        writer.key("SDfDataV3").beginObject();
+        writer.field("bandIndex", RTResponse->bandIndex);
+        writer.key("chanData").beginObject();
+        writer.field("azimData", RTResponse->chanData->azimData);
+        writer.field("specData", RTResponse->chanData->specData);
+        writer.endObject();
+        writer.key("chanSize").beginObject().field("internal", RTResponse->chanSize.internal).endObject();
+        writer.key("firstChanFreq").beginObject().field("internal", RTResponse->firstChanFreq.internal).endObject();
+        writer.field("noiseFloor", RTResponse->noiseFloor);
+        writer.field("numChan", RTResponse->numChan);
+        writer.field("taskId", RTResponse->taskId);
+        writer.field("horizPol", RTResponse->horizPol);
+        writer.endObject();
     }
     break;
 
     case ECSMSDllMsgType::RT_IQ_DATA:
     {
         SSmsRealtimeMsg::SIqDataV4* RTResponse = (SSmsRealtimeMsg::SIqDataV4*)data; // v5 should be sent to rds app
-        jsonObj["SIqDataV4"]["actualBW"]["internal"] = RTResponse->actualBW.internal;
-        jsonObj["SIqDataV4"]["actualSampleRate"] = RTResponse->actualSampleRate;
-        jsonObj["SIqDataV4"]["dataType"] = RTResponse->dataType;
-        jsonObj["SIqDataV4"]["ddcChannel"] = RTResponse->ddcChannel;
-        jsonObj["SIqDataV4"]["EOS"] = RTResponse->EOS;
-        jsonObj["SIqDataV4"]["freq"]["internal"] = RTResponse->freq.internal;
-        jsonObj["SIqDataV4"]["inputPort"] = RTResponse->inputPort;
-        jsonObj["SIqDataV4"]["MAX_SAMPLES"] = RTResponse->MAX_SAMPLES;
-        jsonObj["SIqDataV4"]["numSamples"] = RTResponse->numSamples;
-        jsonObj["SIqDataV4"]["rxAtten"] = RTResponse->rxAtten;
-        jsonObj["SIqDataV4"]["sampleOffset"] = RTResponse->sampleOffset;
-        jsonObj["SIqDataV4"]["scaleFactor"] = RTResponse->scaleFactor;
-        jsonObj["SIqDataV4"]["seqNumber"] = RTResponse->seqNumber;
-        jsonObj["SIqDataV4"]["SIq"]["samplesFloat32"]["im"] = RTResponse->SIq.samplesFloat32->im;
-        jsonObj["SIqDataV4"]["SIq"]["samplesFloat32"]["re"] = RTResponse->SIq.samplesFloat32->re;
-        jsonObj["SIqDataV4"]["SIq"]["samplesInt16"]["im"] = RTResponse->SIq.samplesInt16->im;
-        jsonObj["SIqDataV4"]["SIq"]["samplesInt16"]["re"] = RTResponse->SIq.samplesInt16->re;
-        jsonObj["SIqDataV4"]["SIq"]["samplesInt32"]["im"] = RTResponse->SIq.samplesInt32->im;
-        jsonObj["SIqDataV4"]["SIq"]["samplesInt32"]["re"] = RTResponse->SIq.samplesInt32->re;
-        jsonObj["SIqDataV4"]["streamID"] = RTResponse->streamID;
-        jsonObj["SIqDataV4"]["streamStartTime"]["timestamp"] = RTResponse->streamStartTime.timestamp;
+
+        // Samples beyond the capacity of the member selected by dataType are not part of the block
+        size_t numSamples = (std::min)(static_cast<size_t>(RTResponse->numSamples), iqSampleCapacity(*RTResponse));
+
+        writer.key("SIqDataV4").beginObject();
+        writer.key("actualBW").beginObject().field("internal", RTResponse->actualBW.internal).endObject();
+        writer.field("actualSampleRate", RTResponse->actualSampleRate);
+        writer.field("dataType", RTResponse->dataType);
+        writer.field("ddcChannel", RTResponse->ddcChannel);
+        writer.field("EOS", RTResponse->EOS);
+        writer.key("freq").beginObject().field("internal", RTResponse->freq.internal).endObject();
+        writer.field("inputPort", RTResponse->inputPort);
+        writer.field("numSamples", (unsigned long)numSamples);
+        writer.field("rxAtten", RTResponse->rxAtten);
+        writer.field("sampleOffset", RTResponse->sampleOffset);
+        writer.field("scaleFactor", RTResponse->scaleFactor);
+        writer.field("seqNumber", RTResponse->seqNumber);
+        writer.field("dropped", iqBlocksDropped(RTResponse->streamID, RTResponse->seqNumber, RTResponse->EOS));
+        writer.field("streamID", RTResponse->streamID);
+        writer.key("streamStartTime").beginObject().field("timestamp", RTResponse->streamStartTime.timestamp).endObject();
+        switch (static_cast<unsigned long>(RTResponse->dataType))
+        {
+        case IqDataType::INT16:
+            writeIqSamples(writer, RTResponse->SIq.samplesInt16, numSamples);
+            break;
+        case IqDataType::INT32:
+            writeIqSamples(writer, RTResponse->SIq.samplesInt32, numSamples);
+            break;
+        case IqDataType::FLOAT32:
+            writeIqSamples(writer, RTResponse->SIq.samplesFloat32, numSamples);
+            break;
+        default:
+            writer.field("error", "Unknown IQ data type " + std::to_string(static_cast<unsigned long>(RTResponse->dataType)));
+            break;
+        }
+        writer.endObject();
     }
     break;
 
     default:
-        jsonObj["error"] = std::string("Unexpected ProcessRealTimeData type ") + ECSMSDllMsgTypeToString(respType);
+        writer.field("error", std::string("Unexpected ProcessRealTimeData type ") + ECSMSDllMsgTypeToString(respType));
         break;
     }
-    return jsonObj;
+
+    writer.endObject();
+}
+
+// ----------------------------------------------------------------------
+/** @brief Check if the response type closes the request, i.e. no further responses are expected for the same request ID
+ *
+ * @param respType Type of the response message
+ * @return bool True if the response is the only one expected for the request
+ * @throws NO EXCEPTION HANDLING
+**/
+bool isFinalResponse(ECSMSDllMsgType respType)
+{
+    switch (respType)
+    {
+    case ECSMSDllMsgType::GET_PAN:
+    case ECSMSDllMsgType::SET_PAN_PARAMS:
+    case ECSMSDllMsgType::SET_AUDIO_PARAMS:
+    case ECSMSDllMsgType::FREE_AUDIO_CHANNEL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// ----------------------------------------------------------------------
+/** @brief Writer used by the callbacks to convert responses, one for each DLL thread
+ *
+ * The buffer is cleared on each call and its allocation is reused for the next response.
+ *
+ * @return edll::JsonWriter& Empty writer for the calling thread
+ * @throws NO EXCEPTION HANDLING
+**/
+edll::JsonWriter& responseWriter()
+{
+    static thread_local edll::JsonWriter writer;
+    writer.clear();
+    return writer;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Add the client session and client ID from the originating request to the response
+ *
+ * Log the latency between request submission and the first response.
+ * Add the trace timestamps used to record the response latency when sent to the client.
+ *
+ * @param responseJson JSON object with the response to be sent to the client
+ * @param entry Request registry entry associated with the response, or nullptr if not available
+ * @param callbackNs Trace timestamp of the callback entry
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void tagResponse(json& responseJson, const RequestEntry* entry, long long callbackNs)
+{
+    long long convertedNs = edll::traceNow();
+    latencyTracer.record(edll::commandCodeOf(responseJson), edll::Stage::CONVERSION, callbackNs, convertedNs);
+
+    json trace = json::array({ callbackNs, convertedNs });
+
+    if (entry != nullptr) {
+        responseJson[edll::DefaultConfig::Service::TaskKeys::SessionId::VALUE] = entry->sessionId;
+        responseJson[clientIdKey] = entry->clientId;
+
+        if (!entry->answered) {
+            auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - entry->submitTime);
+            loggerPtr->info("[{}] first response after {:.3f} ms", entry->commandName, latency.count() / 1000.0);
+            trace.push_back(entry->recvTraceNs);
+        }
+    }
+
+    responseJson[edll::TRACE_KEY] = std::move(trace);
+}
+
+// ----------------------------------------------------------------------
+/** @brief Merge a chunk of occupancy results into the full band and send the band if it is due
+ *
+ * Used instead of the conversion of each chunk when the band assembly is enabled.
+ *
+ * @param serverId ID of the server instance
+ * @param respType Type of the response message
+ * @param requestID Request ID associated with the message
+ * @param data Pointer to the response data
+ * @param callbackNs Trace timestamp of the callback entry
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void processBandChunk(unsigned long serverId, ECSMSDllMsgType respType, unsigned long requestID, SEquipCtrlMsg::UBody* data, long long callbackNs)
+{
+    RequestEntry entry;
+    if (!requestRegistry.resolve(requestID, entry)) {
+        loggerPtr->debug("processBandChunk: requestID={} not found in request registry", requestID);
+        return;
+    }
+    if (!entry.answered) {
+        admissionControl.release(entry.sessionId, entry.commandCode);
+    }
+
+    std::string body = channelMap.update(requestID, respType, entry, data);
+    if (body.empty()) {
+        return;
+    }
+
+    json responseJson;
+    responseJson[edll::BODY_KEY] = std::move(body);
+    responseJson[edll::DefaultConfig::Service::TaskKeys::CommandCode::VALUE] = int(respType);
+    responseJson[edll::DefaultConfig::Service::TaskKeys::DLLId::VALUE] = serverId;
+    tagResponse(responseJson, &entry, callbackNs);
+
+    response.push(responseJson, "Scorpio::processBandChunk");
+}
+
+// ----------------------------------------------------------------------
+/** @brief Bytes of a data callback body read by the service for its response type, as cast by the converters
+ *
+ * Only the used bins of a pan response are counted.
+ *
+ * @param respType Type of the response message
+ * @param data Pointer to the response data
+ * @return size_t Bytes to be captured, zero for response types not read by the service
+ * @throws NO EXCEPTION HANDLING
+**/
+size_t dataBodySize(ECSMSDllMsgType respType, const SEquipCtrlMsg::UBody* data)
+{
+    switch (respType)
+    {
+    case ECSMSDllMsgType::GET_BIST:
+    case ECSMSDllMsgType::GET_BIST_RESULT:
+    case ECSMSDllMsgType::GET_DIAGNOSTICS:
+        return sizeof(SEquipCtrlMsg::SGetBistResp);
+    case ECSMSDllMsgType::GET_ANT_LIST_INFO:
+        return sizeof(SEquipCtrlMsg::SAntInfoListResp);
+    case ECSMSDllMsgType::OCC_MSGLEN_DIST_RESPONSE:
+        return sizeof(SEquipCtrlMsg::SMsgLengthDistributionResp);
+    case ECSMSDllMsgType::OCC_SPECTRUM_RESPONSE:
+    case ECSMSDllMsgType::OCC_CHANNEL_RESULT:
+    case ECSMSDllMsgType::OCC_EFLD_CHANNEL_RESULT:
+    case ECSMSDllMsgType::OCC_TIMEOFDAY_RESULT:
+    case ECSMSDllMsgType::OCC_MSGLEN_CHANNEL_RESULT:
+    case ECSMSDllMsgType::OCC_EFLD_TIMEOFDAY_RESULT:
+    case ECSMSDllMsgType::AVD_OCC_CHANNEL_RESULT:
+        return sizeof(SEquipCtrlMsg::SOccResult);
+    case ECSMSDllMsgType::OCC_STATE_RESPONSE:
+    case ECSMSDllMsgType::OCC_SOLICIT_STATE_RESPONSE:
+    case ECSMSDllMsgType::OCCDF_STATE_RESPONSE:
+    case ECSMSDllMsgType::OCCDF_SOLICIT_STATE_RESPONSE:
+    case ECSMSDllMsgType::AVD_STATE_RESPONSE:
+    case ECSMSDllMsgType::AVD_SOLICIT_STATE_RESPONSE:
+        return sizeof(SEquipCtrlMsg::SStateResp);
+    case ECSMSDllMsgType::OCC_FREQ_VS_CHANNEL:
+    case ECSMSDllMsgType::OCCDF_FREQ_VS_CHANNEL:
+    case ECSMSDllMsgType::AVD_FREQ_VS_CHANNEL:
+        return sizeof(SEquipCtrlMsg::SFrequencyVsChannelResp);
+    case ECSMSDllMsgType::OCC_STATUS:
+    case ECSMSDllMsgType::OCCDF_STATUS:
+    case ECSMSDllMsgType::AVD_STATUS:
+        return sizeof(SEquipCtrlMsg::SEquipTaskStatusResp);
+    case ECSMSDllMsgType::OCCDF_SCANDF_VS_CHANNEL:
+        return sizeof(SEquipCtrlMsg::SScanDfVsChannelResp);
+    case ECSMSDllMsgType::AVD_FREQ_MEAS:
+    case ECSMSDllMsgType::AVD_BW_MEAS:
+        return sizeof(SEquipCtrlMsg::SAvdMeasureResult);
+    case ECSMSDllMsgType::GET_MEAS:
+        return sizeof(SEquipCtrlMsg::SGetMeasResp);
+    case ECSMSDllMsgType::VALIDATE_MEAS:
+        return sizeof(SEquipCtrlMsg::SValidateMeasurementResp);
+    case ECSMSDllMsgType::SET_PAN_PARAMS:
+    case ECSMSDllMsgType::FREE_AUDIO_CHANNEL:
+        return sizeof(SEquipCtrlMsg::SGenericResp);
+    case ECSMSDllMsgType::SET_AUDIO_PARAMS:
+        return sizeof(SEquipCtrlMsg::SAudioParamsResp);
+    case ECSMSDllMsgType::GET_PAN:
+    {
+        const SEquipCtrlMsg::SGetPanResp* PanResponse = (const SEquipCtrlMsg::SGetPanResp*)data;
+        size_t numBins = (std::min)(static_cast<size_t>(PanResponse->numBins), sizeof(PanResponse->binData) / sizeof(PanResponse->binData[0]));
+        return capturedBodySize(*PanResponse, PanResponse->binData + numBins);
+    }
+    default:
+        return 0;
+    }
+}
+
+// ----------------------------------------------------------------------
+/** @brief Bytes of a realtime callback body read by the service for its response type, as cast by the converters
+ *
+ * Only the used channels of a spectrum and the samples of an IQ block, within the member selected by its data type, are counted.
+ *
+ * @param respType Type of the response message
+ * @param data Pointer to the response data
+ * @return size_t Bytes to be captured, zero for response types not read by the service
+ * @throws NO EXCEPTION HANDLING
+**/
+size_t realtimeBodySize(ECSMSDllMsgType respType, const SSmsRealtimeMsg::UBody* data)
+{
+    switch (respType)
+    {
+    case ECSMSDllMsgType::RT_SPECTRUM_START:
+    case ECSMSDllMsgType::RT_DF_START:
+        return sizeof(SSmsRealtimeMsg::SStartV2);
+    case ECSMSDllMsgType::RT_DF_STARTV1:
+        return sizeof(SSmsRealtimeMsg::SStart);
+    case ECSMSDllMsgType::RT_SPECTRUM_STOP:
+    case ECSMSDllMsgType::RT_DF_STOP:
+        return sizeof(SSmsRealtimeMsg::SStop);
+    case ECSMSDllMsgType::RT_SPECTRUM_V1RESPONSE:
+    {
+        const SSmsRealtimeMsg::SSpectrum* RTResponse = (const SSmsRealtimeMsg::SSpectrum*)data;
+        size_t numChan = (std::min)(static_cast<size_t>(RTResponse->numChan), sizeof(RTResponse->chanData) / sizeof(RTResponse->chanData[0]));
+        return capturedBodySize(*RTResponse, RTResponse->chanData + numChan);
+    }
+    case ECSMSDllMsgType::RT_SPECTRUM_V2RESPONSE:
+    {
+        const SSmsRealtimeMsg::SSpectrumV2* RTResponse = (const SSmsRealtimeMsg::SSpectrumV2*)data;
+        size_t numChan = (std::min)(static_cast<size_t>(RTResponse->numChan), sizeof(RTResponse->chanData) / sizeof(RTResponse->chanData[0]));
+        return capturedBodySize(*RTResponse, RTResponse->chanData + numChan);
+    }
+    case ECSMSDllMsgType::RT_SPECTRUM_RESPONSE:
+    {
+        const SSmsRealtimeMsg::SSpectrumV3* RTResponse = (const SSmsRealtimeMsg::SSpectrumV3*)data;
+        size_t numChan = (std::min)(static_cast<size_t>(RTResponse->numChan), sizeof(RTResponse->chanData) / sizeof(RTResponse->chanData[0]));
+        return capturedBodySize(*RTResponse, RTResponse->chanData + numChan);
+    }
+    case ECSMSDllMsgType::RT_DF_DATAV1:
+        return sizeof(SSmsRealtimeMsg::SDfData);
+    case ECSMSDllMsgType::RT_DF_DATAV2:
+        return sizeof(SSmsRealtimeMsg::SDfDataV2);
+    case ECSMSDllMsgType::RT_DF_DATA:
+        return sizeof(SSmsRealtimeMsg::SDfDataV3);
+    case ECSMSDllMsgType::RT_IQ_DATA:
+    {
+        const SSmsRealtimeMsg::SIqDataV4* RTResponse = (const SSmsRealtimeMsg::SIqDataV4*)data;
+        size_t numSamples = (std::min)(static_cast<size_t>(RTResponse->numSamples), iqSampleCapacity(*RTResponse));
+        switch (static_cast<unsigned long>(RTResponse->dataType))
+        {
+        case IqDataType::INT16:
+            return capturedBodySize(*RTResponse, RTResponse->SIq.samplesInt16 + numSamples);
+        case IqDataType::INT32:
+            return capturedBodySize(*RTResponse, RTResponse->SIq.samplesInt32 + numSamples);
+        case IqDataType::FLOAT32:
+            return capturedBodySize(*RTResponse, RTResponse->SIq.samplesFloat32 + numSamples);
+        default:
+            return capturedBodySize(*RTResponse, &RTResponse->SIq);
+        }
+    }
+    default:
+        return 0;
+    }
 }
 
 // ----------------------------------------------------------------------
@@ -1078,9 +1445,26 @@ void OnDataFunc(_In_  unsigned long serverId, _In_ ECSMSDllMsgType respType, _In
 {
 	const std::string logSource = "Scorpio::OnDataFunc";
 
+    long long callbackNs = edll::traceNow();
+    if (callbackCapture.isEnabled()) {
+        callbackCapture.capture(CallbackKind::DATA, serverId, static_cast<unsigned long>(respType), sourceAddr, requestID, data, data == nullptr ? 0 : dataBodySize(respType, data));
+    }
+    serviceMetrics.count(ServiceMetrics::CodeCounter::CALLBACK, respType);
+
     loggerPtr->debug("OnDataFunc: serverId={}, respType={}, sourceAddr={}, requestID={}", serverId, static_cast<int>(respType), sourceAddr, requestID);
 
+    // Chunks merged into full bands are not converted nor sent one by one
+    if (channelMap.replacesChunks(respType)) {
+        processBandChunk(serverId, respType, requestID, data, callbackNs);
+        return;
+    }
+
+    // Resolved before the conversion, which follows the output options of the request
+    RequestEntry entry;
+    bool hasOwner = requestRegistry.resolve(requestID, entry);
+
     json responseJson = {};
+    edll::JsonWriter& writer = responseWriter();
 
     switch (respType)
     {
@@ -1110,7 +1494,7 @@ void OnDataFunc(_In_  unsigned long serverId, _In_ ECSMSDllMsgType respType, _In
     case ECSMSDllMsgType::OCCDF_STATUS:
     case ECSMSDllMsgType::OCCDF_STATE_RESPONSE:
     case ECSMSDllMsgType::OCCDF_SOLICIT_STATE_RESPONSE:
-        responseJson = processOccupancyDFResponse(respType, data);
+        processOccupancyDFResponse(respType, data, writer);
         break;
     case ECSMSDllMsgType::AVD_FREQ_VS_CHANNEL:
     case ECSMSDllMsgType::AVD_OCC_CHANNEL_RESULT:
@@ -1119,7 +1503,7 @@ void OnDataFunc(_In_  unsigned long serverId, _In_ ECSMSDllMsgType respType, _In
     case ECSMSDllMsgType::AVD_SOLICIT_STATE_RESPONSE:
     case ECSMSDllMsgType::AVD_STATE_RESPONSE:
     case ECSMSDllMsgType::AVD_STATUS:
-        responseJson = processAutoViolateResponse(respType, data);
+        processAutoViolateResponse(respType, data, writer);
         break;
     case ECSMSDllMsgType::GET_MEAS:
     case ECSMSDllMsgType::VALIDATE_MEAS:
@@ -1131,7 +1515,10 @@ void OnDataFunc(_In_  unsigned long serverId, _In_ ECSMSDllMsgType respType, _In
         responseJson = processDemodCtrlResponse(respType, data);
         break;
     case ECSMSDllMsgType::GET_PAN:
-        responseJson = processPanResponse(respType, data);
+        storePanSweep(data);
+        tracePanSweep(data);
+        waterfallPanSweep(data);
+        processPanResponse(respType, data, writer, hasOwner ? entry.output : SpectrumOutput());
         break;
     case ECSMSDllMsgType::GET_DM:
 
@@ -1141,12 +1528,36 @@ void OnDataFunc(_In_  unsigned long serverId, _In_ ECSMSDllMsgType respType, _In
         break;
     }
 
+    if (!writer.empty()) {
+        responseJson[edll::BODY_KEY] = writer.str();
+    }
     responseJson[edll::DefaultConfig::Service::TaskKeys::CommandCode::VALUE] = int(respType);
 	responseJson[edll::DefaultConfig::Service::TaskKeys::DLLId::VALUE] = serverId;
 
+    if (hasOwner) {
+        tagResponse(responseJson, &entry, callbackNs);
+        if (!entry.answered) {
+            admissionControl.release(entry.sessionId, entry.commandCode);
+        }
+        channelMap.update(requestID, respType, entry, data);
+        if (isFinalResponse(respType)) {
+            requestRegistry.erase(requestID);
+        }
+    }
+    else {
+        tagResponse(responseJson, nullptr, callbackNs);
+        loggerPtr->debug("OnDataFunc: requestID={} not found in request registry", requestID);
+    }
+
     response.push(responseJson, logSource);
 
-	loggerPtr->trace("OnDataFunc: responseJson={}", responseJson.dump());
+    if (respType == ECSMSDllMsgType::GET_PAN) {
+        onPanStreamResponse(requestID);
+    }
+
+    if (loggerPtr->should_log(spdlog::level::trace)) {
+        loggerPtr->trace("OnDataFunc: responseJson={}", responseJson.dump());
+    }
 }
 
 // ----------------------------------------------------------------------
@@ -1161,6 +1572,9 @@ void OnErrorFunc(_In_  unsigned long serverId, _In_ const std::wstring& errorMsg
 {
 	const std::string logSource = "Scorpio::OnErrorFunc";
 
+    callbackCapture.captureError(serverId, errorMsg);
+    serviceMetrics.count(ServiceMetrics::CodeCounter::CALLBACK, edll::DefaultConfig::Service::TaskKeys::CommandCode::INIT_VALUE);
+
     json errorJson = {};
 
     std::string errorMsgStr(errorMsg.begin(), errorMsg.end());
@@ -1186,18 +1600,87 @@ void OnErrorFunc(_In_  unsigned long serverId, _In_ const std::wstring& errorMsg
 void OnRealTimeDataFunc(_In_  unsigned long serverId, _In_ ECSMSDllMsgType respType, _In_ SSmsRealtimeMsg::UBody* data)
 {
 	const std::string logSource = "Scorpio::OnRealTimeDataFunc";
-    
+
+    long long callbackNs = edll::traceNow();
+    if (callbackCapture.isEnabled()) {
+        callbackCapture.capture(CallbackKind::REALTIME, serverId, static_cast<unsigned long>(respType), 0, 0, data, data == nullptr ? 0 : realtimeBodySize(respType, data));
+    }
+    serviceMetrics.count(ServiceMetrics::CodeCounter::CALLBACK, respType);
+
+    if (respType == ECSMSDllMsgType::RT_IQ_DATA) {
+        recordIqData(data);
+    }
+    else if (respType == ECSMSDllMsgType::RT_SPECTRUM_V2RESPONSE) {
+        storeSpectrum(respType, *(const SSmsRealtimeMsg::SSpectrumV2*)data);
+    }
+    else if (respType == ECSMSDllMsgType::RT_SPECTRUM_RESPONSE) {
+        storeSpectrum(respType, *(const SSmsRealtimeMsg::SSpectrumV3*)data);
+    }
+
     json responseJson = {};
+    edll::JsonWriter& writer = responseWriter();
 
-    responseJson = ProcessRealTimeData(respType, data);
+    ProcessRealTimeData(respType, data, writer);
 
+    responseJson[edll::BODY_KEY] = writer.str();
     responseJson[edll::DefaultConfig::Service::TaskKeys::CommandCode::VALUE] = int(respType);
     responseJson[edll::DefaultConfig::Service::TaskKeys::DLLId::VALUE] = serverId;
 
-	//TODO Map client IP and client ID from the request and add to the responseJson
+    RequestEntry entry;
+    bool hasOwner = requestRegistry.resolveRealTime(entry);
+    tagResponse(responseJson, hasOwner ? &entry : nullptr, callbackNs);
 
 	response.push(responseJson, logSource);
 
     loggerPtr->debug("OnRealTimeDataFunc: serverId={}, respType={}", serverId, static_cast<int>(respType));
-	loggerPtr->trace("OnRealTimeDataFunc: responseJson={}", responseJson.dump());
-}
\ No newline at end of file
+    if (loggerPtr->should_log(spdlog::level::trace)) {
+        loggerPtr->trace("OnRealTimeDataFunc: responseJson={}", responseJson.dump());
+    }
+}
+
+// ----------------------------------------------------------------------
+/** @brief Feed a captured callback back into the Scorpio API callbacks
+ *
+ * Bodies are rebuilt in zeroed buffers with the size of the DLL body types, as the DLL hands them to the callbacks.
+ *
+ * @param record Captured callback
+ * @param body Pointer to the stored body, or nullptr if the callback received a null body
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void replayCallback(const CapturedCallback& record, const char* body)
+{
+    static ReplayBody dataBody(sizeof(SEquipCtrlMsg::UBody));
+    static ReplayBody realtimeBody(sizeof(SSmsRealtimeMsg::UBody));
+
+    switch (static_cast<CallbackKind>(record.kind)) {
+    case CallbackKind::DATA: {
+        void* replayed = body == nullptr ? nullptr : dataBody.fill(body, record.size);
+        if (body != nullptr && replayed == nullptr) {
+            break;
+        }
+        OnDataFunc(record.serverId, static_cast<ECSMSDllMsgType>(record.respType), record.sourceAddr, record.requestID, static_cast<SEquipCtrlMsg::UBody*>(replayed));
+        return;
+    }
+    case CallbackKind::REALTIME: {
+        void* replayed = body == nullptr ? nullptr : realtimeBody.fill(body, record.size);
+        if (body != nullptr && replayed == nullptr) {
+            break;
+        }
+        OnRealTimeDataFunc(record.serverId, static_cast<ECSMSDllMsgType>(record.respType), static_cast<SSmsRealtimeMsg::UBody*>(replayed));
+        return;
+    }
+    case CallbackKind::ERROR_MESSAGE: {
+        std::wstring errorMsg(record.size / sizeof(uint16_t), L'\0');
+        for (size_t i = 0; i < errorMsg.size(); i++) {
+            uint16_t unit;
+            std::memcpy(&unit, body + i * sizeof(uint16_t), sizeof(uint16_t));
+            errorMsg[i] = static_cast<wchar_t>(unit);
+        }
+        OnErrorFunc(record.serverId, errorMsg);
+        return;
+    }
+    }
+
+    loggerPtr->warn("Skipping captured callback of kind {} and {} bytes not matching the DLL body types", record.kind, record.size);
+}
@@ -0,0 +1,177 @@
+/**
+ * @file etherDLLSchema.hpp
+ * @brief Validation limits and compiled validation rules of the Scorpio API requests
+ *
+ * Kept apart from etherDLLValidation.hpp, without dependencies on the Scorpio API,
+ * so that the rules can be used by tools built outside the service project, such as the benchmarks in test/benchmark.
+ *
+ * @author fslobao
+ * @date 2025-10-04
+ * @version 1.0
+ *
+ * @note Requires C++14 or later
+ * @note Uses nlohmann/json library for JSON parsing
+ *
+ * Dependencies:
+ * - nlohmann/json.hpp
+ *
+ **/
+ // ----------------------------------------------------------------------
+#pragma once
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+#include "EtherDLLUtils.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+
+// For convenience
+using json = nlohmann::json;
+
+// Validation Constants
+const double MIN_FREQ = 20e6;      // Minimum frequency in Hz
+const double MAX_FREQ = 3e9;       // Maximum frequency in Hz
+const double MIN_BANDWIDTH = 500;  // Minimum bandwidth in Hz
+const double MAX_BANDWIDTH = 80e6; // Maximum bandwidth in Hz
+const int MIN_DURATION = 1;        // Minimum duration in seconds
+const int MAX_DURATION = 3600;     // Maximum duration in seconds
+const int MIN_ANT = 1;             // Minimum antenna number
+const int MAX_ANT = 16;            // Maximum antenna number
+const int MIN_DF_CONFIDENCE = 1;      // Minimum DF confidence level
+const int MAX_DF_CONFIDENCE = 360;    // Maximum DF confidence level
+const int MIN_AZIMUTHS = 1;        // Minimum number of azimuth
+const int MAX_AZIMUTHS = 720;      // Maximum number of azimuth
+const int MIN_RECORD_HOLDOFF = 0;  // Minimum record holdoff time
+const int MAX_RECORD_HOLDOFF = 1024; // Maximum record holdoff time
+const int MIN_SCAN_DF_THRESHOLD = 0; // Minimum scan DF threshold
+const int MAX_SCAN_DF_THRESHOLD = 256; // Maximum scan DF threshold
+const int MIN_NUM_BANDS = 1;       // Minimum number of bands
+const int MAX_NUM_BANDS = 255;   // Maximum number of bands
+const int MIN_STORAGE_TIME = 1;    // Minimum storage time in ms
+const int MAX_STORAGE_TIME = 3600000; // Maximum storage time in ms
+const int MIN_MEASUREMENT_TIME = 100; // Minimum measurement time in ms
+const int MAX_MEASUREMENT_TIME = 3600000; // Maximum measurement time in ms
+const int MIN_BFO = 0;             // Minimum BFO value
+const int MAX_BFO = 1024;          // Maximum BFO value
+const int MIN_DET_MODE = 0;        // Minimum detection mode
+const int MAX_DET_MODE = 256;      // Maximum detection mode
+const int MIN_RCVD_ATTEN = 0;      // Minimum receiver attenuation in dB
+const int MAX_RCVD_ATTEN = 255;     // Maximum receiver attenuation in dB
+const int MIN_AGC_TIME = 0;        // Minimum AGC time in ms
+const int MAX_AGC_TIME = 3600000;  // Maximum AGC time in
+const int MIN_QUERY_BINS = 1;      // Minimum number of bins of a sweep query trace
+const int MAX_QUERY_BINS = 65536;  // Maximum number of bins of a sweep query trace
+const int MIN_OUTPUT_BINS = 0;     // Minimum number of spectrum bins sent to the client, zero to send every bin
+const int MAX_OUTPUT_BINS = 65535; // Maximum number of spectrum bins sent to the client
+const int MIN_NOISE_PERCENTILE = 0;   // Minimum percentile of the spectrum levels taken as the noise floor
+const int MAX_NOISE_PERCENTILE = 100; // Maximum percentile of the spectrum levels taken as the noise floor
+const double MIN_PEAK_SPACING = 0;             // Minimum distance between spectrum peaks in Hz
+const double MAX_PEAK_SPACING = MAX_BANDWIDTH; // Maximum distance between spectrum peaks in Hz, the widest span
+const int MIN_WATERFALL_SWEEPS = 0;     // Minimum number of waterfall sweeps sent to the client, zero to send every sweep
+const int MAX_WATERFALL_SWEEPS = 65535; // Maximum number of waterfall sweeps sent to the client
+const double MIN_STREAM_RATE_HZ = 0;     // Minimum pan stream rate in Hz, zero to request sweeps as fast as the station allows
+const double MAX_STREAM_RATE_HZ = 1000;  // Maximum pan stream rate in Hz
+const double MIN_TRACE_RATE_HZ = 0.01;   // Minimum pan trace frame rate in Hz
+const double MAX_TRACE_RATE_HZ = 100;    // Maximum pan trace frame rate in Hz
+
+
+// Validation rules for each request, compiled once at startup
+const ValidationSchema AVD_SCHEMA = ValidationSchema()
+    .requireRange("freq", MIN_FREQ, MAX_FREQ)
+    .requireRange("bandwidth", MIN_BANDWIDTH, MAX_BANDWIDTH)
+    .requireRange("duration", MIN_DURATION, MAX_DURATION)
+    .requireType("modulation", VALID_TYPE_STRING);
+
+const ValidationSchema MEASUREMENT_SCHEMA = ValidationSchema()
+    .requireRange("ant", MIN_ANT, MAX_ANT)
+    .requireRange("freq", MIN_FREQ, MAX_FREQ)
+    .requireRange("bandwidth", MIN_BANDWIDTH, MAX_BANDWIDTH);
+
+const ValidationSchema OCCUPANCY_SCHEMA = ValidationSchema()
+    .requireRange("ant", MIN_ANT, MAX_ANT)
+    .requireRange("numBands", MIN_NUM_BANDS, MAX_NUM_BANDS)
+    .requireRange("storageTime", MIN_STORAGE_TIME, MAX_STORAGE_TIME)
+    .requireRange("measurementTime", MIN_MEASUREMENT_TIME, MAX_MEASUREMENT_TIME)
+    .requireRange("numAzimuths", MIN_AZIMUTHS, MAX_AZIMUTHS)
+    .requireRange("confidence", MIN_DF_CONFIDENCE, MAX_DF_CONFIDENCE)
+    .requireRange("recordHoldoff", MIN_RECORD_HOLDOFF, MAX_RECORD_HOLDOFF)
+    .requireRange("scanDfThreshold", MIN_SCAN_DF_THRESHOLD, MAX_SCAN_DF_THRESHOLD)
+    .requireType("recordAudioDf", VALID_TYPE_BOOLEAN)
+    .validateObjectItems("band", ValidationSchema()
+        .requireRange("channelBandwidth", MIN_BANDWIDTH, MAX_BANDWIDTH)
+        .requireType("exclude", VALID_TYPE_BOOLEAN)
+        .requireRange("stopFrequency", MIN_FREQ, MAX_FREQ)
+        .requireRange("startFrequency", MIN_FREQ, MAX_FREQ)
+        .lessThan("startFrequency", "stopFrequency", "startFrequency must be less than stopFrequency"));
+
+const ValidationSchema OCCUPANCY_DF_SCHEMA = ValidationSchema()
+    .validateObjectItems("rcvrCtrl", ValidationSchema()
+        .requireRange("freq", MIN_FREQ, MAX_FREQ)
+        .requireRange("bandwidth", MIN_BANDWIDTH, MAX_BANDWIDTH)
+        .requireRange("bfo", MIN_BFO, MAX_BFO)
+        .requireRange("detMode", MIN_DET_MODE, MAX_DET_MODE)
+        .requireRange("agcTime", MIN_AGC_TIME, MAX_AGC_TIME));
+
+const ValidationSchema GET_PAN_SCHEMA = ValidationSchema()
+    .requireRange("centerFrequency", MIN_FREQ, MAX_FREQ)
+    .requireRange("span", MIN_BANDWIDTH, MAX_BANDWIDTH)
+    .requireRange("rcvrAtten", MIN_RCVD_ATTEN, MAX_RCVD_ATTEN)
+    .optionalRange("outputBins", MIN_OUTPUT_BINS, MAX_OUTPUT_BINS)
+    .optionalType("decimation", VALID_TYPE_STRING)
+    .optionalType("peakThreshold", VALID_TYPE_NUMBER)
+    .optionalType("peakMargin", VALID_TYPE_NUMBER)
+    .optionalRange("peakSpacing", MIN_PEAK_SPACING, MAX_PEAK_SPACING)
+    .optionalType("noisePercentile", VALID_TYPE_NUMBER)
+    .optionalType("sweepData", VALID_TYPE_BOOLEAN);
+
+const ValidationSchema PAN_STREAM_SCHEMA = ValidationSchema(GET_PAN_SCHEMA)
+    .optionalRange("rateHz", MIN_STREAM_RATE_HZ, MAX_STREAM_RATE_HZ);
+
+const ValidationSchema SWEEP_QUERY_SCHEMA = ValidationSchema()
+    .requireType("fromMs", VALID_TYPE_NUMBER)
+    .requireType("toMs", VALID_TYPE_NUMBER)
+    .requireRange("startFrequency", MIN_FREQ, MAX_FREQ)
+    .requireRange("stopFrequency", MIN_FREQ, MAX_FREQ)
+    .lessThan("startFrequency", "stopFrequency", "startFrequency must be less than stopFrequency")
+    .requireType("reducer", VALID_TYPE_STRING)
+    .optionalType("percentile", VALID_TYPE_NUMBER)
+    .requireRange("numBins", MIN_QUERY_BINS, MAX_QUERY_BINS);
+
+const ValidationSchema WATERFALL_SCHEMA = ValidationSchema()
+    .optionalType("source", VALID_TYPE_STRING)
+    .optionalType("taskId", VALID_TYPE_NUMBER)
+    .optionalType("bandIndex", VALID_TYPE_NUMBER)
+    .optionalType("centerFrequency", VALID_TYPE_NUMBER)
+    .optionalRange("sweeps", MIN_WATERFALL_SWEEPS, MAX_WATERFALL_SWEEPS)
+    .optionalRange("outputBins", MIN_OUTPUT_BINS, MAX_OUTPUT_BINS)
+    .optionalType("decimation", VALID_TYPE_STRING);
+
+const ValidationSchema TRACE_SUBSCRIBE_SCHEMA = ValidationSchema()
+    .requireArray("detectors", VALID_TYPE_STRING)
+    .optionalRange("rateHz", MIN_TRACE_RATE_HZ, MAX_TRACE_RATE_HZ);
+
+const ValidationSchema TRACE_RESET_SCHEMA = ValidationSchema()
+    .requireRange("centerFrequency", MIN_FREQ, MAX_FREQ)
+    .optionalRange("numBins", MIN_QUERY_BINS, MAX_QUERY_BINS);
+
+const ValidationSchema AUDIO_PARAMS_SCHEMA = ValidationSchema()
+    .requireRange("freq", MIN_FREQ, MAX_FREQ)
+    .optionalType("channel", VALID_TYPE_NUMBER)
+    .requireRange("bandwidth", MIN_BANDWIDTH, MAX_BANDWIDTH)
+    .optionalType("bfo", VALID_TYPE_NUMBER)
+    .optionalType("anyChannel", VALID_TYPE_BOOLEAN)
+    .optionalType("detMode", VALID_TYPE_NUMBER)
+    .optionalType("doModRec", VALID_TYPE_BOOLEAN)
+    .optionalType("doRDS", VALID_TYPE_BOOLEAN)
+    .optionalType("streamID", VALID_TYPE_NUMBER)
+    .requireArray("test_array", VALID_TYPE_NUMBER, 2)
+    .requireArray("test_string_array", VALID_TYPE_STRING, 2)
+    .requireType("test_float", VALID_TYPE_NUMBER)
+    .requireType("test_string", VALID_TYPE_STRING);
+
+// Common fields of all requests
+const ValidationSchema REQUEST_SCHEMA = ValidationSchema()
+    .requireType(edll::DefaultConfig::Service::TaskKeys::CommandCode::VALUE, VALID_TYPE_NUMBER)
+    .requireType(edll::DefaultConfig::Service::TaskKeys::CommandName::VALUE, VALID_TYPE_STRING)
+    .requireType(edll::DefaultConfig::Service::TaskKeys::Arguments::VALUE, VALID_TYPE_OBJECT);
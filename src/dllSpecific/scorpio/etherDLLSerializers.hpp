@@ -0,0 +1,137 @@
+/**
+ * @file etherDLLSerializers.hpp
+ *
+ * @brief Field lists used to serialize Scorpio DLL structures shared by several response families
+ *
+ * Each list describes, at compile time, the keys and the values written for a structure.
+ * The same list is used by the responses written with edll::JsonWriter and by those built as JSON objects,
+ * keeping the format of the GPS data, occupancy header, task state and task status identical across families.
+ * Channel results are written as typed binary columns by writeChannelColumn.
+ *
+ * * @author fslobao
+ * * @date 2025-10-27
+ * * @version 1.0
+ *
+ * * @note Requires C++17 or later
+ * * @note Uses nlohmann/json library for JSON handling
+ *
+ * * * Dependencies:
+ * * - nlohmann/json.hpp
+**/
+// ----------------------------------------------------------------------
+#pragma once
+
+// Include provided DLL libraries
+#include "StdAfx.h"
+#include "EquipCtrlMsg.h"
+
+// Include DLL specific libraries
+#include "etherDLLCodes.hpp"
+
+// Include core EtherDLL libraries
+#include "EtherDLLUtils.hpp"
+#include "EtherDLLWriter.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+
+// Include general C++ libraries
+#include <string>
+#include <tuple>
+#include <vector>
+#include <type_traits>
+
+// For convenience
+using json = nlohmann::json;
+
+// ----------------------------------------------------------------------
+/** @brief Fields of SGpsResponse, written as the site of the measurement
+**/
+constexpr auto GPS_RESPONSE_FIELDS = std::make_tuple(
+    edll::jsonField("dateTime", [](const SEquipCtrlMsg::SGpsResponse& gps) { return COleTimeToIsoStr(gps.dateTime); }), // using COleTime format
+    edll::jsonField("latitude", [](const SEquipCtrlMsg::SGpsResponse& gps) { return double(gps.latitude); }), // degrees (+ North, - South)
+    edll::jsonField("longitude", [](const SEquipCtrlMsg::SGpsResponse& gps) { return double(gps.longitude); }), // degrees (+ East, - West)
+    edll::jsonObject("status", edll::JsonSelf(), std::make_tuple(
+        edll::jsonField("numSats", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.numSats); }), // >7 stored as 7
+        edll::jsonField("accuracy", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.accuracy); }), // = A,B,C,D
+        edll::jsonField("antenna", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.antenna); }), // = -,O,S
+        edll::jsonField("batVolt", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.batVolt); }), // = -,B
+        edll::jsonField("lockHist", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.lockHist); }), // = -,a,A
+        edll::jsonField("mode", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.mode); }), // = T,A,S,D
+        edll::jsonField("noGps", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.noGps); }),
+        edll::jsonField("notTested", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.notTested); }),
+        edll::jsonField("nvRam", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.nvRam); }), // = -,N
+        edll::jsonField("oscVolt", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.oscVolt); }), // = -,X
+        edll::jsonField("pllSynth", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.pllSynth); }), // = -,P
+        edll::jsonField("receiver", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.receiver); }), // = -,R
+        edll::jsonField("satLock", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.satLock); }), // = L,U
+        edll::jsonField("timErr1", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.timErr1); }), // = -,U
+        edll::jsonField("timErr2", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.timErr2); }), // = -,U
+        edll::jsonField("timSrce", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.timSrce); }), // = G,F,I,N
+        edll::jsonField("tracking", [](const SEquipCtrlMsg::SGpsResponse& gps) { return int(gps.status.tracking); }) // = -,T
+    ))
+);
+
+// ----------------------------------------------------------------------
+/** @brief Fields of SOccupancyHeader, written as the site and the occupancy header members of the response
+**/
+constexpr auto OCCUPANCY_HEADER_FIELDS = std::make_tuple(
+    edll::jsonObject("site", [](const SEquipCtrlMsg::SOccupancyHeader& occHdr) -> const SEquipCtrlMsg::SGpsResponse& { return occHdr.gpsResponse; }, GPS_RESPONSE_FIELDS),
+    edll::jsonObject("occHdr", edll::JsonSelf(), std::make_tuple(
+        edll::jsonField("status", [](const SEquipCtrlMsg::SOccupancyHeader& occHdr) { return eErrorCodeToString(occHdr.status); }),
+        edll::jsonField("firstChannel", [](const SEquipCtrlMsg::SOccupancyHeader& occHdr) { return (unsigned long)occHdr.firstChannel; }),
+        edll::jsonField("numChannels", [](const SEquipCtrlMsg::SOccupancyHeader& occHdr) { return (unsigned long)occHdr.numChannels; }),
+        edll::jsonField("numTotalChannels", [](const SEquipCtrlMsg::SOccupancyHeader& occHdr) { return (unsigned long)occHdr.numTotalChannels; }),
+        edll::jsonField("numTimeOfDays", [](const SEquipCtrlMsg::SOccupancyHeader& occHdr) { return (unsigned long)occHdr.numTimeOfDays; })
+    ))
+);
+
+// ----------------------------------------------------------------------
+/** @brief Fields of SStateResp, written as the task member of the response
+**/
+constexpr auto STATE_RESP_FIELDS = std::make_tuple(
+    edll::jsonObject("task", edll::JsonSelf(), std::make_tuple(
+        edll::jsonField("completionTime", [](const SEquipCtrlMsg::SStateResp& state) { return double(state.completionTime); }),
+        edll::jsonField("state", [](const SEquipCtrlMsg::SStateResp& state) { return eStateRespToString(state.state); })
+    ))
+);
+
+// ----------------------------------------------------------------------
+/** @brief Fields of SEquipTaskStatusResp, written as the task status member of the response
+**/
+constexpr auto TASK_STATUS_RESP_FIELDS = std::make_tuple(
+    edll::jsonObject("SEquipTaskStatusResp", edll::JsonSelf(), std::make_tuple(
+        edll::jsonField("dateTime", [](const SEquipCtrlMsg::SEquipTaskStatusResp& status) { return status.dateTime; }),
+        edll::jsonField("key", [](const SEquipCtrlMsg::SEquipTaskStatusResp& status) { return status.key; }),
+        edll::jsonField("status", [](const SEquipCtrlMsg::SEquipTaskStatusResp& status) { return eStatusToString(status.status); }),
+        edll::jsonField("taskId", [](const SEquipCtrlMsg::SEquipTaskStatusResp& status) { return status.taskId; })
+    ))
+);
+
+// ----------------------------------------------------------------------
+/** @brief Write one member of a list of channel results as a binary column
+ *
+ * The column is written as an object with the element type and the base64 encoded little endian values, in channel order.
+ *
+ * @param writer Writer receiving the column object
+ * @param items Pointer to the first channel result
+ * @param count Number of channel results
+ * @param get Function receiving a channel result and returning the value of the column
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+template <typename T, typename Getter>
+void writeChannelColumn(edll::JsonWriter& writer, const T* items, size_t count, Getter get)
+{
+    using Value = std::decay_t<decltype(get(items[0]))>;
+
+    std::vector<Value> column(count);
+    for (size_t i = 0; i < count; i++) {
+        column[i] = get(items[i]);
+    }
+
+    writer.beginObject();
+    writer.field("type", edll::columnType<Value>());
+    writer.key("data").binary(column.data(), count * sizeof(Value));
+    writer.endObject();
+}
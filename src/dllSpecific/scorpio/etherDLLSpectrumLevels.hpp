@@ -0,0 +1,60 @@
+/**
+ * @file etherDLLSpectrumLevels.hpp
+ * @brief Conversion of the levels of the RT_SPECTRUM responses to a binary column
+ *
+ * Kept apart from etherDLLResponse.hpp, without dependencies on the Scorpio API,
+ * so that the conversion can be used by tools built outside the service project, such as the benchmarks in test/benchmark.
+ *
+ * Levels are sent as a base64 binary column inside the JSON response, as the IQ samples.
+ * Written as a JSON string of raw bytes, levels above 0x7F are not valid UTF-8 and control bytes are escaped one by one.
+ *
+ * @author fslobao
+ * @date 2025-10-27
+ * @version 1.0
+ *
+ * @note Requires C++17 or later
+ *
+ **/
+ // ----------------------------------------------------------------------
+#pragma once
+
+// Include core EtherDLL libraries
+#include "EtherDLLWriter.hpp"
+
+// Include general C++ libraries
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+
+
+// Spectrum structures carrying the level offset, from SSpectrumV3 on
+template <typename T, typename = void>
+struct HasZeroVal : std::false_type {};
+template <typename T>
+struct HasZeroVal<T, std::void_t<decltype(std::declval<const T&>().zeroVal)>> : std::true_type {};
+
+// ----------------------------------------------------------------------
+/** @brief Write the levels of a real-time spectrum as a binary column with its scaling metadata
+ *
+ * Levels are written as base64 encoded bytes straight from the DLL structure, without copy or string escaping.
+ * The noise floor, and the level offset when available, are written with the column to convert the levels.
+ *
+ * @param writer Writer receiving the levelData member
+ * @param spectrum Real-time spectrum received from the DLL
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+template <typename Spectrum>
+void writeLevelData(edll::JsonWriter& writer, const Spectrum& spectrum)
+{
+	using Level = std::decay_t<decltype(spectrum.chanData[0])>;
+
+	writer.key("levelData").beginObject();
+	writer.field("type", edll::columnType<Level>());
+	writer.field("noiseFloor", spectrum.noiseFloor);
+	if constexpr (HasZeroVal<Spectrum>::value) {
+		writer.field("zeroVal", spectrum.zeroVal);
+	}
+	writer.key("data").binary(spectrum.chanData, static_cast<size_t>(spectrum.numChan) * sizeof(Level));
+	writer.endObject();
+}
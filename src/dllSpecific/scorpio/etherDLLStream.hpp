@@ -0,0 +1,301 @@
+/**
+* @file etherDLLStream.hpp
+*
+* @brief Header file for server side periodic tasks using the Scorpio API
+*
+* A client may register a pan configuration to be requested continuously.
+* The next RequestPan is issued by the service right after the response to the previous one,
+* optionally delayed to keep the rate requested by the client, until the stream is stopped or the client disconnects.
+*
+* * @author fslobao
+* * @date 2025-10-24
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+
+// ----------------------------------------------------------------------
+#pragma once
+
+// Include provided DLL libraries
+#include "StdAfx.h"
+#include "ScorpioAPITypes.h"
+#include "ScorpioAPIDll.h"
+
+// Include DLL specific libraries
+#include "etherDLLCodes.hpp"
+#include "etherDLLInit.hpp"
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+#include "EtherDLLClient.hpp"
+#include "EtherDLLMetrics.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+// Include general C++ libraries
+#include <string>
+#include <mutex>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+
+// For convenience
+using json = nlohmann::json;
+
+// Global variables
+extern spdlog::logger* loggerPtr;
+extern MessageQueue response;
+extern RequestRegistry requestRegistry;
+extern ServiceMetrics serviceMetrics;
+
+
+// ----------------------------------------------------------------------
+/** @brief Continuous pan request on behalf of a single client session
+ *
+ * Only one stream is active at a time, since the station computes a single pan at a time.
+ * Starting a stream replaces the active one, which is reported as stopped to its owner.
+ * The DLL is never called while holding the lock, since its callbacks may need it.
+**/
+class PanStreamer {
+private:
+	// Longest interval between sweeps, so that very low rates do not overflow the period
+	static constexpr double MAX_PERIOD_S = 3600;
+
+	std::mutex mtx;
+	std::condition_variable cv;
+
+	// Stream definition
+	bool active = false;
+	RequestEntry owner;
+	SGetPanParams params{};
+	std::chrono::steady_clock::duration period = std::chrono::steady_clock::duration::zero();
+
+	// State of the last pan request issued
+	std::chrono::steady_clock::time_point lastIssue;
+	bool pending = false;
+	unsigned long pendingRequestId = 0;
+	unsigned long lastAnsweredId = 0;
+	unsigned long long sweepCount = 0;
+
+	// ----------------------------------------------------------------------
+	/** @brief Report to the stream owner that the stream is no longer active. Must be called with the lock held.
+	 *
+	 * @param reason: Reason for stopping the stream
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void reportStopped(const std::string& reason) {
+		using TaskKeys = edll::DefaultConfig::Service::TaskKeys;
+
+		json notice;
+		notice[TaskKeys::CommandCode::VALUE] = StreamMsgType::STREAM_PAN_STOP;
+		notice[TaskKeys::CommandName::VALUE] = StreamMsgType::toString(StreamMsgType::STREAM_PAN_STOP);
+		notice[TaskKeys::Arguments::VALUE] = json::object();
+		notice[TaskKeys::SessionId::VALUE] = owner.sessionId;
+		notice[clientIdKey] = owner.clientId;
+		notice[TaskKeys::Message::VALUE] = reason + ". Sweeps requested: " + std::to_string(sweepCount);
+		response.push(notice, "PanStreamer");
+
+		loggerPtr->info("[" + owner.commandName + "] " + reason + " after " + std::to_string(sweepCount) + " sweeps");
+	}
+
+public:
+	// ----------------------------------------------------------------------
+	/** @brief Start a pan stream, issuing the first pan request from the calling thread
+	 *
+	 * @param DLLConnID: Connection ID obtained from the DLL during initialization
+	 * @param request: Request received from the client, used to identify the stream owner
+	 * @param panParams: Pan parameters to be requested on every sweep
+	 * @param rateHz: Maximum sweep rate. Zero to request sweeps as fast as the station allows
+	 * @param output: Spectrum output options of the sweeps sent to the client
+	 * @param requestID: Request ID returned by the DLL for the first sweep
+	 * @return ERetCode: Code returned by the DLL for the first sweep
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	ERetCode start(DLLConnectionData DLLConnID, const json& request, const SGetPanParams& panParams, double rateHz, const SpectrumOutput& output, unsigned long* requestID) {
+		using TaskKeys = edll::DefaultConfig::Service::TaskKeys;
+
+		ERetCode errCode = RequestPan(DLLConnID, panParams, requestID);
+
+		std::lock_guard<std::mutex> lock(mtx);
+		if (active) {
+			reportStopped("Pan stream replaced by a new stream");
+		}
+		active = false;
+		pending = false;
+		if (errCode != ERetCode::API_SUCCESS) {
+			return errCode;
+		}
+
+		owner = RequestEntry();
+		owner.sessionId = request.value(TaskKeys::SessionId::VALUE, TaskKeys::SessionId::INIT_VALUE);
+		owner.clientId = request.value(clientIdKey, json(TaskKeys::ClientId::INIT_VALUE));
+		owner.commandCode = StreamMsgType::STREAM_PAN_START;
+		owner.commandName = request.value(TaskKeys::CommandName::VALUE, std::string(StreamMsgType::toString(StreamMsgType::STREAM_PAN_START)));
+		// Sweeps after the first do not hold an admission control slot
+		owner.answered = true;
+		owner.output = output;
+
+		params = panParams;
+		period = rateHz > 0 ?
+			std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>((std::min)(1.0 / rateHz, MAX_PERIOD_S))) :
+			std::chrono::steady_clock::duration::zero();
+
+		active = true;
+		sweepCount = 1;
+		lastIssue = std::chrono::steady_clock::now();
+		pendingRequestId = *requestID;
+		pending = lastAnsweredId != *requestID;
+
+		cv.notify_all();
+		return errCode;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Stop the stream if it is owned by the given session
+	 *
+	 * @param sessionId: Session requesting the stop or disconnected
+	 * @param reason: Reason for stopping the stream, reported to the owner
+	 * @return bool: True if a stream was stopped, false otherwise
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool stop(unsigned long sessionId, const std::string& reason) {
+		std::lock_guard<std::mutex> lock(mtx);
+		if (!active || owner.sessionId != sessionId) {
+			return false;
+		}
+		reportStopped(reason);
+		active = false;
+		pending = false;
+
+		cv.notify_all();
+		return true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Signal that the DLL answered a pan request, releasing the next sweep
+	 * Called from the DLL callback thread.
+	 *
+	 * @param requestID: Request ID received in the DLL callback
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void onPanResponse(unsigned long requestID) {
+		std::lock_guard<std::mutex> lock(mtx);
+		lastAnsweredId = requestID;
+		if (active && pending && requestID == pendingRequestId) {
+			pending = false;
+			cv.notify_all();
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Issue the pan requests of the active stream until the service is interrupted
+	 *
+	 * This function will lock the thread. Must be run in a separate thread.
+	 * If the station does not answer a sweep within the station timeout, the next sweep is issued anyway.
+	 * The stream is stopped if the DLL refuses a request.
+	 *
+	 * @param DLLConnID: Connection ID obtained from the DLL during initialization
+	 * @param config: JSON object containing configuration parameters
+	 * @param interruptionCode: Signal interruption for service interruption
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void run(DLLConnectionData DLLConnID, const json& config, const edll::INT_CODE& interruptionCode) {
+		using station_conf = DefaultDLLParam::Station;
+
+		int timeoutS = station_conf::Timeout::VALUE;
+		if (config.contains(DefaultDLLParam::KEY) && config[DefaultDLLParam::KEY].contains(station_conf::KEY)) {
+			timeoutS = config[DefaultDLLParam::KEY][station_conf::KEY].value(station_conf::Timeout::KEY, timeoutS);
+		}
+		std::chrono::seconds responseTimeout(timeoutS);
+
+		std::unique_lock<std::mutex> lock(mtx);
+		while (interruptionCode == edll::Code::RUNNING) {
+
+			cv.wait_for(lock, std::chrono::seconds(1), [this, &interruptionCode] {
+				return (active && !pending) || interruptionCode != edll::Code::RUNNING;
+				});
+
+			if (!active || interruptionCode != edll::Code::RUNNING) {
+				continue;
+			}
+
+			if (pending) {
+				if (std::chrono::steady_clock::now() - lastIssue < responseTimeout) {
+					continue;
+				}
+				loggerPtr->warn("[" + owner.commandName + "] no response to pan request " + std::to_string(pendingRequestId) + ". Requesting next sweep");
+				pending = false;
+			}
+
+			// Keep the requested rate, measured from the start of the previous sweep
+			bool cancelled = cv.wait_until(lock, lastIssue + period, [this, &interruptionCode] {
+				return !active || interruptionCode != edll::Code::RUNNING;
+				});
+			if (cancelled) {
+				continue;
+			}
+
+			SGetPanParams panParams = params;
+			RequestEntry entry = owner;
+			pending = true;
+			pendingRequestId = 0;
+			lastIssue = std::chrono::steady_clock::now();
+
+			lock.unlock();
+			unsigned long requestID = 0;
+			entry.submitTime = std::chrono::steady_clock::now();
+			entry.lastSeen = entry.submitTime;
+			requestRegistry.reserve();
+			ERetCode errCode = RequestPan(DLLConnID, panParams, &requestID);
+			if (errCode == ERetCode::API_SUCCESS) {
+				requestRegistry.commit(requestID, entry);
+			}
+			else {
+				requestRegistry.rollback();
+			}
+			lock.lock();
+
+			// Stream stopped or replaced while the request was being issued
+			if (!active || owner.sessionId != entry.sessionId || !(owner.clientId == entry.clientId)) {
+				continue;
+			}
+
+			if (errCode != ERetCode::API_SUCCESS) {
+				serviceMetrics.countDLLError(errCode);
+				reportStopped("Pan stream stopped. " + ERetCodeToString(errCode));
+				active = false;
+				pending = false;
+				continue;
+			}
+
+			sweepCount++;
+			pendingRequestId = requestID;
+			pending = lastAnsweredId != requestID;
+		}
+	}
+};
+
+
+// Active pan stream, shared by the request thread, the stream thread and the DLL callbacks
+extern PanStreamer panStreamer;
+
+
+// ----------------------------------------------------------------------
+/** @brief Forward pan responses received in the DLL callback to the pan streamer
+ *
+ * @param requestID: Request ID received in the DLL callback
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void onPanStreamResponse(unsigned long requestID)
+{
+	panStreamer.onPanResponse(requestID);
+}
@@ -0,0 +1,749 @@
+/**
+* @file etherDLLSweepQuery.hpp
+*
+* @brief Header file for the reduction of the stored sweeps into a single trace, requested by the client with command code 9103
+*
+* The sweeps stored within a time range are reduced bin by bin with max, min, mean or percentile,
+* and the result is resampled to the requested number of bins over a frequency range.
+* Queries are answered by their own thread, one at a time, so the client thread is never held by the scan.
+* The time range is split among a configured number of scan threads. Each scan thread keeps one accumulator for each sweep geometry
+* (center frequency, bin size and number of bins), updated with SIMD kernels over the raw uint8 bins.
+* The accumulators of a query are limited to a configured memory budget.
+*
+* * @author fslobao
+* * @date 2025-10-31
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+
+// ----------------------------------------------------------------------
+#pragma once
+
+// Include DLL specific libraries
+#include "etherDLLCodes.hpp"
+#include "etherDLLDataProcess.hpp"
+#include "etherDLLSweepStore.hpp"
+#include "etherDLLValidation.hpp"
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+#include "EtherDLLClient.hpp"
+#include "EtherDLLWriter.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+// Include general C++ libraries
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <condition_variable>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ETHERDLL_SWEEP_SSE2
+#endif
+
+// For convenience
+using json = nlohmann::json;
+
+// Global variables
+extern spdlog::logger* loggerPtr;
+extern MessageQueue response;
+extern SweepStore sweepStore;
+
+
+// ----------------------------------------------------------------------
+/** @brief Element-wise reductions of a sweep into an accumulator, over raw uint8 bins
+**/
+namespace sweepKernel {
+
+	inline void max(uint8_t* acc, const uint8_t* bins, size_t n) {
+		size_t i = 0;
+#ifdef ETHERDLL_SWEEP_SSE2
+		for (; i + 16 <= n; i += 16) {
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bins + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i), _mm_max_epu8(a, b));
+		}
+#endif
+		for (; i < n; i++) {
+			acc[i] = (std::max)(acc[i], bins[i]);
+		}
+	}
+
+	inline void min(uint8_t* acc, const uint8_t* bins, size_t n) {
+		size_t i = 0;
+#ifdef ETHERDLL_SWEEP_SSE2
+		for (; i + 16 <= n; i += 16) {
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bins + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i), _mm_min_epu8(a, b));
+		}
+#endif
+		for (; i < n; i++) {
+			acc[i] = (std::min)(acc[i], bins[i]);
+		}
+	}
+
+	inline void add(uint32_t* acc, const uint8_t* bins, size_t n) {
+		size_t i = 0;
+#ifdef ETHERDLL_SWEEP_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 16 <= n; i += 16) {
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bins + i));
+			__m128i lo = _mm_unpacklo_epi8(b, zero);
+			__m128i hi = _mm_unpackhi_epi8(b, zero);
+			__m128i* out = reinterpret_cast<__m128i*>(acc + i);
+			_mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), _mm_unpacklo_epi16(lo, zero)));
+			_mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), _mm_unpackhi_epi16(lo, zero)));
+			_mm_storeu_si128(out + 2, _mm_add_epi32(_mm_loadu_si128(out + 2), _mm_unpacklo_epi16(hi, zero)));
+			_mm_storeu_si128(out + 3, _mm_add_epi32(_mm_loadu_si128(out + 3), _mm_unpackhi_epi16(hi, zero)));
+		}
+#endif
+		for (; i < n; i++) {
+			acc[i] += bins[i];
+		}
+	}
+
+	inline void subtract(uint32_t* acc, const uint8_t* bins, size_t n) {
+		size_t i = 0;
+#ifdef ETHERDLL_SWEEP_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 16 <= n; i += 16) {
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bins + i));
+			__m128i lo = _mm_unpacklo_epi8(b, zero);
+			__m128i hi = _mm_unpackhi_epi8(b, zero);
+			__m128i* out = reinterpret_cast<__m128i*>(acc + i);
+			_mm_storeu_si128(out, _mm_sub_epi32(_mm_loadu_si128(out), _mm_unpacklo_epi16(lo, zero)));
+			_mm_storeu_si128(out + 1, _mm_sub_epi32(_mm_loadu_si128(out + 1), _mm_unpackhi_epi16(lo, zero)));
+			_mm_storeu_si128(out + 2, _mm_sub_epi32(_mm_loadu_si128(out + 2), _mm_unpacklo_epi16(hi, zero)));
+			_mm_storeu_si128(out + 3, _mm_sub_epi32(_mm_loadu_si128(out + 3), _mm_unpackhi_epi16(hi, zero)));
+		}
+#endif
+		for (; i < n; i++) {
+			acc[i] -= bins[i];
+		}
+	}
+
+	// Exponential average: acc += alpha * (bins - acc)
+	inline void smooth(float* acc, const uint8_t* bins, size_t n, float alpha) {
+		size_t i = 0;
+#ifdef ETHERDLL_SWEEP_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 weight = _mm_set1_ps(alpha);
+		for (; i + 16 <= n; i += 16) {
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bins + i));
+			__m128i lo = _mm_unpacklo_epi8(b, zero);
+			__m128i hi = _mm_unpackhi_epi8(b, zero);
+			__m128i words[4] = { _mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero), _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero) };
+			for (int k = 0; k < 4; k++) {
+				float* out = acc + i + 4 * k;
+				__m128 a = _mm_loadu_ps(out);
+				_mm_storeu_ps(out, _mm_add_ps(a, _mm_mul_ps(weight, _mm_sub_ps(_mm_cvtepi32_ps(words[k]), a))));
+			}
+		}
+#endif
+		for (; i < n; i++) {
+			acc[i] += alpha * (float(bins[i]) - acc[i]);
+		}
+	}
+
+	inline void count(uint32_t* histogram, const uint8_t* bins, size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			histogram[i * 256 + bins[i]]++;
+		}
+	}
+}
+
+
+// ----------------------------------------------------------------------
+/** @brief Reduction of the stored sweeps over a time and frequency window
+**/
+class SweepQuery {
+public:
+	enum class Reducer { MAX, MIN, MEAN, PERCENTILE };
+
+	// Limits of the output trace
+	static constexpr long long MAX_BINS = 65536;
+
+	long long fromNs = 0;
+	long long toNs = 0;
+	double startFrequencyHz = 0;
+	double stopFrequencyHz = 0;
+	Reducer reducer = Reducer::MAX;
+	double percentile = 50;
+	size_t numBins = 0;
+
+	// ----------------------------------------------------------------------
+	/** @brief Read the query from the arguments of the request
+	 *
+	 * Times are milliseconds since the Unix epoch. Zero or negative times are taken relative to the current time.
+	 *
+	 * @param arguments: Arguments of the request, already validated
+	 * @param query: Query read from the arguments
+	 * @return std::string: Error message, empty if the arguments are valid
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static std::string read(const json& arguments, SweepQuery& query) {
+		const long long NS_PER_MS = 1000000LL;
+
+		long long nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		auto toTime = [nowNs, NS_PER_MS](const json& value) {
+			long long ms = value.get<long long>();
+			return ms > 0 ? ms * NS_PER_MS : nowNs + ms * NS_PER_MS;
+		};
+
+		query.fromNs = toTime(arguments["fromMs"]);
+		query.toNs = toTime(arguments["toMs"]);
+		query.startFrequencyHz = arguments["startFrequency"].get<double>();
+		query.stopFrequencyHz = arguments["stopFrequency"].get<double>();
+		query.numBins = arguments["numBins"].get<size_t>();
+		query.percentile = arguments.value("percentile", query.percentile);
+
+		std::string reducer = arguments["reducer"].get<std::string>();
+		if (reducer == "max") {
+			query.reducer = Reducer::MAX;
+		}
+		else if (reducer == "min") {
+			query.reducer = Reducer::MIN;
+		}
+		else if (reducer == "mean") {
+			query.reducer = Reducer::MEAN;
+		}
+		else if (reducer == "percentile") {
+			query.reducer = Reducer::PERCENTILE;
+		}
+		else {
+			return "Unknown reducer " + reducer + ". Expected max, min, mean or percentile";
+		}
+
+		if (query.fromNs > query.toNs) {
+			return "Query time range ends before it starts";
+		}
+		if (query.percentile < 0 || query.percentile > 100) {
+			return "Percentile must be within 0 and 100";
+		}
+		return std::string();
+	}
+
+private:
+	// ----------------------------------------------------------------------
+	/** @brief Reduction of the sweeps sharing a geometry, over the bins within the frequency window
+	**/
+	struct Accumulator {
+		double firstBinHz = 0;
+		double binSizeHz = 0;
+		uint32_t numBins = 0;
+		size_t firstBin = 0;		// Bins reduced, within the frequency window
+		size_t lastBin = 0;
+		unsigned long long sweeps = 0;
+		std::vector<uint8_t> extreme;
+		std::vector<uint32_t> sum;		// Flushed to total before it may overflow
+		std::vector<unsigned long long> total;
+		std::vector<uint32_t> histogram;
+
+		// Sweeps added to sum before it may overflow
+		static constexpr unsigned long long SUM_SWEEPS = 0xFFFFFFFFULL / 0xFF;
+
+		size_t width() const { return lastBin - firstBin; }
+
+		// Memory used by each bin reduced with the given reducer
+		static size_t binBytes(Reducer reducer) {
+			switch (reducer) {
+			case Reducer::MEAN: return sizeof(uint32_t) + sizeof(unsigned long long);
+			case Reducer::PERCENTILE: return 256 * sizeof(uint32_t);
+			default: return sizeof(uint8_t);
+			}
+		}
+
+		void flush() {
+			for (size_t i = 0; i < sum.size(); i++) {
+				total[i] += sum[i];
+				sum[i] = 0;
+			}
+		}
+	};
+
+	using Accumulators = std::vector<Accumulator>;
+
+	// Memory shared by the accumulators of all scan threads of a query
+	struct Budget {
+		size_t limit = 0;
+		std::atomic<size_t> used{ 0 };
+		std::atomic<bool> exceeded{ false };
+	};
+
+	// ----------------------------------------------------------------------
+	/** @brief Find or create the accumulator of the geometry of a sweep
+	 *
+	 * @param accumulators: Accumulators of the worker
+	 * @param record: Header of the sweep
+	 * @param budget: Memory budget of the query, flagged as exceeded if the new accumulator does not fit
+	 * @return Accumulator*: Accumulator of the geometry, nullptr if the sweep has no bin within the frequency window or the budget is exceeded
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	Accumulator* accumulatorFor(Accumulators& accumulators, const SweepRecord& record, Budget& budget) const {
+		double firstBinHz = record.firstBinHz();
+		for (auto& acc : accumulators) {
+			if (acc.firstBinHz == firstBinHz && acc.binSizeHz == record.binSizeHz && acc.numBins == record.numBins) {
+				return acc.width() > 0 ? &acc : nullptr;
+			}
+		}
+
+		Accumulator acc;
+		acc.firstBinHz = firstBinHz;
+		acc.binSizeHz = record.binSizeHz;
+		acc.numBins = record.numBins;
+		if (record.binSizeHz > 0) {
+			double first = std::ceil((startFrequencyHz - firstBinHz) / record.binSizeHz);
+			double last = std::floor((stopFrequencyHz - firstBinHz) / record.binSizeHz) + 1;
+			acc.firstBin = static_cast<size_t>((std::clamp)(first, 0.0, double(record.numBins)));
+			acc.lastBin = static_cast<size_t>((std::clamp)(last, double(acc.firstBin), double(record.numBins)));
+		}
+
+		size_t bytes = acc.width() * Accumulator::binBytes(reducer);
+		if (budget.used.fetch_add(bytes, std::memory_order_relaxed) + bytes > budget.limit) {
+			budget.exceeded.store(true, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		switch (reducer) {
+		case Reducer::MAX:
+			acc.extreme.assign(acc.width(), 0);
+			break;
+		case Reducer::MIN:
+			acc.extreme.assign(acc.width(), 0xFF);
+			break;
+		case Reducer::MEAN:
+			acc.sum.assign(acc.width(), 0);
+			acc.total.assign(acc.width(), 0);
+			break;
+		case Reducer::PERCENTILE:
+			acc.histogram.assign(acc.width() * 256, 0);
+			break;
+		}
+		accumulators.push_back(std::move(acc));
+		return accumulators.back().width() > 0 ? &accumulators.back() : nullptr;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Reduce a sweep into the accumulator of its geometry
+	 *
+	 * @param accumulators: Accumulators of the worker
+	 * @param record: Header of the sweep
+	 * @param bins: Raw levels of the sweep
+	 * @param budget: Memory budget of the query
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void reduce(Accumulators& accumulators, const SweepRecord& record, const uint8_t* bins, Budget& budget) const {
+		if (budget.exceeded.load(std::memory_order_relaxed)) {
+			return;
+		}
+		Accumulator* acc = accumulatorFor(accumulators, record, budget);
+		if (acc == nullptr) {
+			return;
+		}
+
+		const uint8_t* window = bins + acc->firstBin;
+		switch (reducer) {
+		case Reducer::MAX:
+			sweepKernel::max(acc->extreme.data(), window, acc->width());
+			break;
+		case Reducer::MIN:
+			sweepKernel::min(acc->extreme.data(), window, acc->width());
+			break;
+		case Reducer::MEAN:
+			sweepKernel::add(acc->sum.data(), window, acc->width());
+			if ((acc->sweeps + 1) % Accumulator::SUM_SWEEPS == 0) {
+				acc->flush();
+			}
+			break;
+		case Reducer::PERCENTILE:
+			sweepKernel::count(acc->histogram.data(), window, acc->width());
+			break;
+		}
+		acc->sweeps++;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Merge the accumulators of a worker into the accumulators of the query
+	 *
+	 * @param into: Accumulators of the query
+	 * @param from: Accumulators of the worker
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void merge(Accumulators& into, Accumulators& from) const {
+		for (auto& source : from) {
+			auto it = std::find_if(into.begin(), into.end(), [&source](const Accumulator& acc) {
+				return acc.firstBinHz == source.firstBinHz && acc.binSizeHz == source.binSizeHz && acc.numBins == source.numBins;
+				});
+			if (it == into.end()) {
+				into.push_back(std::move(source));
+				continue;
+			}
+
+			it->sweeps += source.sweeps;
+			switch (reducer) {
+			case Reducer::MAX:
+				sweepKernel::max(it->extreme.data(), source.extreme.data(), it->width());
+				break;
+			case Reducer::MIN:
+				sweepKernel::min(it->extreme.data(), source.extreme.data(), it->width());
+				break;
+			case Reducer::MEAN:
+				it->flush();
+				source.flush();
+				for (size_t i = 0; i < it->width(); i++) {
+					it->total[i] += source.total[i];
+				}
+				break;
+			case Reducer::PERCENTILE:
+				for (size_t i = 0; i < it->histogram.size(); i++) {
+					it->histogram[i] += source.histogram[i];
+				}
+				break;
+			}
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Build the output trace from the reduced bins falling in each output bin
+	 *
+	 * Levels are converted as in the GET_PAN sweep data. Output bins without any stored bin are NaN.
+	 * Output bins are built one at a time, following the bins of each accumulator in frequency order,
+	 * so no memory is allocated for each output bin beyond the trace.
+	 *
+	 * @param accumulators: Accumulators of the query
+	 * @return std::vector<float>: Output trace
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	std::vector<float> finish(Accumulators& accumulators) const {
+		double outBinHz = (stopFrequencyHz - startFrequencyHz) / numBins;
+		auto outputBin = [this, outBinHz](const Accumulator& acc, size_t i) {
+			double frequency = acc.firstBinHz + (acc.firstBin + i) * acc.binSizeHz;
+			return (std::min)(static_cast<size_t>((std::max)((frequency - startFrequencyHz) / outBinHz, 0.0)), numBins - 1);
+		};
+
+		for (auto& acc : accumulators) {
+			if (reducer == Reducer::MEAN) {
+				acc.flush();
+			}
+		}
+
+		std::vector<float> trace(numBins, std::numeric_limits<float>::quiet_NaN());
+		std::vector<size_t> next(accumulators.size(), 0);
+		unsigned long long histogram[256];
+		for (size_t bin = 0; bin < numBins; bin++) {
+			int extreme = reducer == Reducer::MAX ? -1 : 256;
+			unsigned long long total = 0;
+			unsigned long long samples = 0;
+			if (reducer == Reducer::PERCENTILE) {
+				std::fill(std::begin(histogram), std::end(histogram), 0ULL);
+			}
+
+			// Output bins grow with the frequency, so the bins of each accumulator are consumed in order
+			for (size_t k = 0; k < accumulators.size(); k++) {
+				const Accumulator& acc = accumulators[k];
+				if (acc.sweeps == 0) {
+					continue;
+				}
+				for (size_t& i = next[k]; i < acc.width() && outputBin(acc, i) <= bin; i++) {
+					samples += acc.sweeps;
+					switch (reducer) {
+					case Reducer::MAX:
+						extreme = (std::max)(extreme, int(acc.extreme[i]));
+						break;
+					case Reducer::MIN:
+						extreme = (std::min)(extreme, int(acc.extreme[i]));
+						break;
+					case Reducer::MEAN:
+						total += acc.total[i];
+						break;
+					case Reducer::PERCENTILE:
+						for (size_t level = 0; level < 256; level++) {
+							histogram[level] += acc.histogram[i * 256 + level];
+						}
+						break;
+					}
+				}
+			}
+
+			if (samples == 0) {
+				continue;
+			}
+			double level = 0;
+			switch (reducer) {
+			case Reducer::MAX:
+			case Reducer::MIN:
+				level = extreme;
+				break;
+			case Reducer::MEAN:
+				level = double(total) / samples;
+				break;
+			case Reducer::PERCENTILE:
+			{
+				// Nearest rank
+				unsigned long long rank = (std::max)(1ULL, static_cast<unsigned long long>(std::ceil(percentile / 100.0 * samples)));
+				unsigned long long seen = 0;
+				for (size_t value = 0; value < 256; value++) {
+					seen += histogram[value];
+					if (seen >= rank) {
+						level = double(value);
+						break;
+					}
+				}
+				break;
+			}
+			}
+			trace[bin] = static_cast<float>(level) - BYTE_POWER_OFFSET;
+		}
+		return trace;
+	}
+
+public:
+	// ----------------------------------------------------------------------
+	/** @brief Reduce the stored sweeps, splitting the time range of each segment among the scan threads
+	 *
+	 * @param store: Sweep store to be scanned
+	 * @param numThreads: Number of scan threads, including the calling thread
+	 * @param maxBytes: Memory budget of the accumulators of all scan threads
+	 * @param trace: Output trace, empty if the budget was exceeded
+	 * @param sweeps: Number of sweeps with bins within the frequency window
+	 * @return bool: False if the accumulators needed more memory than the budget
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool run(const SweepStore& store, size_t numThreads, size_t maxBytes, std::vector<float>& trace, unsigned long long& sweeps) const {
+		struct Slice {
+			std::shared_ptr<const SweepSegment> segment;
+			long long fromNs;
+			long long toNs;
+		};
+
+		numThreads = (std::max)(numThreads, size_t(1));
+		std::vector<Slice> slices;
+		for (const auto& segment : store.segmentsInRange(fromNs, toNs)) {
+			long long first = (std::max)(fromNs, segment->firstNs.load());
+			long long last = (std::min)(toNs, segment->lastNs.load());
+			long long step = (std::max)((last - first) / static_cast<long long>(numThreads), 1LL);
+			for (long long start = first; start <= last; start += step) {
+				slices.push_back({ segment, start, (std::min)(last, start + step - 1) });
+			}
+		}
+
+		std::vector<Accumulators> workerAccumulators((std::min)(numThreads, (std::max)(slices.size(), size_t(1))));
+		std::atomic<size_t> next{ 0 };
+		Budget budget;
+		budget.limit = maxBytes;
+		auto work = [this, &slices, &next, &budget](Accumulators& accumulators) {
+			for (size_t i = next++; i < slices.size() && !budget.exceeded.load(std::memory_order_relaxed); i = next++) {
+				slices[i].segment->scan(slices[i].fromNs, slices[i].toNs, [this, &accumulators, &budget](const SweepRecord& record, const uint8_t* bins) {
+					reduce(accumulators, record, bins, budget);
+					});
+			}
+		};
+
+		std::vector<std::thread> workers;
+		for (size_t i = 1; i < workerAccumulators.size(); i++) {
+			workers.emplace_back(work, std::ref(workerAccumulators[i]));
+		}
+		work(workerAccumulators[0]);
+		for (auto& worker : workers) {
+			worker.join();
+		}
+
+		sweeps = 0;
+		if (budget.exceeded.load(std::memory_order_relaxed)) {
+			trace.clear();
+			return false;
+		}
+
+		Accumulators accumulators;
+		for (auto& worker : workerAccumulators) {
+			merge(accumulators, worker);
+		}
+
+		for (const auto& acc : accumulators) {
+			sweeps += acc.width() > 0 ? acc.sweeps : 0;
+		}
+		trace = finish(accumulators);
+		return true;
+	}
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Sweep queries waiting to be answered, reduced one at a time by their own thread
+ *
+ * Queries are read and checked on the client thread and answered later with the reduced trace or an error message.
+ * New queries are refused while the configured number of queries is waiting.
+**/
+class SweepQueries {
+private:
+	struct Pending {
+		json request;
+		SweepQuery query;
+	};
+
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::deque<Pending> pending;		// Protected by mtx
+
+	// Configuration, set before the service starts
+	bool enabled = false;
+	size_t numThreads = 1;
+	size_t maxPending = 0;
+	size_t maxBytes = 0;
+
+	// ----------------------------------------------------------------------
+	/** @brief Reduce the stored sweeps and answer the client with the trace
+	 *
+	 * @param next: Query to be answered
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void answer(const Pending& next) {
+		using TaskKeys = edll::DefaultConfig::Service::TaskKeys;
+
+		const SweepQuery& query = next.query;
+		auto start = std::chrono::steady_clock::now();
+		unsigned long long sweeps = 0;
+		std::vector<float> trace;
+		if (!query.run(sweepStore, numThreads, maxBytes, trace, sweeps)) {
+			std::string message = "Sweep query needs more than " + std::to_string(maxBytes >> 20) +
+				" MiB. Reduce the frequency range or the time range, or use another reducer";
+			loggerPtr->warn(message);
+			response.push(buildErrorResponse(next.request, message), "SweepQuery");
+			return;
+		}
+		double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		const json& arguments = next.request[TaskKeys::Arguments::VALUE];
+		edll::JsonWriter writer;
+		writer.beginObject();
+		writer.field("fromMs", query.fromNs / 1000000);
+		writer.field("toMs", query.toNs / 1000000);
+		writer.field("startFrequency", query.startFrequencyHz);
+		writer.field("stopFrequency", query.stopFrequencyHz);
+		writer.field("reducer", arguments["reducer"].get<std::string>());
+		if (query.reducer == SweepQuery::Reducer::PERCENTILE) {
+			writer.field("percentile", query.percentile);
+		}
+		writer.field("numBins", query.numBins);
+		writer.field("sweeps", sweeps);
+		writer.key("trace").beginObject();
+		writer.field("type", edll::columnType<float>());
+		writer.key("data").binary(trace.data(), trace.size() * sizeof(float));
+		writer.endObject();
+		writer.endObject();
+
+		json queryResponse;
+		queryResponse[TaskKeys::CommandCode::VALUE] = StreamMsgType::SWEEP_QUERY;
+		queryResponse[TaskKeys::CommandName::VALUE] = StreamMsgType::toString(StreamMsgType::SWEEP_QUERY);
+		queryResponse[TaskKeys::Arguments::VALUE] = json::object();
+		queryResponse[TaskKeys::SessionId::VALUE] = next.request.value(TaskKeys::SessionId::VALUE, TaskKeys::SessionId::INIT_VALUE);
+		queryResponse[clientIdKey] = next.request.value(clientIdKey, json(TaskKeys::ClientId::INIT_VALUE));
+		queryResponse[edll::BODY_KEY] = writer.str();
+		response.push(queryResponse, "SweepQuery");
+
+		loggerPtr->info("Sweep query reduced " + std::to_string(sweeps) + " sweeps in " + std::to_string(elapsedMs) + " ms");
+	}
+
+public:
+	// ----------------------------------------------------------------------
+	/** @brief Set the query configuration. Must be called before the service starts.
+	 *
+	 * @param enable: Answer the queries, set when the sweep store is enabled
+	 * @param threads: Number of threads scanning the sweeps of each query
+	 * @param maxQueries: Number of queries waiting to be answered before new queries are refused
+	 * @param maxMemoryMB: Memory budget of the accumulators of each query, in MiB
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void configure(bool enable, long long threads, long long maxQueries, long long maxMemoryMB) {
+		enabled = enable && maxQueries > 0 && maxMemoryMB > 0;
+		numThreads = static_cast<size_t>((std::max)(threads, 1LL));
+		maxPending = static_cast<size_t>((std::max)(maxQueries, 0LL));
+		maxBytes = static_cast<size_t>((std::max)(maxMemoryMB, 0LL)) << 20;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Queue a sweep query received from the client, to be answered by the query thread
+	 *
+	 * @param request: Request received from the client
+	 * @return std::string: Error message, empty if the query was queued
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	std::string submit(const json& request) {
+		using TaskKeys = edll::DefaultConfig::Service::TaskKeys;
+
+		if (!enabled) {
+			return "Sweep store is disabled";
+		}
+
+		Pending next;
+		std::string error = SweepQuery::read(request[TaskKeys::Arguments::VALUE], next.query);
+		if (!error.empty()) {
+			return error;
+		}
+		next.request = request;
+
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			if (pending.size() >= maxPending) {
+				return "Sweep query refused. " + std::to_string(pending.size()) + " queries waiting to be answered";
+			}
+			pending.push_back(std::move(next));
+		}
+		cv.notify_one();
+		return std::string();
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Answer the queued queries until the service is interrupted
+	 *
+	 * This function will lock the thread. Must be run in a separate thread.
+	 *
+	 * @param interruptionCode: Signal interruption for service interruption
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void run(const edll::INT_CODE& interruptionCode) {
+		if (!enabled) {
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(mtx);
+		while (interruptionCode == edll::Code::RUNNING) {
+			if (pending.empty()) {
+				cv.wait_for(lock, std::chrono::seconds(1));
+				continue;
+			}
+			Pending next = std::move(pending.front());
+			pending.pop_front();
+
+			lock.unlock();
+			answer(next);
+			lock.lock();
+		}
+	}
+};
+
+
+// Sweep queries received from the clients and answered by their own thread
+extern SweepQueries sweepQueries;
@@ -0,0 +1,579 @@
+/**
+* @file etherDLLSweepStore.hpp
+*
+* @brief Header file for the on-disk history of the spectrum sweeps received from the station
+*
+* GET_PAN responses and realtime spectra are appended as fixed layout records to segment files, preallocated and memory mapped.
+* The DLL callback threads hand the sweeps to the writer thread through a lock-free bounded queue, dropping them if the queue is full.
+* Each segment keeps a sparse time index, used to start the scan of a time range close to its first record.
+* Segments are deleted when older than the configured age or when the store exceeds the configured size.
+*
+* * @author fslobao
+* * @date 2025-10-30
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+
+// ----------------------------------------------------------------------
+#pragma once
+
+// Include DLL specific libraries
+#include "etherDLLRecorder.hpp"
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+// Include general C++ libraries
+#include <string>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+// For convenience
+using json = nlohmann::json;
+
+// Global variables
+extern spdlog::logger* loggerPtr;
+
+
+// ----------------------------------------------------------------------
+/** @brief Header of a sweep record, followed by numBins raw uint8 levels padded to 8 bytes
+**/
+struct SweepRecord {
+	static constexpr uint32_t MAGIC = 0x50455753; // "SWEP"
+
+	uint32_t magic = MAGIC;
+	uint32_t numBins = 0;
+	int64_t timeNs = 0;			// Reception time, in nanoseconds since the Unix epoch
+	double centerFrequencyHz = 0;
+	double binSizeHz = 0;
+	uint32_t source = 0;		// Response type of the sweep
+	uint32_t reserved = 0;
+
+	// ----------------------------------------------------------------------
+	/** @brief Size of a record with the given number of bins, including the header and the padding
+	 *
+	 * @param bins: Number of bins of the sweep
+	 * @return size_t: Size of the record, in bytes
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static size_t size(size_t bins) {
+		return sizeof(SweepRecord) + ((bins + 7) & ~size_t(7));
+	}
+
+	// Frequency of the first bin, using the same center bin as the pan response
+	double firstBinHz() const {
+		return centerFrequencyHz - binSizeHz * (numBins / 2);
+	}
+};
+static_assert(sizeof(SweepRecord) == 40, "Sweep records must keep a fixed layout");
+
+
+// ----------------------------------------------------------------------
+/** @brief Segment file holding consecutive sweep records
+ *
+ * Records are read straight from the mapping, up to the bytes committed by the writer thread.
+ * An expired segment is deleted when the last reader releases it.
+**/
+class SweepSegment {
+public:
+	// Records between two entries of the time index
+	static constexpr size_t INDEX_STRIDE = 64;
+
+	struct IndexEntry {
+		long long timeNs;
+		size_t offset;
+	};
+
+	std::filesystem::path path;
+	MappedFile file;
+	std::atomic<size_t> committed{ 0 };
+	std::atomic<long long> firstNs{ (std::numeric_limits<long long>::max)() };
+	std::atomic<long long> lastNs{ (std::numeric_limits<long long>::min)() };
+	std::atomic<bool> expired{ false };
+	size_t records = 0;		// Written only by the writer thread
+
+private:
+	mutable std::mutex indexMtx;
+	std::vector<IndexEntry> index;
+
+public:
+	~SweepSegment() {
+		file.close();
+		if (expired) {
+			std::error_code ec;
+			std::filesystem::remove(path, ec);
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Register a record written at the given offset. Called by the writer thread after the record is complete.
+	 *
+	 * @param timeNs: Time of the record
+	 * @param offset: Offset of the record in the segment
+	 * @param end: Offset following the record
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void commit(long long timeNs, size_t offset, size_t end) {
+		if (records % INDEX_STRIDE == 0) {
+			std::lock_guard<std::mutex> lock(indexMtx);
+			index.push_back({ timeNs, offset });
+		}
+		records++;
+		if (timeNs < firstNs.load(std::memory_order_relaxed)) {
+			firstNs.store(timeNs, std::memory_order_relaxed);
+		}
+		lastNs.store(timeNs, std::memory_order_relaxed);
+		committed.store(end, std::memory_order_release);
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Visit the records of the segment within a time range, in time order
+	 *
+	 * @param fromNs: Start of the time range, inclusive
+	 * @param toNs: End of the time range, inclusive
+	 * @param visit: Function receiving the record header and a pointer to its bins
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <typename Visitor>
+	void scan(long long fromNs, long long toNs, Visitor&& visit) const {
+		size_t end = committed.load(std::memory_order_acquire);
+		size_t offset = 0;
+		{
+			std::lock_guard<std::mutex> lock(indexMtx);
+			auto it = std::lower_bound(index.begin(), index.end(), fromNs, [](const IndexEntry& entry, long long t) { return entry.timeNs < t; });
+			if (it != index.begin()) {
+				offset = std::prev(it)->offset;
+			}
+		}
+
+		const char* base = file.data();
+		SweepRecord record;
+		while (offset + sizeof(SweepRecord) <= end) {
+			std::memcpy(&record, base + offset, sizeof(SweepRecord));
+			if (record.magic != SweepRecord::MAGIC || offset + SweepRecord::size(record.numBins) > end || record.timeNs > toNs) {
+				break;
+			}
+			if (record.timeNs >= fromNs) {
+				visit(record, reinterpret_cast<const uint8_t*>(base + offset + sizeof(SweepRecord)));
+			}
+			offset += SweepRecord::size(record.numBins);
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Rebuild the time index of a segment mapped for reading
+	 *
+	 * @return size_t: Number of valid records
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	size_t load() {
+		const char* base = file.data();
+		size_t end = file.size();
+		size_t offset = 0;
+		SweepRecord record;
+		while (offset + sizeof(SweepRecord) <= end) {
+			std::memcpy(&record, base + offset, sizeof(SweepRecord));
+			size_t next = offset + SweepRecord::size(record.numBins);
+			if (record.magic != SweepRecord::MAGIC || next > end) {
+				break;
+			}
+			commit(record.timeNs, offset, next);
+			offset = next;
+		}
+		return records;
+	}
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Store of the spectrum sweeps received from the station
+ *
+ * The queue is a bounded multiple producer queue with a sequence number per cell, so the callback threads never take a lock.
+ * Cell bin buffers are allocated when the store is configured, so the callback threads never allocate memory.
+ * Records are kept in time order within each segment. A sweep older than the last record of the active segment is recorded
+ * with the time of that record if the clock went back by up to MAX_SKEW_NS, or starts a new segment otherwise.
+**/
+class SweepStore {
+private:
+	struct Cell {
+		std::atomic<size_t> sequence{ 0 };
+		SweepRecord record;
+		std::vector<uint8_t> bins;
+	};
+
+	// Clock step back, in nanoseconds, above which a new segment is started instead of shifting the record time
+	static constexpr long long MAX_SKEW_NS = 1000000000LL;
+
+	// Configuration, set before the service starts
+	bool enabled = false;
+	std::filesystem::path directory;
+	size_t segmentSize = 0;
+	size_t maxBins = 0;
+	long long maxAgeNs = 0;
+	size_t maxTotalBytes = 0;
+
+	// Lock-free handoff between the callback threads and the writer thread
+	std::unique_ptr<Cell[]> cells;
+	size_t mask = 0;
+	alignas(64) std::atomic<size_t> enqueuePos{ 0 };
+	alignas(64) std::atomic<size_t> dequeuePos{ 0 };
+	std::atomic<unsigned long long> droppedSweeps{ 0 };
+	std::atomic<unsigned long long> oversizedSweeps{ 0 };
+
+	// Segments in time order, the last one receiving the new records
+	mutable std::mutex segmentsMtx;
+	std::vector<std::shared_ptr<SweepSegment>> segments;
+	std::shared_ptr<SweepSegment> active;
+	bool skewed = false;		// Written only by the writer thread
+
+	static long long nowNs() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Map the segments left by previous runs, dropping the empty ones
+	 *
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void loadSegments() {
+		std::vector<std::filesystem::path> paths;
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+			if (entry.path().extension() == ".seg") {
+				paths.push_back(entry.path());
+			}
+		}
+		// Names hold the zero padded time of the first record
+		std::sort(paths.begin(), paths.end());
+
+		for (const auto& path : paths) {
+			auto segment = std::make_shared<SweepSegment>();
+			segment->path = path;
+			if (!segment->file.openRead(path) || segment->load() == 0) {
+				segment->expired = true;
+				continue;
+			}
+			segments.push_back(segment);
+		}
+		if (!segments.empty()) {
+			loggerPtr->info("Sweep store loaded " + std::to_string(segments.size()) + " segments from " + directory.string());
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Delete the oldest segments while they are older than the maximum age or the store exceeds the maximum size
+	 *
+	 * The active segment is never deleted.
+	 *
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void enforceRetention() {
+		std::lock_guard<std::mutex> lock(segmentsMtx);
+
+		size_t totalBytes = 0;
+		for (const auto& segment : segments) {
+			totalBytes += segment->file.size() + segment->file.available();
+		}
+
+		long long oldestNs = nowNs() - maxAgeNs;
+		while (segments.size() > 1 && segments.front() != active &&
+			((maxAgeNs > 0 && segments.front()->lastNs < oldestNs) || (maxTotalBytes > 0 && totalBytes > maxTotalBytes))) {
+			const auto& segment = segments.front();
+			totalBytes -= segment->file.size() + segment->file.available();
+			segment->expired = true;
+			loggerPtr->debug("Sweep store segment " + segment->path.string() + " expired");
+			segments.erase(segments.begin());
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Start a new segment for a record of the given size
+	 *
+	 * @param timeNs: Time of the first record of the segment
+	 * @return bool: True if the segment was created, false otherwise
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool openSegment(long long timeNs) {
+		char name[40];
+		std::snprintf(name, sizeof(name), "sweeps_%020lld.seg", timeNs);
+
+		auto segment = std::make_shared<SweepSegment>();
+		segment->path = directory / name;
+		if (!segment->file.open(segment->path, segmentSize)) {
+			loggerPtr->error("Sweep store failed to create " + segment->path.string());
+			return false;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(segmentsMtx);
+			segments.push_back(segment);
+			active = segment;
+		}
+		enforceRetention();
+		return true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Append a record to the active segment, starting a new one if it is full
+	 *
+	 * @param cell: Queue cell holding the sweep
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void append(Cell& cell) {
+		static const char PADDING[8] = {};
+
+		SweepRecord& record = cell.record;
+		size_t size = SweepRecord::size(record.numBins);
+		if (size > segmentSize) {
+			loggerPtr->warn("Sweep with " + std::to_string(record.numBins) + " bins exceeds the sweep store segment size");
+			return;
+		}
+
+		long long skewNs = active && active->records > 0 ? active->lastNs.load(std::memory_order_relaxed) - record.timeNs : 0;
+		if (skewNs > MAX_SKEW_NS) {
+			loggerPtr->warn("Sweep store clock went back by {} ms. Starting a new segment", skewNs / 1000000);
+			active.reset();
+		}
+		else if (skewNs > 0) {
+			if (!skewed) {
+				loggerPtr->warn("Sweep store clock went back by {} ms. Sweeps recorded with the time of the previous sweep", skewNs / 1000000.0);
+			}
+			record.timeNs += skewNs;
+		}
+		skewed = skewNs > 0;
+
+		if (!active || active->file.available() < size) {
+			active.reset();
+			if (!openSegment(record.timeNs)) {
+				return;
+			}
+		}
+
+		MappedFile& file = active->file;
+		size_t offset = file.size();
+		file.append(reinterpret_cast<const char*>(&record), sizeof(SweepRecord));
+		file.append(reinterpret_cast<const char*>(cell.bins.data()), record.numBins);
+		file.append(PADDING, size - sizeof(SweepRecord) - record.numBins);
+		active->commit(record.timeNs, offset, file.size());
+	}
+
+public:
+	// ----------------------------------------------------------------------
+	/** @brief Set the store configuration and load the segments of previous runs. Must be called before the service starts.
+	 *
+	 * @param enable: Store the sweeps received from the station
+	 * @param path: Folder receiving the segments, created if missing
+	 * @param segmentMB: Size of each segment file, in MiB
+	 * @param maxAgeS: Age after which a segment is deleted, in seconds. Zero to keep the segments regardless of age
+	 * @param maxTotalMB: Size of the store above which the oldest segments are deleted, in MiB. Zero for no limit
+	 * @param queueSweeps: Number of sweeps waiting to be written before new sweeps are dropped, rounded up to a power of two
+	 * @param maxSweepBins: Number of bins allocated for each queued sweep. Larger sweeps are dropped
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void configure(bool enable, const std::string& path, long long segmentMB, long long maxAgeS, long long maxTotalMB, long long queueSweeps, long long maxSweepBins) {
+		enabled = enable && segmentMB > 0 && queueSweeps > 0 && maxSweepBins > 0;
+		if (!enabled) {
+			return;
+		}
+
+		directory = path;
+		segmentSize = static_cast<size_t>(segmentMB) << 20;
+		maxBins = static_cast<size_t>(maxSweepBins);
+		maxAgeNs = (std::max)(maxAgeS, 0LL) * 1000000000LL;
+		maxTotalBytes = static_cast<size_t>((std::max)(maxTotalMB, 0LL)) << 20;
+
+		size_t capacity = 1;
+		while (capacity < static_cast<size_t>(queueSweeps)) {
+			capacity <<= 1;
+		}
+		cells.reset(new Cell[capacity]);
+		for (size_t i = 0; i < capacity; i++) {
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+			cells[i].bins.resize(maxBins);
+		}
+		mask = capacity - 1;
+
+		std::error_code ec;
+		std::filesystem::create_directories(directory, ec);
+		if (ec) {
+			loggerPtr->error("Sweep store disabled. Failed to create " + directory.string() + ": " + ec.message());
+			enabled = false;
+			return;
+		}
+		loadSegments();
+		enforceRetention();
+	}
+
+	bool isEnabled() const { return enabled; }
+	unsigned long long dropped() const { return droppedSweeps.load(std::memory_order_relaxed); }
+
+	// ----------------------------------------------------------------------
+	/** @brief Queue a sweep to be stored. Called from the DLL callback threads, never waits for the writer thread.
+	 *
+	 * @param source: Response type of the sweep
+	 * @param timeNs: Reception time, in nanoseconds since the Unix epoch
+	 * @param centerFrequencyHz: Frequency of the center bin
+	 * @param binSizeHz: Frequency step between bins
+	 * @param bins: Raw levels of the sweep
+	 * @param numBins: Number of bins of the sweep
+	 * @return bool: True if the sweep was queued, false if the store is disabled, the queue is full or the sweep has more than maxBins bins
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool record(uint32_t source, long long timeNs, double centerFrequencyHz, double binSizeHz, const uint8_t* bins, size_t numBins) {
+		if (!enabled || numBins == 0) {
+			return false;
+		}
+		if (numBins > maxBins) {
+			oversizedSweeps.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		Cell* cell = nullptr;
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		for (;;) {
+			cell = &cells[pos & mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			if (sequence == pos) {
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			}
+			else if (sequence < pos) {
+				// Cell still held by the writer thread
+				droppedSweeps.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else {
+				pos = enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->record = SweepRecord();
+		cell->record.numBins = static_cast<uint32_t>(numBins);
+		cell->record.timeNs = timeNs;
+		cell->record.centerFrequencyHz = centerFrequencyHz;
+		cell->record.binSizeHz = binSizeHz;
+		cell->record.source = source;
+		std::memcpy(cell->bins.data(), bins, numBins);
+
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Write the queued sweeps until the service is interrupted
+	 *
+	 * This function will lock the thread. Must be run in a separate thread.
+	 * The retention limits are checked every second and whenever a segment is created.
+	 *
+	 * @param interruptionCode: Signal interruption for service interruption
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void run(const edll::INT_CODE& interruptionCode) {
+		if (!enabled) {
+			return;
+		}
+
+		auto nextRetention = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+		unsigned long long reportedDrops = 0;
+		unsigned long long reportedOversized = 0;
+		for (;;) {
+			size_t pos = dequeuePos.load(std::memory_order_relaxed);
+			Cell& cell = cells[pos & mask];
+			if (cell.sequence.load(std::memory_order_acquire) == pos + 1) {
+				dequeuePos.store(pos + 1, std::memory_order_relaxed);
+				append(cell);
+				cell.sequence.store(pos + mask + 1, std::memory_order_release);
+				continue;
+			}
+
+			if (interruptionCode != edll::Code::RUNNING) {
+				break;
+			}
+			if (std::chrono::steady_clock::now() >= nextRetention) {
+				enforceRetention();
+				unsigned long long drops = dropped();
+				if (drops != reportedDrops) {
+					loggerPtr->warn("Sweep store queue full. " + std::to_string(drops - reportedDrops) + " sweeps dropped");
+					reportedDrops = drops;
+				}
+				unsigned long long oversized = oversizedSweeps.load(std::memory_order_relaxed);
+				if (oversized != reportedOversized) {
+					loggerPtr->warn("Sweep store dropped " + std::to_string(oversized - reportedOversized) + " sweeps with more than " + std::to_string(maxBins) + " bins");
+					reportedOversized = oversized;
+				}
+				nextRetention = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		std::lock_guard<std::mutex> lock(segmentsMtx);
+		active.reset();
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Get the segments holding records within a time range, in time order
+	 *
+	 * The segments remain readable while referenced, even if they expire.
+	 *
+	 * @param fromNs: Start of the time range, inclusive
+	 * @param toNs: End of the time range, inclusive
+	 * @return std::vector<std::shared_ptr<const SweepSegment>>: Segments overlapping the time range
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	std::vector<std::shared_ptr<const SweepSegment>> segmentsInRange(long long fromNs, long long toNs) const {
+		std::vector<std::shared_ptr<const SweepSegment>> result;
+		std::lock_guard<std::mutex> lock(segmentsMtx);
+		for (const auto& segment : segments) {
+			if (segment->committed.load(std::memory_order_acquire) > 0 && segment->firstNs <= toNs && segment->lastNs >= fromNs) {
+				result.push_back(segment);
+			}
+		}
+		return result;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Visit the stored sweeps within a time range, in time order
+	 *
+	 * @param fromNs: Start of the time range, inclusive
+	 * @param toNs: End of the time range, inclusive
+	 * @param visit: Function receiving the record header and a pointer to its bins
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <typename Visitor>
+	void scan(long long fromNs, long long toNs, Visitor&& visit) const {
+		for (const auto& segment : segmentsInRange(fromNs, toNs)) {
+			segment->scan(fromNs, toNs, visit);
+		}
+	}
+};
+
+
+// Sweep history fed by the DLL callbacks and written by its own thread
+extern SweepStore sweepStore;
@@ -0,0 +1,579 @@
+/**
+* @file etherDLLWaterfall.hpp
+*
+* @brief Header file for the waterfalls of the last sweeps, kept by the service for each spectrum task
+*
+* Every GET_PAN sweep and every realtime spectrum with uint8 levels is copied as one row of a circular buffer,
+* a contiguous 2D array with the last depth sweeps of its task, so that a new or reconnecting display
+* receives the whole history at once instead of waiting for depth sweeps.
+* Pan waterfalls are kept for each pan configuration (center frequency, bin size and number of bins)
+* and realtime waterfalls for each task and band.
+* Command code 9107 returns one waterfall as a single binary column, optionally decimated in time and frequency.
+* The requests are answered by their own thread, so that copying, decimating and encoding a large waterfall does not hold the client thread.
+*
+* The waterfall is sent as a base64 binary column inside the JSON response, not as a separate binary frame.
+* The client protocol carries JSON messages delimited by the message end string, which binary data could contain,
+* so a raw frame would need a length prefixed framing understood by every client. Base64 adds one third to the size of the rows.
+*
+* * @author fslobao
+* * @date 2025-11-01
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+
+// ----------------------------------------------------------------------
+#pragma once
+
+// Include DLL specific libraries
+#include "etherDLLCodes.hpp"
+#include "etherDLLDataProcess.hpp"
+#include "etherDLLSweepQuery.hpp"
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+#include "EtherDLLClient.hpp"
+#include "EtherDLLWriter.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+// Include general C++ libraries
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <deque>
+#include <condition_variable>
+
+// For convenience
+using json = nlohmann::json;
+
+// Global variables
+extern spdlog::logger* loggerPtr;
+extern MessageQueue response;
+
+
+// ----------------------------------------------------------------------
+/** @brief Circular buffers with the last sweeps of each spectrum task
+**/
+class Waterfalls {
+public:
+	// Sources of the sweeps
+	static constexpr unsigned PAN = 0;
+	static constexpr unsigned REALTIME = 1;
+
+private:
+	struct Waterfall {
+		std::mutex mtx;
+
+		// Task and configuration of the sweeps
+		unsigned source = PAN;
+		unsigned long taskId = 0;		// Realtime task, zero for pan sweeps
+		unsigned long bandIndex = 0;	// Realtime band, zero for pan sweeps
+		double centerHz = 0;
+		double binHz = 0;
+		size_t numBins = 0;
+
+		// Rows of numBins raw uint8 bins, the oldest replaced by each new sweep
+		std::vector<uint8_t> rows;
+		std::vector<long long> timeNs;	// Unix time of each row
+		size_t nextRow = 0;
+		size_t numRows = 0;
+		unsigned long long sweeps = 0;
+		std::atomic<long long> lastUpdate{ 0 };	// steady_clock ticks of the last sweep, compared without the waterfall lock
+	};
+
+	// Request waiting to be answered, with the waterfall selected when it was received
+	struct Pending {
+		json request;
+		std::shared_ptr<Waterfall> selected;
+		std::string sourceName;
+		Decimation decimation = Decimation::MAX;
+		size_t outRows = 0;
+		size_t outBins = 0;
+	};
+
+	std::mutex mtx;
+	std::condition_variable cv;
+
+	// Configuration, set before the service starts
+	bool enabled = false;
+	size_t depth = 0;
+	size_t maxWaterfalls = 0;
+	size_t maxPending = 0;
+
+	// Waterfalls and requests, protected by mtx. Each waterfall is also protected by its own mutex.
+	std::vector<std::shared_ptr<Waterfall>> buffers;
+	std::deque<Pending> pending;
+
+	// ----------------------------------------------------------------------
+	/** @brief Find the waterfall of a task with the configuration of a sweep. Must be called with the lock held.
+	 *
+	 * @param source: Source of the sweep, PAN or REALTIME
+	 * @param taskId: Realtime task, zero for pan sweeps
+	 * @param bandIndex: Realtime band, zero for pan sweeps
+	 * @param centerHz: Center frequency of the sweep, in Hz
+	 * @param binHz: Bin size of the sweep, in Hz
+	 * @param numBins: Number of bins of the sweep
+	 * @return std::shared_ptr<Waterfall>: Waterfall of the task, null if none has the configuration of the sweep
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	std::shared_ptr<Waterfall> findWaterfall(unsigned source, unsigned long taskId, unsigned long bandIndex, double centerHz, double binHz, size_t numBins) const {
+		for (const auto& waterfall : buffers) {
+			if (waterfall->source == source && waterfall->taskId == taskId && waterfall->bandIndex == bandIndex &&
+				waterfall->centerHz == centerHz && waterfall->binHz == binHz && waterfall->numBins == numBins) {
+				return waterfall;
+			}
+		}
+		return nullptr;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Add a new waterfall, allocated without the lock. Must be called with the lock held.
+	 *
+	 * Pan sweeps with a new configuration start a new waterfall. A realtime waterfall is replaced when its configuration changes.
+	 * The least recently updated waterfall is replaced when maxWaterfalls waterfalls already exist.
+	 * If another callback thread added a waterfall with the same configuration meanwhile, that waterfall is kept.
+	 *
+	 * @param created: New waterfall
+	 * @param replaced: Waterfall removed to make room, to be released once the lock is released
+	 * @return std::shared_ptr<Waterfall>: Waterfall of the task
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	std::shared_ptr<Waterfall> addWaterfall(const std::shared_ptr<Waterfall>& created, std::shared_ptr<Waterfall>& replaced) {
+		for (auto& waterfall : buffers) {
+			if (waterfall->source != created->source || waterfall->taskId != created->taskId || waterfall->bandIndex != created->bandIndex) {
+				continue;
+			}
+			bool sameConfiguration = waterfall->centerHz == created->centerHz && waterfall->binHz == created->binHz && waterfall->numBins == created->numBins;
+			if (sameConfiguration) {
+				return waterfall;
+			}
+			if (created->source == REALTIME) {
+				replaced = std::move(waterfall);
+				waterfall = created;
+				return created;
+			}
+		}
+
+		if (buffers.size() < maxWaterfalls) {
+			buffers.push_back(created);
+		}
+		else {
+			auto oldest = std::min_element(buffers.begin(), buffers.end(), [](const auto& a, const auto& b) { return a->lastUpdate.load() < b->lastUpdate.load(); });
+			replaced = std::move(*oldest);
+			*oldest = created;
+		}
+		return created;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Empty waterfall of depth rows for a task
+	**/
+	std::shared_ptr<Waterfall> newWaterfall(unsigned source, unsigned long taskId, unsigned long bandIndex, double centerHz, double binHz, size_t numBins) const {
+		auto waterfall = std::make_shared<Waterfall>();
+		waterfall->source = source;
+		waterfall->taskId = taskId;
+		waterfall->bandIndex = bandIndex;
+		waterfall->centerHz = centerHz;
+		waterfall->binHz = binHz;
+		waterfall->numBins = numBins;
+		waterfall->rows.resize(depth * numBins);
+		waterfall->timeNs.resize(depth);
+		waterfall->lastUpdate.store(std::chrono::steady_clock::now().time_since_epoch().count());
+		return waterfall;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Copy of the rows of a waterfall, oldest first
+	**/
+	struct Snapshot {
+		unsigned source = PAN;
+		unsigned long taskId = 0;
+		unsigned long bandIndex = 0;
+		double centerHz = 0;
+		double binHz = 0;
+		size_t numBins = 0;
+		size_t numRows = 0;
+		unsigned long long sweeps = 0;
+		long long fromNs = 0;
+		long long toNs = 0;
+		std::vector<uint8_t> rows;
+	};
+
+	// ----------------------------------------------------------------------
+	/** @brief Copy the rows of a waterfall in time order. Must be called with the waterfall lock held.
+	 *
+	 * The circular buffer is unwrapped with at most two copies.
+	 *
+	 * @param waterfall: Waterfall to be copied
+	 * @return Snapshot: Rows of the waterfall, oldest first
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static Snapshot snapshot(const Waterfall& waterfall) {
+		Snapshot copy;
+		copy.source = waterfall.source;
+		copy.taskId = waterfall.taskId;
+		copy.bandIndex = waterfall.bandIndex;
+		copy.centerHz = waterfall.centerHz;
+		copy.binHz = waterfall.binHz;
+		copy.numBins = waterfall.numBins;
+		copy.numRows = waterfall.numRows;
+		copy.sweeps = waterfall.sweeps;
+		copy.rows.resize(waterfall.numRows * waterfall.numBins);
+		if (waterfall.numRows == 0) {
+			return copy;
+		}
+
+		size_t depthRows = waterfall.timeNs.size();
+		size_t oldest = (waterfall.nextRow + depthRows - waterfall.numRows) % depthRows;
+		size_t firstPart = (std::min)(waterfall.numRows, depthRows - oldest);
+		std::memcpy(copy.rows.data(), waterfall.rows.data() + oldest * waterfall.numBins, firstPart * waterfall.numBins);
+		std::memcpy(copy.rows.data() + firstPart * waterfall.numBins, waterfall.rows.data(), (waterfall.numRows - firstPart) * waterfall.numBins);
+
+		copy.fromNs = waterfall.timeNs[oldest];
+		copy.toNs = waterfall.timeNs[(waterfall.nextRow + depthRows - 1) % depthRows];
+		return copy;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Decimate the rows of a waterfall in time and frequency
+	 *
+	 * Output row j merges the input rows from floor(j * numRows / outRows) up to floor((j + 1) * numRows / outRows),
+	 * and output bin k the bins from floor(k * numBins / outBins) up to floor((k + 1) * numBins / outBins).
+	 * Rows are merged with the sweep query kernels and bins with the pan decimation kernels, in their 8-bit form.
+	 * The mean is rounded to the nearest 8-bit value.
+	 *
+	 * @tparam D: Reduction applied to the rows and bins merged
+	 * @param rows: Input rows, numRows rows of numBins bins
+	 * @param numRows: Number of input rows
+	 * @param numBins: Number of bins of each input row
+	 * @param output: Output rows, outRows rows of outBins bins
+	 * @param outRows: Number of output rows, at most numRows
+	 * @param outBins: Number of bins of each output row, at most numBins
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	template <Decimation D>
+	static void decimateRows(const uint8_t* rows, size_t numRows, size_t numBins, uint8_t* output, size_t outRows, size_t outBins) {
+		std::vector<uint8_t> merged(numBins);
+		std::vector<uint32_t> sum(D == Decimation::MEAN ? numBins : 0);
+
+		size_t firstRow = 0;
+		for (size_t j = 0; j < outRows; j++) {
+			size_t lastRow = (j + 1) * numRows / outRows;
+			uint8_t* target = output + j * outBins;
+
+			if constexpr (D == Decimation::MEAN) {
+				std::fill(sum.begin(), sum.end(), 0);
+				for (size_t r = firstRow; r < lastRow; r++) {
+					sweepKernel::add(sum.data(), rows + r * numBins, numBins);
+				}
+				size_t firstBin = 0;
+				for (size_t k = 0; k < outBins; k++) {
+					size_t lastBin = (k + 1) * numBins / outBins;
+					uint64_t total = 0;
+					for (size_t i = firstBin; i < lastBin; i++) {
+						total += sum[i];
+					}
+					uint64_t count = uint64_t(lastRow - firstRow) * (lastBin - firstBin);
+					target[k] = static_cast<uint8_t>((total + count / 2) / count);
+					firstBin = lastBin;
+				}
+			}
+			else {
+				std::memcpy(merged.data(), rows + firstRow * numBins, numBins);
+				for (size_t r = firstRow + 1; r < lastRow; r++) {
+					if constexpr (D == Decimation::MAX) {
+						sweepKernel::max(merged.data(), rows + r * numBins, numBins);
+					}
+					else {
+						sweepKernel::min(merged.data(), rows + r * numBins, numBins);
+					}
+				}
+				if (outBins == numBins) {
+					std::memcpy(target, merged.data(), numBins);
+				}
+				else {
+					size_t firstBin = 0;
+					for (size_t k = 0; k < outBins; k++) {
+						size_t lastBin = (k + 1) * numBins / outBins;
+						target[k] = static_cast<uint8_t>(reduceBinGroup<D>(merged.data() + firstBin, lastBin - firstBin));
+						firstBin = lastBin;
+					}
+				}
+			}
+
+			firstRow = lastRow;
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Decimate a waterfall copy to outRows rows of outBins bins, in place
+	 *
+	 * @param copy: Waterfall copy, with the decimated rows on return
+	 * @param outRows: Number of rows requested, zero to keep every row
+	 * @param outBins: Number of bins requested, zero to keep every bin
+	 * @param decimation: Reduction applied to the rows and bins merged
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	static void decimate(Snapshot& copy, size_t outRows, size_t outBins, Decimation decimation) {
+		outRows = outputBinCount(copy.numRows, outRows);
+		outBins = outputBinCount(copy.numBins, outBins);
+		if (outRows == copy.numRows && outBins == copy.numBins) {
+			return;
+		}
+
+		std::vector<uint8_t> output(outRows * outBins);
+		switch (decimation) {
+		case Decimation::MEAN:
+			decimateRows<Decimation::MEAN>(copy.rows.data(), copy.numRows, copy.numBins, output.data(), outRows, outBins);
+			break;
+		case Decimation::MIN:
+			decimateRows<Decimation::MIN>(copy.rows.data(), copy.numRows, copy.numBins, output.data(), outRows, outBins);
+			break;
+		default:
+			decimateRows<Decimation::MAX>(copy.rows.data(), copy.numRows, copy.numBins, output.data(), outRows, outBins);
+			break;
+		}
+		copy.rows = std::move(output);
+		copy.numRows = outRows;
+		copy.numBins = outBins;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Copy, decimate and send the waterfall selected by a request
+	 *
+	 * @param next: Request to be answered
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void answer(const Pending& next) {
+		using TaskKeys = edll::DefaultConfig::Service::TaskKeys;
+
+		Snapshot copy;
+		{
+			std::lock_guard<std::mutex> lock(next.selected->mtx);
+			copy = snapshot(*next.selected);
+		}
+		size_t sourceRows = copy.numRows;
+		size_t sourceBins = copy.numBins;
+		decimate(copy, next.outRows, next.outBins, next.decimation);
+
+		double halfSpan = copy.binHz * std::floor(sourceBins / 2.0);
+		double binSize = copy.binHz * double(sourceBins) / double((std::max)(copy.numBins, size_t(1)));
+
+		edll::JsonWriter writer;
+		writer.beginObject();
+		writer.field("source", next.sourceName);
+		if (copy.source == REALTIME) {
+			writer.field("taskId", copy.taskId);
+			writer.field("bandIndex", copy.bandIndex);
+		}
+		writer.field("fromMs", copy.fromNs / 1000000);
+		writer.field("toMs", copy.toNs / 1000000);
+		writer.field("numSweeps", copy.numRows);
+		writer.field("numBins", copy.numBins);
+		if (copy.numRows != sourceRows || copy.numBins != sourceBins) {
+			writer.field("decimation", decimationToString(next.decimation));
+			writer.field("sourceNumSweeps", sourceRows);
+			writer.field("sourceNumBins", sourceBins);
+		}
+		writer.field("startFrequency", (copy.centerHz - halfSpan) / edll::MHZ_MULTIPLIER);
+		writer.field("stopFrequency", (copy.centerHz + halfSpan) / edll::MHZ_MULTIPLIER);
+		writer.field("frequencyUnit", "MHz");
+		writer.field("binSize", binSize);
+		writer.field("binSizeUnit", "Hz");
+		if (copy.source == PAN) {
+			writer.field("levelOffset", BYTE_POWER_OFFSET);
+		}
+		writer.key("waterfall").beginObject();
+		writer.field("type", edll::columnType<uint8_t>());
+		writer.key("data").binary(copy.rows.data(), copy.rows.size());
+		writer.endObject();
+		writer.endObject();
+
+		json waterfallResponse;
+		waterfallResponse[TaskKeys::CommandCode::VALUE] = StreamMsgType::WATERFALL;
+		waterfallResponse[TaskKeys::CommandName::VALUE] = StreamMsgType::toString(StreamMsgType::WATERFALL);
+		waterfallResponse[TaskKeys::Arguments::VALUE] = json::object();
+		waterfallResponse[TaskKeys::SessionId::VALUE] = next.request.value(TaskKeys::SessionId::VALUE, TaskKeys::SessionId::INIT_VALUE);
+		waterfallResponse[clientIdKey] = next.request.value(clientIdKey, json(TaskKeys::ClientId::INIT_VALUE));
+		waterfallResponse[edll::BODY_KEY] = writer.str();
+		response.push(waterfallResponse, "Waterfalls");
+	}
+
+public:
+	Waterfalls() = default;
+
+	// ----------------------------------------------------------------------
+	/** @brief Configure the waterfalls. Must be called before the service starts.
+	 *
+	 * @param enable: Keep the waterfalls of the spectrum tasks
+	 * @param numSweeps: Depth of each waterfall, in sweeps
+	 * @param numWaterfalls: Number of waterfalls kept, the least recently updated is replaced beyond it
+	 * @param maxRequests: Number of requests waiting to be answered before new requests are refused
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void configure(bool enable, long long numSweeps, long long numWaterfalls, long long maxRequests) {
+		enabled = enable && numSweeps > 0 && numWaterfalls > 0 && maxRequests > 0;
+		depth = enabled ? static_cast<size_t>(numSweeps) : 0;
+		maxWaterfalls = enabled ? static_cast<size_t>(numWaterfalls) : 0;
+		maxPending = enabled ? static_cast<size_t>(maxRequests) : 0;
+	}
+
+	bool isEnabled() const { return enabled; }
+
+	// ----------------------------------------------------------------------
+	/** @brief Add a sweep to the waterfall of its task. Called from the DLL callback threads.
+	 *
+	 * The rows of a new configuration are allocated without holding the lock shared by every callback thread,
+	 * and the waterfall replaced by it is released after the lock.
+	 *
+	 * @param source: Source of the sweep, PAN or REALTIME
+	 * @param taskId: Realtime task, zero for pan sweeps
+	 * @param bandIndex: Realtime band, zero for pan sweeps
+	 * @param centerHz: Center frequency of the sweep, in Hz
+	 * @param binHz: Bin size of the sweep, in Hz
+	 * @param bins: Raw uint8 bins of the sweep
+	 * @param numBins: Number of bins of the sweep
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void update(unsigned source, unsigned long taskId, unsigned long bandIndex, double centerHz, double binHz, const uint8_t* bins, size_t numBins) {
+		if (!enabled || numBins == 0) {
+			return;
+		}
+
+		long long timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+		std::shared_ptr<Waterfall> waterfall;
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			waterfall = findWaterfall(source, taskId, bandIndex, centerHz, binHz, numBins);
+		}
+		if (!waterfall) {
+			std::shared_ptr<Waterfall> created = newWaterfall(source, taskId, bandIndex, centerHz, binHz, numBins);
+			std::shared_ptr<Waterfall> replaced;
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				waterfall = addWaterfall(created, replaced);
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(waterfall->mtx);
+		std::memcpy(waterfall->rows.data() + waterfall->nextRow * numBins, bins, numBins);
+		waterfall->timeNs[waterfall->nextRow] = timeNs;
+		waterfall->nextRow = (waterfall->nextRow + 1) % depth;
+		waterfall->numRows = (std::min)(waterfall->numRows + 1, depth);
+		waterfall->sweeps++;
+		waterfall->lastUpdate.store(std::chrono::steady_clock::now().time_since_epoch().count());
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Queue a waterfall request received from the client, to be answered by the waterfall thread with the whole waterfall
+	 *
+	 * Arguments select the most recently updated waterfall of the source, "pan" by default or "realtime",
+	 * optionally with the realtime taskId and bandIndex, or the pan centerFrequency in Hz.
+	 * sweeps and outputBins decimate the waterfall in time and frequency with the "max", "mean" or "min" decimation.
+	 *
+	 * @param request: Request received from the client
+	 * @return std::string: Error message, empty if the request was queued
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	std::string submit(const json& request) {
+		using TaskKeys = edll::DefaultConfig::Service::TaskKeys;
+
+		if (!enabled) {
+			return "Waterfalls are disabled";
+		}
+
+		const json& arguments = request[TaskKeys::Arguments::VALUE];
+		Pending next;
+		next.sourceName = arguments.value("source", std::string("pan"));
+		unsigned source = PAN;
+		if (next.sourceName == "realtime") {
+			source = REALTIME;
+		}
+		else if (next.sourceName != "pan") {
+			return "Unknown waterfall source '" + next.sourceName + "'. Use 'pan' or 'realtime'";
+		}
+
+		std::string decimationName = arguments.value("decimation", std::string(decimationToString(next.decimation)));
+		if (!decimationFromString(decimationName, next.decimation)) {
+			return "Unknown decimation '" + decimationName + "'. Use 'max', 'mean' or 'min'";
+		}
+		next.outRows = arguments.value("sweeps", size_t(0));
+		next.outBins = arguments.value("outputBins", size_t(0));
+
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			for (const auto& waterfall : buffers) {
+				if (waterfall->source != source ||
+					(arguments.contains("taskId") && waterfall->taskId != arguments["taskId"].get<unsigned long>()) ||
+					(arguments.contains("bandIndex") && waterfall->bandIndex != arguments["bandIndex"].get<unsigned long>()) ||
+					(arguments.contains("centerFrequency") && std::fabs(waterfall->centerHz - arguments["centerFrequency"].get<double>()) > waterfall->binHz / 2)) {
+					continue;
+				}
+				if (!next.selected || waterfall->lastUpdate.load() > next.selected->lastUpdate.load()) {
+					next.selected = waterfall;
+				}
+			}
+			if (!next.selected) {
+				return "No " + next.sourceName + " waterfall matching the request";
+			}
+			if (pending.size() >= maxPending) {
+				return "Waterfall request refused. " + std::to_string(pending.size()) + " requests waiting to be answered";
+			}
+			next.request = request;
+			pending.push_back(std::move(next));
+		}
+		cv.notify_one();
+		return std::string();
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Answer the queued requests until the service is interrupted
+	 *
+	 * This function will lock the thread. Must be run in a separate thread.
+	 *
+	 * @param interruptionCode: Signal interruption for service interruption
+	 * @return void
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	void run(const edll::INT_CODE& interruptionCode) {
+		if (!enabled) {
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(mtx);
+		while (interruptionCode == edll::Code::RUNNING) {
+			if (pending.empty()) {
+				cv.wait_for(lock, std::chrono::seconds(1));
+				continue;
+			}
+			Pending next = std::move(pending.front());
+			pending.pop_front();
+
+			lock.unlock();
+			answer(next);
+			lock.lock();
+		}
+	}
+};
+
+
+// Waterfalls fed by the DLL callbacks and answered by their own thread
+extern Waterfalls waterfalls;
@@ -0,0 +1,214 @@
+/**
+* @file captureBenchmark.cpp
+*
+* @brief Capture synthetic pan callbacks with CallbackCapture and replay the file with CallbackReplay
+*
+* A producer thread plays OnDataFunc with pan bodies laid out as SGetPanResp, a header followed by bins sized for the largest sweep,
+* while the writer thread of the capture appends them to the file. Each body is captured in turn with:
+*   - union: the size of the whole body union, as the callbacks did before the size was read from the response type
+*   - payload: the size up to the last bin used, from capturedBodySize. The body is allocated with that size only,
+*     so a capture reading beyond the payload is reported when built with -fsanitize=address
+* Reports the time of each capture call, the file size, and the callbacks per second replayed from the file,
+* checking that every replayed body matches the captured payload, zero padded to the body union.
+*
+* Usage: captureBenchmark [directory] [callbacks] [bins] [queue]
+*
+* * @author fslobao
+* * @date 2025-10-30
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+*
+**/
+
+// ----------------------------------------------------------------------
+// Include DLL specific libraries
+#include "etherDLLCapture.hpp"
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+
+// Include project libraries
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+
+// Include general C++ libraries
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <filesystem>
+
+// For convenience
+using Clock = std::chrono::steady_clock;
+
+// Global variables
+spdlog::logger* loggerPtr = nullptr;
+
+// Bins of the largest sweep and size of the body union, as in the DLL types
+const size_t MAX_BINS = 32768;
+const size_t UNION_SIZE = 256 * 1024;
+
+// Response type of GET_PAN
+const unsigned long GET_PAN = 55;
+
+// Body laid out as SGetPanResp
+struct PanBody {
+	uint64_t freq;
+	uint64_t binSize;
+	uint32_t numBins;
+	uint8_t binData[MAX_BINS];
+};
+
+// Body union sized for its largest member, as SEquipCtrlMsg::UBody
+union DataBody {
+	PanBody pan;
+	char largest[UNION_SIZE];
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Fill the pan body of a callback, with no zero bin so the payload is never trimmed
+ *
+ * @param body: Body to be filled
+ * @param index: Index of the callback
+ * @param bins: Number of bins of the sweep
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void fillPan(PanBody& body, size_t index, size_t bins) {
+	body.freq = 100000000 + index;
+	body.binSize = 1000;
+	body.numBins = static_cast<uint32_t>(bins);
+	for (size_t b = 0; b < bins; b++) {
+		body.binData[b] = static_cast<uint8_t>(1 + (index + b) % 255);
+	}
+}
+
+// ----------------------------------------------------------------------
+/** @brief Capture the callbacks into a new file in the given folder
+ *
+ * @param directory: Folder of the capture file, deleted before the capture
+ * @param callbacks: Number of callbacks
+ * @param bins: Number of bins of each sweep
+ * @param queue: Number of callbacks waiting to be written
+ * @param wholeUnion: Capture the size of the body union instead of the payload
+ * @return std::filesystem::path: Capture file, empty if the capture failed
+ * @throws NO EXCEPTION HANDLING
+**/
+std::filesystem::path captureCallbacks(const std::filesystem::path& directory, size_t callbacks, size_t bins, long long queue, bool wholeUnion) {
+	std::filesystem::remove_all(directory);
+	CallbackCapture capture;
+	capture.configure(true, directory.string(), queue);
+	if (!capture.isEnabled()) {
+		return std::filesystem::path();
+	}
+	edll::INT_CODE interruptionCode = edll::Code::RUNNING;
+	std::thread writer([&] { capture.run(interruptionCode); });
+
+	// Union bodies are allocated whole, payload bodies only up to their last bin
+	std::unique_ptr<DataBody> unionBody(new DataBody());
+	size_t payloadSize = capturedBodySize(unionBody->pan, unionBody->pan.binData + bins);
+	std::unique_ptr<uint64_t[]> payloadBody(new uint64_t[(payloadSize + sizeof(uint64_t) - 1) / sizeof(uint64_t)]);
+	PanBody& pan = wholeUnion ? unionBody->pan : *reinterpret_cast<PanBody*>(payloadBody.get());
+
+	Clock::duration captureTime{};
+	unsigned long long retries = 0;
+	auto start = Clock::now();
+	for (size_t i = 0; i < callbacks; i++) {
+		fillPan(pan, i, bins);
+		for (;;) {
+			auto callStart = Clock::now();
+			size_t bodySize = wholeUnion ? sizeof(DataBody) : capturedBodySize(pan, pan.binData + pan.numBins);
+			bool queued = capture.capture(CallbackKind::DATA, 1, GET_PAN, 0, static_cast<unsigned long>(i), &pan, bodySize);
+			captureTime += Clock::now() - callStart;
+			if (queued) {
+				break;
+			}
+			retries++;
+			std::this_thread::yield();
+		}
+	}
+	interruptionCode = edll::Code::CTRL_C_INTERRUPT;
+	writer.join();
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::filesystem::path file;
+	for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+		file = entry.path();
+	}
+	if (file.empty()) {
+		return file;
+	}
+	double megabytes = std::filesystem::file_size(file) / 1e6;
+	std::cout << (wholeUnion ? "union" : "payload") << " capture: " << std::chrono::duration<double, std::nano>(captureTime).count() / (callbacks + retries)
+		<< " ns/call, " << callbacks / seconds << " callbacks/s, " << megabytes << " MB written, " << retries << " retries on a full queue" << std::endl;
+	return file;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Replay a capture file and check each body against the callback captured
+ *
+ * @param file: Capture file
+ * @param callbacks: Number of callbacks captured
+ * @param bins: Number of bins of each sweep
+ * @return bool: True if every callback was replayed with its pan body
+ * @throws NO EXCEPTION HANDLING
+**/
+bool replayCallbacks(const std::filesystem::path& file, size_t callbacks, size_t bins) {
+	CallbackReplay replay;
+	replay.configure(true, file.string(), 0, false);
+
+	ReplayBody replayed(sizeof(DataBody));
+	std::unique_ptr<DataBody> expected(new DataBody());
+	size_t count = 0;
+	size_t mismatches = 0;
+	unsigned long long bytes = 0;
+	edll::INT_CODE interruptionCode = edll::Code::RUNNING;
+	auto start = Clock::now();
+	replay.run(interruptionCode, [&](const CapturedCallback& record, const char* body) {
+		const DataBody* data = static_cast<const DataBody*>(replayed.fill(body, record.size));
+		fillPan(expected->pan, record.requestID, bins);
+		if (data == nullptr || record.respType != GET_PAN || record.requestID != count ||
+			std::memcmp(data, expected.get(), sizeof(DataBody)) != 0) {
+			mismatches++;
+		}
+		bytes += record.size;
+		count++;
+		});
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::cout << "  replay: " << count << " callbacks, " << count / seconds << " callbacks/s, " << bytes / seconds / 1e6 << " MB/s, "
+		<< mismatches << " bodies not matching the capture" << std::endl;
+	return count == callbacks && mismatches == 0;
+}
+
+int main(int argc, char* argv[]) {
+	std::filesystem::path directory = argc > 1 ? argv[1] : "captureBenchmark";
+	size_t callbacks = argc > 2 ? std::stoul(argv[2]) : 20000;
+	size_t bins = argc > 3 ? (std::min)(std::stoul(argv[3]), MAX_BINS) : 4096;
+	long long queue = argc > 4 ? std::stoll(argv[4]) : 1024;
+
+	auto logger = std::make_shared<spdlog::logger>("benchmark", std::make_shared<spdlog::sinks::null_sink_mt>());
+	loggerPtr = logger.get();
+
+	bool valid = true;
+	for (bool wholeUnion : { true, false }) {
+		std::filesystem::path file = captureCallbacks(directory / (wholeUnion ? "union" : "payload"), callbacks, bins, queue, wholeUnion);
+		if (file.empty()) {
+			std::cerr << "Failed to capture the callbacks in " << directory.string() << std::endl;
+			return 1;
+		}
+		valid = replayCallbacks(file, callbacks, bins) && valid;
+	}
+
+	std::filesystem::remove_all(directory);
+	if (!valid) {
+		std::cout << "Replayed callbacks do not match the callbacks captured" << std::endl;
+	}
+	return valid ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+/**
+* @file iqBenchmark.cpp
+*
+* @brief Measure the conversion rate of RT_IQ_DATA blocks to the JSON response sent to the client
+*
+* Blocks with synthetic samples are written by writeIqSamples, as done for each RT_IQ_DATA callback, in:
+*   - int16 and float32 samples, written as a base64 binary column
+*   - int16 samples written as JSON numbers, for comparison
+* Also checks the sequence tracking of iqBlocksDropped and that the samples are limited to the size of the sample member.
+* The result is the number of samples converted per second, in MS/s, on a single core.
+*
+* Usage: iqBenchmark [samples per block] [blocks]
+*
+* * @author fslobao
+* * @date 2025-10-28
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+
+// ----------------------------------------------------------------------
+// Include DLL specific libraries
+#include "etherDLLIqBlock.hpp"
+
+// Include core EtherDLL libraries
+#include "EtherDLLWriter.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+
+// Include general C++ libraries
+#include <string>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <iostream>
+
+// For convenience
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+// Global variables
+spdlog::logger* loggerPtr = nullptr;
+
+// Capacity of the sample members of the synthetic block
+const size_t MAX_SAMPLES = 65536;
+
+// Sample pairs with the layout of the members of SIq
+struct Int16Sample { short re; short im; };
+struct Float32Sample { float re; float im; };
+
+// Synthetic block with one sample member of each type
+struct IqBlock {
+	Int16Sample samplesInt16[MAX_SAMPLES];
+	Float32Sample samplesFloat32[MAX_SAMPLES];
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Write IQ blocks as the RT_IQ_DATA response does and report the conversion rate
+ *
+ * @param name: Name of the sample type
+ * @param samples: Sample member of the block
+ * @param numSamples: Samples per block
+ * @param blocks: Number of blocks written
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+template <typename Sample, size_t N>
+void benchmark(const std::string& name, const Sample (&samples)[N], size_t numSamples, size_t blocks) {
+	const unsigned long long STREAM_ID = 7;
+
+	edll::JsonWriter writer;
+	size_t bytes = 0;
+	auto start = Clock::now();
+	for (size_t i = 0; i < blocks; i++) {
+		writer.clear();
+		writer.beginObject().key("SIqDataV4").beginObject();
+		writer.field("numSamples", (unsigned long)numSamples);
+		writer.field("seqNumber", i);
+		writer.field("dropped", iqBlocksDropped(STREAM_ID, i, i + 1 == blocks));
+		writeIqSamples(writer, samples, numSamples);
+		writer.endObject().endObject();
+		bytes = writer.str().size();
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::cout << name << ": " << bytes << " bytes/block, " << blocks / seconds << " blocks/s, "
+		<< blocks * numSamples / seconds / 1e6 << " MS/s" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+	size_t numSamples = argc > 1 ? std::stoul(argv[1]) : 4096;
+	size_t blocks = argc > 2 ? std::stoul(argv[2]) : 20000;
+	numSamples = (std::min)(numSamples, MAX_SAMPLES);
+
+	auto logger = std::make_shared<spdlog::logger>("benchmark", std::make_shared<spdlog::sinks::null_sink_mt>());
+	loggerPtr = logger.get();
+
+	auto block = std::make_unique<IqBlock>();
+	for (size_t i = 0; i < MAX_SAMPLES; i++) {
+		block->samplesInt16[i] = { static_cast<short>(i % 1000), static_cast<short>(-static_cast<short>(i % 1000)) };
+		block->samplesFloat32[i] = { static_cast<float>(i % 1000) / 1000, -static_cast<float>(i % 1000) / 1000 };
+	}
+
+	// Sequence tracking: the first block of a stream and the blocks after the end of stream report no drops
+	bool valid = iqBlocksDropped(1, 10, false) == 0 && iqBlocksDropped(1, 11, false) == 0 &&
+		iqBlocksDropped(1, 15, false) == 3 && iqBlocksDropped(1, 16, true) == 0 && iqBlocksDropped(1, 40, false) == 0;
+
+	// Samples beyond the member are not written, whatever the number of samples reported by the block
+	edll::JsonWriter writer;
+	writer.beginObject();
+	writeIqSamples(writer, block->samplesInt16, MAX_SAMPLES + 1000);
+	writer.endObject();
+	json clamped = json::parse(writer.str(), nullptr, false);
+	valid = valid && !clamped.is_discarded() && clamped["samples"]["type"] == "int16" && clamped["samples"]["layout"] == "re,im" &&
+		clamped["samples"]["data"].get_ref<const std::string&>().size() == (MAX_SAMPLES * sizeof(Int16Sample) + 2) / 3 * 4;
+	if (!valid) {
+		std::cout << "IQ block checks failed" << std::endl;
+		return 1;
+	}
+
+	benchmark("int16", block->samplesInt16, numSamples, blocks);
+	benchmark("float32", block->samplesFloat32, numSamples, blocks);
+
+	size_t numberBlocks = (std::max)(blocks / 10, size_t(1));
+	size_t bytes = 0;
+	auto start = Clock::now();
+	for (size_t i = 0; i < numberBlocks; i++) {
+		json samples = json::array();
+		for (size_t s = 0; s < numSamples; s++) {
+			samples.push_back(block->samplesInt16[s].re);
+			samples.push_back(block->samplesInt16[s].im);
+		}
+		bytes = samples.dump().size();
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	std::cout << "int16 as JSON numbers: " << bytes << " bytes/block, " << numberBlocks / seconds << " blocks/s, "
+		<< numberBlocks * numSamples / seconds / 1e6 << " MS/s" << std::endl;
+
+	return 0;
+}
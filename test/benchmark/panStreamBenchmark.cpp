@@ -0,0 +1,263 @@
+/**
+* @file panStreamBenchmark.cpp
+*
+* @brief Compare the sweep rate of GET_PAN requested in a client loop with the server side pan stream
+*
+* Connects to a running EtherDLL service, attached to a station or to a simulated station,
+* and measures for the same pan configuration:
+*   - loop: one GET_PAN request at a time, each sent after the response to the previous one
+*   - stream: a single STREAM_PAN_START request, with the sweeps issued by the service
+*
+* Usage: panStreamBenchmark [host] [port] [seconds] [command file] [rateHz]
+*
+* * @author fslobao
+* * @date 2025-10-24
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+
+// ----------------------------------------------------------------------
+// Include project libraries
+#include <nlohmann/json.hpp>
+
+// Include general C++ libraries
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+typedef int SOCKET;
+#define INVALID_SOCKET (-1)
+#define closesocket close
+#endif
+
+// For convenience
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+// Service message keys and codes, as in the default configuration
+const char* const CODE_KEY = "CODE";
+const char* const COMMAND_KEY = "COMMAND";
+const char* const ARGS_KEY = "ARGS";
+const char* const ID_KEY = "ID";
+const char* const MSG_END = "\r\n";
+const long long STREAM_PAN_START = 9100;
+const long long STREAM_PAN_STOP = 9101;
+
+
+// ----------------------------------------------------------------------
+/** @brief Client connection that reads the messages sent by the service, one at a time
+**/
+class ServiceConnection {
+private:
+	SOCKET clientSocket = INVALID_SOCKET;
+	std::string accumulatedData;
+
+public:
+	~ServiceConnection() {
+		if (clientSocket != INVALID_SOCKET) {
+			closesocket(clientSocket);
+		}
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Connect to the service
+	 *
+	 * @param host: Service address
+	 * @param port: Service port
+	 * @return bool: True if connected
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool connectTo(const std::string& host, const std::string& port) {
+		addrinfo hints{};
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		addrinfo* result = nullptr;
+		if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0) {
+			return false;
+		}
+		for (addrinfo* ptr = result; ptr != nullptr && clientSocket == INVALID_SOCKET; ptr = ptr->ai_next) {
+			clientSocket = socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
+			if (clientSocket != INVALID_SOCKET && connect(clientSocket, ptr->ai_addr, static_cast<int>(ptr->ai_addrlen)) != 0) {
+				closesocket(clientSocket);
+				clientSocket = INVALID_SOCKET;
+			}
+		}
+		freeaddrinfo(result);
+		if (clientSocket == INVALID_SOCKET) {
+			return false;
+		}
+		// Requests are small and answered one at a time in the client loop
+		int noDelay = 1;
+		setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+		return true;
+	}
+
+	bool sendMessage(const json& message) {
+		std::string text = message.dump() + MSG_END;
+		size_t sent = 0;
+		while (sent < text.size()) {
+			int iResult = send(clientSocket, text.c_str() + sent, static_cast<int>(text.size() - sent), 0);
+			if (iResult <= 0) {
+				return false;
+			}
+			sent += static_cast<size_t>(iResult);
+		}
+		return true;
+	}
+
+	// ----------------------------------------------------------------------
+	/** @brief Read the next message sent by the service
+	 *
+	 * @param message: Message received
+	 * @param deadline: Time limit to wait for the message
+	 * @return bool: True if a message was received before the deadline
+	 * @throws NO EXCEPTION HANDLING
+	**/
+	bool readMessage(json& message, Clock::time_point deadline) {
+		char buffer[65536];
+		while (true) {
+			size_t end = accumulatedData.find(MSG_END);
+			if (end != std::string::npos) {
+				message = json::parse(accumulatedData.begin(), accumulatedData.begin() + end, nullptr, false);
+				accumulatedData.erase(0, end + 2);
+				return true;
+			}
+
+			auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - Clock::now());
+			if (remaining.count() <= 0) {
+				return false;
+			}
+			fd_set readSet;
+			FD_ZERO(&readSet);
+			FD_SET(clientSocket, &readSet);
+			timeval timeout{ static_cast<long>(remaining.count() / 1000000), static_cast<long>(remaining.count() % 1000000) };
+			if (select(static_cast<int>(clientSocket + 1), &readSet, nullptr, nullptr, &timeout) <= 0) {
+				return false;
+			}
+			int bytesRead = recv(clientSocket, buffer, sizeof(buffer), 0);
+			if (bytesRead <= 0) {
+				return false;
+			}
+			accumulatedData.append(buffer, static_cast<size_t>(bytesRead));
+		}
+	}
+};
+
+// ----------------------------------------------------------------------
+/** @brief Test if a message is a sweep answering the given client ID
+ *
+ * @param message: Message received from the service
+ * @param panCode: Command code of the pan request and response
+ * @param clientId: Client ID of the request
+ * @return bool
+ * @throws NO EXCEPTION HANDLING
+**/
+bool isSweep(const json& message, long long panCode, long long clientId) {
+	if (!message.is_object()) {
+		return false;
+	}
+	auto codeIt = message.find(CODE_KEY);
+	auto idIt = message.find(ID_KEY);
+	return codeIt != message.end() && codeIt->is_number() && codeIt->get<long long>() == panCode &&
+		idIt != message.end() && idIt->is_number() && idIt->get<long long>() == clientId;
+}
+
+void printResult(const std::string& mode, unsigned long long sweeps, double seconds) {
+	std::cout << mode << ": " << sweeps << " sweeps in " << seconds << " s, "
+		<< sweeps / seconds << " sweeps/s, " << (sweeps > 0 ? 1000.0 * seconds / sweeps : 0.0) << " ms/sweep" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+	std::string host = argc > 1 ? argv[1] : "127.0.0.1";
+	std::string port = argc > 2 ? argv[2] : "5555";
+	double seconds = argc > 3 ? std::stod(argv[3]) : 10.0;
+	std::string commandFile = argc > 4 ? argv[4] : "../Scorpio/command/cmdRequestPan.json";
+	double rateHz = argc > 5 ? std::stod(argv[5]) : 0.0;
+
+#ifdef _WIN32
+	WSADATA wsaData;
+	WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+	std::ifstream file(commandFile);
+	json panRequest = json::parse(file, nullptr, false);
+	if (!panRequest.is_object() || !panRequest.contains(ARGS_KEY)) {
+		std::cerr << "Invalid pan command file " << commandFile << std::endl;
+		return 1;
+	}
+	long long panCode = panRequest.value(CODE_KEY, 0LL);
+
+	ServiceConnection connection;
+	if (!connection.connectTo(host, port)) {
+		std::cerr << "Failed to connect to " << host << ":" << port << std::endl;
+		return 1;
+	}
+
+	json message;
+	auto duration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+	// Client loop: each request waits for the previous sweep
+	unsigned long long loopSweeps = 0;
+	long long clientId = 1;
+	Clock::time_point start = Clock::now();
+	Clock::time_point stop = start + duration;
+	while (Clock::now() < stop) {
+		panRequest[ID_KEY] = clientId;
+		if (!connection.sendMessage(panRequest)) {
+			std::cerr << "Connection lost" << std::endl;
+			return 1;
+		}
+		bool answered = false;
+		while (!answered && connection.readMessage(message, stop)) {
+			answered = isSweep(message, panCode, clientId);
+		}
+		if (!answered) {
+			break;
+		}
+		loopSweeps++;
+		clientId++;
+	}
+	printResult("loop", loopSweeps, std::chrono::duration<double>(Clock::now() - start).count());
+
+	// Server side stream: a single request, sweeps issued by the service
+	json streamRequest = panRequest;
+	streamRequest[CODE_KEY] = STREAM_PAN_START;
+	streamRequest[COMMAND_KEY] = "StreamPanStart";
+	streamRequest[ARGS_KEY]["rateHz"] = rateHz;
+	streamRequest[ID_KEY] = ++clientId;
+	connection.sendMessage(streamRequest);
+
+	unsigned long long streamSweeps = 0;
+	start = Clock::now();
+	stop = start + duration;
+	while (connection.readMessage(message, stop)) {
+		if (isSweep(message, panCode, clientId)) {
+			streamSweeps++;
+		}
+	}
+	printResult("stream", streamSweeps, std::chrono::duration<double>(Clock::now() - start).count());
+
+	json stopRequest;
+	stopRequest[CODE_KEY] = STREAM_PAN_STOP;
+	stopRequest[COMMAND_KEY] = "StreamPanStop";
+	stopRequest[ARGS_KEY] = json::object();
+	stopRequest[ID_KEY] = ++clientId;
+	connection.sendMessage(stopRequest);
+
+	return 0;
+}
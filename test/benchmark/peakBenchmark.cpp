@@ -0,0 +1,258 @@
+/**
+* @file peakBenchmark.cpp
+*
+* @brief Detect the noise floor and peaks of synthetic spectra with binPercentile and findPeaks
+*
+* Spectra are 8-bit bins of gaussian noise with gaussian shaped signals added at random, as sent in SGetPanResp.
+* Each detection is compared with a reference on the float levels sent to the client:
+*   - noise floor: level at the percentile of the sorted bins
+*   - peaks: runs of bins above the threshold, scanned one bin at a time, merged when closer than the spacing
+* Reports the time to detect the peaks of a spectrum with the given number of bins, of the noise floor alone,
+* and of the float reference.
+*
+* Usage: peakBenchmark [bins] [repetitions] [spectra checked]
+*
+* * @author fslobao
+* * @date 2025-10-31
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+*
+**/
+
+// ----------------------------------------------------------------------
+// Include DLL specific libraries
+#include "etherDLLPeaks.hpp"
+
+// Include general C++ libraries
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+
+// For convenience
+using Clock = std::chrono::steady_clock;
+
+// Noise level of the synthetic spectra, -100 dBm as 8-bit bins
+const double NOISE_BIN = 92.0;
+const double NOISE_SIGMA = 2.0;
+
+// Peak found by the reference detection
+struct ReferencePeak {
+	size_t bin;
+	float level;
+	size_t firstBin;
+	size_t lastBin;
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Build a spectrum of noise with signals at random
+ *
+ * @param rng: Random generator
+ * @param numBins: Number of bins
+ * @param signals: Number of signals
+ * @return std::vector<uint8_t>: 8-bit bins
+ * @throws NO EXCEPTION HANDLING
+**/
+std::vector<uint8_t> syntheticSpectrum(std::mt19937& rng, size_t numBins, int signals) {
+	std::normal_distribution<double> noise(NOISE_BIN, NOISE_SIGMA);
+	std::vector<uint8_t> bins(numBins);
+	for (auto& bin : bins) {
+		bin = static_cast<uint8_t>(std::clamp(noise(rng), 0.0, 255.0));
+	}
+	for (int s = 0; s < signals; s++) {
+		size_t center = rng() % numBins;
+		size_t width = 1 + rng() % 200;
+		double amplitude = 5.0 + rng() % 60;
+		for (size_t i = center > width ? center - width : 0; i < (std::min)(numBins, center + width); i++) {
+			double distance = (double(i) - double(center)) / double(width);
+			bins[i] = static_cast<uint8_t>(std::clamp(bins[i] + amplitude * std::exp(-8.0 * distance * distance), 0.0, 255.0));
+		}
+	}
+	return bins;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Float levels of the bins, as sent to the client
+ *
+ * @param bins: 8-bit bins
+ * @return std::vector<float>: Levels
+ * @throws NO EXCEPTION HANDLING
+**/
+std::vector<float> binLevels(const std::vector<uint8_t>& bins) {
+	std::vector<float> levels(bins.size());
+	std::transform(bins.begin(), bins.end(), levels.begin(), [](uint8_t bin) { return float(bin) - BYTE_POWER_OFFSET; });
+	return levels;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Level at a percentile of the bins, from the sorted bins
+ *
+ * @param bins: 8-bit bins
+ * @param percentile: Percentile, from 0 to 100
+ * @return float: Noise floor level
+ * @throws NO EXCEPTION HANDLING
+**/
+float referenceNoiseFloor(const std::vector<uint8_t>& bins, double percentile) {
+	std::vector<uint8_t> sorted(bins);
+	std::sort(sorted.begin(), sorted.end());
+	size_t rank = (std::max)(static_cast<size_t>(std::ceil(percentile / 100.0 * double(sorted.size()))), size_t(1));
+	return float(sorted[rank - 1]) - BYTE_POWER_OFFSET;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Peaks of the float levels, one bin at a time
+ *
+ * @param levels: Bin levels
+ * @param threshold: Level the bins of a peak are above
+ * @param minSpacing: Minimum distance between peaks, in bins
+ * @return std::vector<ReferencePeak>: Peaks in increasing bin order
+ * @throws NO EXCEPTION HANDLING
+**/
+std::vector<ReferencePeak> referencePeaks(const std::vector<float>& levels, float threshold, size_t minSpacing) {
+	size_t numBins = levels.size();
+	std::vector<std::pair<size_t, size_t>> runs;
+	for (size_t i = 0; i < numBins;) {
+		if (levels[i] > threshold) {
+			size_t end = i;
+			while (end < numBins && levels[end] > threshold) {
+				end++;
+			}
+			runs.push_back({ i, end });
+			i = end;
+		}
+		else {
+			i++;
+		}
+	}
+
+	std::vector<ReferencePeak> peaks;
+	for (size_t r = 0; r < runs.size(); r++) {
+		size_t top = runs[r].first;
+		for (size_t i = runs[r].first; i < runs[r].second; i++) {
+			if (levels[i] > levels[top]) {
+				top = i;
+			}
+		}
+		float edge = levels[top] - PEAK_BANDWIDTH_DB;
+		size_t lowerBound = r > 0 ? runs[r - 1].second : 0;
+		size_t upperBound = r + 1 < runs.size() ? runs[r + 1].first : numBins;
+		size_t low = top;
+		while (low > lowerBound && levels[low - 1] >= edge) {
+			low--;
+		}
+		size_t high = top;
+		while (high + 1 < upperBound && levels[high + 1] >= edge) {
+			high++;
+		}
+
+		ReferencePeak peak{ top, levels[top], low, high };
+		if (!peaks.empty() && top - peaks.back().bin < minSpacing) {
+			if (peak.level > peaks.back().level) {
+				peaks.back() = peak;
+			}
+		}
+		else {
+			peaks.push_back(peak);
+		}
+	}
+	return peaks;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Compare the detection with the reference on spectra of random size, noise percentile, margin and spacing
+ *
+ * Spacing goes up to twice the number of bins, as a request may ask for a spacing wider than the sweep.
+ *
+ * @param rng: Random generator
+ * @param spectra: Number of spectra checked
+ * @return bool: True if every noise floor and peak matches the reference
+ * @throws NO EXCEPTION HANDLING
+**/
+bool checkPeaks(std::mt19937& rng, size_t spectra) {
+	size_t mismatches = 0;
+	size_t total = 0;
+	for (size_t t = 0; t < spectra; t++) {
+		size_t numBins = 1 + rng() % 20000;
+		std::vector<uint8_t> bins = syntheticSpectrum(rng, numBins, rng() % 40);
+		double percentile = rng() % 101;
+		float margin = float(rng() % 20);
+		size_t minSpacing = t % 10 == 0 ? rng() % (2 * numBins) : rng() % 50;
+
+		float noiseFloor = float(binPercentile(bins.data(), numBins, percentile)) - BYTE_POWER_OFFSET;
+		if (noiseFloor != referenceNoiseFloor(bins, percentile)) {
+			mismatches++;
+		}
+
+		float threshold = noiseFloor + margin;
+		std::vector<ReferencePeak> expected = referencePeaks(binLevels(bins), threshold, minSpacing);
+		total += expected.size();
+		unsigned int minValue = binValueAbove(threshold);
+		std::vector<SpectrumPeak> found;
+		if (minValue <= 255) {
+			found = findPeaks(bins.data(), numBins, static_cast<unsigned char>(minValue), minSpacing);
+		}
+		if (found.size() != expected.size()) {
+			mismatches++;
+			continue;
+		}
+		for (size_t k = 0; k < found.size(); k++) {
+			if (found[k].bin != expected[k].bin || found[k].firstBin != expected[k].firstBin || found[k].lastBin != expected[k].lastBin) {
+				mismatches++;
+			}
+		}
+	}
+	std::cout << spectra << " spectra checked, " << total << " peaks, " << mismatches << " not matching the reference" << std::endl;
+	return mismatches == 0;
+}
+
+int main(int argc, char* argv[]) {
+	size_t numBins = argc > 1 ? (std::max)(std::stoul(argv[1]), 1UL) : 100000;
+	size_t repetitions = argc > 2 ? (std::max)(std::stoul(argv[2]), 1UL) : 5000;
+	size_t spectra = argc > 3 ? std::stoul(argv[3]) : 2000;
+
+	std::mt19937 rng(7);
+	bool valid = checkPeaks(rng, spectra);
+
+	std::vector<uint8_t> bins = syntheticSpectrum(rng, numBins, 50);
+	const float margin = 10.0f;
+	const size_t minSpacing = 10;
+	volatile size_t sink = 0;
+
+	auto start = Clock::now();
+	size_t peakCount = 0;
+	for (size_t r = 0; r < repetitions; r++) {
+		float noiseFloor = float(binPercentile(bins.data(), numBins, 50)) - BYTE_POWER_OFFSET;
+		unsigned int minValue = binValueAbove(noiseFloor + margin);
+		peakCount = minValue <= 255 ? findPeaks(bins.data(), numBins, static_cast<unsigned char>(minValue), minSpacing).size() : 0;
+		sink = sink + peakCount;
+	}
+	double detection = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / repetitions;
+
+	start = Clock::now();
+	for (size_t r = 0; r < repetitions; r++) {
+		sink = sink + binPercentile(bins.data(), numBins, 50);
+	}
+	double histogram = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / repetitions;
+
+	size_t referenceRepetitions = (std::max)(repetitions / 25, size_t(1));
+	start = Clock::now();
+	for (size_t r = 0; r < referenceRepetitions; r++) {
+		float noiseFloor = referenceNoiseFloor(bins, 50);
+		sink = sink + referencePeaks(binLevels(bins), noiseFloor + margin, minSpacing).size();
+	}
+	double reference = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / referenceRepetitions;
+
+	std::cout << numBins << " bins, " << peakCount << " peaks: detection " << detection << " us, noise floor " << histogram
+		<< " us, float reference " << reference << " us" << std::endl;
+
+	if (!valid) {
+		std::cout << "Detected peaks do not match the reference" << std::endl;
+	}
+	return valid ? 0 : 1;
+}
@@ -0,0 +1,304 @@
+/**
+* @file realtimeBenchmark.cpp
+*
+* @brief Measure the conversion rate of real-time spectra to the JSON response sent to the client
+*
+* Spectra with synthetic levels are written with the Spectrum body of RT_SPECTRUM_V1RESPONSE, RT_SPECTRUM_V2RESPONSE
+* and RT_SPECTRUM_RESPONSE, the levels written by writeLevelData as a base64 binary column.
+* The synthetic structures hold the members written by each body: frequencies as numbers in V1,
+* as objects with the internal value from V2 on, and the efield and zeroVal members of V3.
+* Also checks that the frames are valid JSON and that the levels decoded from the column match the levels of the spectrum.
+* The result is the number of frames per second of each version, on a single core.
+*
+* Usage: realtimeBenchmark [bins] [frames]
+*
+* * @author fslobao
+* * @date 2025-10-27
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+
+// ----------------------------------------------------------------------
+// Include DLL specific libraries
+#include "etherDLLSpectrumLevels.hpp"
+
+// Include core EtherDLL libraries
+#include "EtherDLLWriter.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+
+// Include general C++ libraries
+#include <string>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+
+// For convenience
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+// Capacity of the level member of the synthetic spectra
+const size_t MAX_CHANNELS = 65536;
+
+// Frequency with the layout of Units::Frequency, written as its internal value
+struct RawFrequency { unsigned long long internal; };
+
+// Synthetic spectra with the members written by each response body
+struct SpectrumV1 {
+	unsigned long taskId;
+	unsigned long bandIndex;
+	unsigned long firstChanFreq;
+	unsigned long chanSize;
+	unsigned long numChan;
+	short noiseFloor;
+	unsigned char chanData[MAX_CHANNELS];
+};
+
+struct SpectrumV2 {
+	unsigned long taskId;
+	unsigned long bandIndex;
+	RawFrequency firstChanFreq;
+	RawFrequency chanSize;
+	unsigned long numChan;
+	short noiseFloor;
+	unsigned char chanData[MAX_CHANNELS];
+};
+
+struct SpectrumV3 {
+	unsigned long taskId;
+	unsigned long bandIndex;
+	RawFrequency firstChanFreq;
+	RawFrequency chanSize;
+	unsigned long numChan;
+	bool efield;
+	short noiseFloor;
+	short zeroVal;
+	unsigned char chanData[MAX_CHANNELS];
+};
+
+
+// ----------------------------------------------------------------------
+/** @brief Write a spectrum as the RT_SPECTRUM_V1RESPONSE body
+ *
+ * @param writer: Writer receiving the body
+ * @param spectrum: Spectrum to be written
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void writeSpectrum(edll::JsonWriter& writer, const SpectrumV1& spectrum) {
+	writer.key("Spectrum").beginObject();
+	writer.field("taskId", spectrum.taskId);
+	writer.field("bandIndex", spectrum.bandIndex);
+	writer.field("startFreq", spectrum.firstChanFreq);
+	writer.field("binSize", spectrum.chanSize);
+	writer.field("numChan", spectrum.numChan);
+	writeLevelData(writer, spectrum);
+	writer.endObject();
+}
+
+// ----------------------------------------------------------------------
+/** @brief Write a spectrum as the RT_SPECTRUM_V2RESPONSE body
+ *
+ * @param writer: Writer receiving the body
+ * @param spectrum: Spectrum to be written
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void writeSpectrum(edll::JsonWriter& writer, const SpectrumV2& spectrum) {
+	writer.key("Spectrum").beginObject();
+	writer.field("taskId", spectrum.taskId);
+	writer.field("bandIndex", spectrum.bandIndex);
+	writer.key("startFreq").beginObject().field("internal", spectrum.firstChanFreq.internal).endObject();
+	writer.key("binSize").beginObject().field("internal", spectrum.chanSize.internal).endObject();
+	writer.field("numChan", spectrum.numChan);
+	writeLevelData(writer, spectrum);
+	writer.endObject();
+}
+
+// ----------------------------------------------------------------------
+/** @brief Write a spectrum as the RT_SPECTRUM_RESPONSE body
+ *
+ * @param writer: Writer receiving the body
+ * @param spectrum: Spectrum to be written
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void writeSpectrum(edll::JsonWriter& writer, const SpectrumV3& spectrum) {
+	writer.key("Spectrum").beginObject();
+	writer.field("taskId", spectrum.taskId);
+	writer.field("bandIndex", spectrum.bandIndex);
+	writer.key("startFreq").beginObject().field("internal", spectrum.firstChanFreq.internal).endObject();
+	writer.key("binSize").beginObject().field("internal", spectrum.chanSize.internal).endObject();
+	writer.field("numChan", spectrum.numChan);
+	writer.field("efield", spectrum.efield);
+	writeLevelData(writer, spectrum);
+	writer.endObject();
+}
+
+// ----------------------------------------------------------------------
+/** @brief Decode base64 text, as done by the client
+ *
+ * @param text: Base64 text
+ * @param data: Decoded bytes
+ * @return bool: False if the text is not valid base64
+ * @throws NO EXCEPTION HANDLING
+**/
+bool decodeBase64(const std::string& text, std::vector<uint8_t>& data) {
+	static const std::string BASE64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	data.clear();
+	if (text.size() % 4 != 0) {
+		return false;
+	}
+	for (size_t i = 0; i < text.size(); i += 4) {
+		uint32_t triple = 0;
+		size_t padding = 0;
+		for (size_t k = 0; k < 4; k++) {
+			char c = text[i + k];
+			size_t index = BASE64.find(c);
+			if (c == '=' && i + 4 == text.size() && k >= 2) {
+				padding++;
+				index = 0;
+			}
+			else if (index == std::string::npos || padding > 0) {
+				return false;
+			}
+			triple = (triple << 6) | static_cast<uint32_t>(index);
+		}
+		data.push_back(static_cast<uint8_t>(triple >> 16));
+		if (padding < 2) {
+			data.push_back(static_cast<uint8_t>(triple >> 8));
+		}
+		if (padding < 1) {
+			data.push_back(static_cast<uint8_t>(triple));
+		}
+	}
+	return true;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Check that a frame is valid JSON and that the level column holds the levels of the spectrum
+ *
+ * Every length from 0 to 5 levels is checked, so that each base64 padding is covered, and then the given length.
+ *
+ * @param name: Name of the response version
+ * @param spectrum: Spectrum written, numChan is changed by the check
+ * @param numChan: Number of levels of the benchmark
+ * @return bool: True if every frame matches the spectrum
+ * @throws NO EXCEPTION HANDLING
+**/
+template <typename Spectrum>
+bool checkLevels(const std::string& name, Spectrum& spectrum, unsigned long numChan) {
+	edll::JsonWriter writer;
+	std::vector<uint8_t> levels;
+	for (unsigned long n : { 0UL, 1UL, 2UL, 3UL, 4UL, 5UL, numChan }) {
+		spectrum.numChan = n;
+		writer.clear();
+		writer.beginObject();
+		writeSpectrum(writer, spectrum);
+		writer.endObject();
+
+		json frame = json::parse(writer.str(), nullptr, false);
+		if (frame.is_discarded()) {
+			std::cout << name << ": invalid JSON with " << n << " levels" << std::endl;
+			return false;
+		}
+		const json& levelData = frame["Spectrum"]["levelData"];
+		bool valid = levelData["type"] == "uint8" && levelData["noiseFloor"] == spectrum.noiseFloor &&
+			levelData.contains("zeroVal") == HasZeroVal<Spectrum>::value &&
+			decodeBase64(levelData["data"].get<std::string>(), levels) && levels.size() == n &&
+			std::equal(levels.begin(), levels.end(), spectrum.chanData);
+		if (!valid) {
+			std::cout << name << ": levels do not match the spectrum with " << n << " levels" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Write spectra as the response does and report the conversion rate
+ *
+ * @param name: Name of the response version
+ * @param spectrum: Spectrum written
+ * @param frames: Number of frames written
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+template <typename Spectrum>
+void benchmark(const std::string& name, const Spectrum& spectrum, size_t frames) {
+	edll::JsonWriter writer;
+	size_t bytes = 0;
+	auto start = Clock::now();
+	for (size_t i = 0; i < frames; i++) {
+		writer.clear();
+		writer.beginObject();
+		writeSpectrum(writer, spectrum);
+		writer.endObject();
+		bytes = writer.str().size();
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::cout << name << ": " << bytes << " bytes/frame, " << frames / seconds << " frames/s, "
+		<< frames * spectrum.numChan / seconds / 1e6 << " Mlevels/s" << std::endl;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Fill the members of a spectrum, with levels covering every byte value
+ *
+ * @param spectrum: Spectrum to be filled
+ * @param numChan: Number of levels
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+template <typename Spectrum>
+void fillSpectrum(Spectrum& spectrum, unsigned long numChan) {
+	spectrum.taskId = 3;
+	spectrum.bandIndex = 1;
+	spectrum.numChan = numChan;
+	spectrum.noiseFloor = -110;
+	for (size_t i = 0; i < MAX_CHANNELS; i++) {
+		spectrum.chanData[i] = static_cast<unsigned char>((i * 37 + i / 256) % 256);
+	}
+}
+
+int main(int argc, char* argv[]) {
+	unsigned long numChan = argc > 1 ? std::stoul(argv[1]) : 4096;
+	size_t frames = argc > 2 ? std::stoul(argv[2]) : 100000;
+	numChan = (std::min)(numChan, static_cast<unsigned long>(MAX_CHANNELS));
+
+	auto v1 = std::make_unique<SpectrumV1>();
+	fillSpectrum(*v1, numChan);
+	v1->firstChanFreq = 99500000;
+	v1->chanSize = 976;
+
+	auto v2 = std::make_unique<SpectrumV2>();
+	fillSpectrum(*v2, numChan);
+	v2->firstChanFreq = { 99500000ULL << 20 };
+	v2->chanSize = { 976ULL << 20 };
+
+	auto v3 = std::make_unique<SpectrumV3>();
+	fillSpectrum(*v3, numChan);
+	v3->firstChanFreq = v2->firstChanFreq;
+	v3->chanSize = v2->chanSize;
+	v3->efield = false;
+	v3->zeroVal = -128;
+
+	bool valid = checkLevels("V1", *v1, numChan) && checkLevels("V2", *v2, numChan) && checkLevels("V3", *v3, numChan);
+
+	benchmark("V1", *v1, frames);
+	benchmark("V2", *v2, frames);
+	benchmark("V3", *v3, frames);
+
+	if (!valid) {
+		std::cout << "Level columns do not match the spectra" << std::endl;
+	}
+	return valid ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+/**
+* @file recorderBenchmark.cpp
+*
+* @brief Measure the throughput of the IQ recorder and the time spent by the DLL callback to queue each block
+*
+* A producer thread plays the RT_IQ_DATA callback, queuing synthetic int16 blocks in IqRecorder at a fixed sample rate
+* or as fast as possible, while the writer thread of the recorder appends them to the SigMF files. Reports:
+*   - the time taken by each call to IqRecorder::record (median, 99th percentile and maximum), that the callback would wait
+*   - the jitter of the producer, as the delay of each call after its scheduled time
+*   - the blocks queued and dropped and the rate written to disk, in MS/s and MB/s, including the time to drain the queue
+*
+* Usage: recorderBenchmark [directory] [samples per block] [blocks] [sample rate MS/s] [queue blocks] [file size MB]
+*
+* * @author fslobao
+* * @date 2025-10-29
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+
+// ----------------------------------------------------------------------
+// Include DLL specific libraries
+#include "etherDLLRecorder.hpp"
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+
+// Include project libraries
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+
+// Include general C++ libraries
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+// For convenience
+using Clock = std::chrono::steady_clock;
+
+// Global variables
+spdlog::logger* loggerPtr = nullptr;
+IqRecorder iqRecorder;
+
+
+// ----------------------------------------------------------------------
+/** @brief Print the median, 99th percentile and maximum of a list of durations
+ *
+ * @param name: Name of the measurement
+ * @param values: Durations in microseconds, sorted in place
+ * @return void
+ * @throws NO EXCEPTION HANDLING
+**/
+void printPercentiles(const std::string& name, std::vector<double>& values) {
+	if (values.empty()) {
+		return;
+	}
+	std::sort(values.begin(), values.end());
+	std::cout << name << ": median " << values[values.size() / 2] << " us, p99 " << values[values.size() * 99 / 100]
+		<< " us, max " << values.back() << " us" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+	const unsigned long long FILETIME_UNIX_EPOCH = 116444736000000000ULL;
+
+	std::filesystem::path directory = argc > 1 ? argv[1] : "recorderBenchmark";
+	size_t numSamples = argc > 2 ? std::stoul(argv[2]) : 4096;
+	size_t blocks = argc > 3 ? std::stoul(argv[3]) : 20000;
+	double rateMSs = argc > 4 ? std::stod(argv[4]) : 0.0;
+	long long queueBlocks = argc > 5 ? std::stoll(argv[5]) : 64;
+	long long fileSizeMB = argc > 6 ? std::stoll(argv[6]) : 256;
+
+	auto logger = std::make_shared<spdlog::logger>("benchmark", std::make_shared<spdlog::sinks::null_sink_mt>());
+	loggerPtr = logger.get();
+
+	std::filesystem::remove_all(directory);
+	iqRecorder.configure(true, directory.string(), fileSizeMB, queueBlocks);
+	if (!iqRecorder.isEnabled()) {
+		std::cerr << "Failed to enable the recorder in " << directory.string() << std::endl;
+		return 1;
+	}
+	edll::INT_CODE interruptionCode = edll::Code::RUNNING;
+	std::thread writer([&interruptionCode] { iqRecorder.run(interruptionCode); });
+
+	std::vector<int16_t> samples(2 * numSamples);
+	for (size_t i = 0; i < samples.size(); i++) {
+		samples[i] = static_cast<int16_t>(i % 2000 - 1000);
+	}
+	IqBlockInfo info;
+	info.streamID = 7;
+	info.datatype = "ci16_le";
+	info.sampleSize = 2 * sizeof(int16_t);
+	info.numSamples = numSamples;
+	info.frequencyHz = 100e6;
+	info.sampleRate = rateMSs > 0 ? rateMSs * 1e6 : 1e6;
+	info.scaleFactor = 1.0 / 32768;
+	info.startTimestamp = 133000000000000000ULL;
+	info.startTimeNs = static_cast<long long>(info.startTimestamp - FILETIME_UNIX_EPOCH) * 100;
+
+	// Blocks are due at the sample rate, or back to back if no rate is given
+	auto period = std::chrono::nanoseconds(rateMSs > 0 ? static_cast<long long>(numSamples * 1e3 / rateMSs) : 0);
+	std::vector<double> recordUs;
+	std::vector<double> lateUs;
+	recordUs.reserve(blocks);
+	lateUs.reserve(blocks);
+	size_t queued = 0;
+
+	auto start = Clock::now();
+	for (size_t i = 0; i < blocks; i++) {
+		info.seqNumber = i;
+		info.sampleOffset = i * numSamples;
+		info.endOfStream = i + 1 == blocks;
+
+		auto due = start + period * i;
+		if (period.count() > 0) {
+			std::this_thread::sleep_until(due);
+		}
+		auto callStart = Clock::now();
+		queued += iqRecorder.record(info, samples.data());
+		auto callEnd = Clock::now();
+
+		recordUs.push_back(std::chrono::duration<double, std::micro>(callEnd - callStart).count());
+		if (period.count() > 0) {
+			lateUs.push_back(std::chrono::duration<double, std::micro>(callStart - due).count());
+		}
+	}
+	auto produced = Clock::now();
+
+	interruptionCode = edll::Code::CTRL_C_INTERRUPT;
+	writer.join();
+	auto drained = Clock::now();
+
+	double produceS = std::chrono::duration<double>(produced - start).count();
+	double totalS = std::chrono::duration<double>(drained - start).count();
+	double writtenSamples = static_cast<double>(queued * numSamples);
+	std::cout << "blocks: " << blocks << " offered, " << queued << " queued, " << blocks - queued << " dropped" << std::endl;
+	std::cout << "offered: " << blocks * numSamples / produceS / 1e6 << " MS/s in " << produceS << " s" << std::endl;
+	std::cout << "written: " << writtenSamples / totalS / 1e6 << " MS/s, " << writtenSamples * info.sampleSize / totalS / 1e6
+		<< " MB/s in " << totalS << " s" << std::endl;
+	printPercentiles("record call", recordUs);
+	printPercentiles("producer delay", lateUs);
+
+	std::filesystem::remove_all(directory);
+	return 0;
+}
@@ -0,0 +1,213 @@
+/**
+* @file sweepStoreBenchmark.cpp
+*
+* @brief Measure the ingestion rate of the sweep store and the rate of the time range scans over the stored sweeps
+*
+* Producer threads play the DLL callbacks, queuing synthetic uint8 sweeps in SweepStore with consecutive times,
+* retrying when the queue is full, while the writer thread of the store appends them to the segments. Reports:
+*   - ingest: sweeps per second and MB/s written, until the queue is drained
+*   - scan: MB/s of bins visited over the whole history, after the segments are loaded again as on a service restart
+*   - range: time to scan a time range starting in the middle of a segment, which must return only the sweeps of the range
+* Also checks that the sweeps are kept in time order when the clock goes back.
+*
+* Usage: sweepStoreBenchmark [directory] [bins] [sweeps] [producers] [segment MB]
+*
+* * @author fslobao
+* * @date 2025-10-30
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+
+// ----------------------------------------------------------------------
+// Include DLL specific libraries
+#include "etherDLLSweepStore.hpp"
+
+// Include core EtherDLL libraries
+#include "EtherDLLConfig.hpp"
+
+// Include project libraries
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+
+// Include general C++ libraries
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <limits>
+#include <cstdint>
+#include <iostream>
+#include <filesystem>
+
+// For convenience
+using Clock = std::chrono::steady_clock;
+
+// Global variables
+spdlog::logger* loggerPtr = nullptr;
+
+// Time of the first sweep and interval between sweeps, in nanoseconds
+const long long FIRST_NS = 1700000000000000000LL;
+const long long SWEEP_NS = 1000000LL;
+
+
+// ----------------------------------------------------------------------
+/** @brief Visit every stored sweep and test if the times are in order within each segment
+ *
+ * @param store: Sweep store to be checked
+ * @return bool: True if the times never decrease within a segment
+ * @throws NO EXCEPTION HANDLING
+**/
+bool timeOrdered(const SweepStore& store) {
+	for (const auto& segment : store.segmentsInRange((std::numeric_limits<long long>::min)(), (std::numeric_limits<long long>::max)())) {
+		long long previousNs = (std::numeric_limits<long long>::min)();
+		bool ordered = true;
+		segment->scan((std::numeric_limits<long long>::min)(), (std::numeric_limits<long long>::max)(), [&](const SweepRecord& record, const uint8_t*) {
+			ordered = ordered && record.timeNs >= previousNs;
+			previousNs = record.timeNs;
+			});
+		if (!ordered) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Store sweeps whose clock goes back by a small and by a large step, and check the segments
+ *
+ * @param directory: Folder of the segments, deleted before and after the check
+ * @return bool: True if the small step is absorbed in the segment and the large step starts a new one
+ * @throws NO EXCEPTION HANDLING
+**/
+bool checkSkew(const std::filesystem::path& directory) {
+	const long long TIMES_NS[] = { FIRST_NS, FIRST_NS + 10 * SWEEP_NS, FIRST_NS + 5 * SWEEP_NS, FIRST_NS + 11 * SWEEP_NS, FIRST_NS - 3600000000000LL, FIRST_NS - 3599000000000LL };
+
+	std::filesystem::remove_all(directory);
+	std::vector<uint8_t> sweep(64, 100);
+	size_t segments = 0;
+	bool ordered = false;
+	{
+		SweepStore store;
+		store.configure(true, directory.string(), 1, 0, 0, 16, 64);
+		edll::INT_CODE interruptionCode = edll::Code::RUNNING;
+		std::thread writer([&] { store.run(interruptionCode); });
+		for (long long timeNs : TIMES_NS) {
+			while (!store.record(1, timeNs, 100e6, 1000, sweep.data(), sweep.size())) {
+				std::this_thread::yield();
+			}
+		}
+		interruptionCode = edll::Code::CTRL_C_INTERRUPT;
+		writer.join();
+
+		segments = store.segmentsInRange((std::numeric_limits<long long>::min)(), (std::numeric_limits<long long>::max)()).size();
+		ordered = timeOrdered(store);
+	}
+	std::filesystem::remove_all(directory);
+	return segments == 2 && ordered;
+}
+
+int main(int argc, char* argv[]) {
+	std::filesystem::path directory = argc > 1 ? argv[1] : "sweepStoreBenchmark";
+	size_t bins = argc > 2 ? std::stoul(argv[2]) : 4096;
+	size_t sweeps = argc > 3 ? std::stoul(argv[3]) : 100000;
+	int producers = argc > 4 ? std::stoi(argv[4]) : 2;
+	long long segmentMB = argc > 5 ? std::stoll(argv[5]) : 64;
+
+	auto logger = std::make_shared<spdlog::logger>("benchmark", std::make_shared<spdlog::sinks::null_sink_mt>());
+	loggerPtr = logger.get();
+
+	if (!checkSkew(directory)) {
+		std::cout << "Sweeps out of time order after a clock step back" << std::endl;
+		return 1;
+	}
+
+	// Ingestion, with the producers retrying while the queue is full
+	double ingestS = 0;
+	unsigned long long retries = 0;
+	{
+		SweepStore store;
+		store.configure(true, directory.string(), segmentMB, 0, 0, 1024, static_cast<long long>(bins));
+		if (!store.isEnabled()) {
+			std::cerr << "Failed to enable the sweep store in " << directory.string() << std::endl;
+			return 1;
+		}
+		edll::INT_CODE interruptionCode = edll::Code::RUNNING;
+		std::thread writer([&] { store.run(interruptionCode); });
+
+		std::atomic<size_t> next{ 0 };
+		auto start = Clock::now();
+		std::vector<std::thread> threads;
+		for (int p = 0; p < producers; p++) {
+			threads.emplace_back([&] {
+				std::vector<uint8_t> sweep(bins);
+				for (size_t i = next.fetch_add(1); i < sweeps; i = next.fetch_add(1)) {
+					for (size_t b = 0; b < bins; b++) {
+						sweep[b] = static_cast<uint8_t>(i + b);
+					}
+					while (!store.record(1, FIRST_NS + static_cast<long long>(i) * SWEEP_NS, 100e6, 1000, sweep.data(), bins)) {
+						std::this_thread::yield();
+					}
+				}
+				});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		interruptionCode = edll::Code::CTRL_C_INTERRUPT;
+		writer.join();
+		ingestS = std::chrono::duration<double>(Clock::now() - start).count();
+		retries = store.dropped();
+	}
+	std::cout << "ingest: " << sweeps / ingestS << " sweeps/s, " << sweeps * SweepRecord::size(bins) / ingestS / 1e6
+		<< " MB/s, " << retries << " retries on a full queue" << std::endl;
+
+	// Scans over the segments loaded again
+	SweepStore store;
+	store.configure(true, directory.string(), segmentMB, 0, 0, 16, static_cast<long long>(bins));
+
+	size_t visited = 0;
+	unsigned long long bytes = 0;
+	unsigned long long sum = 0;
+	auto start = Clock::now();
+	store.scan((std::numeric_limits<long long>::min)(), (std::numeric_limits<long long>::max)(), [&](const SweepRecord& record, const uint8_t* levels) {
+		visited++;
+		bytes += record.numBins;
+		for (size_t b = 0; b < record.numBins; b++) {
+			sum += levels[b];
+		}
+		});
+	double scanS = std::chrono::duration<double>(Clock::now() - start).count();
+	std::cout << "scan: " << visited << " sweeps, " << bytes / scanS / 1e6 << " MB/s of bins (checksum " << sum << ")" << std::endl;
+
+	size_t first = sweeps / 3;
+	size_t last = first + sweeps / 10;
+	long long fromNs = FIRST_NS + static_cast<long long>(first) * SWEEP_NS;
+	long long toNs = FIRST_NS + static_cast<long long>(last) * SWEEP_NS;
+	size_t inRange = 0;
+	bool bounded = true;
+	start = Clock::now();
+	store.scan(fromNs, toNs, [&](const SweepRecord& record, const uint8_t* levels) {
+		bounded = bounded && record.timeNs >= fromNs && record.timeNs <= toNs;
+		inRange++;
+		for (size_t b = 0; b < record.numBins; b++) {
+			sum += levels[b];
+		}
+		});
+	double rangeS = std::chrono::duration<double>(Clock::now() - start).count();
+	std::cout << "range: " << inRange << " sweeps in " << rangeS * 1e3 << " ms, " << inRange * bins / rangeS / 1e6 << " MB/s of bins" << std::endl;
+
+	// Concurrent producers may queue a sweep after a later one, which is then stored with the time of the later sweep
+	size_t expected = last - first + 1;
+	size_t tolerance = static_cast<size_t>(producers - 1);
+	bool valid = visited == sweeps && inRange + tolerance >= expected && inRange <= expected + tolerance && bounded && timeOrdered(store);
+	if (!valid) {
+		std::cout << "Stored sweeps do not match the sweeps ingested" << std::endl;
+	}
+	std::filesystem::remove_all(directory);
+	return valid ? 0 : 1;
+}
@@ -0,0 +1,275 @@
+/**
+* @file validationBenchmark.cpp
+*
+* @brief Compare request validation with JsonValidator rule chains and with the compiled ValidationSchema
+*
+* Every request of the command folder is validated, in turn, by:
+*   - chain: the JsonValidator rules built on every request, as the validators did before the schemas were compiled
+*   - schema: the ValidationSchema used by the service, from etherDLLSchema.hpp
+* Both must report the same errors. The result is the number of validations per second of each method.
+* Also checks that both methods reject an array with an item of the wrong type after the first item.
+*
+* Usage: validationBenchmark [command folder] [iterations]
+*
+* * @author fslobao
+* * @date 2025-10-04
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+
+// ----------------------------------------------------------------------
+// Include DLL specific libraries
+#include "etherDLLSchema.hpp"
+
+// Include core EtherDLL libraries
+#include "EtherDLLUtils.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+
+// Include general C++ libraries
+#include <string>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+// For convenience
+using json = nlohmann::json;
+using TaskKeys = edll::DefaultConfig::Service::TaskKeys;
+
+// Global variables
+spdlog::logger* loggerPtr = nullptr;
+
+// Command codes of the requests in test/Scorpio/command
+const long long GET_OCCUPANCY = 12;
+const long long GET_OCCUPANCYDF = 14;
+const long long GET_AVD = 15;
+const long long SET_AUDIO_PARAMS = 16;
+const long long GET_PAN = 55;
+const long long GET_MEAS = 84;
+
+
+// ----------------------------------------------------------------------
+/** @brief Validate the arguments with JsonValidator rule chains, built on every call
+ *
+ * @param code: Command code of the request
+ * @param args: Arguments of the request
+ * @param validator: JsonValidator instance to accumulate validation results
+ * @return bool: False if the command code is not part of the benchmark
+ * @throws NO EXCEPTION HANDLING
+**/
+bool validateChain(long long code, const json& args, JsonValidator& validator) {
+	switch (code) {
+		case GET_OCCUPANCYDF:
+			validator.validateObjectItems(args, "rcvrCtrl", [](const json& rcvrItem, JsonValidator& v, size_t index) {
+				v.requireRange(rcvrItem, "freq", MIN_FREQ, MAX_FREQ)
+					.requireRange(rcvrItem, "bandwidth", MIN_BANDWIDTH, MAX_BANDWIDTH)
+					.requireRange(rcvrItem, "bfo", MIN_BFO, MAX_BFO)
+					.requireRange(rcvrItem, "detMode", MIN_DET_MODE, MAX_DET_MODE)
+					.requireRange(rcvrItem, "agcTime", MIN_AGC_TIME, MAX_AGC_TIME);
+				});
+			// Fall through intended
+		case GET_OCCUPANCY:
+			validator
+				.requireRange(args, "ant", MIN_ANT, MAX_ANT)
+				.requireRange(args, "numBands", MIN_NUM_BANDS, MAX_NUM_BANDS)
+				.requireRange(args, "storageTime", MIN_STORAGE_TIME, MAX_STORAGE_TIME)
+				.requireRange(args, "measurementTime", MIN_MEASUREMENT_TIME, MAX_MEASUREMENT_TIME)
+				.requireRange(args, "numAzimuths", MIN_AZIMUTHS, MAX_AZIMUTHS)
+				.requireRange(args, "confidence", MIN_DF_CONFIDENCE, MAX_DF_CONFIDENCE)
+				.requireRange(args, "recordHoldoff", MIN_RECORD_HOLDOFF, MAX_RECORD_HOLDOFF)
+				.requireRange(args, "scanDfThreshold", MIN_SCAN_DF_THRESHOLD, MAX_SCAN_DF_THRESHOLD)
+				.requireType(args, "recordAudioDf", VALID_TYPE_BOOLEAN)
+				.validateObjectItems(args, "band", [](const json& bandItem, JsonValidator& v, size_t index) {
+					v.requireRange(bandItem, "channelBandwidth", MIN_BANDWIDTH, MAX_BANDWIDTH)
+						.requireType(bandItem, "exclude", VALID_TYPE_BOOLEAN)
+						.requireRange(bandItem, "stopFrequency", MIN_FREQ, MAX_FREQ)
+						.requireRange(bandItem, "startFrequency", MIN_FREQ, MAX_FREQ)
+						.custom(bandItem, "startFrequency", [&bandItem](const json& lf) {
+							if (bandItem.contains("stopFrequency") && bandItem["stopFrequency"].is_number() && lf.is_number()) {
+								return lf.get<double>() < bandItem["stopFrequency"].get<double>();
+							}
+							return true;
+							}, "startFrequency must be less than stopFrequency");
+					});
+			return true;
+		case GET_AVD:
+			validator
+				.requireRange(args, "freq", MIN_FREQ, MAX_FREQ)
+				.requireRange(args, "bandwidth", MIN_BANDWIDTH, MAX_BANDWIDTH)
+				.requireRange(args, "duration", MIN_DURATION, MAX_DURATION)
+				.requireType(args, "modulation", VALID_TYPE_STRING);
+			return true;
+		case GET_MEAS:
+			validator
+				.requireRange(args, "ant", MIN_ANT, MAX_ANT)
+				.requireRange(args, "freq", MIN_FREQ, MAX_FREQ)
+				.requireRange(args, "bandwidth", MIN_BANDWIDTH, MAX_BANDWIDTH);
+			return true;
+		case GET_PAN:
+			validator
+				.requireRange(args, "centerFrequency", MIN_FREQ, MAX_FREQ)
+				.requireRange(args, "span", MIN_BANDWIDTH, MAX_BANDWIDTH)
+				.requireRange(args, "rcvrAtten", MIN_RCVD_ATTEN, MAX_RCVD_ATTEN)
+				.optionalRange(args, "outputBins", MIN_OUTPUT_BINS, MAX_OUTPUT_BINS)
+				.optionalType(args, "decimation", VALID_TYPE_STRING)
+				.optionalType(args, "peakThreshold", VALID_TYPE_NUMBER)
+				.optionalType(args, "peakMargin", VALID_TYPE_NUMBER)
+				.optionalRange(args, "peakSpacing", MIN_PEAK_SPACING, MAX_PEAK_SPACING)
+				.optionalType(args, "noisePercentile", VALID_TYPE_NUMBER)
+				.optionalType(args, "sweepData", VALID_TYPE_BOOLEAN);
+			return true;
+		case SET_AUDIO_PARAMS:
+			validator
+				.requireRange(args, "freq", MIN_FREQ, MAX_FREQ)
+				.optionalType(args, "channel", VALID_TYPE_NUMBER)
+				.requireRange(args, "bandwidth", MIN_BANDWIDTH, MAX_BANDWIDTH)
+				.optionalType(args, "bfo", VALID_TYPE_NUMBER)
+				.optionalType(args, "anyChannel", VALID_TYPE_BOOLEAN)
+				.optionalType(args, "detMode", VALID_TYPE_NUMBER)
+				.optionalType(args, "doModRec", VALID_TYPE_BOOLEAN)
+				.optionalType(args, "doRDS", VALID_TYPE_BOOLEAN)
+				.optionalType(args, "streamID", VALID_TYPE_NUMBER)
+				.requireArray(args, "test_array", VALID_TYPE_NUMBER, 2)
+				.requireArray(args, "test_string_array", VALID_TYPE_STRING, 2)
+				.requireType(args, "test_float", VALID_TYPE_NUMBER)
+				.requireType(args, "test_string", VALID_TYPE_STRING);
+			return true;
+		default:
+			return false;
+	}
+}
+
+// ----------------------------------------------------------------------
+/** @brief Validate the arguments with the compiled schemas used by the service
+ *
+ * @param code: Command code of the request
+ * @param args: Arguments of the request
+ * @param validator: JsonValidator instance to accumulate validation results
+ * @return bool: False if the command code is not part of the benchmark
+ * @throws NO EXCEPTION HANDLING
+**/
+bool validateSchema(long long code, const json& args, JsonValidator& validator) {
+	switch (code) {
+		case GET_OCCUPANCYDF:
+			OCCUPANCY_DF_SCHEMA.validate(args, validator);
+			// Fall through intended
+		case GET_OCCUPANCY:
+			OCCUPANCY_SCHEMA.validate(args, validator);
+			return true;
+		case GET_AVD:
+			AVD_SCHEMA.validate(args, validator);
+			return true;
+		case GET_MEAS:
+			MEASUREMENT_SCHEMA.validate(args, validator);
+			return true;
+		case GET_PAN:
+			GET_PAN_SCHEMA.validate(args, validator);
+			return true;
+		case SET_AUDIO_PARAMS:
+			AUDIO_PARAMS_SCHEMA.validate(args, validator);
+			return true;
+		default:
+			return false;
+	}
+}
+
+// ----------------------------------------------------------------------
+/** @brief Validate arrays whose first item has the required type and a later item does not
+ *
+ * @return bool: True if both methods reject the arrays with the same error
+ * @throws NO EXCEPTION HANDLING
+**/
+bool checkArrayItems() {
+	const json args = json::parse(R"({"detectors": ["maxHold", 3], "test_array": [1, "2"], "test_string_array": ["a", null]})");
+
+	JsonValidator chain;
+	chain.requireArray(args, "detectors", VALID_TYPE_STRING)
+		.requireArray(args, "test_array", VALID_TYPE_NUMBER)
+		.requireArray(args, "test_string_array", VALID_TYPE_STRING);
+	JsonValidator schema;
+	ValidationSchema()
+		.requireArray("detectors", VALID_TYPE_STRING)
+		.requireArray("test_array", VALID_TYPE_NUMBER)
+		.requireArray("test_string_array", VALID_TYPE_STRING)
+		.validate(args, schema);
+
+	std::cout << "array items: " << schema.getErrorString() << std::endl;
+	return !schema.isValid() && chain.getErrorString() == schema.getErrorString();
+}
+
+int main(int argc, char* argv[]) {
+	std::string commandFolder = argc > 1 ? argv[1] : "../Scorpio/command";
+	size_t iterations = argc > 2 ? std::stoul(argv[2]) : 200000;
+
+	// Logged at the service default level, so the debug messages of JsonValidator are filtered but still formatted
+	auto logger = std::make_shared<spdlog::logger>("benchmark", std::make_shared<spdlog::sinks::null_sink_mt>());
+	logger->set_level(spdlog::level::info);
+	loggerPtr = logger.get();
+
+	if (!checkArrayItems()) {
+		std::cout << "Array items of the wrong type not rejected by both methods" << std::endl;
+		return 1;
+	}
+
+	std::vector<json> corpus;
+	for (const auto& entry : std::filesystem::directory_iterator(commandFolder)) {
+		std::ifstream file(entry.path());
+		json request = json::parse(file, nullptr, false);
+		if (!request.is_object() || !request.contains(TaskKeys::Arguments::VALUE)) {
+			continue;
+		}
+		JsonValidator chain;
+		JsonValidator schema;
+		if (!validateChain(request.value(TaskKeys::CommandCode::VALUE, 0LL), request[TaskKeys::Arguments::VALUE], chain) ||
+			!validateSchema(request.value(TaskKeys::CommandCode::VALUE, 0LL), request[TaskKeys::Arguments::VALUE], schema)) {
+			continue;
+		}
+		std::cout << entry.path().filename().string() << ": " << (schema.isValid() ? "valid" : schema.getErrorString()) << std::endl;
+		if (chain.getErrorString() != schema.getErrorString()) {
+			std::cout << "  chain reported: " << chain.getErrorString() << std::endl;
+		}
+		corpus.push_back(std::move(request));
+	}
+	if (corpus.empty()) {
+		std::cerr << "No requests found in " << commandFolder << std::endl;
+		return 1;
+	}
+
+	size_t validCount = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; ++i) {
+		for (const json& request : corpus) {
+			JsonValidator validator;
+			REQUEST_SCHEMA.validate(request, validator);
+			validateChain(request[TaskKeys::CommandCode::VALUE].get<long long>(), request[TaskKeys::Arguments::VALUE], validator);
+			validCount += validator.isValid();
+		}
+	}
+	auto chainEnd = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; ++i) {
+		for (const json& request : corpus) {
+			JsonValidator validator;
+			REQUEST_SCHEMA.validate(request, validator);
+			validateSchema(request[TaskKeys::CommandCode::VALUE].get<long long>(), request[TaskKeys::Arguments::VALUE], validator);
+			validCount += validator.isValid();
+		}
+	}
+	auto schemaEnd = std::chrono::steady_clock::now();
+
+	double total = static_cast<double>(iterations * corpus.size());
+	double chainS = std::chrono::duration<double>(chainEnd - start).count();
+	double schemaS = std::chrono::duration<double>(schemaEnd - chainEnd).count();
+	std::cout << "chain: " << total / chainS << " validations/s, " << 1e9 * chainS / total << " ns/validation" << std::endl;
+	std::cout << "schema: " << total / schemaS << " validations/s, " << 1e9 * schemaS / total << " ns/validation" << std::endl;
+	std::cout << "valid: " << validCount << std::endl;
+
+	return 0;
+}
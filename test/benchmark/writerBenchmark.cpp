@@ -0,0 +1,271 @@
+/**
+* @file writerBenchmark.cpp
+*
+* @brief Compare the conversion of responses to JSON text by building a JSON document and by the streaming JsonWriter
+*
+* Two response shapes are converted, in turn, by:
+*   - document: a nlohmann/json document built member by member and dumped, as the converters did before the writer
+*   - writer: the JsonWriter body merged with the message envelope by mergeBody, as sent by the service
+* Both must produce the same JSON content. The result is the number of frames per second of each method, on a single core.
+*   - pan: a spectrum sweep with the levels encoded as base64, as in GET_PAN and the pan stream
+*   - avd: an AVD result with one object per frequency
+*
+* Usage: writerBenchmark [frames] [bins]
+*
+* * @author fslobao
+* * @date 2025-10-26
+* * @version 1.0
+*
+* * @note Requires C++17 or later
+* * @note Uses nlohmann/json library for JSON handling
+*
+**/
+
+// ----------------------------------------------------------------------
+// Include core EtherDLL libraries
+#include "EtherDLLWriter.hpp"
+
+// Include project libraries
+#include <nlohmann/json.hpp>
+
+// Include general C++ libraries
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+// For convenience
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+const size_t AVD_FREQUENCIES = 1000;
+
+
+// ----------------------------------------------------------------------
+/** @brief Envelope added by the service to every response
+ *
+ * @param frame: Frame number, used as client ID
+ * @return json: Envelope with the command code and client ID
+ * @throws NO EXCEPTION HANDLING
+**/
+json envelope(size_t frame) {
+	json message;
+	message["CODE"] = 55;
+	message["ID"] = frame;
+	message["QID"] = 1;
+	return message;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Encode bytes as base64, for the levels of the JSON document
+ *
+ * @param data: Bytes to be encoded
+ * @return std::string: Base64 text
+ * @throws NO EXCEPTION HANDLING
+**/
+std::string base64(const std::vector<uint8_t>& data) {
+	static const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	std::string text;
+	text.reserve((data.size() + 2) / 3 * 4);
+	for (size_t i = 0; i < data.size(); i += 3) {
+		uint32_t triple = uint32_t(data[i]) << 16;
+		triple |= i + 1 < data.size() ? uint32_t(data[i + 1]) << 8 : 0;
+		triple |= i + 2 < data.size() ? uint32_t(data[i + 2]) : 0;
+		text.push_back(BASE64[(triple >> 18) & 0x3F]);
+		text.push_back(BASE64[(triple >> 12) & 0x3F]);
+		text.push_back(i + 1 < data.size() ? BASE64[(triple >> 6) & 0x3F] : '=');
+		text.push_back(i + 2 < data.size() ? BASE64[triple & 0x3F] : '=');
+	}
+	return text;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Build a pan frame as a JSON document and dump it
+ *
+ * @param levels: Sweep levels, one byte per bin
+ * @param frame: Frame number
+ * @return std::string: JSON text
+ * @throws NO EXCEPTION HANDLING
+**/
+std::string panDocument(const std::vector<uint8_t>& levels, size_t frame) {
+	json message = envelope(frame);
+	message["measure"]["status"] = 0;
+	message["measure"]["dateTime"] = "2025-10-26T10:00:00.000000Z";
+	message["measure"]["powerDbm"] = -40.5f;
+	message["setting"]["attenuation"] = 10;
+	message["spectrum"]["numBins"] = levels.size();
+	message["spectrum"]["startFrequency"] = 99.5;
+	message["spectrum"]["stopFrequency"] = 100.5;
+	message["spectrum"]["frequencyUnit"] = "MHz";
+	message["spectrum"]["binSize"] = 976.5625;
+	message["spectrum"]["binSizeUnit"] = "Hz";
+	message["spectrum"]["sweepData"] = base64(levels);
+	message["spectrum"]["conversionFactorForFS"] = 1.25f;
+	message["demod"]["nActiveAudioChannels"] = 0;
+	message["demod"]["audioPower"] = json::array();
+	return message.dump();
+}
+
+// ----------------------------------------------------------------------
+/** @brief Write a pan frame with JsonWriter and merge it with the envelope
+ *
+ * @param writer: Writer reused between frames
+ * @param levels: Sweep levels, one byte per bin
+ * @param frame: Frame number
+ * @return std::string: JSON text
+ * @throws NO EXCEPTION HANDLING
+**/
+std::string panWriter(edll::JsonWriter& writer, const std::vector<uint8_t>& levels, size_t frame) {
+	writer.clear();
+	writer.beginObject();
+	writer.key("measure").beginObject()
+		.field("status", 0)
+		.field("dateTime", "2025-10-26T10:00:00.000000Z")
+		.field("powerDbm", -40.5f)
+		.endObject();
+	writer.key("setting").beginObject().field("attenuation", 10).endObject();
+	writer.key("spectrum").beginObject()
+		.field("numBins", levels.size())
+		.field("startFrequency", 99.5)
+		.field("stopFrequency", 100.5)
+		.field("frequencyUnit", "MHz")
+		.field("binSize", 976.5625)
+		.field("binSizeUnit", "Hz");
+	writer.key("sweepData").binary(levels.data(), levels.size());
+	writer.field("conversionFactorForFS", 1.25f).endObject();
+	writer.key("demod").beginObject().field("nActiveAudioChannels", 0).key("audioPower").beginArray().endArray().endObject();
+	writer.endObject();
+
+	std::string message;
+	edll::mergeBody(writer.str(), envelope(frame), message);
+	return message;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Build an AVD frame as a JSON document and dump it
+ *
+ * @param frame: Frame number
+ * @return std::string: JSON text
+ * @throws NO EXCEPTION HANDLING
+**/
+std::string avdDocument(size_t frame) {
+	json message = envelope(frame);
+	json& measData = message["SAvdMeasureResult"]["measData"];
+	for (size_t i = 0; i < AVD_FREQUENCIES; i++) {
+		measData[i]["result"] = 100000.0 + i;
+		measData[i]["stdDev"] = 1.5 + i;
+	}
+	return message.dump();
+}
+
+// ----------------------------------------------------------------------
+/** @brief Write an AVD frame with JsonWriter and merge it with the envelope
+ *
+ * @param writer: Writer reused between frames
+ * @param frame: Frame number
+ * @return std::string: JSON text
+ * @throws NO EXCEPTION HANDLING
+**/
+std::string avdWriter(edll::JsonWriter& writer, size_t frame) {
+	writer.clear();
+	writer.beginObject().key("SAvdMeasureResult").beginObject().key("measData").beginArray();
+	for (size_t i = 0; i < AVD_FREQUENCIES; i++) {
+		writer.beginObject().field("result", 100000.0 + i).field("stdDev", 1.5 + i).endObject();
+	}
+	writer.endArray().endObject().endObject();
+
+	std::string message;
+	edll::mergeBody(writer.str(), envelope(frame), message);
+	return message;
+}
+
+// ----------------------------------------------------------------------
+/** @brief Check that both methods produce the same content
+ *
+ * @param name: Name of the frame shape
+ * @param document: Text produced from the JSON document
+ * @param written: Text produced by the writer
+ * @return bool: True if the content matches
+ * @throws NO EXCEPTION HANDLING
+**/
+bool sameContent(const std::string& name, const std::string& document, const std::string& written) {
+	json received = json::parse(written, nullptr, false);
+	if (received.is_discarded()) {
+		std::cout << name << ": writer produced invalid JSON" << std::endl;
+		return false;
+	}
+	if (json::parse(document) != received) {
+		std::cout << name << ": content differs" << std::endl << "  document: " << document.substr(0, 200) << std::endl << "  writer: " << written.substr(0, 200) << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void printResult(const std::string& mode, size_t frames, size_t bytes, Clock::time_point start, Clock::time_point end) {
+	double seconds = std::chrono::duration<double>(end - start).count();
+	std::cout << mode << ": " << frames / seconds << " frames/s, " << bytes / seconds / 1e6 << " MB/s" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+	size_t frames = argc > 1 ? std::stoul(argv[1]) : 20000;
+	size_t bins = argc > 2 ? std::stoul(argv[2]) : 4096;
+
+	std::vector<uint8_t> levels(bins);
+	for (size_t i = 0; i < bins; i++) {
+		levels[i] = static_cast<uint8_t>(i * 7);
+	}
+	edll::JsonWriter writer;
+
+	// Content checks, including the cases rejected or replaced by the writer
+	bool valid = sameContent("pan", panDocument(levels, 0), panWriter(writer, levels, 0)) &&
+		sameContent("avd", avdDocument(0), avdWriter(writer, 0));
+	writer.clear();
+	writer.beginObject().field("text", std::string_view("ok \xC3\xA9 \xFF\xC0\x80 end")).endObject();
+	json replaced = json::parse(writer.str(), nullptr, false);
+	if (replaced.is_discarded() || replaced["text"] != "ok \xC3\xA9 \xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD end") {
+		std::cout << "invalid UTF-8 was not replaced: " << writer.str() << std::endl;
+		valid = false;
+	}
+	std::string message;
+	if (edll::mergeBody("{\"data\":{\"ID\":1},\"ID\":2}", envelope(0), message) != "ID" ||
+		!edll::mergeBody("{\"data\":{\"ID\":1},\"text\":\",\\\"ID\"}", envelope(0), message).empty()) {
+		std::cout << "mergeBody did not detect the duplicated key" << std::endl;
+		valid = false;
+	}
+	if (!valid) {
+		return 1;
+	}
+
+	size_t bytes = 0;
+	auto start = Clock::now();
+	for (size_t i = 0; i < frames; i++) {
+		bytes += panDocument(levels, i).size();
+	}
+	auto documentEnd = Clock::now();
+	printResult("pan document", frames, bytes, start, documentEnd);
+	bytes = 0;
+	for (size_t i = 0; i < frames; i++) {
+		bytes += panWriter(writer, levels, i).size();
+	}
+	auto writerEnd = Clock::now();
+	printResult("pan writer", frames, bytes, documentEnd, writerEnd);
+
+	size_t avdFrames = frames / 10;
+	bytes = 0;
+	start = Clock::now();
+	for (size_t i = 0; i < avdFrames; i++) {
+		bytes += avdDocument(i).size();
+	}
+	documentEnd = Clock::now();
+	printResult("avd document", avdFrames, bytes, start, documentEnd);
+	bytes = 0;
+	for (size_t i = 0; i < avdFrames; i++) {
+		bytes += avdWriter(writer, i).size();
+	}
+	writerEnd = Clock::now();
+	printResult("avd writer", avdFrames, bytes, documentEnd, writerEnd);
+
+	return 0;
+}